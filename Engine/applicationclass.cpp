@@ -6,18 +6,39 @@
 
 ApplicationClass::ApplicationClass()
 {
+	int i;
+
+
 	m_Input = 0;
-	m_Direct3D = 0;
+	m_Device = 0;
+	m_SoftwareDevice = 0;
 	m_Camera = 0;
 	m_Terrain = 0;
-	m_Timer = 0;
+	m_Clock = 0;
 	m_Position = 0;
 	m_Fps = 0;
 	m_Cpu = 0;
+	m_JobSystem = 0;
 	m_FontShader = 0;
 	m_Text = 0;
 	m_TerrainShader = 0;
 	m_Light = 0;
+	m_DrawList = 0;
+	m_FrameLimiter = 0;
+	m_Profiler = 0;
+	m_FrameAllocator = 0;
+	m_StatsOverlay = 0;
+	m_RingBuffer = 0;
+	m_FrameGraph = 0;
+	m_RenderThread = 0;
+	m_saveFrame = false;
+	m_simulationStep = 0.0f;
+	m_simulationTime = 0.0f;
+
+	for(i=0; i<6; i++)
+	{
+		m_cameraMetrics[i] = -1;
+	}
 }
 
 
@@ -31,45 +52,163 @@ ApplicationClass::~ApplicationClass()
 }
 
 
-bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth, int screenHeight)
+bool ApplicationClass::Initialize(HWND hwnd, InputClass* input, int screenWidth, int screenHeight)
 {
 	bool result;
 	float cameraX, cameraY, cameraZ;
-	D3DXMATRIX baseViewMatrix;
+	Matrix baseViewMatrix;
 	char videoCard[128];
-	int videoMemory;
+	int videoMemory, metric;
+	D3DClass* direct3D;
+	NullDeviceClass* nullDevice;
 
-	
-	// Create the input object.  The input object will be used to handle reading the keyboard and mouse input from the user.
-	m_Input = new InputClass;
-	if(!m_Input)
+
+	// Store the window and its size, the software device presents its frames to it.
+	m_hwnd = hwnd;
+	m_screenWidth = screenWidth;
+	m_screenHeight = screenHeight;
+
+	// Create the profiler object first so everything after it can be profiled.
+	m_Profiler = new ProfilerClass;
+	if(!m_Profiler)
+	{
+		return false;
+	}
+
+	// Initialize the profiler object.
+	result = m_Profiler->Initialize();
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the profiler object.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Create the stats overlay object next so the objects after it can add their metrics as they are initialized.
+	m_StatsOverlay = new StatsOverlayClass;
+	if(!m_StatsOverlay)
+	{
+		return false;
+	}
+
+	// Initialize the stats overlay object.
+	result = m_StatsOverlay->Initialize(screenWidth, screenHeight);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the stats overlay object.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Create the frame allocator object, anything may use it from here on.
+	m_FrameAllocator = new FrameAllocatorClass;
+	if(!m_FrameAllocator)
 	{
 		return false;
 	}
 
-	// Initialize the input object.
-	result = m_Input->Initialize(hinstance, hwnd, screenWidth, screenHeight);
+	// Initialize the frame allocator object.
+	result = m_FrameAllocator->Initialize(FRAME_ALLOCATOR_SIZE);
 	if(!result)
 	{
-		MessageBox(hwnd, L"Could not initialize the input object.", L"Error", MB_OK);
+		MessageBox(hwnd, L"Could not initialize the frame allocator object.", L"Error", MB_OK);
 		return false;
 	}
 
-	// Create the Direct3D object.
-	m_Direct3D = new D3DClass;
-	if(!m_Direct3D)
+	// Create the cpu object before any threads are started so they are all counted.
+	m_Cpu = new CpuClass;
+	if(!m_Cpu)
 	{
 		return false;
 	}
 
-	// Initialize the Direct3D object.
-	result = m_Direct3D->Initialize(screenWidth, screenHeight, VSYNC_ENABLED, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR);
+	// Initialize the cpu object.
+	m_Cpu->Initialize();
+
+	// Create the job system object, the terrain bakers and the software rasterizer split their work into its jobs.
+	m_JobSystem = new JobSystemClass;
+	if(!m_JobSystem)
+	{
+		return false;
+	}
+
+	// Initialize the job system object, with no thread count it uses every hardware thread.
+	result = m_JobSystem->Initialize(JOB_THREADS);
 	if(!result)
 	{
-		MessageBox(hwnd, L"Could not initialize DirectX 11.", L"Error", MB_OK);
+		MessageBox(hwnd, L"Could not initialize the job system object.", L"Error", MB_OK);
 		return false;
 	}
 
+	// Use the input object the window thread samples, each frame applies the events it has published.
+	m_Input = input;
+	m_Input->AddMetrics();
+
+	// Bind the actions to their keys.
+	result = BindActions();
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not bind the input actions.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Create the render device, the null device runs the whole frame without a GPU.
+	if(NULL_RENDER_DEVICE)
+	{
+		// Create the null device object.
+		nullDevice = new NullDeviceClass;
+		if(!nullDevice)
+		{
+			return false;
+		}
+
+		m_Device = nullDevice;
+
+		// Initialize the null device object.
+		result = nullDevice->Initialize(screenWidth, screenHeight, SCREEN_DEPTH, SCREEN_NEAR);
+		if(!result)
+		{
+			MessageBox(hwnd, L"Could not initialize the null device.", L"Error", MB_OK);
+			return false;
+		}
+	}
+	else if(SOFTWARE_RENDER_DEVICE)
+	{
+		// Create the software device object.
+		m_SoftwareDevice = new SoftwareDeviceClass;
+		if(!m_SoftwareDevice)
+		{
+			return false;
+		}
+
+		m_Device = m_SoftwareDevice;
+
+		// Initialize the software device object.
+		result = m_SoftwareDevice->Initialize(screenWidth, screenHeight, SCREEN_DEPTH, SCREEN_NEAR);
+		if(!result)
+		{
+			MessageBox(hwnd, L"Could not initialize the software device.", L"Error", MB_OK);
+			return false;
+		}
+	}
+	else
+	{
+		// Create the Direct3D object.
+		direct3D = new D3DClass;
+		if(!direct3D)
+		{
+			return false;
+		}
+
+		m_Device = direct3D;
+
+		// Initialize the Direct3D object.
+		result = direct3D->Initialize(screenWidth, screenHeight, VSYNC_ENABLED, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR);
+		if(!result)
+		{
+			MessageBox(hwnd, L"Could not initialize DirectX 11.", L"Error", MB_OK);
+			return false;
+		}
+	}
+
 	// Create the camera object.
 	m_Camera = new CameraClass;
 	if(!m_Camera)
@@ -97,26 +236,26 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidt
 	}
 
 	// Initialize the terrain object.
-//	result = m_Terrain->Initialize(m_Direct3D->GetDevice(), "../Engine/data/heightmap01.bmp");
-	result = m_Terrain->InitializeTerrain(m_Direct3D->GetDevice(), 128,128);   //initialise the flat terrain.
+//	result = m_Terrain->Initialize(m_Device, "../Engine/data/heightmap01.bmp");
+	result = m_Terrain->InitializeTerrain(m_Device, 128,128);   //initialise the flat terrain.
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the terrain object.", L"Error", MB_OK);
 		return false;
 	}
 
-	// Create the timer object.
-	m_Timer = new TimerClass;
-	if(!m_Timer)
+	// Create the clock object.
+	m_Clock = new ClockClass;
+	if(!m_Clock)
 	{
 		return false;
 	}
 
-	// Initialize the timer object.
-	result = m_Timer->Initialize();
+	// Initialize the clock object.
+	result = m_Clock->Initialize();
 	if(!result)
 	{
-		MessageBox(hwnd, L"Could not initialize the timer object.", L"Error", MB_OK);
+		MessageBox(hwnd, L"Could not initialize the clock object.", L"Error", MB_OK);
 		return false;
 	}
 
@@ -130,6 +269,10 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidt
 	// Set the initial position of the viewer to the same as the initial camera position.
 	m_Position->SetPosition(cameraX, cameraY, cameraZ);
 
+	// Set the length of one simulation step in milliseconds, the same unit as the timer.
+	m_simulationStep = 1000.0f / SIMULATION_RATE;
+	m_simulationTime = 0.0f;
+
 	// Create the fps object.
 	m_Fps = new FpsClass;
 	if(!m_Fps)
@@ -138,18 +281,13 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidt
 	}
 
 	// Initialize the fps object.
-	m_Fps->Initialize();
-
-	// Create the cpu object.
-	m_Cpu = new CpuClass;
-	if(!m_Cpu)
+	result = m_Fps->Initialize();
+	if(!result)
 	{
+		MessageBox(hwnd, L"Could not initialize the fps object.", L"Error", MB_OK);
 		return false;
 	}
 
-	// Initialize the cpu object.
-	m_Cpu->Initialize();
-
 	// Create the font shader object.
 	m_FontShader = new FontShaderClass;
 	if(!m_FontShader)
@@ -158,7 +296,7 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidt
 	}
 
 	// Initialize the font shader object.
-	result = m_FontShader->Initialize(m_Direct3D->GetDevice(), hwnd);
+	result = m_FontShader->Initialize(m_Device);
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the font shader object.", L"Error", MB_OK);
@@ -173,7 +311,7 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidt
 	}
 
 	// Initialize the text object.
-	result = m_Text->Initialize(m_Direct3D->GetDevice(), m_Direct3D->GetDeviceContext(), hwnd, screenWidth, screenHeight, baseViewMatrix);
+	result = m_Text->Initialize(m_Device, screenWidth, screenHeight, baseViewMatrix);
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the text object.", L"Error", MB_OK);
@@ -181,15 +319,22 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidt
 	}
 
 	// Retrieve the video card information.
-	m_Direct3D->GetVideoCardInfo(videoCard, videoMemory);
+	m_Device->GetVideoCardInfo(videoCard, videoMemory);
 
-	// Set the video card information in the text object.
-	result = m_Text->SetVideoCardInfo(videoCard, videoMemory, m_Direct3D->GetDeviceContext());
-	if(!result)
-	{
-		MessageBox(hwnd, L"Could not set video card info in the text object.", L"Error", MB_OK);
-		return false;
-	}
+	// Show the video card information in the stats overlay, it does not change so the handles are not kept.
+	metric = StatsOverlayClass::AddLabel("Device", "Video card");
+	StatsOverlayClass::SetLabel(metric, videoCard);
+
+	metric = StatsOverlayClass::AddCounter("Device", "Video memory", "MB");
+	StatsOverlayClass::SetCounter(metric, videoMemory);
+
+	// Show the camera position and rotation in the stats overlay.
+	m_cameraMetrics[0] = StatsOverlayClass::AddCounter("Camera", "X", "");
+	m_cameraMetrics[1] = StatsOverlayClass::AddCounter("Camera", "Y", "");
+	m_cameraMetrics[2] = StatsOverlayClass::AddCounter("Camera", "Z", "");
+	m_cameraMetrics[3] = StatsOverlayClass::AddCounter("Camera", "rX", "");
+	m_cameraMetrics[4] = StatsOverlayClass::AddCounter("Camera", "rY", "");
+	m_cameraMetrics[5] = StatsOverlayClass::AddCounter("Camera", "rZ", "");
 
 	// Create the terrain shader object.
 	m_TerrainShader = new TerrainShaderClass;
@@ -199,7 +344,7 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidt
 	}
 
 	// Initialize the terrain shader object.
-	result = m_TerrainShader->Initialize(m_Direct3D->GetDevice(), hwnd);
+	result = m_TerrainShader->Initialize(m_Device);
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the terrain shader object.", L"Error", MB_OK);
@@ -218,12 +363,239 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidt
 	m_Light->SetDiffuseColor(1.0f, 1.0f, 1.0f, 1.0f);
 	m_Light->SetDirection(1.0f,0.0f, 0.0f);
 
+	// Create the draw list object.
+	m_DrawList = new DrawListClass;
+	if(!m_DrawList)
+	{
+		return false;
+	}
+
+	// Initialize the draw list object.
+	result = m_DrawList->Initialize(DRAW_LIST_PACKETS, DRAW_LIST_MEMORY);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the draw list object.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Create the ring buffer object, transient geometry such as the text is written into it every frame.
+	m_RingBuffer = new RingBufferClass;
+	if(!m_RingBuffer)
+	{
+		return false;
+	}
+
+	// Initialize the ring buffer object.
+	result = m_RingBuffer->Initialize(m_Device, RING_BUFFER_SIZE);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the ring buffer object.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Create the frame limiter object.
+	m_FrameLimiter = new FrameLimiterClass;
+	if(!m_FrameLimiter)
+	{
+		return false;
+	}
+
+	// Initialize the frame limiter object, without vsync the frame rate is capped at the limit.
+	result = m_FrameLimiter->Initialize(VSYNC_ENABLED ? FRAME_PACING_VSYNC : FRAME_PACING_LIMITED, FRAME_RATE_LIMIT);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the frame limiter object.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Create the frame graph object, the per frame updates run through it as jobs.
+	m_FrameGraph = new FrameGraphClass;
+	if(!m_FrameGraph)
+	{
+		return false;
+	}
+
+	// Initialize the frame graph object.
+	result = m_FrameGraph->Initialize();
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the frame graph object.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Declare the frame's tasks and what each one reads and writes.
+	result = InitializeFrameGraph();
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not build the frame graph.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Create the render thread object, each frame is drawn on it while the main thread works on the next one.
+	m_RenderThread = new RenderThreadClass;
+	if(!m_RenderThread)
+	{
+		return false;
+	}
+
+	// Initialize the render thread object.
+	result = m_RenderThread->Initialize(this, &ApplicationClass::RenderGraphics);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the render thread object.", L"Error", MB_OK);
+		return false;
+	}
+
+	return true;
+}
+
+
+bool ApplicationClass::InitializeFrameGraph()
+{
+	int input, stats, registry, terrain, pacing, position, camera, light, text;
+	int task;
+
+
+	// The resources are the state the tasks share, a task that writes one waits for every earlier task that uses it.
+	// The stats overlay is not thread-safe, so every task that adds or sets a metric writes the registry.
+	input = m_FrameGraph->AddResource("Input");
+	stats = m_FrameGraph->AddResource("Stats");
+	registry = m_FrameGraph->AddResource("Overlay metrics");
+	terrain = m_FrameGraph->AddResource("Terrain");
+	pacing = m_FrameGraph->AddResource("Frame pacing");
+	position = m_FrameGraph->AddResource("Position");
+	camera = m_FrameGraph->AddResource("Camera");
+	light = m_FrameGraph->AddResource("Light");
+	text = m_FrameGraph->AddResource("Text");
+
+	// The tasks are added in the order the frame used to run them in.
+
+	// Draining the event queue also updates the input metrics in the overlay.
+	task = m_FrameGraph->AddTask("Input", this, &ApplicationClass::ReadInput);
+	m_FrameGraph->Write(task, input);
+	m_FrameGraph->Write(task, registry);
+
+	// The cpu object adds a metric for each new thread it sees, so the stats also change the overlay's metric list.
+	task = m_FrameGraph->AddTask("Stats", this, &ApplicationClass::UpdateStats);
+	m_FrameGraph->Write(task, stats);
+	m_FrameGraph->Write(task, registry);
+
+	// Generating new heights bakes a new normal map, and the pacing keys change the limiter mode.  No task uses the
+	// device, the render thread may be drawing with it.
+	task = m_FrameGraph->AddTask("Handle Input", this, &ApplicationClass::HandleInput);
+	m_FrameGraph->Read(task, input);
+	m_FrameGraph->Write(task, terrain);
+	m_FrameGraph->Write(task, pacing);
+
+	task = m_FrameGraph->AddTask("Simulation", this, &ApplicationClass::SimulateFrame);
+	m_FrameGraph->Read(task, input);
+	m_FrameGraph->Write(task, position);
+
+	// The camera puts its position and rotation in the overlay.
+	task = m_FrameGraph->AddTask("Camera", this, &ApplicationClass::UpdateCamera);
+	m_FrameGraph->Read(task, position);
+	m_FrameGraph->Write(task, camera);
+	m_FrameGraph->Write(task, registry);
+
+	task = m_FrameGraph->AddTask("Light Map", this, &ApplicationClass::UpdateLightMap);
+	m_FrameGraph->Read(task, light);
+	m_FrameGraph->Write(task, terrain);
+
+	// The overlay formats every metric the tasks before it have set and clears their changed flags.
+	task = m_FrameGraph->AddTask("Overlay", this, &ApplicationClass::UpdateOverlay);
+	m_FrameGraph->Read(task, stats);
+	m_FrameGraph->Write(task, registry);
+	m_FrameGraph->Read(task, camera);
+	m_FrameGraph->Read(task, pacing);
+	m_FrameGraph->Write(task, text);
+
+	if(task < 0)
+	{
+		return false;
+	}
+
+	// Work out which tasks have to wait for which.
+	return m_FrameGraph->Compile();
+}
+
+
+bool ApplicationClass::BindActions()
+{
+	static const int bindings[][2] =
+	{
+		{ ACTION_QUIT, DIK_ESCAPE },
+		{ ACTION_GENERATE_TERRAIN, DIK_SPACE },
+		{ ACTION_SAVE_FRAME, DIK_F12 },
+		{ ACTION_FRAME_PACING, DIK_F11 },
+		{ ACTION_PROFILE_CAPTURE, DIK_F10 },
+		{ ACTION_TURN_LEFT, DIK_LEFT },
+		{ ACTION_TURN_RIGHT, DIK_RIGHT },
+		{ ACTION_MOVE_FORWARD, DIK_UP },
+		{ ACTION_MOVE_BACKWARD, DIK_DOWN },
+		{ ACTION_MOVE_UPWARD, DIK_A },
+		{ ACTION_MOVE_DOWNWARD, DIK_Z },
+		{ ACTION_LOOK_UPWARD, DIK_PGUP },
+		{ ACTION_LOOK_DOWNWARD, DIK_PGDN }
+	};
+	int i;
+	bool result;
+
+
+	for(i=0; i<(int)(sizeof(bindings) / sizeof(bindings[0])); i++)
+	{
+		result = m_Input->BindAction(bindings[i][0], bindings[i][1]);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
 	return true;
 }
 
 
 void ApplicationClass::Shutdown()
 {
+	// Release the render thread object first, it draws the frames it was given with the objects below.
+	if(m_RenderThread)
+	{
+		m_RenderThread->Shutdown();
+		delete m_RenderThread;
+		m_RenderThread = 0;
+	}
+
+	// Release the frame graph object.
+	if(m_FrameGraph)
+	{
+		m_FrameGraph->Shutdown();
+		delete m_FrameGraph;
+		m_FrameGraph = 0;
+	}
+
+	// Release the frame limiter object.
+	if(m_FrameLimiter)
+	{
+		m_FrameLimiter->Shutdown();
+		delete m_FrameLimiter;
+		m_FrameLimiter = 0;
+	}
+
+	// Release the ring buffer object.
+	if(m_RingBuffer)
+	{
+		m_RingBuffer->Shutdown();
+		delete m_RingBuffer;
+		m_RingBuffer = 0;
+	}
+
+	// Release the draw list object.
+	if(m_DrawList)
+	{
+		m_DrawList->Shutdown();
+		delete m_DrawList;
+		m_DrawList = 0;
+	}
+
 	// Release the light object.
 	if(m_Light)
 	{
@@ -255,17 +627,11 @@ void ApplicationClass::Shutdown()
 		m_FontShader = 0;
 	}
 
-	// Release the cpu object.
-	if(m_Cpu)
-	{
-		m_Cpu->Shutdown();
-		delete m_Cpu;
-		m_Cpu = 0;
-	}
-
-	// Release the fps object.
+	// Write the frame times out and release the fps object.
 	if(m_Fps)
 	{
+		m_Fps->SaveCsv(FRAME_STATS_FILE);
+		m_Fps->Shutdown();
 		delete m_Fps;
 		m_Fps = 0;
 	}
@@ -277,11 +643,11 @@ void ApplicationClass::Shutdown()
 		m_Position = 0;
 	}
 
-	// Release the timer object.
-	if(m_Timer)
+	// Release the clock object.
+	if(m_Clock)
 	{
-		delete m_Timer;
-		m_Timer = 0;
+		delete m_Clock;
+		m_Clock = 0;
 	}
 
 	// Release the terrain object.
@@ -299,22 +665,63 @@ void ApplicationClass::Shutdown()
 		m_Camera = 0;
 	}
 
-	// Release the Direct3D object.
-	if(m_Direct3D)
+	// Release the render device object.
+	if(m_Device)
 	{
-		m_Direct3D->Shutdown();
-		delete m_Direct3D;
-		m_Direct3D = 0;
+		m_Device->Shutdown();
+		delete m_Device;
+		m_Device = 0;
+		m_SoftwareDevice = 0;
 	}
 
-	// Release the input object.
+	// Let go of the input object, the window thread releases it.
 	if(m_Input)
 	{
-		m_Input->Shutdown();
-		delete m_Input;
+		m_Input->ClearActions();
+		m_Input->RemoveMetrics();
 		m_Input = 0;
 	}
 
+	// Release the job system object.
+	if(m_JobSystem)
+	{
+		m_JobSystem->Shutdown();
+		delete m_JobSystem;
+		m_JobSystem = 0;
+	}
+
+	// Release the cpu object.
+	if(m_Cpu)
+	{
+		m_Cpu->Shutdown();
+		delete m_Cpu;
+		m_Cpu = 0;
+	}
+
+	// Release the frame allocator object.
+	if(m_FrameAllocator)
+	{
+		m_FrameAllocator->Shutdown();
+		delete m_FrameAllocator;
+		m_FrameAllocator = 0;
+	}
+
+	// Release the stats overlay object.
+	if(m_StatsOverlay)
+	{
+		m_StatsOverlay->Shutdown();
+		delete m_StatsOverlay;
+		m_StatsOverlay = 0;
+	}
+
+	// Release the profiler object.
+	if(m_Profiler)
+	{
+		m_Profiler->Shutdown();
+		delete m_Profiler;
+		m_Profiler = 0;
+	}
+
 	return;
 }
 
@@ -324,169 +731,380 @@ bool ApplicationClass::Frame()
 	bool result;
 
 
-	// Read the user input.
-	result = m_Input->Frame();
+	// Gather the zones recorded during the last frame before this one starts.
+	m_Profiler->EndFrame();
+
+	PROFILE_ZONE("Frame");
+
+	// Mark the start of the frame and measure the time since the last one started.
+	m_Clock->Frame();
+
+	// Stop if the render thread could not draw the last frame.
+	if(m_RenderThread->HasFailed())
+	{
+		return false;
+	}
+
+	// Read the input, update the stats, simulation, camera, light map and overlay, each task runs as soon as the ones
+	// it depends on are done.
+	result = m_FrameGraph->Execute();
 	if(!result)
 	{
 		return false;
 	}
 	
 	// Check if the user pressed escape and wants to exit the application.
-	if(m_Input->IsEscapePressed() == true)
+	if(m_Input->WasActionPressed(ACTION_QUIT) == true)
 	{
 		return false;
 	}
 
-	// Update the system stats.
-	m_Timer->Frame();
-	m_Fps->Frame();
-	m_Cpu->Frame();
-
-	// Update the FPS value in the text object.
-	result = m_Text->SetFps(m_Fps->GetFps(), m_Direct3D->GetDeviceContext());
+	// Write any terrain changes to the device.
+	result = UploadTerrain();
 	if(!result)
 	{
 		return false;
 	}
-	
-	// Update the CPU usage value in the text object.
-	result = m_Text->SetCpu(m_Cpu->GetCpuPercentage(), m_Direct3D->GetDeviceContext());
+
+	// Hand the frame to the render thread and go on with the next one while it is drawn.
+	result = SubmitFrame();
 	if(!result)
 	{
 		return false;
 	}
 
-	// Do the frame input processing.
-	result = HandleInput(m_Timer->GetTime());
-	if(!result)
+	// Mark the end of the frame's work before waiting for the next one.
+	m_Clock->EndFrame();
+
+	// Switch the frame memory over, what this frame allocated stays valid through the next one.
+	m_FrameAllocator->EndFrame();
+
+	// Hold the frame until the pacing mode allows the next one to start.
+	m_FrameLimiter->Wait();
+
+	return result;
+}
+
+
+bool ApplicationClass::ReadInput()
+{
+	// Read the user input.
+	return m_Input->Frame();
+}
+
+
+bool ApplicationClass::UpdateStats()
+{
+	// Update the system stats, they put their own values in the stats overlay.
+	m_Fps->Frame(m_Clock->GetTime());
+	m_Cpu->Frame();
+	m_JobSystem->Frame();
+	m_RenderThread->Frame();
+
+	return true;
+}
+
+
+bool ApplicationClass::HandleInput()
+{
+	FramePacing mode;
+	bool result;
+
+
+	// Generate new terrain heights each time space is pressed, the new mesh is uploaded once the frame's tasks are done.
+	if(m_Input->WasActionPressed(ACTION_GENERATE_TERRAIN))
 	{
-		return false;
+		result = m_Terrain->GenerateHeightMap();
+		if(!result)
+		{
+			return false;
+		}
 	}
 
-	// Render the graphics.
-	result = RenderGraphics();
-	if(!result)
+	// Save the software frame to a bitmap each time F12 is pressed, the render thread saves it once it is drawn.
+	if(m_Input->WasActionPressed(ACTION_SAVE_FRAME) && m_SoftwareDevice)
 	{
-		return false;
+		m_saveFrame = true;
 	}
 
-	return result;
+	// Step to the next frame pacing mode each time F11 is pressed, vsync follows the mode from the next packet.
+	if(m_Input->WasActionPressed(ACTION_FRAME_PACING))
+	{
+		mode = (FramePacing)((m_FrameLimiter->GetMode() + 1) % FRAME_PACING_COUNT);
+		m_FrameLimiter->SetMode(mode);
+	}
+
+	// Capture the next frames to a trace file each time F10 is pressed.
+	if(m_Input->WasActionPressed(ACTION_PROFILE_CAPTURE) && !m_Profiler->IsCapturing())
+	{
+		m_Profiler->StartCapture(PROFILER_CAPTURE_FRAMES, PROFILER_TRACE_FILE);
+	}
+
+	return true;
 }
 
 
-bool ApplicationClass::HandleInput(float frameTime)
+bool ApplicationClass::SimulateFrame()
 {
-	bool keyDown, result;
-	float posX, posY, posZ, rotX, rotY, rotZ;
+	// Advance the simulation by however many fixed steps the frame time covers.
+	UpdateSimulation(m_Clock->GetTime(), m_Clock->GetFrameStart());
 
+	return true;
+}
 
-	// Set the frame time for calculating the updated position.
-	m_Position->SetFrameTime(frameTime);
 
-	// Handle the input.
-	keyDown = m_Input->IsSpacePressed();
-	m_Terrain->GenerateHeightMap(m_Direct3D->GetDevice(), keyDown);	
+void ApplicationClass::UpdateSimulation(float frameTime, long long frameStart)
+{
+	// Add the frame time to the time the simulation still has to catch up on.
+	m_simulationTime += frameTime;
 
-	keyDown = m_Input->IsLeftPressed();
-	m_Position->TurnLeft(keyDown);
+	// After a long frame only run a bounded number of steps and drop the rest so a slow frame can not snowball into slower ones.
+	if(m_simulationTime > m_simulationStep * (float)SIMULATION_MAX_STEPS)
+	{
+		m_simulationTime = m_simulationStep * (float)SIMULATION_MAX_STEPS;
+	}
 
-	keyDown = m_Input->IsRightPressed();
-	m_Position->TurnRight(keyDown);
+	// Every step is the same length so the same input always gives the same movement whatever the frame rate.  The
+	// simulation is behind the frame start by the time it still has to catch up on, so that is how far before the frame
+	// start each step ends.
+	while(m_simulationTime >= m_simulationStep)
+	{
+		m_simulationTime -= m_simulationStep;
+		StepSimulation(frameStart - ClockClass::FromMilliseconds(m_simulationTime));
+	}
+
+	return;
+}
 
-	keyDown = m_Input->IsUpPressed();
-	m_Position->MoveForward(keyDown);
 
-	keyDown = m_Input->IsDownPressed();
-	m_Position->MoveBackward(keyDown);
+void ApplicationClass::StepSimulation(long long endTime)
+{
+	// Remember where the viewer was at the end of the last step.
+	m_Position->SaveState();
 
-	keyDown = m_Input->IsAPressed();
-	m_Position->MoveUpward(keyDown);
+	// Set the step time for calculating the updated position.
+	m_Position->SetFrameTime(m_simulationStep);
 
-	keyDown = m_Input->IsZPressed();
-	m_Position->MoveDownward(keyDown);
+	// Take the key presses and releases that happened up to the end of the step.
+	m_Input->BeginStep(endTime);
 
-	keyDown = m_Input->IsPgUpPressed();
-	m_Position->LookUpward(keyDown);
+	// Handle the movement input, a key tapped and let go within the step still moves the viewer.
+	m_Position->TurnLeft(m_Input->IsStepActionActive(ACTION_TURN_LEFT));
+	m_Position->TurnRight(m_Input->IsStepActionActive(ACTION_TURN_RIGHT));
+	m_Position->MoveForward(m_Input->IsStepActionActive(ACTION_MOVE_FORWARD));
+	m_Position->MoveBackward(m_Input->IsStepActionActive(ACTION_MOVE_BACKWARD));
+	m_Position->MoveUpward(m_Input->IsStepActionActive(ACTION_MOVE_UPWARD));
+	m_Position->MoveDownward(m_Input->IsStepActionActive(ACTION_MOVE_DOWNWARD));
+	m_Position->LookUpward(m_Input->IsStepActionActive(ACTION_LOOK_UPWARD));
+	m_Position->LookDownward(m_Input->IsStepActionActive(ACTION_LOOK_DOWNWARD));
 
-	keyDown = m_Input->IsPgDownPressed();
-	m_Position->LookDownward(keyDown);
-	
-	// Get the view point position/rotation.
-	m_Position->GetPosition(posX, posY, posZ);
-	m_Position->GetRotation(rotX, rotY, rotZ);
+	return;
+}
+
+
+bool ApplicationClass::UpdateCamera()
+{
+	float posX, posY, posZ, rotX, rotY, rotZ, alpha;
+
+
+	// Work out how far the frame is between the last step and the next one.
+	alpha = m_simulationTime / m_simulationStep;
+
+	// Get the interpolated view point position/rotation.
+	m_Position->GetInterpolatedPosition(alpha, posX, posY, posZ);
+	m_Position->GetInterpolatedRotation(alpha, rotX, rotY, rotZ);
 
 	// Set the position of the camera.
 	m_Camera->SetPosition(posX, posY, posZ);
 	m_Camera->SetRotation(rotX, rotY, rotZ);
 
-	// Update the position values in the text object.
-	result = m_Text->SetCameraPosition(posX, posY, posZ, m_Direct3D->GetDeviceContext());
+	// Generate the view matrix based on the camera's position.
+	m_Camera->Render();
+
+	// Update the position and rotation values in the stats overlay.
+	StatsOverlayClass::SetCounter(m_cameraMetrics[0], (int)posX);
+	StatsOverlayClass::SetCounter(m_cameraMetrics[1], (int)posY);
+	StatsOverlayClass::SetCounter(m_cameraMetrics[2], (int)posZ);
+	StatsOverlayClass::SetCounter(m_cameraMetrics[3], (int)rotX);
+	StatsOverlayClass::SetCounter(m_cameraMetrics[4], (int)rotY);
+	StatsOverlayClass::SetCounter(m_cameraMetrics[5], (int)rotZ);
+
+	return true;
+}
+
+
+bool ApplicationClass::UpdateLightMap()
+{
+	// Bake the terrain light map again if the heights or the light direction have changed.
+	return m_Terrain->UpdateLightMap(m_Light->GetDirection());
+}
+
+
+bool ApplicationClass::UpdateOverlay()
+{
+	// Bring the overlay sentences up to date with the metrics that changed this frame.
+	return m_StatsOverlay->Frame(m_Text);
+}
+
+
+bool ApplicationClass::UploadTerrain()
+{
+	bool result;
+
+
+	if(!m_Terrain->IsUploadPending())
+	{
+		return true;
+	}
+
+	// The render thread has to be done with the old textures and mesh before they are changed.
+	m_RenderThread->Flush();
+
+	result = m_Terrain->Upload(m_Device);
 	if(!result)
 	{
 		return false;
 	}
 
-	// Update the rotation values in the text object.
-	result = m_Text->SetCameraRotation(rotX, rotY, rotZ, m_Direct3D->GetDeviceContext());
+	return true;
+}
+
+
+bool ApplicationClass::SubmitFrame()
+{
+	FramePacketType* packet;
+	FrameResultType frameResult;
+	bool result;
+
+
+	PROFILE_ZONE("Submit");
+
+	// Take the next packet, if the render thread is still drawing every earlier one this waits for it.
+	packet = m_RenderThread->BeginPacket();
+
+	// Put what the render thread counted while drawing the packet last time in the stats overlay.
+	if(m_RenderThread->GetResult(frameResult))
+	{
+		m_RingBuffer->UpdateMetrics(frameResult.ringBuffer);
+		m_Text->SetBytesUploaded(frameResult.textBytesUploaded, frameResult.textBytesSaved);
+	}
+
+	packet->startTime = m_Clock->GetFrameStart();
+	packet->inputTime = m_Input->GetInputTime();
+
+	// Get the world, view, projection, and ortho matrices from the camera and render device objects.
+	m_Device->GetWorldMatrix(packet->worldMatrix);
+	m_Camera->GetViewMatrix(packet->viewMatrix);
+	m_Device->GetProjectionMatrix(packet->projectionMatrix);
+	m_Device->GetOrthoMatrix(packet->orthoMatrix);
+
+	// Put the terrain buffers in an opaque draw packet.
+	memset(&packet->terrain, 0, sizeof(DrawPacketType));
+	packet->terrain.pass = DRAW_PASS_OPAQUE;
+	m_Terrain->Render(packet->terrain);
+
+	// Add the terrain textures and the light.
+	packet->normalMap = m_Terrain->GetNormalMap();
+	packet->lightMap = m_Terrain->GetLightMap();
+	packet->ambientColor = m_Light->GetAmbientColor();
+	packet->diffuseColor = m_Light->GetDiffuseColor();
+	packet->lightDirection = m_Light->GetDirection();
+
+	// Copy the text user interface, the sentences can change as soon as the packet is submitted.
+	result = m_Text->TakeSnapshot(packet->text);
 	if(!result)
 	{
 		return false;
 	}
 
+	packet->vsync = (m_FrameLimiter->GetMode() == FRAME_PACING_VSYNC);
+	packet->saveFrame = m_saveFrame;
+	m_saveFrame = false;
+
+	m_RenderThread->SubmitPacket();
+
 	return true;
 }
 
 
-bool ApplicationClass::RenderGraphics()
+bool ApplicationClass::RenderGraphics(const FramePacketType& frame, FrameResultType& frameResult)
 {
-	D3DXMATRIX worldMatrix, viewMatrix, projectionMatrix, orthoMatrix;
+	DrawPacketType packet;
 	bool result;
 
 
 	// Clear the scene.
-	m_Direct3D->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+	m_Device->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
 
-	// Generate the view matrix based on the camera's position.
-	m_Camera->Render();
-
-	// Get the world, view, projection, and ortho matrices from the camera and Direct3D objects.
-	m_Direct3D->GetWorldMatrix(worldMatrix);
-	m_Camera->GetViewMatrix(viewMatrix);
-	m_Direct3D->GetProjectionMatrix(projectionMatrix);
-	m_Direct3D->GetOrthoMatrix(orthoMatrix);
+	// Start recording a new frame of draws.
+	m_DrawList->Reset();
 
-	// Render the terrain buffers.
-	m_Terrain->Render(m_Direct3D->GetDeviceContext());
+	// Submit the terrain using the terrain shader.
+	packet = frame.terrain;
+	result = m_TerrainShader->Render(m_DrawList, packet, frame.worldMatrix, frame.viewMatrix, frame.projectionMatrix, 
+									 frame.normalMap, frame.lightMap, frame.ambientColor, frame.diffuseColor, frame.lightDirection);
+	if(!result)
+	{
+		return false;
+	}
 
-	// Render the terrain using the terrain shader.
-	result = m_TerrainShader->Render(m_Direct3D->GetDeviceContext(), m_Terrain->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix, 
-									 m_Light->GetAmbientColor(), m_Light->GetDiffuseColor(), m_Light->GetDirection());
+	// Submit the text user interface elements, they are drawn in the overlay pass with the Z buffer off and alpha blending on.
+	result = m_Text->Render(m_DrawList, m_FontShader, frame.worldMatrix, frame.orthoMatrix, m_RingBuffer, m_Device, frame.text,
+							frameResult.textBytesUploaded, frameResult.textBytesSaved);
 	if(!result)
 	{
 		return false;
 	}
 
-	// Turn off the Z buffer to begin all 2D rendering.
-	m_Direct3D->TurnZBufferOff();
-		
-	// Turn on the alpha blending before rendering the text.
-	m_Direct3D->TurnOnAlphaBlending();
+	// Sort the draws and render them with as few state changes as possible.
+	m_DrawList->Sort();
 
-	// Render the text user interface elements.
-	result = m_Text->Render(m_Direct3D->GetDeviceContext(), m_FontShader, worldMatrix, orthoMatrix);
+	result = m_DrawList->Execute(m_Device);
 	if(!result)
 	{
 		return false;
 	}
 
-	// Turn off alpha blending after rendering the text.
-	m_Direct3D->TurnOffAlphaBlending();
+	// Fence off this frame's part of the ring buffer now its draws have been sent.
+	m_RingBuffer->EndFrame(m_Device, frameResult.ringBuffer);
+
+	// Present the rendered scene to the screen, vsync follows the frame pacing mode the packet was made with.
+	m_Device->SetVSync(frame.vsync);
+	m_Device->EndScene();
 
-	// Turn the Z buffer back on now that all 2D rendering has completed.
-	m_Direct3D->TurnZBufferOn();
+	// The software device has no swap chain so copy its frame to the window.
+	if(m_SoftwareDevice)
+	{
+		PresentSoftwareFrame();
 
-	// Present the rendered scene to the screen.
-	m_Direct3D->EndScene();
+		if(frame.saveFrame)
+		{
+			m_SoftwareDevice->SaveFrame("frame.bmp");
+		}
+	}
 
 	return true;
+}
+
+
+void ApplicationClass::PresentSoftwareFrame()
+{
+	BITMAPINFO bitmapInfo;
+	HDC deviceContext;
+
+
+	// Describe the frame as a top down 32 bit bitmap.
+	memset(&bitmapInfo, 0, sizeof(BITMAPINFO));
+	bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bitmapInfo.bmiHeader.biWidth = m_screenWidth;
+	bitmapInfo.bmiHeader.biHeight = -m_screenHeight;
+	bitmapInfo.bmiHeader.biPlanes = 1;
+	bitmapInfo.bmiHeader.biBitCount = 32;
+	bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+	deviceContext = GetDC(m_hwnd);
+	SetDIBitsToDevice(deviceContext, 0, 0, m_screenWidth, m_screenHeight, 0, 0, 0, m_screenHeight, m_SoftwareDevice->GetFrameData(), &bitmapInfo, DIB_RGB_COLORS);
+	ReleaseDC(m_hwnd, deviceContext);
+
+	return;
 }
\ No newline at end of file
@@ -10,25 +10,73 @@
 /////////////
 const bool FULL_SCREEN = false;
 const bool VSYNC_ENABLED = true;
+const float FRAME_RATE_LIMIT = 60.0f;
+const char FRAME_STATS_FILE[] = "framestats.csv";
+const int PROFILER_CAPTURE_FRAMES = 120;
+const char PROFILER_TRACE_FILE[] = "profile.json";
 const float SCREEN_DEPTH = 1000.0f;
 const float SCREEN_NEAR = 0.1f;
+const bool NULL_RENDER_DEVICE = false;
+const bool SOFTWARE_RENDER_DEVICE = false;
+const int DRAW_LIST_PACKETS = 16384;
+const int FRAME_ALLOCATOR_SIZE = 1048576;
+const int DRAW_LIST_MEMORY = 8 * 1024 * 1024;
+const int RING_BUFFER_SIZE = 1024 * 1024;
+const int JOB_THREADS = 0;
+const float SIMULATION_RATE = 60.0f;
+const int SIMULATION_MAX_STEPS = 5;
 
 
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
 #include "inputclass.h"
+#include "renderdeviceclass.h"
 #include "d3dclass.h"
+#include "nulldeviceclass.h"
+#include "softwaredeviceclass.h"
 #include "cameraclass.h"
 #include "terrainclass.h"
-#include "timerclass.h"
+#include "clockclass.h"
 #include "positionclass.h"
 #include "fpsclass.h"
 #include "cpuclass.h"
+#include "jobsystemclass.h"
 #include "fontshaderclass.h"
 #include "textclass.h"
 #include "terrainshaderclass.h"
 #include "lightclass.h"
+#include "drawlistclass.h"
+#include "framelimiterclass.h"
+#include "profilerclass.h"
+#include "frameallocatorclass.h"
+#include "statsoverlayclass.h"
+#include "ringbufferclass.h"
+#include "framegraphclass.h"
+#include "renderthreadclass.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// The frame only asks the input object about actions, each is bound to its keys once.
+enum InputAction
+{
+	ACTION_QUIT,
+	ACTION_GENERATE_TERRAIN,
+	ACTION_SAVE_FRAME,
+	ACTION_FRAME_PACING,
+	ACTION_PROFILE_CAPTURE,
+	ACTION_TURN_LEFT,
+	ACTION_TURN_RIGHT,
+	ACTION_MOVE_FORWARD,
+	ACTION_MOVE_BACKWARD,
+	ACTION_MOVE_UPWARD,
+	ACTION_MOVE_DOWNWARD,
+	ACTION_LOOK_UPWARD,
+	ACTION_LOOK_DOWNWARD,
+	ACTION_COUNT
+};
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -41,27 +89,56 @@ public:
 	ApplicationClass(const ApplicationClass&);
 	~ApplicationClass();
 
-	bool Initialize(HINSTANCE, HWND, int, int);
+	bool Initialize(HWND, InputClass*, int, int);
 	void Shutdown();
 	bool Frame();
 
 private:
-	bool HandleInput(float);
-	bool RenderGraphics();
+	bool InitializeFrameGraph();
+	bool BindActions();
+
+	bool ReadInput();
+	bool UpdateStats();
+	bool HandleInput();
+	bool SimulateFrame();
+	void UpdateSimulation(float, long long);
+	void StepSimulation(long long);
+	bool UpdateCamera();
+	bool UpdateLightMap();
+	bool UpdateOverlay();
+	bool UploadTerrain();
+	bool SubmitFrame();
+	bool RenderGraphics(const FramePacketType&, FrameResultType&);
+	void PresentSoftwareFrame();
 
 private:
+	HWND m_hwnd;
+	int m_screenWidth, m_screenHeight;
 	InputClass* m_Input;
-	D3DClass* m_Direct3D;
+	RenderDeviceClass* m_Device;
+	SoftwareDeviceClass* m_SoftwareDevice;
 	CameraClass* m_Camera;
 	TerrainClass* m_Terrain;
-	TimerClass* m_Timer;
+	ClockClass* m_Clock;
 	PositionClass* m_Position;
 	FpsClass* m_Fps;
 	CpuClass* m_Cpu;
+	JobSystemClass* m_JobSystem;
 	FontShaderClass* m_FontShader;
 	TextClass* m_Text;
 	TerrainShaderClass* m_TerrainShader;
 	LightClass* m_Light;
+	DrawListClass* m_DrawList;
+	FrameLimiterClass* m_FrameLimiter;
+	ProfilerClass* m_Profiler;
+	FrameAllocatorClass* m_FrameAllocator;
+	StatsOverlayClass* m_StatsOverlay;
+	RingBufferClass* m_RingBuffer;
+	FrameGraphClass* m_FrameGraph;
+	RenderThreadClass* m_RenderThread;
+	int m_cameraMetrics[6];
+	bool m_saveFrame;
+	float m_simulationStep, m_simulationTime;
 };
 
 #endif
\ No newline at end of file
@@ -44,23 +44,23 @@ void CameraClass::SetRotation(float x, float y, float z)
 }
 
 
-D3DXVECTOR3 CameraClass::GetPosition()
+Vector3 CameraClass::GetPosition()
 {
-	return D3DXVECTOR3(m_positionX, m_positionY, m_positionZ);
+	return Vector3(m_positionX, m_positionY, m_positionZ);
 }
 
 
-D3DXVECTOR3 CameraClass::GetRotation()
+Vector3 CameraClass::GetRotation()
 {
-	return D3DXVECTOR3(m_rotationX, m_rotationY, m_rotationZ);
+	return Vector3(m_rotationX, m_rotationY, m_rotationZ);
 }
 
 
 void CameraClass::Render()
 {
-	D3DXVECTOR3 up, position, lookAt;
+	Vector3 up, position, lookAt;
 	float yaw, pitch, roll;
-	D3DXMATRIX rotationMatrix;
+	Matrix rotationMatrix;
 
 
 	// Setup the vector that points upwards.
@@ -84,23 +84,23 @@ void CameraClass::Render()
 	roll  = m_rotationZ * 0.0174532925f;
 
 	// Create the rotation matrix from the yaw, pitch, and roll values.
-	D3DXMatrixRotationYawPitchRoll(&rotationMatrix, yaw, pitch, roll);
+	MatrixRotationYawPitchRoll(&rotationMatrix, yaw, pitch, roll);
 
 	// Transform the lookAt and up vector by the rotation matrix so the view is correctly rotated at the origin.
-	D3DXVec3TransformCoord(&lookAt, &lookAt, &rotationMatrix);
-	D3DXVec3TransformCoord(&up, &up, &rotationMatrix);
+	Vec3TransformCoord(&lookAt, &lookAt, &rotationMatrix);
+	Vec3TransformCoord(&up, &up, &rotationMatrix);
 
 	// Translate the rotated camera position to the location of the viewer.
 	lookAt = position + lookAt;
 
 	// Finally create the view matrix from the three updated vectors.
-	D3DXMatrixLookAtLH(&m_viewMatrix, &position, &lookAt, &up);
+	MatrixLookAtLH(&m_viewMatrix, &position, &lookAt, &up);
 
 	return;
 }
 
 
-void CameraClass::GetViewMatrix(D3DXMATRIX& viewMatrix)
+void CameraClass::GetViewMatrix(Matrix& viewMatrix)
 {
 	viewMatrix = m_viewMatrix;
 	return;
@@ -5,10 +5,10 @@
 #define _CAMERACLASS_H_
 
 
-//////////////
-// INCLUDES //
-//////////////
-#include <d3dx10math.h>
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mathclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -24,16 +24,16 @@ public:
 	void SetPosition(float, float, float);
 	void SetRotation(float, float, float);
 
-	D3DXVECTOR3 GetPosition();
-	D3DXVECTOR3 GetRotation();
+	Vector3 GetPosition();
+	Vector3 GetRotation();
 
 	void Render();
-	void GetViewMatrix(D3DXMATRIX&);
+	void GetViewMatrix(Matrix&);
 
 private:
 	float m_positionX, m_positionY, m_positionZ;
 	float m_rotationX, m_rotationY, m_rotationZ;
-	D3DXMATRIX m_viewMatrix;
+	Matrix m_viewMatrix;
 };
 
 #endif
\ No newline at end of file
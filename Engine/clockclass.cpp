@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+// Filename: clockclass.cpp
+///////////////////////////////////////////////////////////////////////////////
+#include "clockclass.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+
+// Read once before main so every thread can take timestamps without setting anything up.
+long long ClockClass::m_frequency = ClockClass::ReadFrequency();
+
+
+ClockClass::ClockClass()
+{
+	m_frameStart = 0;
+	m_frameEnd = 0;
+	m_frameTime = 0;
+}
+
+
+ClockClass::ClockClass(const ClockClass& other)
+{
+}
+
+
+ClockClass::~ClockClass()
+{
+}
+
+
+bool ClockClass::Initialize()
+{
+	// Check to see if this system supports high performance timers.
+	if(m_frequency == 0)
+	{
+		return false;
+	}
+
+	m_frameStart = GetTimestamp();
+	m_frameEnd = m_frameStart;
+
+	return true;
+}
+
+
+void ClockClass::Frame()
+{
+	long long currentTime;
+
+
+	// The frame time runs from the start of the last frame to the start of this one.
+	currentTime = GetTimestamp();
+	m_frameTime = currentTime - m_frameStart;
+	m_frameStart = currentTime;
+
+	return;
+}
+
+
+void ClockClass::EndFrame()
+{
+	m_frameEnd = GetTimestamp();
+	return;
+}
+
+
+float ClockClass::GetTime()
+{
+	return ToMilliseconds(m_frameTime);
+}
+
+
+long long ClockClass::GetFrameTime()
+{
+	return m_frameTime;
+}
+
+
+long long ClockClass::GetFrameStart()
+{
+	return m_frameStart;
+}
+
+
+long long ClockClass::GetFrameEnd()
+{
+	return m_frameEnd;
+}
+
+
+long long ClockClass::GetTimestamp()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+
+
+	QueryPerformanceCounter(&counter);
+
+	// Split the conversion so the multiply cannot overflow however long the machine has been running.
+	return (counter.QuadPart / m_frequency) * 1000000000LL + (counter.QuadPart % m_frequency) * 1000000000LL / m_frequency;
+#else
+	struct timespec time;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (long long)time.tv_sec * 1000000000LL + time.tv_nsec;
+#endif
+}
+
+
+float ClockClass::ToMilliseconds(long long time)
+{
+	return (float)((double)time / 1000000.0);
+}
+
+
+long long ClockClass::FromMilliseconds(float time)
+{
+	return (long long)((double)time * 1000000.0);
+}
+
+
+long long ClockClass::ReadFrequency()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+
+
+	if(!QueryPerformanceFrequency(&frequency))
+	{
+		return 0;
+	}
+
+	return frequency.QuadPart;
+#else
+	return 1000000000LL;
+#endif
+}
@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: clockclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _CLOCKCLASS_H_
+#define _CLOCKCLASS_H_
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ClockClass
+////////////////////////////////////////////////////////////////////////////////
+class ClockClass
+{
+public:
+	ClockClass();
+	ClockClass(const ClockClass&);
+	~ClockClass();
+
+	bool Initialize();
+	void Frame();
+	void EndFrame();
+
+	float GetTime();
+	long long GetFrameTime();
+	long long GetFrameStart();
+	long long GetFrameEnd();
+
+	// Timestamps are monotonic nanoseconds from an unspecified start and can be compared across threads.
+	static long long GetTimestamp();
+	static float ToMilliseconds(long long);
+	static long long FromMilliseconds(float);
+
+private:
+	static long long ReadFrequency();
+
+private:
+	static long long m_frequency;
+
+	long long m_frameStart, m_frameEnd;
+	long long m_frameTime;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: StopwatchClass
+////////////////////////////////////////////////////////////////////////////////
+class StopwatchClass
+{
+public:
+	StopwatchClass()
+	{
+		Start();
+	}
+
+	void Start()
+	{
+		m_startTime = ClockClass::GetTimestamp();
+	}
+
+	long long GetElapsed()
+	{
+		return ClockClass::GetTimestamp() - m_startTime;
+	}
+
+	float GetMilliseconds()
+	{
+		return ClockClass::ToMilliseconds(GetElapsed());
+	}
+
+	// Returns the milliseconds since the last start and starts again from now, for timing one step after another.
+	float Lap()
+	{
+		long long currentTime;
+		float time;
+
+
+		currentTime = ClockClass::GetTimestamp();
+		time = ClockClass::ToMilliseconds(currentTime - m_startTime);
+		m_startTime = currentTime;
+
+		return time;
+	}
+
+private:
+	long long m_startTime;
+};
+
+#endif
@@ -2,10 +2,53 @@
 // Filename: cpuclass.cpp
 ///////////////////////////////////////////////////////////////////////////////
 #include "cpuclass.h"
+#include "clockclass.h"
+#include "statsoverlayclass.h"
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+
+CpuClass* CpuClass::m_instance = 0;
 
 
 CpuClass::CpuClass()
 {
+	int i;
+
+
+	m_canReadCpu = false;
+#ifdef _WIN32
+	m_queryHandle = 0;
+	m_counterHandle = 0;
+	m_coreCounterHandle = 0;
+	m_coreItems = 0;
+	m_coreItemsSize = 0;
+#else
+	memset(m_lastBusy, 0, sizeof(m_lastBusy));
+	memset(m_lastTotal, 0, sizeof(m_lastTotal));
+#endif
+	m_lastSampleTime = 0;
+	m_lastProcessUser = 0;
+	m_lastProcessSystem = 0;
+	m_cpuUsage = 0;
+	memset(&m_usage, 0, sizeof(UsageType));
+
+	for(i=0; i<CPU_MAX_THREADS; i++)
+	{
+		m_threads[i].inUse = false;
+	}
+	m_groupCount = 0;
+	m_mainThread = -1;
+
+	for(i=0; i<3; i++)
+	{
+		m_metrics[i] = -1;
+	}
+	m_coreMetricCount = 0;
+	m_threadMetricCount = 0;
 }
 
 
@@ -21,6 +64,7 @@ CpuClass::~CpuClass()
 
 void CpuClass::Initialize()
 {
+#ifdef _WIN32
 	PDH_STATUS status;
 
 
@@ -41,20 +85,86 @@ void CpuClass::Initialize()
 		m_canReadCpu = false;
 	}
 
+	// Set query object to poll each cpu on its own as well.
+	status = PdhAddCounter(m_queryHandle, TEXT("\\Processor(*)\\% processor time"), 0, &m_coreCounterHandle);
+	if(status != ERROR_SUCCESS)
+	{
+		m_canReadCpu = false;
+	}
+#else
+	// The proc file system has the system and process times, if it is not mounted then only the threads are counted.
+	m_canReadCpu = true;
+#endif
+
+	// Take the starting times so the first sample covers the first second, a rate counter needs two samples before it
+	// has a value.
+	SampleSystem();
+	SampleProcess(0.0);
+
 	// Initialize the start time and cpu usage.
-	m_lastSampleTime = GetTickCount(); 
+	m_lastSampleTime = ClockClass::GetTimestamp();
 	m_cpuUsage = 0;
 
+	// The calling thread is the main thread and is counted for as long as the class is running.
+	m_instance = this;
+	m_mainThread = BeginThread("Main");
+
+	// Show the usage in the stats overlay, the cores and threads are added once they have been sampled.
+	m_metrics[0] = StatsOverlayClass::AddCounter("Cpu", "Total", "%");
+	m_metrics[1] = StatsOverlayClass::AddCounter("Cpu", "Process user", "%");
+	m_metrics[2] = StatsOverlayClass::AddCounter("Cpu", "Process system", "%");
+
 	return;
 }
 
 
 void CpuClass::Shutdown()
 {
-	if(m_canReadCpu)
+	int i;
+
+
+	// Take the cpu metrics off the overlay.
+	for(i=0; i<3; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
+	for(i=0; i<m_coreMetricCount; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_coreMetrics[i]);
+	}
+
+	for(i=0; i<m_threadMetricCount; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_threadMetrics[i]);
+	}
+
+	m_coreMetricCount = 0;
+	m_threadMetricCount = 0;
+
+	// Stop counting the main thread, every other thread has finished by now.
+	if(m_mainThread >= 0)
+	{
+		EndThread(m_mainThread);
+		m_mainThread = -1;
+	}
+
+	m_instance = 0;
+
+#ifdef _WIN32
+	if(m_queryHandle)
 	{
 		PdhCloseQuery(m_queryHandle);
+		m_queryHandle = 0;
+	}
+
+	if(m_coreItems)
+	{
+		delete [] (char*)m_coreItems;
+		m_coreItems = 0;
 	}
+#endif
 
 	return;
 }
@@ -62,22 +172,27 @@ void CpuClass::Shutdown()
 
 void CpuClass::Frame()
 {
-	PDH_FMT_COUNTERVALUE value; 
+	long long currentTime;
+	double elapsedTime;
 
-	if(m_canReadCpu)
+
+	// If it has been 1 second then update the current cpu usage and reset the 1 second timer again.
+	currentTime = ClockClass::GetTimestamp();
+	elapsedTime = ClockClass::ToMilliseconds(currentTime - m_lastSampleTime);
+	if(elapsedTime < CPU_SAMPLE_PERIOD)
 	{
-		// If it has been 1 second then update the current cpu usage and reset the 1 second timer again.
-		if((m_lastSampleTime + 1000) < GetTickCount())
-		{
-			m_lastSampleTime = GetTickCount(); 
+		return;
+	}
 
-			PdhCollectQueryData(m_queryHandle);
-        
-			PdhGetFormattedCounterValue(m_counterHandle, PDH_FMT_LONG, NULL, &value);
+	m_lastSampleTime = currentTime;
 
-			m_cpuUsage = value.longValue;
-		}
-	}
+	SampleSystem();
+	SampleProcess(elapsedTime);
+	SampleThreads(elapsedTime);
+
+	m_cpuUsage = (long)m_usage.total;
+
+	UpdateMetrics();
 
 	return;
 }
@@ -99,4 +214,424 @@ int CpuClass::GetCpuPercentage()
 	}
 
 	return usage;
-}
\ No newline at end of file
+}
+
+
+void CpuClass::GetUsage(UsageType& usage)
+{
+	usage = m_usage;
+	return;
+}
+
+
+int CpuClass::BeginThread(const char* name)
+{
+	CpuClass* cpu;
+	int i, thread, group;
+
+
+	cpu = m_instance;
+	if(!cpu)
+	{
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> lock(cpu->m_threadMutex);
+
+	// A thread that is already being counted keeps the name it started with.
+	thread = -1;
+	for(i=0; i<CPU_MAX_THREADS; i++)
+	{
+		if(cpu->m_threads[i].inUse)
+		{
+			if(cpu->m_threads[i].id == std::this_thread::get_id())
+			{
+				return -1;
+			}
+		}
+		else if(thread < 0)
+		{
+			thread = i;
+		}
+	}
+
+	group = cpu->FindGroup(name);
+	if((thread < 0) || (group < 0))
+	{
+		return -1;
+	}
+
+	// Keep a handle to the thread so its time can be read from the main thread while it runs.
+#ifdef _WIN32
+	if(!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &cpu->m_threads[thread].handle,
+						THREAD_QUERY_LIMITED_INFORMATION, FALSE, 0))
+	{
+		return -1;
+	}
+#else
+	if(pthread_getcpuclockid(pthread_self(), &cpu->m_threads[thread].clock) != 0)
+	{
+		return -1;
+	}
+#endif
+
+	cpu->m_threads[thread].id = std::this_thread::get_id();
+	cpu->m_threads[thread].group = group;
+	cpu->m_threads[thread].startTime = GetThreadTime(cpu->m_threads[thread]);
+	cpu->m_threads[thread].inUse = true;
+
+	return thread;
+}
+
+
+void CpuClass::EndThread(int thread)
+{
+	CpuClass* cpu;
+	ThreadEntryType* entry;
+
+
+	cpu = m_instance;
+	if(!cpu)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(cpu->m_threadMutex);
+
+	// Move the thread's time into its group before the thread and its handle go away.
+	entry = &cpu->m_threads[thread];
+	cpu->m_groups[entry->group].finishedTime += GetThreadTime(*entry) - entry->startTime;
+
+#ifdef _WIN32
+	CloseHandle(entry->handle);
+#endif
+	entry->inUse = false;
+
+	return;
+}
+
+
+void CpuClass::SampleSystem()
+{
+#ifdef _WIN32
+	DWORD bufferSize, itemCount, i;
+	PDH_FMT_COUNTERVALUE value;
+	PDH_STATUS status;
+
+
+	if(!m_canReadCpu)
+	{
+		return;
+	}
+
+	PdhCollectQueryData(m_queryHandle);
+
+	status = PdhGetFormattedCounterValue(m_counterHandle, PDH_FMT_LONG, NULL, &value);
+	if(status != ERROR_SUCCESS)
+	{
+		return;
+	}
+
+	m_usage.total = (float)value.longValue;
+
+	// Read the counter for every core, growing the item buffer the first time it is too small.
+	bufferSize = m_coreItemsSize;
+	status = PdhGetFormattedCounterArray(m_coreCounterHandle, PDH_FMT_DOUBLE, &bufferSize, &itemCount, m_coreItems);
+	if(status == PDH_MORE_DATA)
+	{
+		if(m_coreItems)
+		{
+			delete [] (char*)m_coreItems;
+		}
+
+		m_coreItems = (PDH_FMT_COUNTERVALUE_ITEM*)new char[bufferSize];
+		m_coreItemsSize = bufferSize;
+		status = PdhGetFormattedCounterArray(m_coreCounterHandle, PDH_FMT_DOUBLE, &bufferSize, &itemCount, m_coreItems);
+	}
+
+	m_usage.coreCount = 0;
+	if(status != ERROR_SUCCESS)
+	{
+		return;
+	}
+
+	// The array also has the total, which is already counted.
+	for(i=0; (i<itemCount) && (m_usage.coreCount<CPU_MAX_CORES); i++)
+	{
+		if(m_coreItems[i].szName[0] != TEXT('_'))
+		{
+			m_usage.cores[m_usage.coreCount] = (float)m_coreItems[i].FmtValue.doubleValue;
+			m_usage.coreCount++;
+		}
+	}
+#else
+	FILE* file;
+	char line[256];
+	unsigned long long user, nice, system, idle, iowait, irq, softirq, steal, busy, total;
+	int core, index;
+
+
+	if(!m_canReadCpu)
+	{
+		return;
+	}
+
+	// Each cpu line has the time it spent in each state since boot, the first line is all of them together.
+	file = fopen("/proc/stat", "r");
+	if(!file)
+	{
+		m_canReadCpu = false;
+		return;
+	}
+
+	m_usage.coreCount = 0;
+	while(fgets(line, sizeof(line), file))
+	{
+		if(strncmp(line, "cpu", 3) != 0)
+		{
+			break;
+		}
+
+		steal = 0;
+		if(line[3] == ' ')
+		{
+			index = 0;
+			if(sscanf(line + 3, "%llu %llu %llu %llu %llu %llu %llu %llu", &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal) < 7)
+			{
+				continue;
+			}
+		}
+		else
+		{
+			if(sscanf(line + 3, "%d %llu %llu %llu %llu %llu %llu %llu %llu", &core, &user, &nice, &system, &idle, &iowait, &irq, &softirq,
+					  &steal) < 8)
+			{
+				continue;
+			}
+
+			if(m_usage.coreCount >= CPU_MAX_CORES)
+			{
+				continue;
+			}
+
+			index = m_usage.coreCount + 1;
+		}
+
+		// Waiting on the disk counts as idle.
+		busy = user + nice + system + irq + softirq + steal;
+		total = busy + idle + iowait;
+
+		if(index == 0)
+		{
+			m_usage.total = (total > m_lastTotal[0]) ? 100.0f * (float)(busy - m_lastBusy[0]) / (float)(total - m_lastTotal[0]) : 0.0f;
+		}
+		else
+		{
+			m_usage.cores[index - 1] = (total > m_lastTotal[index]) ? 100.0f * (float)(busy - m_lastBusy[index]) / (float)(total - m_lastTotal[index]) : 0.0f;
+			m_usage.coreCount++;
+		}
+
+		m_lastBusy[index] = busy;
+		m_lastTotal[index] = total;
+	}
+
+	fclose(file);
+#endif
+
+	return;
+}
+
+
+void CpuClass::SampleProcess(double elapsedTime)
+{
+	long long userTime, systemTime;
+#ifdef _WIN32
+	FILETIME creationTime, exitTime, kernelTime, userFileTime;
+
+
+	// The process times are in 100 nanosecond units.
+	if(!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userFileTime))
+	{
+		return;
+	}
+
+	userTime = (((long long)userFileTime.dwHighDateTime << 32) | userFileTime.dwLowDateTime) * 100;
+	systemTime = (((long long)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime) * 100;
+#else
+	FILE* file;
+	char line[1024];
+	char* fields;
+	unsigned long long userTicks, systemTicks;
+	long ticksPerSecond;
+
+
+	file = fopen("/proc/self/stat", "r");
+	if(!file)
+	{
+		return;
+	}
+
+	if(!fgets(line, sizeof(line), file))
+	{
+		fclose(file);
+		return;
+	}
+
+	fclose(file);
+
+	// The process name is in brackets and can hold spaces, so start after the last bracket.  The user and system
+	// times are the twelfth and thirteenth fields from there.
+	fields = strrchr(line, ')');
+	if(!fields)
+	{
+		return;
+	}
+
+	if(sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &userTicks, &systemTicks) != 2)
+	{
+		return;
+	}
+
+	ticksPerSecond = sysconf(_SC_CLK_TCK);
+	userTime = (long long)(userTicks * (1000000000ULL / ticksPerSecond));
+	systemTime = (long long)(systemTicks * (1000000000ULL / ticksPerSecond));
+#endif
+
+	if(elapsedTime > 0.0)
+	{
+		m_usage.processUser = (float)((userTime - m_lastProcessUser) / (elapsedTime * 10000.0));
+		m_usage.processSystem = (float)((systemTime - m_lastProcessSystem) / (elapsedTime * 10000.0));
+	}
+
+	m_lastProcessUser = userTime;
+	m_lastProcessSystem = systemTime;
+
+	return;
+}
+
+
+void CpuClass::SampleThreads(double elapsedTime)
+{
+	long long groupTime[CPU_MAX_THREAD_GROUPS];
+	int i;
+
+
+	std::lock_guard<std::mutex> lock(m_threadMutex);
+
+	// Each group's time is the time of its finished threads plus the time so far of the ones still running.
+	for(i=0; i<m_groupCount; i++)
+	{
+		groupTime[i] = m_groups[i].finishedTime;
+	}
+
+	for(i=0; i<CPU_MAX_THREADS; i++)
+	{
+		if(m_threads[i].inUse)
+		{
+			groupTime[m_threads[i].group] += GetThreadTime(m_threads[i]) - m_threads[i].startTime;
+		}
+	}
+
+	for(i=0; i<m_groupCount; i++)
+	{
+		m_usage.threads[i].name = m_groups[i].name;
+		m_usage.threads[i].usage = (float)((groupTime[i] - m_groups[i].lastTime) / (elapsedTime * 10000.0));
+		m_groups[i].lastTime = groupTime[i];
+	}
+
+	m_usage.threadCount = m_groupCount;
+
+	return;
+}
+
+
+int CpuClass::FindGroup(const char* name)
+{
+	int i;
+
+
+	for(i=0; i<m_groupCount; i++)
+	{
+		if(strcmp(m_groups[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+
+	if(m_groupCount == CPU_MAX_THREAD_GROUPS)
+	{
+		return -1;
+	}
+
+	m_groups[m_groupCount].name = name;
+	m_groups[m_groupCount].finishedTime = 0;
+	m_groups[m_groupCount].lastTime = 0;
+	m_groupCount++;
+
+	return m_groupCount - 1;
+}
+
+
+long long CpuClass::GetThreadTime(const ThreadEntryType& thread)
+{
+#ifdef _WIN32
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+
+
+	// The thread times are in 100 nanosecond units.
+	if(!GetThreadTimes(thread.handle, &creationTime, &exitTime, &kernelTime, &userTime))
+	{
+		return 0;
+	}
+
+	return ((((long long)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime) +
+			(((long long)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime)) * 100;
+#else
+	struct timespec time;
+
+
+	if(clock_gettime(thread.clock, &time) != 0)
+	{
+		return 0;
+	}
+
+	return (long long)time.tv_sec * 1000000000LL + time.tv_nsec;
+#endif
+}
+
+
+void CpuClass::UpdateMetrics()
+{
+	char name[16];
+	int i;
+
+
+	// Add a metric for each core and thread group the first time it is sampled, they are never taken away.
+	for(; m_coreMetricCount<m_usage.coreCount; m_coreMetricCount++)
+	{
+		sprintf(name, "Core %d", m_coreMetricCount);
+		m_coreMetrics[m_coreMetricCount] = StatsOverlayClass::AddCounter("Cpu cores", name, "%");
+	}
+
+	for(; m_threadMetricCount<m_usage.threadCount; m_threadMetricCount++)
+	{
+		m_threadMetrics[m_threadMetricCount] = StatsOverlayClass::AddCounter("Cpu threads", m_usage.threads[m_threadMetricCount].name, "%");
+	}
+
+	// The process and thread usage is of one core, so a process keeping four cores busy shows 400.
+	StatsOverlayClass::SetCounter(m_metrics[0], GetCpuPercentage());
+	StatsOverlayClass::SetCounter(m_metrics[1], (int)m_usage.processUser);
+	StatsOverlayClass::SetCounter(m_metrics[2], (int)m_usage.processSystem);
+
+	for(i=0; i<m_usage.coreCount; i++)
+	{
+		StatsOverlayClass::SetCounter(m_coreMetrics[i], (int)m_usage.cores[i]);
+	}
+
+	for(i=0; i<m_usage.threadCount; i++)
+	{
+		StatsOverlayClass::SetCounter(m_threadMetrics[i], (int)m_usage.threads[i].usage);
+	}
+
+	return;
+}
@@ -8,13 +8,32 @@
 /////////////
 // LINKING //
 /////////////
+#ifdef _WIN32
 #pragma comment(lib, "pdh.lib")
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int CPU_MAX_CORES = 64;
+const int CPU_MAX_THREADS = 64;
+const int CPU_MAX_THREAD_GROUPS = 8;
+const float CPU_SAMPLE_PERIOD = 1000.0f;
 
 
 //////////////
 // INCLUDES //
 //////////////
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
 #include <pdh.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -22,6 +41,45 @@
 ///////////////////////////////////////////////////////////////////////////////
 class CpuClass
 {
+public:
+	struct ThreadType
+	{
+		const char* name;
+		float usage;
+	};
+
+	// The system and core usage is the percentage of each core that was busy, the process and thread usage is the
+	// percentage of one core so a process keeping four cores busy shows 400.  Threads are grouped by name.
+	struct UsageType
+	{
+		float total;
+		float cores[CPU_MAX_CORES];
+		int coreCount;
+		float processUser, processSystem;
+		ThreadType threads[CPU_MAX_THREAD_GROUPS];
+		int threadCount;
+	};
+
+private:
+	struct GroupType
+	{
+		const char* name;
+		long long finishedTime, lastTime;
+	};
+
+	struct ThreadEntryType
+	{
+		bool inUse;
+		std::thread::id id;
+		int group;
+		long long startTime;
+#ifdef _WIN32
+		HANDLE handle;
+#else
+		clockid_t clock;
+#endif
+	};
+
 public:
 	CpuClass();
 	CpuClass(const CpuClass&);
@@ -31,13 +89,72 @@ public:
 	void Shutdown();
 	void Frame();
 	int GetCpuPercentage();
+	void GetUsage(UsageType&);
+
+	static int BeginThread(const char*);
+	static void EndThread(int);
+
+private:
+	void SampleSystem();
+	void SampleProcess(double);
+	void SampleThreads(double);
+	int FindGroup(const char*);
+	void UpdateMetrics();
+
+	static long long GetThreadTime(const ThreadEntryType&);
 
 private:
+	static CpuClass* m_instance;
+
 	bool m_canReadCpu;
+#ifdef _WIN32
 	HQUERY m_queryHandle;
-	HCOUNTER m_counterHandle;
-	unsigned long m_lastSampleTime;
+	HCOUNTER m_counterHandle, m_coreCounterHandle;
+	PDH_FMT_COUNTERVALUE_ITEM* m_coreItems;
+	DWORD m_coreItemsSize;
+#else
+	unsigned long long m_lastBusy[CPU_MAX_CORES + 1], m_lastTotal[CPU_MAX_CORES + 1];
+#endif
+	long long m_lastSampleTime;
+	long long m_lastProcessUser, m_lastProcessSystem;
 	long m_cpuUsage;
+	UsageType m_usage;
+
+	std::mutex m_threadMutex;
+	ThreadEntryType m_threads[CPU_MAX_THREADS];
+	GroupType m_groups[CPU_MAX_THREAD_GROUPS];
+	int m_groupCount;
+	int m_mainThread;
+
+	int m_metrics[3];
+	int m_coreMetrics[CPU_MAX_CORES];
+	int m_threadMetrics[CPU_MAX_THREAD_GROUPS];
+	int m_coreMetricCount, m_threadMetricCount;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Class name: CpuThreadClass
+///////////////////////////////////////////////////////////////////////////////
+class CpuThreadClass
+{
+public:
+	CpuThreadClass(const char* name)
+	{
+		m_thread = CpuClass::BeginThread(name);
+	}
+
+	~CpuThreadClass()
+	{
+		// A thread that was already being counted, such as the main thread running a worker's share itself, stays counted.
+		if(m_thread >= 0)
+		{
+			CpuClass::EndThread(m_thread);
+		}
+	}
+
+private:
+	int m_thread;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,89 @@
 // Filename: d3dclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "d3dclass.h"
+#include "profilerclass.h"
+#include "clockclass.h"
+#include <stdio.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Direct3D 11 resources behind the render device handles.
+////////////////////////////////////////////////////////////////////////////////
+class D3DBuffer : public RenderBuffer
+{
+public:
+	void Release()
+	{
+		buffer->Release();
+		delete this;
+	}
+
+	ID3D11Buffer* buffer;
+};
+
+class D3DTexture : public RenderTexture
+{
+public:
+	void Release()
+	{
+		view->Release();
+		if(texture)
+		{
+			texture->Release();
+		}
+		delete this;
+	}
+
+	ID3D11Texture2D* texture;
+	ID3D11ShaderResourceView* view;
+};
+
+class D3DShader : public RenderProgram
+{
+public:
+	void Release()
+	{
+		if(vertexShader)
+		{
+			vertexShader->Release();
+		}
+		if(pixelShader)
+		{
+			pixelShader->Release();
+		}
+		delete [] byteCode;
+		delete this;
+	}
+
+	ID3D11VertexShader* vertexShader;
+	ID3D11PixelShader* pixelShader;
+	char* byteCode;
+	int byteCodeSize;
+};
+
+class D3DInputLayout : public RenderInputLayout
+{
+public:
+	void Release()
+	{
+		layout->Release();
+		delete this;
+	}
+
+	ID3D11InputLayout* layout;
+};
+
+class D3DSampler : public RenderSampler
+{
+public:
+	void Release()
+	{
+		sampleState->Release();
+		delete this;
+	}
+
+	ID3D11SamplerState* sampleState;
+};
 
 
 D3DClass::D3DClass()
@@ -17,6 +100,14 @@ D3DClass::D3DClass()
 	m_depthDisabledStencilState = 0;
 	m_alphaEnableBlendingState = 0;
 	m_alphaDisableBlendingState = 0;
+	m_ShaderCache = 0;
+
+	for(int i=0; i<D3D_MAX_FENCES; i++)
+	{
+		m_fenceQueries[i] = 0;
+	}
+	m_fenceValue = 0;
+	m_completedFence = 0;
 }
 
 
@@ -49,14 +140,31 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
 	D3D11_RASTERIZER_DESC rasterDesc;
 	D3D11_VIEWPORT viewport;
-	float fieldOfView, screenAspect;
 	D3D11_DEPTH_STENCIL_DESC depthDisabledStencilDesc;
 	D3D11_BLEND_DESC blendStateDescription;
+	D3D11_QUERY_DESC queryDesc;
+
 
+	// Store the window handle for reporting shader errors.
+	m_hwnd = hwnd;
 
 	// Store the vsync setting.
 	m_vsync_enabled = vsync;
 
+	// Create the shader cache object.
+	m_ShaderCache = new ShaderCacheClass;
+	if(!m_ShaderCache)
+	{
+		return false;
+	}
+
+	// Map the compiled shaders saved by earlier runs.
+	result = m_ShaderCache->Initialize(SHADER_CACHE_FILE);
+	if(!result)
+	{
+		return false;
+	}
+
 	// Create a DirectX graphics interface factory.
 	result = CreateDXGIFactory(__uuidof(IDXGIFactory), (void**)&factory);
 	if(FAILED(result))
@@ -376,18 +484,11 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	// Create the viewport.
     m_deviceContext->RSSetViewports(1, &viewport);
 
-	// Setup the projection matrix.
-	fieldOfView = (float)D3DX_PI / 4.0f;
-	screenAspect = (float)screenWidth / (float)screenHeight;
-
-	// Create the projection matrix for 3D rendering.
-	D3DXMatrixPerspectiveFovLH(&m_projectionMatrix, fieldOfView, screenAspect, screenNear, screenDepth);
+	// Every draw is an indexed triangle list so the topology only needs setting once.
+	m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    // Initialize the world matrix to the identity matrix.
-    D3DXMatrixIdentity(&m_worldMatrix);
-
-	// Create an orthographic projection matrix for 2D rendering.
-	D3DXMatrixOrthoLH(&m_orthoMatrix, (float)screenWidth, (float)screenHeight, screenNear, screenDepth);
+	// Create the projection, world and ortho matrices.
+	InitializeMatrices(screenWidth, screenHeight, screenDepth, screenNear);
 
 	// Clear the second depth stencil state before setting the parameters.
 	ZeroMemory(&depthDisabledStencilDesc, sizeof(depthDisabledStencilDesc));
@@ -449,6 +550,19 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 		return false;
 	}
 
+	// Create the event queries used as fences, they are reused in turn.
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	queryDesc.MiscFlags = 0;
+
+	for(i=0; i<D3D_MAX_FENCES; i++)
+	{
+		result = m_device->CreateQuery(&queryDesc, &m_fenceQueries[i]);
+		if(FAILED(result))
+		{
+			return false;
+		}
+	}
+
     return true;
 }
 
@@ -461,6 +575,24 @@ void D3DClass::Shutdown()
 		m_swapChain->SetFullscreenState(false, NULL);
 	}
 
+	// Release the shader cache object, this saves any shaders compiled during the run.
+	if(m_ShaderCache)
+	{
+		m_ShaderCache->Shutdown();
+		delete m_ShaderCache;
+		m_ShaderCache = 0;
+	}
+
+	// Release the fence queries.
+	for(int i=0; i<D3D_MAX_FENCES; i++)
+	{
+		if(m_fenceQueries[i])
+		{
+			m_fenceQueries[i]->Release();
+			m_fenceQueries[i] = 0;
+		}
+	}
+
 	if(m_alphaEnableBlendingState)
 	{
 		m_alphaEnableBlendingState->Release();
@@ -554,6 +686,8 @@ void D3DClass::BeginScene(float red, float green, float blue, float alpha)
 
 void D3DClass::EndScene()
 {
+	PROFILE_ZONE("Present");
+
 	// Present the back buffer to the screen since rendering is complete.
 	if(m_vsync_enabled)
 	{
@@ -570,92 +704,677 @@ void D3DClass::EndScene()
 }
 
 
-ID3D11Device* D3DClass::GetDevice()
+void D3DClass::SetVSync(bool enabled)
 {
-	return m_device;
+	// Takes effect from the next present.
+	m_vsync_enabled = enabled;
+	return;
 }
 
 
-ID3D11DeviceContext* D3DClass::GetDeviceContext()
+void D3DClass::GetVideoCardInfo(char* cardName, int& memory)
 {
-	return m_deviceContext;
+	strcpy_s(cardName, 128, m_videoCardDescription);
+	memory = m_videoCardMemory;
+	return;
 }
 
 
-void D3DClass::GetProjectionMatrix(D3DXMATRIX& projectionMatrix)
+void D3DClass::BindDepthState(bool enable)
 {
-	projectionMatrix = m_projectionMatrix;
+	if(enable)
+	{
+		m_deviceContext->OMSetDepthStencilState(m_depthStencilState, 1);
+	}
+	else
+	{
+		m_deviceContext->OMSetDepthStencilState(m_depthDisabledStencilState, 1);
+	}
+
 	return;
 }
 
 
-void D3DClass::GetWorldMatrix(D3DXMATRIX& worldMatrix)
+void D3DClass::BindBlendState(bool enable)
 {
-	worldMatrix = m_worldMatrix;
+	float blendFactor[4];
+	
+
+	// Setup the blend factor.
+	blendFactor[0] = 0.0f;
+	blendFactor[1] = 0.0f;
+	blendFactor[2] = 0.0f;
+	blendFactor[3] = 0.0f;
+	
+	// Turn the alpha blending on or off.
+	if(enable)
+	{
+		m_deviceContext->OMSetBlendState(m_alphaEnableBlendingState, blendFactor, 0xffffffff);
+	}
+	else
+	{
+		m_deviceContext->OMSetBlendState(m_alphaDisableBlendingState, blendFactor, 0xffffffff);
+	}
+
 	return;
 }
 
 
-void D3DClass::GetOrthoMatrix(D3DXMATRIX& orthoMatrix)
+RenderBuffer* D3DClass::CreateBuffer(RenderBufferType type, RenderUsage usage, int byteWidth, const void* data)
+{
+	D3D11_BUFFER_DESC bufferDesc;
+	D3D11_SUBRESOURCE_DATA bufferData;
+	D3DBuffer* buffer;
+	HRESULT result;
+
+
+	// Set up the description of the buffer, dynamic buffers are rewritten by the CPU through MapBuffer.
+	bufferDesc.Usage = (usage == RENDER_USAGE_DYNAMIC) ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+	bufferDesc.ByteWidth = byteWidth;
+	bufferDesc.CPUAccessFlags = (usage == RENDER_USAGE_DYNAMIC) ? D3D11_CPU_ACCESS_WRITE : 0;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	switch(type)
+	{
+		case RENDER_BUFFER_VERTEX:
+			bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			break;
+		case RENDER_BUFFER_INDEX:
+			bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+			break;
+		default:
+			bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+			break;
+	}
+
+	// Give the subresource structure a pointer to the initial data.
+	bufferData.pSysMem = data;
+	bufferData.SysMemPitch = 0;
+	bufferData.SysMemSlicePitch = 0;
+
+	buffer = new D3DBuffer;
+	if(!buffer)
+	{
+		return 0;
+	}
+
+	// Create the buffer.
+	result = m_device->CreateBuffer(&bufferDesc, data ? &bufferData : NULL, &buffer->buffer);
+	if(FAILED(result))
+	{
+		delete buffer;
+		return 0;
+	}
+
+	return buffer;
+}
+
+
+RenderTexture* D3DClass::CreateTexture(int width, int height, RenderFormat format, RenderUsage usage, const void* data, int pitch)
 {
-	orthoMatrix = m_orthoMatrix;
+	D3D11_TEXTURE2D_DESC textureDesc;
+	D3D11_SUBRESOURCE_DATA textureData;
+	D3DTexture* texture;
+	HRESULT result;
+
+
+	// Set up the description of the texture, dynamic textures are rewritten through UpdateTexture.
+	textureDesc.Width = width;
+	textureDesc.Height = height;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = GetFormat(format);
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = (usage == RENDER_USAGE_DYNAMIC) ? D3D11_USAGE_DEFAULT : D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	// Give the subresource structure a pointer to the texel data.
+	textureData.pSysMem = data;
+	textureData.SysMemPitch = pitch;
+	textureData.SysMemSlicePitch = 0;
+
+	texture = new D3DTexture;
+	if(!texture)
+	{
+		return 0;
+	}
+
+	texture->texture = 0;
+	texture->view = 0;
+
+	// Create the texture.
+	result = m_device->CreateTexture2D(&textureDesc, &textureData, &texture->texture);
+	if(FAILED(result))
+	{
+		delete texture;
+		return 0;
+	}
+
+	// Create the shader resource view so shaders can sample the texture.
+	result = m_device->CreateShaderResourceView(texture->texture, NULL, &texture->view);
+	if(FAILED(result))
+	{
+		texture->texture->Release();
+		delete texture;
+		return 0;
+	}
+
+	return texture;
+}
+
+
+RenderTexture* D3DClass::CreateTextureFromFile(const char* filename)
+{
+	D3DTexture* texture;
+	HRESULT result;
+
+
+	texture = new D3DTexture;
+	if(!texture)
+	{
+		return 0;
+	}
+
+	texture->texture = 0;
+	texture->view = 0;
+
+	// Load the texture in.
+	result = D3DX11CreateShaderResourceViewFromFileA(m_device, filename, NULL, NULL, &texture->view, NULL);
+	if(FAILED(result))
+	{
+		delete texture;
+		return 0;
+	}
+
+	return texture;
+}
+
+
+RenderProgram* D3DClass::CreateVertexShader(const char* filename, const char* entryPoint)
+{
+	D3DShader* shader;
+	HRESULT result;
+
+
+	shader = new D3DShader;
+	if(!shader)
+	{
+		return 0;
+	}
+
+	shader->vertexShader = 0;
+	shader->pixelShader = 0;
+
+	// Compile the vertex shader code, the byte code is kept for creating input layouts.
+	if(!CompileShader(filename, entryPoint, "vs_5_0", shader->byteCode, shader->byteCodeSize))
+	{
+		delete shader;
+		return 0;
+	}
+
+	// Create the vertex shader from the buffer.
+	result = m_device->CreateVertexShader(shader->byteCode, shader->byteCodeSize, NULL, &shader->vertexShader);
+	if(FAILED(result))
+	{
+		delete [] shader->byteCode;
+		delete shader;
+		return 0;
+	}
+
+	return shader;
+}
+
+
+RenderProgram* D3DClass::CreatePixelShader(const char* filename, const char* entryPoint)
+{
+	D3DShader* shader;
+	HRESULT result;
+
+
+	shader = new D3DShader;
+	if(!shader)
+	{
+		return 0;
+	}
+
+	shader->vertexShader = 0;
+	shader->pixelShader = 0;
+
+	// Compile the pixel shader code.
+	if(!CompileShader(filename, entryPoint, "ps_5_0", shader->byteCode, shader->byteCodeSize))
+	{
+		delete shader;
+		return 0;
+	}
+
+	// Create the pixel shader from the buffer.
+	result = m_device->CreatePixelShader(shader->byteCode, shader->byteCodeSize, NULL, &shader->pixelShader);
+	if(FAILED(result))
+	{
+		delete [] shader->byteCode;
+		delete shader;
+		return 0;
+	}
+
+	return shader;
+}
+
+
+RenderInputLayout* D3DClass::CreateInputLayout(const RenderInputElementType* elements, int elementCount, RenderProgram* vertexShader)
+{
+	D3D11_INPUT_ELEMENT_DESC polygonLayout[8];
+	D3DInputLayout* layout;
+	D3DShader* shader;
+	HRESULT result;
+	int i;
+
+
+	if(elementCount > 8)
+	{
+		return 0;
+	}
+
+	// Create the vertex input layout description.
+	for(i=0; i<elementCount; i++)
+	{
+		polygonLayout[i].SemanticName = elements[i].semanticName;
+		polygonLayout[i].SemanticIndex = elements[i].semanticIndex;
+		polygonLayout[i].Format = GetFormat(elements[i].format);
+		polygonLayout[i].InputSlot = 0;
+		polygonLayout[i].AlignedByteOffset = elements[i].offset;
+		polygonLayout[i].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+		polygonLayout[i].InstanceDataStepRate = 0;
+	}
+
+	layout = new D3DInputLayout;
+	if(!layout)
+	{
+		return 0;
+	}
+
+	// Create the vertex input layout, it is validated against the vertex shader byte code.
+	shader = (D3DShader*)vertexShader;
+	result = m_device->CreateInputLayout(polygonLayout, elementCount, shader->byteCode, shader->byteCodeSize, &layout->layout);
+	if(FAILED(result))
+	{
+		delete layout;
+		return 0;
+	}
+
+	return layout;
+}
+
+
+RenderSampler* D3DClass::CreateSampler(RenderAddressMode addressMode)
+{
+	D3D11_SAMPLER_DESC samplerDesc;
+	D3D11_TEXTURE_ADDRESS_MODE address;
+	D3DSampler* sampler;
+	HRESULT result;
+
+
+	address = (addressMode == RENDER_ADDRESS_CLAMP) ? D3D11_TEXTURE_ADDRESS_CLAMP : D3D11_TEXTURE_ADDRESS_WRAP;
+
+	// Create a texture sampler state description.
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = address;
+    samplerDesc.AddressV = address;
+    samplerDesc.AddressW = address;
+    samplerDesc.MipLODBias = 0.0f;
+    samplerDesc.MaxAnisotropy = 1;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+    samplerDesc.BorderColor[0] = 0;
+	samplerDesc.BorderColor[1] = 0;
+	samplerDesc.BorderColor[2] = 0;
+	samplerDesc.BorderColor[3] = 0;
+    samplerDesc.MinLOD = 0;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+	sampler = new D3DSampler;
+	if(!sampler)
+	{
+		return 0;
+	}
+
+	// Create the texture sampler state.
+    result = m_device->CreateSamplerState(&samplerDesc, &sampler->sampleState);
+	if(FAILED(result))
+	{
+		delete sampler;
+		return 0;
+	}
+
+	return sampler;
+}
+
+
+void* D3DClass::LockBuffer(RenderBuffer* buffer, RenderMapMode mode)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	HRESULT result;
+
+
+	// Lock the buffer so it can be written to, either discarding its previous contents or promising not to overwrite
+	// any part of them still in use.
+	result = m_deviceContext->Map(((D3DBuffer*)buffer)->buffer, 0, (mode == RENDER_MAP_NO_OVERWRITE) ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD,
+								  0, &mappedResource);
+	if(FAILED(result))
+	{
+		return 0;
+	}
+
+	return mappedResource.pData;
+}
+
+
+void D3DClass::UnlockBuffer(RenderBuffer* buffer)
+{
+	m_deviceContext->Unmap(((D3DBuffer*)buffer)->buffer, 0);
 	return;
 }
 
 
-void D3DClass::GetVideoCardInfo(char* cardName, int& memory)
+void D3DClass::UpdateTexture(RenderTexture* texture, const void* data, int pitch)
 {
-	strcpy_s(cardName, 128, m_videoCardDescription);
-	memory = m_videoCardMemory;
+	m_deviceContext->UpdateSubresource(((D3DTexture*)texture)->texture, 0, NULL, data, pitch, 0);
 	return;
 }
 
 
-void D3DClass::TurnZBufferOn()
+void D3DClass::BindVertexBuffer(RenderBuffer* buffer, int stride)
 {
-	m_deviceContext->OMSetDepthStencilState(m_depthStencilState, 1);
+	unsigned int vertexStride, offset;
+
+
+	vertexStride = stride;
+	offset = 0;
+
+	m_deviceContext->IASetVertexBuffers(0, 1, &((D3DBuffer*)buffer)->buffer, &vertexStride, &offset);
 	return;
 }
 
 
-void D3DClass::TurnZBufferOff()
+void D3DClass::BindIndexBuffer(RenderBuffer* buffer)
 {
-	m_deviceContext->OMSetDepthStencilState(m_depthDisabledStencilState, 1);
+	m_deviceContext->IASetIndexBuffer(((D3DBuffer*)buffer)->buffer, DXGI_FORMAT_R32_UINT, 0);
 	return;
 }
 
 
-void D3DClass::TurnOnAlphaBlending()
+void D3DClass::BindInputLayout(RenderInputLayout* layout)
 {
-	float blendFactor[4];
-	
+	m_deviceContext->IASetInputLayout(((D3DInputLayout*)layout)->layout);
+	return;
+}
 
-	// Setup the blend factor.
-	blendFactor[0] = 0.0f;
-	blendFactor[1] = 0.0f;
-	blendFactor[2] = 0.0f;
-	blendFactor[3] = 0.0f;
-	
-	// Turn on the alpha blending.
-	m_deviceContext->OMSetBlendState(m_alphaEnableBlendingState, blendFactor, 0xffffffff);
 
+void D3DClass::BindVertexShader(RenderProgram* shader)
+{
+	m_deviceContext->VSSetShader(((D3DShader*)shader)->vertexShader, NULL, 0);
 	return;
 }
 
 
-void D3DClass::TurnOffAlphaBlending()
+void D3DClass::BindPixelShader(RenderProgram* shader)
 {
-	float blendFactor[4];
-	
+	m_deviceContext->PSSetShader(((D3DShader*)shader)->pixelShader, NULL, 0);
+	return;
+}
+
+
+void D3DClass::BindVSConstantBuffer(int slot, RenderBuffer* buffer)
+{
+	m_deviceContext->VSSetConstantBuffers(slot, 1, &((D3DBuffer*)buffer)->buffer);
+	return;
+}
 
-	// Setup the blend factor.
-	blendFactor[0] = 0.0f;
-	blendFactor[1] = 0.0f;
-	blendFactor[2] = 0.0f;
-	blendFactor[3] = 0.0f;
-	
-	// Turn off the alpha blending.
-	m_deviceContext->OMSetBlendState(m_alphaDisableBlendingState, blendFactor, 0xffffffff);
 
+void D3DClass::BindPSConstantBuffer(int slot, RenderBuffer* buffer)
+{
+	m_deviceContext->PSSetConstantBuffers(slot, 1, &((D3DBuffer*)buffer)->buffer);
+	return;
+}
+
+
+void D3DClass::BindPSTexture(int slot, RenderTexture* texture)
+{
+	m_deviceContext->PSSetShaderResources(slot, 1, &((D3DTexture*)texture)->view);
 	return;
-}
\ No newline at end of file
+}
+
+
+void D3DClass::BindPSSampler(int slot, RenderSampler* sampler)
+{
+	m_deviceContext->PSSetSamplers(slot, 1, &((D3DSampler*)sampler)->sampleState);
+	return;
+}
+
+
+void D3DClass::DrawIndexed(int indexCount, int baseVertex)
+{
+	m_deviceContext->DrawIndexed(indexCount, 0, baseVertex);
+	return;
+}
+
+
+unsigned long long D3DClass::InsertFence()
+{
+	ID3D11Query* query;
+
+
+	// The queries are reused in turn, so the oldest one has to have finished before it can mark the new fence.  This
+	// only waits if the CPU has got more than D3D_MAX_FENCES fences ahead of the GPU.
+	if((m_fenceValue >= D3D_MAX_FENCES) && !IsFenceComplete(m_fenceValue + 1 - D3D_MAX_FENCES))
+	{
+		// Make sure the commands up to the fence have been sent or it will never be reached.
+		m_deviceContext->Flush();
+
+		while(!IsFenceComplete(m_fenceValue + 1 - D3D_MAX_FENCES))
+		{
+		}
+	}
+
+	m_fenceValue++;
+	query = m_fenceQueries[m_fenceValue % D3D_MAX_FENCES];
+
+	// An event query is signalled once the GPU reaches it.
+	m_deviceContext->End(query);
+
+	return m_fenceValue;
+}
+
+
+bool D3DClass::IsFenceComplete(unsigned long long fence)
+{
+	HRESULT result;
+
+
+	// Check the fences in order up to the one asked about, the GPU finishes them in order too.
+	while(m_completedFence < fence)
+	{
+		if(m_completedFence >= m_fenceValue)
+		{
+			return true;
+		}
+
+		result = m_deviceContext->GetData(m_fenceQueries[(m_completedFence + 1) % D3D_MAX_FENCES], NULL, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		if(result != S_OK)
+		{
+			return false;
+		}
+
+		m_completedFence++;
+	}
+
+	return true;
+}
+
+
+bool D3DClass::CompileShader(const char* filename, const char* entryPoint, const char* profile, char*& byteCode, int& byteCodeSize)
+{
+	StopwatchClass stopwatch;
+	unsigned int flags;
+	FILE* file;
+	long sourceSize;
+	char* source;
+	unsigned long long key;
+	const void* cachedCode;
+	int cachedSize;
+	ID3D10Blob* shaderBuffer;
+	ID3D10Blob* errorMessage;
+	HRESULT result;
+	char trace[512];
+
+
+	stopwatch.Start();
+
+	flags = D3D10_SHADER_ENABLE_STRICTNESS;
+
+	// Read the shader source, it is needed for the cache key even when the compile is skipped.
+	file = fopen(filename, "rb");
+	if(!file)
+	{
+		MessageBoxA(m_hwnd, filename, "Missing Shader File", MB_OK);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	sourceSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	source = new char[sourceSize + 1];
+	if(!source)
+	{
+		fclose(file);
+		return false;
+	}
+
+	sourceSize = (long)fread(source, 1, sourceSize, file);
+	source[sourceSize] = 0;
+	fclose(file);
+
+	// Look for byte code compiled from exactly this source with the same entry point, profile and flags.
+	key = ShaderCacheClass::HashShader(source, sourceSize, entryPoint, profile, flags);
+	if(m_ShaderCache->Find(key, cachedCode, cachedSize))
+	{
+		delete [] source;
+
+		byteCode = new char[cachedSize];
+		if(!byteCode)
+		{
+			return false;
+		}
+
+		memcpy(byteCode, cachedCode, cachedSize);
+		byteCodeSize = cachedSize;
+
+		sprintf(trace, "Shader %s %s loaded from cache in %.3f ms\n", filename, entryPoint, 
+				stopwatch.GetMilliseconds());
+		OutputDebugStringA(trace);
+
+		return true;
+	}
+
+	// Initialize the pointers this function will use to null.
+	shaderBuffer = 0;
+	errorMessage = 0;
+
+    // Compile the shader code.
+	result = D3DX11CompileFromMemory(source, sourceSize, filename, NULL, NULL, entryPoint, profile, flags, 0, NULL, 
+									 &shaderBuffer, &errorMessage, NULL);
+	delete [] source;
+	if(FAILED(result))
+	{
+		// If the shader failed to compile it should have writen something to the error message.
+		if(errorMessage)
+		{
+			OutputShaderErrorMessage(errorMessage, filename);
+		}
+		else
+		{
+			MessageBoxA(m_hwnd, filename, "Error compiling shader", MB_OK);
+		}
+
+		return false;
+	}
+
+	// Keep a copy of the byte code and add it to the cache for the next run.
+	byteCodeSize = (int)shaderBuffer->GetBufferSize();
+	byteCode = new char[byteCodeSize];
+	if(!byteCode)
+	{
+		shaderBuffer->Release();
+		return false;
+	}
+
+	memcpy(byteCode, shaderBuffer->GetBufferPointer(), byteCodeSize);
+	shaderBuffer->Release();
+
+	m_ShaderCache->Store(key, byteCode, byteCodeSize);
+
+	sprintf(trace, "Shader %s %s compiled in %.3f ms\n", filename, entryPoint, 
+			stopwatch.GetMilliseconds());
+	OutputDebugStringA(trace);
+
+	return true;
+}
+
+
+void D3DClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, const char* shaderFilename)
+{
+	char* compileErrors;
+	unsigned long bufferSize, i;
+	ofstream fout;
+
+
+	// Get a pointer to the error message text buffer.
+	compileErrors = (char*)(errorMessage->GetBufferPointer());
+
+	// Get the length of the message.
+	bufferSize = errorMessage->GetBufferSize();
+
+	// Open a file to write the error message to.
+	fout.open("shader-error.txt");
+
+	// Write out the error message.
+	for(i=0; i<bufferSize; i++)
+	{
+		fout << compileErrors[i];
+	}
+
+	// Close the file.
+	fout.close();
+
+	// Release the error message.
+	errorMessage->Release();
+	errorMessage = 0;
+
+	// Pop a message up on the screen to notify the user to check the text file for compile errors.
+	MessageBoxA(m_hwnd, "Error compiling shader.  Check shader-error.txt for message.", shaderFilename, MB_OK);
+
+	return;
+}
+
+
+DXGI_FORMAT D3DClass::GetFormat(RenderFormat format)
+{
+	switch(format)
+	{
+		case RENDER_FORMAT_R32G32_FLOAT:
+			return DXGI_FORMAT_R32G32_FLOAT;
+		case RENDER_FORMAT_R32G32B32_FLOAT:
+			return DXGI_FORMAT_R32G32B32_FLOAT;
+		case RENDER_FORMAT_R32G32B32A32_FLOAT:
+			return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		case RENDER_FORMAT_R8G8_SNORM:
+			return DXGI_FORMAT_R8G8_SNORM;
+		case RENDER_FORMAT_R8G8_UNORM:
+			return DXGI_FORMAT_R8G8_UNORM;
+		default:
+			return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+}
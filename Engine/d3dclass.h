@@ -11,7 +11,13 @@
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "d3dx11.lib")
-#pragma comment(lib, "d3dx10.lib")
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char SHADER_CACHE_FILE[] = "shadercache.bin";
+const int D3D_MAX_FENCES = 8;
 
 
 //////////////
@@ -20,13 +26,23 @@
 #include <dxgi.h>
 #include <d3dcommon.h>
 #include <d3d11.h>
-#include <d3dx10math.h>
+#include <d3dx11async.h>
+#include <d3dx11tex.h>
+#include <fstream>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+#include "shadercacheclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: D3DClass
 ////////////////////////////////////////////////////////////////////////////////
-class D3DClass
+class D3DClass : public RenderDeviceClass
 {
 public:
 	D3DClass();
@@ -38,22 +54,46 @@ public:
 	
 	void BeginScene(float, float, float, float);
 	void EndScene();
+	void SetVSync(bool);
 
-	ID3D11Device* GetDevice();
-	ID3D11DeviceContext* GetDeviceContext();
+	void GetVideoCardInfo(char*, int&);
 
-	void GetProjectionMatrix(D3DXMATRIX&);
-	void GetWorldMatrix(D3DXMATRIX&);
-	void GetOrthoMatrix(D3DXMATRIX&);
+	RenderBuffer* CreateBuffer(RenderBufferType, RenderUsage, int, const void*);
+	RenderTexture* CreateTexture(int, int, RenderFormat, RenderUsage, const void*, int);
+	RenderTexture* CreateTextureFromFile(const char*);
+	RenderProgram* CreateVertexShader(const char*, const char*);
+	RenderProgram* CreatePixelShader(const char*, const char*);
+	RenderInputLayout* CreateInputLayout(const RenderInputElementType*, int, RenderProgram*);
+	RenderSampler* CreateSampler(RenderAddressMode);
 
-	void GetVideoCardInfo(char*, int&);
+	void UpdateTexture(RenderTexture*, const void*, int);
+	void DrawIndexed(int, int);
+
+	unsigned long long InsertFence();
+	bool IsFenceComplete(unsigned long long);
 
-	void TurnZBufferOn();
-	void TurnZBufferOff();
-	void TurnOnAlphaBlending();
-	void TurnOffAlphaBlending();
+protected:
+	void BindDepthState(bool);
+	void BindBlendState(bool);
+	void* LockBuffer(RenderBuffer*, RenderMapMode);
+	void UnlockBuffer(RenderBuffer*);
+	void BindVertexBuffer(RenderBuffer*, int);
+	void BindIndexBuffer(RenderBuffer*);
+	void BindInputLayout(RenderInputLayout*);
+	void BindVertexShader(RenderProgram*);
+	void BindPixelShader(RenderProgram*);
+	void BindVSConstantBuffer(int, RenderBuffer*);
+	void BindPSConstantBuffer(int, RenderBuffer*);
+	void BindPSTexture(int, RenderTexture*);
+	void BindPSSampler(int, RenderSampler*);
+
+private:
+	bool CompileShader(const char*, const char*, const char*, char*&, int&);
+	void OutputShaderErrorMessage(ID3D10Blob*, const char*);
+	DXGI_FORMAT GetFormat(RenderFormat);
 
 private:
+	HWND m_hwnd;
 	bool m_vsync_enabled;
 	int m_videoCardMemory;
 	char m_videoCardDescription[128];
@@ -65,12 +105,12 @@ private:
 	ID3D11DepthStencilState* m_depthStencilState;
 	ID3D11DepthStencilView* m_depthStencilView;
 	ID3D11RasterizerState* m_rasterState;
-	D3DXMATRIX m_projectionMatrix;
-	D3DXMATRIX m_worldMatrix;
-	D3DXMATRIX m_orthoMatrix;
 	ID3D11DepthStencilState* m_depthDisabledStencilState;
 	ID3D11BlendState* m_alphaEnableBlendingState;
 	ID3D11BlendState* m_alphaDisableBlendingState;
+	ShaderCacheClass* m_ShaderCache;
+	ID3D11Query* m_fenceQueries[D3D_MAX_FENCES];
+	unsigned long long m_fenceValue, m_completedFence;
 };
 
 #endif
\ No newline at end of file
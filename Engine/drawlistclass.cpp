@@ -0,0 +1,333 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: drawlistclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "drawlistclass.h"
+#include "profilerclass.h"
+#include "clockclass.h"
+#include <string.h>
+#include <algorithm>
+
+
+// Depth and blend state for each pass, indexed by DrawPass.
+static const bool PASS_DEPTH_ENABLE[DRAW_PASS_COUNT] = { true, true, false };
+static const bool PASS_BLEND_ENABLE[DRAW_PASS_COUNT] = { false, true, true };
+
+
+DrawListClass::DrawListClass()
+{
+	m_memory = 0;
+	m_memorySize = 0;
+	m_memoryUsed = 0;
+	m_entries = 0;
+	m_maxPackets = 0;
+	m_packetCount = 0;
+	m_sorted = false;
+	memset(&m_stats, 0, sizeof(StatsType));
+}
+
+
+DrawListClass::DrawListClass(const DrawListClass& other)
+{
+}
+
+
+DrawListClass::~DrawListClass()
+{
+}
+
+
+bool DrawListClass::Initialize(int maxPackets, int memorySize)
+{
+	// Create the linear memory block that holds the packets and their constants for one frame.
+	m_memory = new char[memorySize + DRAW_LIST_ALIGNMENT];
+	if(!m_memory)
+	{
+		return false;
+	}
+
+	m_memorySize = memorySize;
+
+	// Create the sort entries, one for each packet.
+	m_entries = new SortEntryType[maxPackets];
+	if(!m_entries)
+	{
+		return false;
+	}
+
+	m_maxPackets = maxPackets;
+
+	Reset();
+
+	return true;
+}
+
+
+void DrawListClass::Shutdown()
+{
+	// Release the sort entries.
+	if(m_entries)
+	{
+		delete [] m_entries;
+		m_entries = 0;
+	}
+
+	// Release the packet memory.
+	if(m_memory)
+	{
+		delete [] m_memory;
+		m_memory = 0;
+	}
+
+	return;
+}
+
+
+void DrawListClass::Reset()
+{
+	// Everything recorded last frame is thrown away at once by rewinding the allocator.
+	m_memoryUsed = 0;
+	m_packetCount = 0;
+	m_sorted = true;
+
+	return;
+}
+
+
+void* DrawListClass::Allocate(int size)
+{
+	size_t base, offset;
+
+
+	// Align the start of the allocation in absolute terms since new only guarantees the alignment of the largest basic type.
+	base = (size_t)m_memory;
+	offset = ((base + m_memoryUsed + (DRAW_LIST_ALIGNMENT - 1)) & ~(size_t)(DRAW_LIST_ALIGNMENT - 1)) - base;
+	if((int)offset + size > m_memorySize + DRAW_LIST_ALIGNMENT)
+	{
+		return 0;
+	}
+
+	m_memoryUsed = (int)offset + size;
+
+	return m_memory + offset;
+}
+
+
+bool DrawListClass::Submit(const DrawPacketType& packet)
+{
+	DrawPacketType* copy;
+
+
+	if(m_packetCount == m_maxPackets)
+	{
+		return false;
+	}
+
+	// Copy the packet into the frame memory, the caller's packet can live on the stack.
+	copy = (DrawPacketType*)Allocate(sizeof(DrawPacketType));
+	if(!copy)
+	{
+		return false;
+	}
+
+	*copy = packet;
+
+	// Record the sort entry for the packet.
+	m_entries[m_packetCount].key = MakeSortKey(packet);
+	m_entries[m_packetCount].sequence = m_packetCount;
+	m_entries[m_packetCount].packet = copy;
+	m_packetCount++;
+
+	m_sorted = false;
+
+	return true;
+}
+
+
+void DrawListClass::Sort()
+{
+	StopwatchClass stopwatch;
+
+
+	PROFILE_ZONE("Sort");
+
+	stopwatch.Start();
+
+	if(!m_sorted)
+	{
+		std::sort(m_entries, m_entries + m_packetCount, CompareEntries);
+		m_sorted = true;
+	}
+
+	m_stats.sortTime = stopwatch.GetMilliseconds();
+
+	return;
+}
+
+
+bool DrawListClass::Execute(RenderDeviceClass* device)
+{
+	StopwatchClass stopwatch;
+	DrawPacketType* packet;
+	int i, j, pass;
+	bool result;
+
+
+	PROFILE_ZONE("Execute");
+
+	stopwatch.Start();
+
+	// Make sure the packets are in key order.
+	if(!m_sorted)
+	{
+		Sort();
+	}
+
+	pass = -1;
+
+	for(i=0; i<m_packetCount; i++)
+	{
+		packet = m_entries[i].packet;
+
+		// Set the depth and blend state when moving into a new pass.
+		if(packet->pass != pass)
+		{
+			pass = packet->pass;
+
+			if(PASS_DEPTH_ENABLE[pass])
+			{
+				device->TurnZBufferOn();
+			}
+			else
+			{
+				device->TurnZBufferOff();
+			}
+
+			if(PASS_BLEND_ENABLE[pass])
+			{
+				device->TurnOnAlphaBlending();
+			}
+			else
+			{
+				device->TurnOffAlphaBlending();
+			}
+		}
+
+		// Sorting keeps packets that share a pipeline next to each other so the device's state cache drops most of these.
+		device->SetInputLayout(packet->layout);
+		device->SetVertexShader(packet->vertexShader);
+		device->SetPixelShader(packet->pixelShader);
+		device->SetPSSampler(0, packet->sampler);
+
+		for(j=0; j<DRAW_PACKET_TEXTURES; j++)
+		{
+			if(packet->textures[j])
+			{
+				device->SetPSTexture(j, packet->textures[j]);
+			}
+		}
+
+		// Upload the constants, unchanged constants are skipped by the device.
+		if(packet->vsConstantBuffer)
+		{
+			result = device->UpdateBuffer(packet->vsConstantBuffer, packet->vsConstants, packet->vsConstantsSize);
+			if(!result)
+			{
+				return false;
+			}
+
+			device->SetVSConstantBuffer(0, packet->vsConstantBuffer);
+		}
+
+		if(packet->psConstantBuffer)
+		{
+			result = device->UpdateBuffer(packet->psConstantBuffer, packet->psConstants, packet->psConstantsSize);
+			if(!result)
+			{
+				return false;
+			}
+
+			device->SetPSConstantBuffer(0, packet->psConstantBuffer);
+		}
+
+		// Set the geometry and draw.
+		device->SetVertexBuffer(packet->vertexBuffer, packet->vertexStride);
+		device->SetIndexBuffer(packet->indexBuffer);
+		device->DrawIndexed(packet->indexCount, packet->baseVertex);
+	}
+
+	// Leave the device in the default state of depth testing on and blending off.
+	device->TurnZBufferOn();
+	device->TurnOffAlphaBlending();
+
+	m_stats.packets = m_packetCount;
+	m_stats.memoryUsed = m_memoryUsed;
+	m_stats.executeTime = stopwatch.GetMilliseconds();
+
+	return true;
+}
+
+
+int DrawListClass::GetPacketCount()
+{
+	return m_packetCount;
+}
+
+
+void DrawListClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+unsigned long long DrawListClass::MakeSortKey(const DrawPacketType& packet)
+{
+	unsigned long long pass, shader, material, depth;
+
+
+	// The pass is always the top of the key so passes never interleave.
+	pass = (unsigned long long)packet.pass << 60;
+
+	// Overlay draws are painted in the order they were submitted.
+	if(packet.pass == DRAW_PASS_OVERLAY)
+	{
+		return pass;
+	}
+
+	// Build the 16 bit shader and 20 bit material fields from the resource ids, a collision only costs an extra bind.
+	shader = ((packet.vertexShader ? packet.vertexShader->GetId() & 0xff : 0) << 8) | (packet.pixelShader ? packet.pixelShader->GetId() & 0xff : 0);
+	material = ((packet.textures[0] ? packet.textures[0]->GetId() : 0) ^ ((packet.textures[1] ? packet.textures[1]->GetId() : 0) << 10)) & 0xfffff;
+
+	// Quantize the depth to 24 bits.
+	if(packet.depth <= 0.0f)
+	{
+		depth = 0;
+	}
+	else if(packet.depth >= 1.0f)
+	{
+		depth = 0xffffff;
+	}
+	else
+	{
+		depth = (unsigned long long)(packet.depth * 16777215.0f);
+	}
+
+	// Transparent draws go back to front first and group by state second, opaque draws group by state and then go front to back.
+	if(packet.pass == DRAW_PASS_TRANSPARENT)
+	{
+		return pass | ((0xffffff - depth) << 36) | (shader << 20) | material;
+	}
+
+	return pass | (shader << 44) | (material << 24) | depth;
+}
+
+
+bool DrawListClass::CompareEntries(const SortEntryType& first, const SortEntryType& second)
+{
+	if(first.key != second.key)
+	{
+		return first.key < second.key;
+	}
+
+	return first.sequence < second.sequence;
+}
@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: drawlistclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _DRAWLISTCLASS_H_
+#define _DRAWLISTCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int DRAW_PACKET_TEXTURES = 2;
+const int DRAW_LIST_ALIGNMENT = 16;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// Passes run in this order, each pass sets its own depth and blend state.
+enum DrawPass
+{
+	DRAW_PASS_OPAQUE,
+	DRAW_PASS_TRANSPARENT,
+	DRAW_PASS_OVERLAY,
+	DRAW_PASS_COUNT
+};
+
+// One draw with everything needed to issue it, the constants are copied into the draw list's memory.
+// Depth is the normalized view depth from 0 to 1 and only orders draws within the opaque and transparent passes.
+// The base vertex is added to every index, so geometry placed part way into a shared buffer can use the same indices.
+struct DrawPacketType
+{
+	DrawPass pass;
+	float depth;
+	RenderInputLayout* layout;
+	RenderProgram* vertexShader;
+	RenderProgram* pixelShader;
+	RenderSampler* sampler;
+	RenderTexture* textures[DRAW_PACKET_TEXTURES];
+	RenderBuffer* vertexBuffer;
+	int vertexStride, baseVertex;
+	RenderBuffer* indexBuffer;
+	int indexCount;
+	RenderBuffer* vsConstantBuffer;
+	const void* vsConstants;
+	int vsConstantsSize;
+	RenderBuffer* psConstantBuffer;
+	const void* psConstants;
+	int psConstantsSize;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: DrawListClass
+////////////////////////////////////////////////////////////////////////////////
+class DrawListClass
+{
+public:
+	struct StatsType
+	{
+		int packets, memoryUsed;
+		float sortTime, executeTime;
+	};
+
+private:
+	// Ties on the key fall back to the submission order so equal draws keep the order they were recorded in.
+	struct SortEntryType
+	{
+		unsigned long long key;
+		int sequence;
+		DrawPacketType* packet;
+	};
+
+public:
+	DrawListClass();
+	DrawListClass(const DrawListClass&);
+	~DrawListClass();
+
+	bool Initialize(int, int);
+	void Shutdown();
+
+	void Reset();
+	void* Allocate(int);
+	bool Submit(const DrawPacketType&);
+	void Sort();
+	bool Execute(RenderDeviceClass*);
+
+	int GetPacketCount();
+	void GetStats(StatsType&);
+
+	static unsigned long long MakeSortKey(const DrawPacketType&);
+
+private:
+	static bool CompareEntries(const SortEntryType&, const SortEntryType&);
+
+private:
+	char* m_memory;
+	int m_memorySize, m_memoryUsed;
+	SortEntryType* m_entries;
+	int m_maxPackets, m_packetCount;
+	bool m_sorted;
+	StatsType m_stats;
+};
+
+#endif
@@ -21,12 +21,14 @@ struct VertexInputType
 {
     float4 position : POSITION;
     float2 tex : TEXCOORD0;
+    float4 color : COLOR;
 };
 
 struct PixelInputType
 {
     float4 position : SV_POSITION;
     float2 tex : TEXCOORD0;
+    nointerpolation float4 color : COLOR;
 };
 
 
@@ -48,6 +50,9 @@ PixelInputType FontVertexShader(VertexInputType input)
     
 	// Store the texture coordinates for the pixel shader.
 	output.tex = input.tex;
+
+	// Pass the glyph color through, every vertex of a glyph has the same color.
+	output.color = input.color;
     
     return output;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 // Filename: fontclass.cpp
 ///////////////////////////////////////////////////////////////////////////////
 #include "fontclass.h"
+#include <string.h>
 
 
 FontClass::FontClass()
@@ -21,7 +22,7 @@ FontClass::~FontClass()
 }
 
 
-bool FontClass::Initialize(ID3D11Device* device, char* fontFilename, WCHAR* textureFilename)
+bool FontClass::Initialize(RenderDeviceClass* device, char* fontFilename, char* textureFilename)
 {
 	bool result;
 
@@ -116,7 +117,7 @@ void FontClass::ReleaseFontData()
 }
 
 
-bool FontClass::LoadTexture(ID3D11Device* device, WCHAR* filename)
+bool FontClass::LoadTexture(RenderDeviceClass* device, char* filename)
 {
 	bool result;
 
@@ -153,13 +154,13 @@ void FontClass::ReleaseTexture()
 }
 
 
-ID3D11ShaderResourceView* FontClass::GetTexture()
+RenderTexture* FontClass::GetTexture()
 {
 	return m_Texture->GetTexture();
 }
 
 
-void FontClass::BuildVertexArray(void* vertices, char* sentence, float drawX, float drawY)
+int FontClass::BuildVertexArray(void* vertices, char* sentence, float drawX, float drawY, Vector4 color)
 {
 	VertexType* vertexPtr;
 	int numLetters, index, i, letter;
@@ -174,7 +175,7 @@ void FontClass::BuildVertexArray(void* vertices, char* sentence, float drawX, fl
 	// Initialize the index to the vertex array.
 	index = 0;
 
-	// Draw each letter onto a quad.
+	// Draw each letter onto a quad of four vertices, the index buffer splits it into two triangles.
 	for(i=0; i<numLetters; i++)
 	{
 		letter = ((int)sentence[i]) - 32;
@@ -186,30 +187,24 @@ void FontClass::BuildVertexArray(void* vertices, char* sentence, float drawX, fl
 		}
 		else
 		{
-			// First triangle in quad.
-			vertexPtr[index].position = D3DXVECTOR3(drawX, drawY, 0.0f);  // Top left.
-			vertexPtr[index].texture = D3DXVECTOR2(m_Font[letter].left, 0.0f);
+			vertexPtr[index].position = Vector3(drawX, drawY, 0.0f);  // Top left.
+			vertexPtr[index].texture = Vector2(m_Font[letter].left, 0.0f);
+			vertexPtr[index].color = color;
 			index++;
 
-			vertexPtr[index].position = D3DXVECTOR3((drawX + m_Font[letter].size), (drawY - 16), 0.0f);  // Bottom right.
-			vertexPtr[index].texture = D3DXVECTOR2(m_Font[letter].right, 1.0f);
+			vertexPtr[index].position = Vector3(drawX + m_Font[letter].size, drawY, 0.0f);  // Top right.
+			vertexPtr[index].texture = Vector2(m_Font[letter].right, 0.0f);
+			vertexPtr[index].color = color;
 			index++;
 
-			vertexPtr[index].position = D3DXVECTOR3(drawX, (drawY - 16), 0.0f);  // Bottom left.
-			vertexPtr[index].texture = D3DXVECTOR2(m_Font[letter].left, 1.0f);
+			vertexPtr[index].position = Vector3(drawX, (drawY - 16), 0.0f);  // Bottom left.
+			vertexPtr[index].texture = Vector2(m_Font[letter].left, 1.0f);
+			vertexPtr[index].color = color;
 			index++;
 
-			// Second triangle in quad.
-			vertexPtr[index].position = D3DXVECTOR3(drawX, drawY, 0.0f);  // Top left.
-			vertexPtr[index].texture = D3DXVECTOR2(m_Font[letter].left, 0.0f);
-			index++;
-
-			vertexPtr[index].position = D3DXVECTOR3(drawX + m_Font[letter].size, drawY, 0.0f);  // Top right.
-			vertexPtr[index].texture = D3DXVECTOR2(m_Font[letter].right, 0.0f);
-			index++;
-
-			vertexPtr[index].position = D3DXVECTOR3((drawX + m_Font[letter].size), (drawY - 16), 0.0f);  // Bottom right.
-			vertexPtr[index].texture = D3DXVECTOR2(m_Font[letter].right, 1.0f);
+			vertexPtr[index].position = Vector3((drawX + m_Font[letter].size), (drawY - 16), 0.0f);  // Bottom right.
+			vertexPtr[index].texture = Vector2(m_Font[letter].right, 1.0f);
+			vertexPtr[index].color = color;
 			index++;
 
 			// Update the x location for drawing by the size of the letter and one pixel.
@@ -217,5 +212,6 @@ void FontClass::BuildVertexArray(void* vertices, char* sentence, float drawX, fl
 		}
 	}
 
-	return;
+	// Return the number of vertices written, spaces do not add any.
+	return index;
 }
\ No newline at end of file
@@ -8,8 +8,6 @@
 //////////////
 // INCLUDES //
 //////////////
-#include <d3d11.h>
-#include <d3dx10math.h>
 #include <fstream>
 using namespace std;
 
@@ -17,6 +15,7 @@ using namespace std;
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
+#include "mathclass.h"
 #include "textureclass.h"
 
 
@@ -34,8 +33,9 @@ private:
 
 	struct VertexType
 	{
-		D3DXVECTOR3 position;
-	    D3DXVECTOR2 texture;
+		Vector3 position;
+	    Vector2 texture;
+		Vector4 color;
 	};
 
 public:
@@ -43,17 +43,17 @@ public:
 	FontClass(const FontClass&);
 	~FontClass();
 
-	bool Initialize(ID3D11Device*, char*, WCHAR*);
+	bool Initialize(RenderDeviceClass*, char*, char*);
 	void Shutdown();
 
-	ID3D11ShaderResourceView* GetTexture();
+	RenderTexture* GetTexture();
 
-	void BuildVertexArray(void*, char*, float, float);
+	int BuildVertexArray(void*, char*, float, float, Vector4);
 
 private:
 	bool LoadFontData(char*);
 	void ReleaseFontData();
-	bool LoadTexture(ID3D11Device*, WCHAR*);
+	bool LoadTexture(RenderDeviceClass*, char*);
 	void ReleaseTexture();
 
 private:
@@ -5,14 +5,12 @@
 #define _FONTSHADERCLASS_H_
 
 
-//////////////
-// INCLUDES //
-//////////////
-#include <d3d11.h>
-#include <d3dx10math.h>
-#include <d3dx11async.h>
-#include <fstream>
-using namespace std;
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mathclass.h"
+#include "renderdeviceclass.h"
+#include "drawlistclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -23,14 +21,9 @@ class FontShaderClass
 private:
 	struct ConstantBufferType
 	{
-		D3DXMATRIX world;
-		D3DXMATRIX view;
-		D3DXMATRIX projection;
-	};
-
-	struct PixelBufferType
-	{
-		D3DXVECTOR4 pixelColor;
+		Matrix world;
+		Matrix view;
+		Matrix projection;
 	};
 
 public:
@@ -38,25 +31,23 @@ public:
 	FontShaderClass(const FontShaderClass&);
 	~FontShaderClass();
 
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(RenderDeviceClass*);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, D3DXMATRIX, D3DXMATRIX, D3DXMATRIX, ID3D11ShaderResourceView*, D3DXVECTOR4);
+	bool Render(DrawListClass*, DrawPacketType&, Matrix, Matrix, Matrix, RenderTexture*);
 
 private:
-	bool InitializeShader(ID3D11Device*, HWND, WCHAR*, WCHAR*);
+	bool InitializeShader(RenderDeviceClass*, char*, char*);
 	void ShutdownShader();
-	void OutputShaderErrorMessage(ID3D10Blob*, HWND, WCHAR*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, D3DXMATRIX, D3DXMATRIX, D3DXMATRIX, ID3D11ShaderResourceView*, D3DXVECTOR4);
-	void RenderShader(ID3D11DeviceContext*, int);
+	bool SetShaderParameters(DrawListClass*, DrawPacketType&, Matrix, Matrix, Matrix, RenderTexture*);
+	bool RenderShader(DrawListClass*, DrawPacketType&);
 
 private:
-	ID3D11VertexShader* m_vertexShader;
-	ID3D11PixelShader* m_pixelShader;
-	ID3D11InputLayout* m_layout;
-	ID3D11Buffer* m_constantBuffer;
-	ID3D11SamplerState* m_sampleState;
-	ID3D11Buffer* m_pixelBuffer;
+	RenderProgram* m_vertexShader;
+	RenderProgram* m_pixelShader;
+	RenderInputLayout* m_layout;
+	RenderBuffer* m_constantBuffer;
+	RenderSampler* m_sampleState;
 };
 
 #endif
\ No newline at end of file
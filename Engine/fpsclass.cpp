@@ -2,10 +2,30 @@
 // Filename: fpsclass.cpp
 ///////////////////////////////////////////////////////////////////////////////
 #include "fpsclass.h"
+#include "clockclass.h"
+#include "statsoverlayclass.h"
+#include "frameallocatorclass.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
 
 
 FpsClass::FpsClass()
 {
+	int i;
+
+
+	m_frameTimes = 0;
+	m_frameIndex = 0;
+	m_frameCount = 0;
+	m_window = FPS_DEFAULT_WINDOW;
+	m_totalStutters = 0;
+	memset(&m_stats, 0, sizeof(StatsType));
+
+	for(i=0; i<FPS_METRICS; i++)
+	{
+		m_metrics[i] = -1;
+	}
 }
 
 
@@ -19,28 +39,96 @@ FpsClass::~FpsClass()
 }
 
 
-void FpsClass::Initialize()
+bool FpsClass::Initialize()
 {
 	// Initialize the counters and the start time.
 	m_fps = 0;
 	m_count = 0;
-	m_startTime = timeGetTime();
+	m_startTime = ClockClass::GetTimestamp();
+
+	// Create the ring buffer of frame times.
+	m_frameTimes = new float[FPS_HISTORY_SIZE];
+	if(!m_frameTimes)
+	{
+		return false;
+	}
+
+	// Show the frame rate and frame time statistics in the stats overlay.
+	m_metrics[0] = StatsOverlayClass::AddCounter("Frame", "Fps", "");
+	m_metrics[1] = StatsOverlayClass::AddGauge("Frame", "Min", 1, "ms");
+	m_metrics[2] = StatsOverlayClass::AddGauge("Frame", "Average", 1, "ms");
+	m_metrics[3] = StatsOverlayClass::AddGauge("Frame", "Max", 1, "ms");
+	m_metrics[4] = StatsOverlayClass::AddGauge("Frame", "P50", 1, "ms");
+	m_metrics[5] = StatsOverlayClass::AddGauge("Frame", "P95", 1, "ms");
+	m_metrics[6] = StatsOverlayClass::AddGauge("Frame", "P99", 1, "ms");
+	m_metrics[7] = StatsOverlayClass::AddCounter("Frame", "1% low", "fps");
+	m_metrics[8] = StatsOverlayClass::AddCounter("Frame", "Stutters", "");
 	
+	return true;
+}
+
+
+void FpsClass::Shutdown()
+{
+	int i;
+
+
+	// Take the frame metrics off the overlay.
+	for(i=0; i<FPS_METRICS; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
+	// Release the frame time buffer.
+	if(m_frameTimes)
+	{
+		delete [] m_frameTimes;
+		m_frameTimes = 0;
+	}
+
 	return;
 }
 
 
-void FpsClass::Frame()
+void FpsClass::Frame(float frameTime)
 {
+	// Count a stutter against the median from the last time the statistics were updated.
+	if((m_stats.frames > 0) && (frameTime > m_stats.percentile50 * FPS_STUTTER_FACTOR))
+	{
+		m_totalStutters++;
+	}
+
+	// Store the frame time in the ring buffer.
+	m_frameTimes[m_frameIndex] = frameTime;
+	m_frameIndex = (m_frameIndex + 1) % FPS_HISTORY_SIZE;
+	if(m_frameCount < FPS_HISTORY_SIZE)
+	{
+		m_frameCount++;
+	}
+
 	m_count++;
 
-	// If one second has passed then update the frame per second speed.
-	if(timeGetTime() >= (m_startTime + 1000))
+	// If one second has passed then update the frame per second speed and the frame time statistics.
+	if(ClockClass::ToMilliseconds(ClockClass::GetTimestamp() - m_startTime) >= 1000.0f)
 	{
 		m_fps = m_count;
 		m_count = 0;
+
+		UpdateStats();
+
+		// Update the overlay once a second along with the statistics.
+		StatsOverlayClass::SetCounter(m_metrics[0], m_fps);
+		StatsOverlayClass::SetGauge(m_metrics[1], m_stats.minimumTime);
+		StatsOverlayClass::SetGauge(m_metrics[2], m_stats.averageTime);
+		StatsOverlayClass::SetGauge(m_metrics[3], m_stats.maximumTime);
+		StatsOverlayClass::SetGauge(m_metrics[4], m_stats.percentile50);
+		StatsOverlayClass::SetGauge(m_metrics[5], m_stats.percentile95);
+		StatsOverlayClass::SetGauge(m_metrics[6], m_stats.percentile99);
+		StatsOverlayClass::SetCounter(m_metrics[7], (int)m_stats.lowFps);
+		StatsOverlayClass::SetCounter(m_metrics[8], m_stats.stutters);
 		
-		m_startTime = timeGetTime();
+		m_startTime = ClockClass::GetTimestamp();
 	}
 }
 
@@ -48,4 +136,129 @@ void FpsClass::Frame()
 int FpsClass::GetFps()
 {
 	return m_fps;
-}
\ No newline at end of file
+}
+
+
+void FpsClass::SetWindow(int frames)
+{
+	// Keep the window inside the ring buffer.
+	if(frames < 1)
+	{
+		frames = 1;
+	}
+
+	if(frames > FPS_HISTORY_SIZE)
+	{
+		frames = FPS_HISTORY_SIZE;
+	}
+
+	m_window = frames;
+
+	return;
+}
+
+
+void FpsClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+int FpsClass::GetTotalStutters()
+{
+	return m_totalStutters;
+}
+
+
+bool FpsClass::SaveCsv(const char* filename)
+{
+	FILE* file;
+	int i, index;
+
+
+	file = fopen(filename, "w");
+	if(!file)
+	{
+		return false;
+	}
+
+	// Write every frame still in the ring buffer, oldest first.
+	fprintf(file, "frame,time_ms\n");
+	for(i=0; i<m_frameCount; i++)
+	{
+		index = (m_frameIndex - m_frameCount + i + FPS_HISTORY_SIZE) % FPS_HISTORY_SIZE;
+		fprintf(file, "%d,%.4f\n", i, m_frameTimes[index]);
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+
+void FpsClass::UpdateStats()
+{
+	float* sortedTimes;
+	int frames, lowFrames, i, index;
+	double total;
+
+
+	// Copy the newest frames in the window out of the ring buffer.
+	frames = (m_frameCount < m_window) ? m_frameCount : m_window;
+	if(frames == 0)
+	{
+		return;
+	}
+
+	// The sorted copy is only needed until the stats are worked out so it comes from the frame allocator.  If that is
+	// full the stats stay as they were until the next update.
+	sortedTimes = FrameAllocatorClass::AllocateArray<float>(frames);
+	if(!sortedTimes)
+	{
+		return;
+	}
+
+	total = 0.0;
+	for(i=0; i<frames; i++)
+	{
+		index = (m_frameIndex - frames + i + FPS_HISTORY_SIZE) % FPS_HISTORY_SIZE;
+		sortedTimes[i] = m_frameTimes[index];
+		total += m_frameTimes[index];
+	}
+
+	// Sort the copy so the percentiles can be read straight out of it.
+	std::sort(sortedTimes, sortedTimes + frames);
+
+	m_stats.frames = frames;
+	m_stats.minimumTime = sortedTimes[0];
+	m_stats.maximumTime = sortedTimes[frames - 1];
+	m_stats.averageTime = (float)(total / frames);
+	m_stats.percentile50 = sortedTimes[(frames - 1) * 50 / 100];
+	m_stats.percentile95 = sortedTimes[(frames - 1) * 95 / 100];
+	m_stats.percentile99 = sortedTimes[(frames - 1) * 99 / 100];
+
+	// The 1% low is the frame rate over the slowest one percent of frames, at least one frame.
+	lowFrames = frames / 100;
+	if(lowFrames < 1)
+	{
+		lowFrames = 1;
+	}
+
+	total = 0.0;
+	for(i=frames-lowFrames; i<frames; i++)
+	{
+		total += sortedTimes[i];
+	}
+
+	m_stats.lowFps = (total > 0.0) ? (float)(1000.0 * lowFrames / total) : 0.0f;
+
+	// Count the frames in the window that took much longer than the median.
+	m_stats.stutters = 0;
+	for(i=frames-1; (i>=0) && (sortedTimes[i] > m_stats.percentile50 * FPS_STUTTER_FACTOR); i--)
+	{
+		m_stats.stutters++;
+	}
+
+	return;
+}
@@ -6,16 +6,12 @@
 
 
 /////////////
-// LINKING //
+// GLOBALS //
 /////////////
-#pragma comment(lib, "winmm.lib")
-
-
-//////////////
-// INCLUDES //
-//////////////
-#include <windows.h>
-#include <mmsystem.h>
+const int FPS_HISTORY_SIZE = 8192;
+const int FPS_DEFAULT_WINDOW = 300;
+const float FPS_STUTTER_FACTOR = 2.0f;
+const int FPS_METRICS = 9;
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -23,18 +19,43 @@
 ////////////////////////////////////////////////////////////////////////////////
 class FpsClass
 {
+public:
+	// Frame times are in milliseconds over the last window of frames.  The 1% low is the frame rate of the slowest
+	// one percent of frames and a stutter is a frame that took more than FPS_STUTTER_FACTOR times the median.
+	struct StatsType
+	{
+		float minimumTime, averageTime, maximumTime;
+		float percentile50, percentile95, percentile99;
+		float lowFps;
+		int stutters, frames;
+	};
+
 public:
 	FpsClass();
 	FpsClass(const FpsClass&);
 	~FpsClass();
 
-	void Initialize();
-	void Frame();
+	bool Initialize();
+	void Shutdown();
+	void Frame(float);
 	int GetFps();
 
+	void SetWindow(int);
+	void GetStats(StatsType&);
+	int GetTotalStutters();
+	bool SaveCsv(const char*);
+
+private:
+	void UpdateStats();
+
 private:
 	int m_fps, m_count;
-	unsigned long m_startTime;
+	long long m_startTime;
+	float* m_frameTimes;
+	int m_frameIndex, m_frameCount, m_window;
+	int m_totalStutters;
+	StatsType m_stats;
+	int m_metrics[FPS_METRICS];
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: frameallocatorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "frameallocatorclass.h"
+#include "statsoverlayclass.h"
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+
+FrameAllocatorClass* FrameAllocatorClass::m_instance = 0;
+std::atomic<long long> FrameAllocatorClass::m_heapAllocations(0);
+
+
+// Every new in the program comes through here so the frame can count its heap allocations.
+void* operator new(size_t size)
+{
+	void* memory;
+
+
+	FrameAllocatorClass::CountHeapAllocation();
+
+	memory = malloc(size ? size : 1);
+	if(!memory)
+	{
+		throw std::bad_alloc();
+	}
+
+	return memory;
+}
+
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+	FrameAllocatorClass::CountHeapAllocation();
+
+	return malloc(size ? size : 1);
+}
+
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) throw()
+{
+	return operator new(size, nothrow);
+}
+
+
+void operator delete(void* memory) throw()
+{
+	free(memory);
+}
+
+
+void operator delete[](void* memory) throw()
+{
+	free(memory);
+}
+
+
+void operator delete(void* memory, const std::nothrow_t&) throw()
+{
+	free(memory);
+}
+
+
+void operator delete[](void* memory, const std::nothrow_t&) throw()
+{
+	free(memory);
+}
+
+
+FrameAllocatorClass::FrameAllocatorClass()
+{
+	int i;
+
+
+	m_memory = 0;
+	m_buffers[0] = 0;
+	m_buffers[1] = 0;
+	m_currentBuffer = 0;
+	m_capacity = 0;
+	m_offset.store(0);
+	m_failedAllocations.store(0);
+	m_lastHeapAllocations = 0;
+	memset(&m_stats, 0, sizeof(StatsType));
+
+	for(i=0; i<4; i++)
+	{
+		m_metrics[i] = -1;
+	}
+}
+
+
+FrameAllocatorClass::FrameAllocatorClass(const FrameAllocatorClass& other)
+{
+}
+
+
+FrameAllocatorClass::~FrameAllocatorClass()
+{
+}
+
+
+bool FrameAllocatorClass::Initialize(int size)
+{
+	size_t address;
+
+
+	// Round the size of each buffer up so the second one starts aligned as well.
+	m_capacity = (size + FRAME_ALLOCATOR_ALIGNMENT - 1) & ~(FRAME_ALLOCATOR_ALIGNMENT - 1);
+
+	// Create the memory for both buffers, one is filled while the other still holds the last frame's data.
+	m_memory = new char[(m_capacity * 2) + FRAME_ALLOCATOR_ALIGNMENT];
+	if(!m_memory)
+	{
+		return false;
+	}
+
+	address = ((size_t)m_memory + FRAME_ALLOCATOR_ALIGNMENT - 1) & ~(size_t)(FRAME_ALLOCATOR_ALIGNMENT - 1);
+	m_buffers[0] = (char*)address;
+	m_buffers[1] = m_buffers[0] + m_capacity;
+
+	m_currentBuffer = 0;
+	m_offset.store(0);
+	m_stats.capacity = m_capacity;
+	m_lastHeapAllocations = m_heapAllocations.load(std::memory_order_relaxed);
+
+	m_instance = this;
+
+	// Show the memory use of each frame in the stats overlay.
+	m_metrics[0] = StatsOverlayClass::AddCounter("Memory", "Heap", "/frame");
+	m_metrics[1] = StatsOverlayClass::AddCounter("Memory", "Arena", "KB");
+	m_metrics[2] = StatsOverlayClass::AddCounter("Memory", "Arena peak", "KB");
+	m_metrics[3] = StatsOverlayClass::AddCounter("Memory", "Failed", "/frame");
+
+	return true;
+}
+
+
+void FrameAllocatorClass::Shutdown()
+{
+	int i;
+
+
+	m_instance = 0;
+
+	// Take the memory metrics off the overlay.
+	for(i=0; i<4; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
+	// Release the buffers.
+	if(m_memory)
+	{
+		delete [] m_memory;
+		m_memory = 0;
+	}
+
+	m_buffers[0] = 0;
+	m_buffers[1] = 0;
+
+	return;
+}
+
+
+void FrameAllocatorClass::EndFrame()
+{
+	long long heapAllocations;
+
+
+	// Record the frame before the buffers swap.
+	m_stats.usedBytes = m_offset.load(std::memory_order_relaxed);
+	if(m_stats.usedBytes > m_stats.peakBytes)
+	{
+		m_stats.peakBytes = m_stats.usedBytes;
+	}
+
+	m_stats.failedAllocations = m_failedAllocations.exchange(0, std::memory_order_relaxed);
+
+	heapAllocations = m_heapAllocations.load(std::memory_order_relaxed);
+	m_stats.heapAllocations = (int)(heapAllocations - m_lastHeapAllocations);
+	m_lastHeapAllocations = heapAllocations;
+
+	// Start filling the other buffer, the one just filled stays untouched until the end of the next frame.
+	m_currentBuffer = 1 - m_currentBuffer;
+	m_offset.store(0, std::memory_order_relaxed);
+
+	// Update the overlay, the failed count turns red if the frame memory ran out and something had to fail.
+	StatsOverlayClass::SetCounter(m_metrics[0], m_stats.heapAllocations);
+	StatsOverlayClass::SetCounter(m_metrics[1], m_stats.usedBytes / 1024);
+	StatsOverlayClass::SetCounter(m_metrics[2], m_stats.peakBytes / 1024);
+	StatsOverlayClass::SetCounter(m_metrics[3], m_stats.failedAllocations);
+	StatsOverlayClass::SetWarning(m_metrics[3], m_stats.failedAllocations > 0);
+
+	return;
+}
+
+
+void FrameAllocatorClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+void* FrameAllocatorClass::Allocate(size_t size)
+{
+	FrameAllocatorClass* allocator;
+	int alignedSize, offset;
+
+
+	allocator = m_instance;
+	if(!allocator || (size > (size_t)allocator->m_capacity))
+	{
+		return 0;
+	}
+
+	// Bump the offset, threads that race here each get their own range.
+	alignedSize = ((int)size + FRAME_ALLOCATOR_ALIGNMENT - 1) & ~(FRAME_ALLOCATOR_ALIGNMENT - 1);
+	offset = allocator->m_offset.fetch_add(alignedSize, std::memory_order_relaxed);
+	if(offset + alignedSize > allocator->m_capacity)
+	{
+		// Give the range back so smaller allocations can still fit, while it is out every other allocation fails too
+		// so no range is ever handed out twice.
+		allocator->m_offset.fetch_sub(alignedSize, std::memory_order_relaxed);
+		allocator->m_failedAllocations.fetch_add(1, std::memory_order_relaxed);
+		return 0;
+	}
+
+	return allocator->m_buffers[allocator->m_currentBuffer] + offset;
+}
+
+
+void FrameAllocatorClass::CountHeapAllocation()
+{
+	m_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	return;
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: frameallocatorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FRAMEALLOCATORCLASS_H_
+#define _FRAMEALLOCATORCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int FRAME_ALLOCATOR_ALIGNMENT = 16;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stddef.h>
+#include <atomic>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FrameAllocatorClass
+////////////////////////////////////////////////////////////////////////////////
+class FrameAllocatorClass
+{
+public:
+	// The byte counts are for the frame that just ended.  The heap allocations are every call to new in the process
+	// during that frame, whoever made them.
+	struct StatsType
+	{
+		int usedBytes, peakBytes, capacity;
+		int failedAllocations;
+		int heapAllocations;
+	};
+
+public:
+	FrameAllocatorClass();
+	FrameAllocatorClass(const FrameAllocatorClass&);
+	~FrameAllocatorClass();
+
+	bool Initialize(int);
+	void Shutdown();
+	void EndFrame();
+	void GetStats(StatsType&);
+
+	// Memory handed out lives until the end of the next frame, there is no free and no destructor is ever run so only
+	// plain data should be put in it.  Any thread may allocate but only the main thread may end the frame.
+	static void* Allocate(size_t);
+
+	template <class T>
+	static T* AllocateArray(int count)
+	{
+		return (T*)Allocate(sizeof(T) * count);
+	}
+
+	static void CountHeapAllocation();
+
+private:
+	static FrameAllocatorClass* m_instance;
+	static std::atomic<long long> m_heapAllocations;
+
+	char* m_memory;
+	char* m_buffers[2];
+	int m_currentBuffer;
+	int m_capacity;
+	std::atomic<int> m_offset;
+	std::atomic<int> m_failedAllocations;
+	long long m_lastHeapAllocations;
+	StatsType m_stats;
+	int m_metrics[4];
+};
+
+#endif
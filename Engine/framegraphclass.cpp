@@ -0,0 +1,404 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framegraphclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "framegraphclass.h"
+#include "profilerclass.h"
+#include "clockclass.h"
+#include "statsoverlayclass.h"
+#include <string.h>
+
+
+FrameGraphClass::FrameGraphClass()
+{
+	int i;
+
+
+	m_tasks = 0;
+	m_taskCount = 0;
+	m_resourceCount = 0;
+	m_counter.pending = 0;
+	m_failed = false;
+	m_startTime = 0;
+	memset(&m_stats, 0, sizeof(StatsType));
+
+	for(i=0; i<FRAME_GRAPH_METRICS; i++)
+	{
+		m_metrics[i] = -1;
+	}
+}
+
+
+FrameGraphClass::FrameGraphClass(const FrameGraphClass& other)
+{
+}
+
+
+FrameGraphClass::~FrameGraphClass()
+{
+}
+
+
+bool FrameGraphClass::Initialize()
+{
+	// Create the task array.
+	m_tasks = new TaskType[FRAME_GRAPH_MAX_TASKS];
+	if(!m_tasks)
+	{
+		return false;
+	}
+
+	m_taskCount = 0;
+	m_resourceCount = 0;
+
+	// Show how long the graph took against how long it could have taken in the stats overlay.
+	m_metrics[0] = StatsOverlayClass::AddGauge("Frame graph", "Graph", 2, "ms");
+	m_metrics[1] = StatsOverlayClass::AddGauge("Frame graph", "Critical path", 2, "ms");
+	m_metrics[2] = StatsOverlayClass::AddGauge("Frame graph", "Serial", 2, "ms");
+	m_metrics[3] = StatsOverlayClass::AddCounter("Frame graph", "Edges", "");
+
+	return true;
+}
+
+
+void FrameGraphClass::Shutdown()
+{
+	int i;
+
+
+	// Take the graph metrics off the overlay.
+	for(i=0; i<FRAME_GRAPH_METRICS; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
+	// Release the tasks and anything they were given to call.
+	if(m_tasks)
+	{
+		for(i=0; i<m_taskCount; i++)
+		{
+			StatsOverlayClass::RemoveMetric(m_tasks[i].metric);
+
+			if(m_tasks[i].release)
+			{
+				m_tasks[i].release(m_tasks[i].data);
+			}
+		}
+
+		delete [] m_tasks;
+		m_tasks = 0;
+	}
+
+	m_taskCount = 0;
+	m_resourceCount = 0;
+
+	return;
+}
+
+
+int FrameGraphClass::AddResource(const char* name)
+{
+	if(m_resourceCount >= FRAME_GRAPH_MAX_RESOURCES)
+	{
+		return -1;
+	}
+
+	m_resources[m_resourceCount] = name;
+	m_resourceCount++;
+
+	return m_resourceCount - 1;
+}
+
+
+int FrameGraphClass::AddTask(const char* name, FrameTaskFunction function, void* data)
+{
+	TaskType* task;
+
+
+	if(m_taskCount >= FRAME_GRAPH_MAX_TASKS)
+	{
+		return -1;
+	}
+
+	task = &m_tasks[m_taskCount];
+	task->name = name;
+	task->function = function;
+	task->data = data;
+	task->release = 0;
+	task->reads = 0;
+	task->writes = 0;
+	task->successorCount = 0;
+	task->predecessorCount = 0;
+	task->pending = 0;
+	task->startTime = 0;
+	task->endTime = 0;
+	task->time = 0.0f;
+	task->pathTime = 0.0f;
+	task->critical = false;
+
+	// Every task shows its time in the overlay, the ones on the critical path are highlighted.
+	task->metric = StatsOverlayClass::AddGauge("Frame graph", name, 2, "ms");
+
+	m_taskCount++;
+
+	return m_taskCount - 1;
+}
+
+
+void FrameGraphClass::Read(int task, int resource)
+{
+	if((task < 0) || (task >= m_taskCount) || (resource < 0) || (resource >= m_resourceCount))
+	{
+		return;
+	}
+
+	m_tasks[task].reads |= 1u << resource;
+
+	return;
+}
+
+
+void FrameGraphClass::Write(int task, int resource)
+{
+	if((task < 0) || (task >= m_taskCount) || (resource < 0) || (resource >= m_resourceCount))
+	{
+		return;
+	}
+
+	m_tasks[task].writes |= 1u << resource;
+
+	return;
+}
+
+
+bool FrameGraphClass::Compile()
+{
+	TaskType *task, *earlier;
+	int i, j;
+
+
+	m_stats.tasks = m_taskCount;
+	m_stats.edges = 0;
+
+	for(i=0; i<m_taskCount; i++)
+	{
+		m_tasks[i].successorCount = 0;
+		m_tasks[i].predecessorCount = 0;
+	}
+
+	// Tasks were added in the order they would run one after another, so an edge only ever goes from an earlier task to
+	// a later one and the graph can not have a cycle.
+	for(i=0; i<m_taskCount; i++)
+	{
+		task = &m_tasks[i];
+
+		for(j=0; j<i; j++)
+		{
+			earlier = &m_tasks[j];
+
+			// Reads can run alongside each other, a write has to wait for anything before it that touches the resource.
+			if((task->writes & (earlier->reads | earlier->writes)) || (task->reads & earlier->writes))
+			{
+				earlier->successors[earlier->successorCount] = i;
+				earlier->successorCount++;
+
+				task->predecessors[task->predecessorCount] = j;
+				task->predecessorCount++;
+
+				m_stats.edges++;
+			}
+		}
+	}
+
+	StatsOverlayClass::SetCounter(m_metrics[3], m_stats.edges);
+
+	return true;
+}
+
+
+bool FrameGraphClass::Execute()
+{
+	int i;
+
+
+	PROFILE_ZONE("Frame Graph");
+
+	if(m_taskCount == 0)
+	{
+		return true;
+	}
+
+	m_failed = false;
+	m_startTime = ClockClass::GetTimestamp();
+
+	// Each task waits on however many tasks come before it.
+	for(i=0; i<m_taskCount; i++)
+	{
+		m_tasks[i].pending.store(m_tasks[i].predecessorCount, std::memory_order_relaxed);
+	}
+
+	// Start the tasks that depend on nothing, the rest are started by the last task they wait on.
+	m_counter.pending.store(0, std::memory_order_relaxed);
+
+	for(i=0; i<m_taskCount; i++)
+	{
+		if(m_tasks[i].predecessorCount == 0)
+		{
+			JobSystemClass::Run(&FrameGraphClass::RunTask, this, i, i + 1, &m_counter);
+		}
+	}
+
+	// Run tasks on this thread as well until every one has finished.
+	JobSystemClass::Wait(&m_counter);
+
+	m_stats.graphTime = ClockClass::ToMilliseconds(ClockClass::GetTimestamp() - m_startTime);
+
+	FindCriticalPath();
+	UpdateMetrics();
+
+	return !m_failed;
+}
+
+
+void FrameGraphClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+const char* FrameGraphClass::GetTaskName(int task)
+{
+	return ((task >= 0) && (task < m_taskCount)) ? m_tasks[task].name : 0;
+}
+
+
+float FrameGraphClass::GetTaskTime(int task)
+{
+	return ((task >= 0) && (task < m_taskCount)) ? m_tasks[task].time : 0.0f;
+}
+
+
+bool FrameGraphClass::IsTaskCritical(int task)
+{
+	return ((task >= 0) && (task < m_taskCount)) ? m_tasks[task].critical : false;
+}
+
+
+void FrameGraphClass::RunTask(void* data, int start, int end)
+{
+	FrameGraphClass* graph;
+	TaskType* task;
+	int i, successor;
+
+
+	graph = (FrameGraphClass*)data;
+	task = &graph->m_tasks[start];
+
+	task->startTime = ClockClass::GetTimestamp();
+
+	// Once a task has failed the rest are skipped, but they are still started so the graph finishes.
+	if(!graph->m_failed.load(std::memory_order_relaxed))
+	{
+		PROFILE_ZONE(task->name);
+
+		if(!task->function(task->data))
+		{
+			graph->m_failed = true;
+		}
+	}
+
+	task->endTime = ClockClass::GetTimestamp();
+
+	// Start every task that was only waiting on this one.  They are added before this job counts as done so the
+	// counter can not reach zero early.
+	for(i=0; i<task->successorCount; i++)
+	{
+		successor = task->successors[i];
+		if(graph->m_tasks[successor].pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			JobSystemClass::Run(&FrameGraphClass::RunTask, graph, successor, successor + 1, &graph->m_counter);
+		}
+	}
+
+	return;
+}
+
+
+void FrameGraphClass::FindCriticalPath()
+{
+	TaskType* task;
+	int i, j, last, longest;
+	float serialTime;
+
+
+	serialTime = 0.0f;
+	last = -1;
+
+	// The tasks are in dependency order, so the longest chain ending at each one can be found in a single pass.
+	for(i=0; i<m_taskCount; i++)
+	{
+		task = &m_tasks[i];
+		task->time = ClockClass::ToMilliseconds(task->endTime - task->startTime);
+		task->critical = false;
+
+		task->pathTime = 0.0f;
+		for(j=0; j<task->predecessorCount; j++)
+		{
+			if(m_tasks[task->predecessors[j]].pathTime > task->pathTime)
+			{
+				task->pathTime = m_tasks[task->predecessors[j]].pathTime;
+			}
+		}
+		task->pathTime += task->time;
+
+		serialTime += task->time;
+
+		if((last < 0) || (task->pathTime > m_tasks[last].pathTime))
+		{
+			last = i;
+		}
+	}
+
+	m_stats.serialTime = serialTime;
+	m_stats.criticalPathTime = m_tasks[last].pathTime;
+
+	// Walk back from the end of the longest chain marking the tasks on it.
+	while(last >= 0)
+	{
+		task = &m_tasks[last];
+		task->critical = true;
+
+		longest = -1;
+		for(j=0; j<task->predecessorCount; j++)
+		{
+			if((longest < 0) || (m_tasks[task->predecessors[j]].pathTime > m_tasks[longest].pathTime))
+			{
+				longest = task->predecessors[j];
+			}
+		}
+
+		last = longest;
+	}
+
+	return;
+}
+
+
+void FrameGraphClass::UpdateMetrics()
+{
+	int i;
+
+
+	StatsOverlayClass::SetGauge(m_metrics[0], m_stats.graphTime);
+	StatsOverlayClass::SetGauge(m_metrics[1], m_stats.criticalPathTime);
+	StatsOverlayClass::SetGauge(m_metrics[2], m_stats.serialTime);
+
+	for(i=0; i<m_taskCount; i++)
+	{
+		StatsOverlayClass::SetGauge(m_tasks[i].metric, m_tasks[i].time);
+		StatsOverlayClass::SetWarning(m_tasks[i].metric, m_tasks[i].critical);
+	}
+
+	return;
+}
@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framegraphclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FRAMEGRAPHCLASS_H_
+#define _FRAMEGRAPHCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int FRAME_GRAPH_MAX_TASKS = 32;
+const int FRAME_GRAPH_MAX_RESOURCES = 32;
+const int FRAME_GRAPH_METRICS = 4;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "jobsystemclass.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// A task returns false if the frame can not go on.
+typedef bool (*FrameTaskFunction)(void*);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FrameGraphClass
+////////////////////////////////////////////////////////////////////////////////
+class FrameGraphClass
+{
+private:
+	// The reads and writes are bit masks of resources.  A task waits for every earlier task that writes something it
+	// reads or writes, and for every earlier task that reads something it writes.
+	struct TaskType
+	{
+		const char* name;
+		FrameTaskFunction function;
+		void* data;
+		void (*release)(void*);
+		unsigned int reads, writes;
+		int successors[FRAME_GRAPH_MAX_TASKS];
+		int successorCount;
+		int predecessors[FRAME_GRAPH_MAX_TASKS];
+		int predecessorCount;
+		std::atomic<int> pending;
+		long long startTime, endTime;
+		float time, pathTime;
+		bool critical;
+		int metric;
+	};
+
+	// Calls a member function, for tasks on a class.
+	template<class T>
+	struct MemberTaskType
+	{
+		T* object;
+		bool (T::*function)();
+
+		static bool Run(void* data)
+		{
+			MemberTaskType* task = (MemberTaskType*)data;
+			return (task->object->*(task->function))();
+		}
+
+		static void Release(void* data)
+		{
+			delete (MemberTaskType*)data;
+		}
+	};
+
+public:
+	// Times for the last run in milliseconds.  The serial time is what the tasks would take one after another and the
+	// critical path is the longest chain of dependent tasks, the run can never take less than that.
+	struct StatsType
+	{
+		int tasks, edges;
+		float graphTime, serialTime, criticalPathTime;
+	};
+
+public:
+	FrameGraphClass();
+	FrameGraphClass(const FrameGraphClass&);
+	~FrameGraphClass();
+
+	bool Initialize();
+	void Shutdown();
+
+	// The graph is declared once.  Tasks are added in the order they would run one after another, then each declares
+	// the resources it reads and writes and Compile works out what has to wait for what.
+	int AddResource(const char*);
+	int AddTask(const char*, FrameTaskFunction, void*);
+
+	template<class T>
+	int AddTask(const char* name, T* object, bool (T::*function)())
+	{
+		MemberTaskType<T>* task;
+		int index;
+
+
+		task = new MemberTaskType<T>;
+		if(!task)
+		{
+			return -1;
+		}
+
+		task->object = object;
+		task->function = function;
+
+		index = AddTask(name, &MemberTaskType<T>::Run, task);
+		if(index < 0)
+		{
+			delete task;
+			return -1;
+		}
+
+		m_tasks[index].release = &MemberTaskType<T>::Release;
+
+		return index;
+	}
+
+	void Read(int, int);
+	void Write(int, int);
+	bool Compile();
+
+	// Runs every task as a job once the tasks it depends on are done and returns when they all are.
+	bool Execute();
+
+	void GetStats(StatsType&);
+	const char* GetTaskName(int);
+	float GetTaskTime(int);
+	bool IsTaskCritical(int);
+
+private:
+	static void RunTask(void*, int, int);
+	void FindCriticalPath();
+	void UpdateMetrics();
+
+private:
+	TaskType* m_tasks;
+	int m_taskCount;
+	const char* m_resources[FRAME_GRAPH_MAX_RESOURCES];
+	int m_resourceCount;
+	JobCounterType m_counter;
+	std::atomic<bool> m_failed;
+	long long m_startTime;
+	StatsType m_stats;
+	int m_metrics[FRAME_GRAPH_METRICS];
+};
+
+#endif
@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framelimiterclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "framelimiterclass.h"
+#include "profilerclass.h"
+#include "clockclass.h"
+#include "statsoverlayclass.h"
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+
+FrameLimiterClass::FrameLimiterClass()
+{
+	int i;
+
+
+	m_mode = FRAME_PACING_UNCAPPED;
+	m_framePeriod = 0.0;
+	m_nextFrameTime = 0.0;
+	m_lastFrameTime = 0.0;
+	m_frameIndex = 0;
+	m_frameCount = 0;
+	m_sleepTime = 0.0f;
+	m_spinTime = 0.0f;
+	m_timerPeriodSet = false;
+
+	for(i=0; i<FRAME_LIMITER_METRICS; i++)
+	{
+		m_metrics[i] = -1;
+	}
+}
+
+
+FrameLimiterClass::FrameLimiterClass(const FrameLimiterClass& other)
+{
+}
+
+
+FrameLimiterClass::~FrameLimiterClass()
+{
+}
+
+
+bool FrameLimiterClass::Initialize(FramePacing mode, float targetRate)
+{
+#ifdef _WIN32
+	// Ask for one millisecond scheduler ticks so a sleep wakes up close to when it was asked to.
+	m_timerPeriodSet = (timeBeginPeriod(1) == TIMERR_NOERROR);
+#endif
+
+	m_mode = mode;
+	SetTargetRate(targetRate);
+
+	m_lastFrameTime = GetTime();
+	m_nextFrameTime = m_lastFrameTime + m_framePeriod;
+
+	// Show the pacing in the stats overlay.
+	m_metrics[0] = StatsOverlayClass::AddLabel("Pacing", "Mode");
+	m_metrics[1] = StatsOverlayClass::AddGauge("Pacing", "Frame", 2, "ms");
+	m_metrics[2] = StatsOverlayClass::AddGauge("Pacing", "Jitter", 2, "ms");
+	m_metrics[3] = StatsOverlayClass::AddGauge("Pacing", "Sleep", 2, "ms");
+	m_metrics[4] = StatsOverlayClass::AddGauge("Pacing", "Spin", 2, "ms");
+
+	return true;
+}
+
+
+void FrameLimiterClass::Shutdown()
+{
+	int i;
+
+
+	for(i=0; i<FRAME_LIMITER_METRICS; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
+#ifdef _WIN32
+	// Give the scheduler back its normal tick rate.
+	if(m_timerPeriodSet)
+	{
+		timeEndPeriod(1);
+		m_timerPeriodSet = false;
+	}
+#endif
+
+	return;
+}
+
+
+void FrameLimiterClass::SetMode(FramePacing mode)
+{
+	m_mode = mode;
+
+	// Start the schedule again from now so the first limited frame does not try to catch up.
+	m_nextFrameTime = GetTime() + m_framePeriod;
+
+	return;
+}
+
+
+FramePacing FrameLimiterClass::GetMode()
+{
+	return m_mode;
+}
+
+
+void FrameLimiterClass::SetTargetRate(float targetRate)
+{
+	if(targetRate < 1.0f)
+	{
+		targetRate = 1.0f;
+	}
+
+	m_framePeriod = 1000.0 / (double)targetRate;
+
+	return;
+}
+
+
+void FrameLimiterClass::Wait()
+{
+	double currentTime, startTime, spinStart;
+
+
+	PROFILE_ZONE("Wait");
+
+	startTime = GetTime();
+	currentTime = startTime;
+	spinStart = startTime;
+
+	if(m_mode == FRAME_PACING_LIMITED)
+	{
+		// If the frame ran over by more than a whole period then start the schedule again rather than rushing the next frames.
+		if(currentTime > m_nextFrameTime + m_framePeriod)
+		{
+			m_nextFrameTime = currentTime;
+		}
+
+		// Sleep through most of the wait, the sleep can overshoot so stop short of the deadline.
+		if(m_nextFrameTime - currentTime > FRAME_LIMITER_SPIN_TIME)
+		{
+			SleepFor(m_nextFrameTime - currentTime - FRAME_LIMITER_SPIN_TIME);
+			currentTime = GetTime();
+		}
+
+		// Spin through the last part of the wait to land on the deadline.
+		spinStart = currentTime;
+		while(currentTime < m_nextFrameTime)
+		{
+			currentTime = GetTime();
+		}
+
+		// Schedule the next frame from this deadline rather than from now so the errors do not add up.
+		m_nextFrameTime += m_framePeriod;
+	}
+
+	m_sleepTime = (float)(spinStart - startTime);
+	m_spinTime = (float)(currentTime - spinStart);
+
+	// Record the time since the last frame ended.
+	m_frameTimes[m_frameIndex] = (float)(currentTime - m_lastFrameTime);
+	m_frameIndex = (m_frameIndex + 1) % FRAME_LIMITER_HISTORY;
+	if(m_frameCount < FRAME_LIMITER_HISTORY)
+	{
+		m_frameCount++;
+	}
+
+	m_lastFrameTime = currentTime;
+
+	UpdateMetrics();
+
+	return;
+}
+
+
+void FrameLimiterClass::GetStats(StatsType& stats)
+{
+	double total, difference, variance;
+	int i;
+
+
+	stats.averageTime = 0.0f;
+	stats.jitter = 0.0f;
+	stats.minimumTime = 0.0f;
+	stats.maximumTime = 0.0f;
+	stats.sleepTime = m_sleepTime;
+	stats.spinTime = m_spinTime;
+
+	if(m_frameCount == 0)
+	{
+		return;
+	}
+
+	// Find the average, the minimum and the maximum frame time.
+	total = 0.0;
+	stats.minimumTime = m_frameTimes[0];
+	stats.maximumTime = m_frameTimes[0];
+	for(i=0; i<m_frameCount; i++)
+	{
+		total += m_frameTimes[i];
+
+		if(m_frameTimes[i] < stats.minimumTime)
+		{
+			stats.minimumTime = m_frameTimes[i];
+		}
+
+		if(m_frameTimes[i] > stats.maximumTime)
+		{
+			stats.maximumTime = m_frameTimes[i];
+		}
+	}
+
+	stats.averageTime = (float)(total / m_frameCount);
+
+	// The jitter is the standard deviation of the frame times.
+	variance = 0.0;
+	for(i=0; i<m_frameCount; i++)
+	{
+		difference = m_frameTimes[i] - stats.averageTime;
+		variance += difference * difference;
+	}
+
+	stats.jitter = (float)sqrt(variance / m_frameCount);
+
+	return;
+}
+
+
+double FrameLimiterClass::GetTime()
+{
+	// The schedule is kept in milliseconds as a double, which still resolves well under a microsecond after months.
+	return (double)ClockClass::GetTimestamp() / 1000000.0;
+}
+
+
+void FrameLimiterClass::SleepFor(double time)
+{
+#ifdef _WIN32
+	::Sleep((DWORD)time);
+#else
+	std::this_thread::sleep_for(std::chrono::microseconds((long long)(time * 1000.0)));
+#endif
+
+	return;
+}
+
+
+void FrameLimiterClass::UpdateMetrics()
+{
+	static const char* modeNames[FRAME_PACING_COUNT] = { "Uncapped", "Vsync", "Limited" };
+	StatsType stats;
+
+
+	GetStats(stats);
+
+	StatsOverlayClass::SetLabel(m_metrics[0], modeNames[m_mode]);
+	StatsOverlayClass::SetGauge(m_metrics[1], stats.averageTime);
+	StatsOverlayClass::SetGauge(m_metrics[2], stats.jitter);
+	StatsOverlayClass::SetGauge(m_metrics[3], stats.sleepTime);
+	StatsOverlayClass::SetGauge(m_metrics[4], stats.spinTime);
+
+	// Flag a frame time that swings by more than a tenth of the frame.
+	StatsOverlayClass::SetWarning(m_metrics[2], stats.jitter > stats.averageTime * 0.1f);
+
+	return;
+}
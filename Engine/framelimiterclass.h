@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framelimiterclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FRAMELIMITERCLASS_H_
+#define _FRAMELIMITERCLASS_H_
+
+
+/////////////
+// LINKING //
+/////////////
+#ifdef _WIN32
+#pragma comment(lib, "winmm.lib")
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+const float FRAME_LIMITER_SPIN_TIME = 2.0f;
+const int FRAME_LIMITER_HISTORY = 120;
+const int FRAME_LIMITER_METRICS = 5;
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+enum FramePacing
+{
+	FRAME_PACING_UNCAPPED,
+	FRAME_PACING_VSYNC,
+	FRAME_PACING_LIMITED,
+	FRAME_PACING_COUNT
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FrameLimiterClass
+////////////////////////////////////////////////////////////////////////////////
+class FrameLimiterClass
+{
+public:
+	// Frame times are in milliseconds over the last FRAME_LIMITER_HISTORY frames, the jitter is their standard deviation.
+	struct StatsType
+	{
+		float averageTime, jitter;
+		float minimumTime, maximumTime;
+		float sleepTime, spinTime;
+	};
+
+public:
+	FrameLimiterClass();
+	FrameLimiterClass(const FrameLimiterClass&);
+	~FrameLimiterClass();
+
+	bool Initialize(FramePacing, float);
+	void Shutdown();
+
+	void SetMode(FramePacing);
+	FramePacing GetMode();
+	void SetTargetRate(float);
+
+	void Wait();
+
+	void GetStats(StatsType&);
+
+private:
+	double GetTime();
+	void SleepFor(double);
+	void UpdateMetrics();
+
+private:
+	FramePacing m_mode;
+	double m_framePeriod;
+	double m_nextFrameTime, m_lastFrameTime;
+	float m_frameTimes[FRAME_LIMITER_HISTORY];
+	int m_frameIndex, m_frameCount;
+	float m_sleepTime, m_spinTime;
+	bool m_timerPeriodSet;
+	int m_metrics[FRAME_LIMITER_METRICS];
+};
+
+#endif
@@ -2,13 +2,35 @@
 // Filename: inputclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "inputclass.h"
+#include "profilerclass.h"
+#include "clockclass.h"
+#include "statsoverlayclass.h"
+#include <string.h>
 
 
 InputClass::InputClass()
 {
+	int i;
+
+
 	m_directInput = 0;
 	m_keyboard = 0;
 	m_mouse = 0;
+	m_Queue = 0;
+	m_resync = false;
+	m_lastSampleTime = 0;
+	m_droppedEvents = 0;
+	m_events = 0;
+	m_stepEvents = 0;
+	m_stepEventCount = 0;
+	m_eventCount = 0;
+	m_inputTime = 0;
+	m_bindingCount = 0;
+
+	for(i=0; i<INPUT_METRICS; i++)
+	{
+		m_metrics[i] = -1;
+	}
 }
 
 
@@ -24,6 +46,7 @@ InputClass::~InputClass()
 
 bool InputClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth, int screenHeight)
 {
+	DIPROPDWORD bufferSize;
 	HRESULT result;
 
 
@@ -35,6 +58,50 @@ bool InputClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth, int
 	m_mouseX = 0;
 	m_mouseY = 0;
 
+	// Start with every key up and nothing published.
+	memset(m_keyboardSample, 0, sizeof(m_keyboardSample));
+	memset(m_publishedState, 0, sizeof(m_publishedState));
+	memset(m_keyboardState, 0, sizeof(m_keyboardState));
+	memset(m_stepState, 0, sizeof(m_stepState));
+	memset(&m_mouseState, 0, sizeof(DIMOUSESTATE));
+	m_mouseMoveX = 0;
+	m_mouseMoveY = 0;
+	m_droppedEvents = 0;
+	m_eventCount = 0;
+	m_inputTime = 0;
+	m_stepEventCount = 0;
+
+	// Read the whole keyboard state with the first sample, for keys that are already down.
+	m_resync = true;
+	m_lastSampleTime = 0;
+
+	// Create the array of the events each frame applies.
+	m_events = new InputEventType[INPUT_QUEUE_SIZE];
+	if(!m_events)
+	{
+		return false;
+	}
+
+	// Create the array of the key events waiting for a step.
+	m_stepEvents = new InputEventType[INPUT_STEP_EVENTS];
+	if(!m_stepEvents)
+	{
+		return false;
+	}
+
+	// Create the queue the events are passed to the frame through.
+	m_Queue = new InputQueueClass;
+	if(!m_Queue)
+	{
+		return false;
+	}
+
+	// Initialize the queue.
+	if(!m_Queue->Initialize())
+	{
+		return false;
+	}
+
 	// Initialize the main direct input interface.
 	result = DirectInput8Create(hinstance, DIRECTINPUT_VERSION, IID_IDirectInput8, (void**)&m_directInput, NULL);
 	if(FAILED(result))
@@ -63,6 +130,19 @@ bool InputClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth, int
 		return false;
 	}
 
+	// Give the keyboard a buffer so every key change between samples is kept, not just the state when it is sampled.
+	bufferSize.diph.dwSize = sizeof(DIPROPDWORD);
+	bufferSize.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+	bufferSize.diph.dwObj = 0;
+	bufferSize.diph.dwHow = DIPH_DEVICE;
+	bufferSize.dwData = INPUT_DEVICE_BUFFER;
+
+	result = m_keyboard->SetProperty(DIPROP_BUFFERSIZE, &bufferSize.diph);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
 	// Now acquire the keyboard.
 	result = m_keyboard->Acquire();
 	if(FAILED(result))
@@ -127,17 +207,45 @@ void InputClass::Shutdown()
 		m_directInput = 0;
 	}
 
+	// Release the event queue.
+	if(m_Queue)
+	{
+		m_Queue->Shutdown();
+		delete m_Queue;
+		m_Queue = 0;
+	}
+
+	// Release the frame's events.
+	if(m_events)
+	{
+		delete [] m_events;
+		m_events = 0;
+	}
+
+	// Release the events waiting for a step.
+	if(m_stepEvents)
+	{
+		delete [] m_stepEvents;
+		m_stepEvents = 0;
+	}
+
+	m_stepEventCount = 0;
+
 	return;
 }
 
 
-bool InputClass::Frame()
+bool InputClass::Sample()
 {
+	InputEventType event;
+	long long sampleTime;
 	bool result;
 
 
-	// Read the current state of the keyboard.
-	result = ReadKeyboard();
+	sampleTime = ClockClass::GetTimestamp();
+
+	// Publish the key changes since the last sample.
+	result = ReadKeyboard(sampleTime);
 	if(!result)
 	{
 		return false;
@@ -150,33 +258,221 @@ bool InputClass::Frame()
 		return false;
 	}
 
-	// Process the changes in the mouse and keyboard.
-	ProcessInput();
+	// Publish the mouse movement, movement that does not fit is added to the next sample's.
+	m_mouseMoveX += m_mouseState.lX;
+	m_mouseMoveY += m_mouseState.lY;
+
+	if(m_mouseMoveX || m_mouseMoveY)
+	{
+		event.time = sampleTime;
+		event.type = INPUT_MOUSE_MOVE;
+		event.key = 0;
+		event.x = m_mouseMoveX;
+		event.y = m_mouseMoveY;
+
+		if(m_Queue->Push(event))
+		{
+			m_mouseMoveX = 0;
+			m_mouseMoveY = 0;
+		}
+		else
+		{
+			m_droppedEvents++;
+		}
+	}
+
+	return true;
+}
+
+
+bool InputClass::Frame()
+{
+	int i;
+
+
+	PROFILE_ZONE("Input");
+
+	// Forget last frame's presses and releases, the keys that are down stay down.
+	for(i=0; i<256; i++)
+	{
+		m_keyboardState[i] &= INPUT_STATE_DOWN;
+	}
+
+	// Apply every event published since the last frame in the order they happened, any that do not fit in the frame's
+	// array are left for the next frame.
+	m_eventCount = 0;
+	while((m_eventCount < INPUT_QUEUE_SIZE) && m_Queue->Pop(m_events[m_eventCount]))
+	{
+		ProcessInput(m_events[m_eventCount]);
+		m_eventCount++;
+	}
+
+	// Keep the key events for the steps they fall in.  If the steps have fallen that far behind then the oldest events
+	// are applied to the step state now rather than lost.
+	for(i=0; i<m_eventCount; i++)
+	{
+		if(m_events[i].type == INPUT_MOUSE_MOVE)
+		{
+			continue;
+		}
+
+		if(m_stepEventCount == INPUT_STEP_EVENTS)
+		{
+			ApplyKey(m_stepState, m_stepEvents[0]);
+			memmove(m_stepEvents, m_stepEvents + 1, sizeof(InputEventType) * (m_stepEventCount - 1));
+			m_stepEventCount--;
+		}
+
+		m_stepEvents[m_stepEventCount] = m_events[i];
+		m_stepEventCount++;
+	}
+
+	m_inputTime = (m_eventCount > 0) ? m_events[0].time : 0;
+
+	// Show how much input the frame took and how long the oldest of it waited.
+	StatsOverlayClass::SetCounter(m_metrics[0], m_eventCount);
+	StatsOverlayClass::SetCounter(m_metrics[1], m_droppedEvents.load(std::memory_order_relaxed));
+	if(m_eventCount > 0)
+	{
+		StatsOverlayClass::SetGauge(m_metrics[2], ClockClass::ToMilliseconds(ClockClass::GetTimestamp() - m_inputTime));
+	}
 
 	return true;
 }
 
 
-bool InputClass::ReadKeyboard()
+void InputClass::AddMetrics()
+{
+	m_metrics[0] = StatsOverlayClass::AddCounter("Input", "Events", "");
+	m_metrics[1] = StatsOverlayClass::AddCounter("Input", "Dropped", "");
+	m_metrics[2] = StatsOverlayClass::AddGauge("Input", "Event wait", 2, "ms");
+
+	return;
+}
+
+
+void InputClass::RemoveMetrics()
+{
+	int i;
+
+
+	for(i=0; i<INPUT_METRICS; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
+	return;
+}
+
+
+int InputClass::GetEventCount()
+{
+	return m_eventCount;
+}
+
+
+const InputEventType& InputClass::GetEvent(int index)
+{
+	return m_events[index];
+}
+
+
+long long InputClass::GetInputTime()
+{
+	return m_inputTime;
+}
+
+
+bool InputClass::ReadKeyboard(long long sampleTime)
 {
 	HRESULT result;
+	DWORD count, tickCount;
+	long long time, earliestTime;
+	int i, age;
 
 
-	// Read the keyboard device.
-	result = m_keyboard->GetDeviceState(sizeof(m_keyboardState), (LPVOID)&m_keyboardState);
+	// Read every key change the keyboard buffered since the last sample.
+	count = INPUT_DEVICE_BUFFER;
+	result = m_keyboard->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), m_keyboardData, &count, 0);
+	tickCount = GetTickCount();
 	if(FAILED(result))
 	{
-		// If the keyboard lost focus or was not acquired then try to get control back.
+		// If the keyboard lost focus or was not acquired then try to get control back and read its state again.
 		if((result == DIERR_INPUTLOST) || (result == DIERR_NOTACQUIRED))
 		{
 			m_keyboard->Acquire();
+			m_resync = true;
+			count = 0;
 		}
 		else
 		{
 			return false;
 		}
 	}
-		
+
+	// A full buffer means some changes were lost, so the state is read back instead.
+	if(result == DI_BUFFEROVERFLOW)
+	{
+		m_resync = true;
+	}
+
+	// DirectInput stamps each change with the tick count in milliseconds, which is taken to be the sample time now, so
+	// a change's time is the sample time less its age.  The buffer is in dwSequence order and the tick count is coarse,
+	// so the times are kept between the last sample and this one and never go backwards, the queue stays in order.
+	earliestTime = m_lastSampleTime;
+	m_lastSampleTime = sampleTime;
+
+	for(i=0; (i<(int)count) && !m_resync; i++)
+	{
+		age = (int)(tickCount - m_keyboardData[i].dwTimeStamp);
+		if(age < 0)
+		{
+			age = 0;
+		}
+
+		time = sampleTime - (long long)age * 1000000LL;
+		if(time < earliestTime)
+		{
+			time = earliestTime;
+		}
+		earliestTime = time;
+
+		if(!PublishKey(time, m_keyboardData[i].dwOfs & 0xff, (m_keyboardData[i].dwData & 0x80) != 0))
+		{
+			m_resync = true;
+		}
+	}
+
+	if(!m_resync)
+	{
+		return true;
+	}
+
+	// Read the whole keyboard state back, until the keyboard is acquired again every key is up.
+	result = m_keyboard->GetDeviceState(sizeof(m_keyboardSample), (LPVOID)&m_keyboardSample);
+	if(FAILED(result))
+	{
+		if((result == DIERR_INPUTLOST) || (result == DIERR_NOTACQUIRED))
+		{
+			memset(m_keyboardSample, 0, sizeof(m_keyboardSample));
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// Publish every key that differs from what was published, the keys are in step again once they all fit.
+	m_resync = FAILED(result);
+	for(i=0; i<256; i++)
+	{
+		if(!PublishKey(sampleTime, i, (m_keyboardSample[i] & 0x80) != 0))
+		{
+			m_resync = true;
+		}
+	}
+
 	return true;
 }
 
@@ -190,9 +486,10 @@ bool InputClass::ReadMouse()
 	result = m_mouse->GetDeviceState(sizeof(DIMOUSESTATE), (LPVOID)&m_mouseState);
 	if(FAILED(result))
 	{
-		// If the mouse lost focus or was not acquired then try to get control back.
+		// If the mouse lost focus or was not acquired then try to get control back, until then it does not move.
 		if((result == DIERR_INPUTLOST) || (result == DIERR_NOTACQUIRED))
 		{
+			memset(&m_mouseState, 0, sizeof(DIMOUSESTATE));
 			m_mouse->Acquire();
 		}
 		else
@@ -205,11 +502,47 @@ bool InputClass::ReadMouse()
 }
 
 
-void InputClass::ProcessInput()
+bool InputClass::PublishKey(long long time, int key, bool down)
+{
+	InputEventType event;
+
+
+	// Nothing is sent if the frame already has the key this way.
+	if(((m_publishedState[key] & 0x80) != 0) == down)
+	{
+		return true;
+	}
+
+	event.time = time;
+	event.type = down ? INPUT_KEY_DOWN : INPUT_KEY_UP;
+	event.key = key;
+	event.x = 0;
+	event.y = 0;
+
+	if(!m_Queue->Push(event))
+	{
+		m_droppedEvents++;
+		return false;
+	}
+
+	m_publishedState[key] = down ? 0x80 : 0;
+
+	return true;
+}
+
+
+void InputClass::ProcessInput(const InputEventType& event)
 {
-	// Update the location of the mouse cursor based on the change of the mouse location during the frame.
-	m_mouseX += m_mouseState.lX;
-	m_mouseY += m_mouseState.lY;
+	// Keep the key state up to date with the key events.
+	if(event.type != INPUT_MOUSE_MOVE)
+	{
+		ApplyKey(m_keyboardState, event);
+		return;
+	}
+
+	// Update the location of the mouse cursor based on how far the mouse moved.
+	m_mouseX += event.x;
+	m_mouseY += event.y;
 
 	// Ensure the mouse location doesn't exceed the screen width or height.
 	if(m_mouseX < 0)  { m_mouseX = 0; }
@@ -222,6 +555,21 @@ void InputClass::ProcessInput()
 }
 
 
+void InputClass::ApplyKey(unsigned char* state, const InputEventType& event)
+{
+	if(event.type == INPUT_KEY_DOWN)
+	{
+		state[event.key] |= INPUT_STATE_DOWN | INPUT_STATE_PRESSED;
+	}
+	else
+	{
+		state[event.key] = (state[event.key] & ~INPUT_STATE_DOWN) | INPUT_STATE_RELEASED;
+	}
+
+	return;
+}
+
+
 void InputClass::GetMouseLocation(int& mouseX, int& mouseY)
 {
 	mouseX = m_mouseX;
@@ -230,119 +578,119 @@ void InputClass::GetMouseLocation(int& mouseX, int& mouseY)
 }
 
 
-bool InputClass::IsEscapePressed()
+bool InputClass::IsKeyDown(int key)
 {
-	// Do a bitwise and on the keyboard state to check if the escape key is currently being pressed.
-	if(m_keyboardState[DIK_ESCAPE] & 0x80)
-	{
-		return true;
-	}
-
-	return false;
+	return ((key >= 0) && (key < 256)) ? ((m_keyboardState[key] & INPUT_STATE_DOWN) != 0) : false;
 }
 
-bool InputClass::IsSpacePressed()
+
+bool InputClass::WasKeyPressed(int key)
 {
-	// Do a bitwise and on the keyboard state to check if the key is currently being pressed.
-	if(m_keyboardState[DIK_SPACE] & 0x80)
-	{
-		return true;
-	}
+	return ((key >= 0) && (key < 256)) ? ((m_keyboardState[key] & INPUT_STATE_PRESSED) != 0) : false;
+}
 
-	return false;
+
+bool InputClass::WasKeyReleased(int key)
+{
+	return ((key >= 0) && (key < 256)) ? ((m_keyboardState[key] & INPUT_STATE_RELEASED) != 0) : false;
 }
 
-bool InputClass::IsLeftPressed()
+
+bool InputClass::BindAction(int action, int key)
 {
-	// Do a bitwise and on the keyboard state to check if the key is currently being pressed.
-	if(m_keyboardState[DIK_LEFT] & 0x80)
+	if((action < 0) || (action >= INPUT_MAX_ACTIONS) || (key < 0) || (key >= 256) || (m_bindingCount >= INPUT_MAX_BINDINGS))
 	{
-		return true;
+		return false;
 	}
 
-	return false;
+	m_bindings[m_bindingCount].action = action;
+	m_bindings[m_bindingCount].key = key;
+	m_bindingCount++;
+
+	return true;
 }
 
 
-bool InputClass::IsRightPressed()
+void InputClass::ClearActions()
 {
-	// Do a bitwise and on the keyboard state to check if the key is currently being pressed.
-	if(m_keyboardState[DIK_RIGHT] & 0x80)
-	{
-		return true;
-	}
-
-	return false;
+	m_bindingCount = 0;
+	return;
 }
 
 
-bool InputClass::IsUpPressed()
+bool InputClass::IsActionDown(int action)
 {
-	// Do a bitwise and on the keyboard state to check if the key is currently being pressed.
-	if(m_keyboardState[DIK_UP] & 0x80)
-	{
-		return true;
-	}
+	return TestAction(m_keyboardState, action, INPUT_STATE_DOWN);
+}
 
-	return false;
+
+bool InputClass::IsActionActive(int action)
+{
+	return TestAction(m_keyboardState, action, INPUT_STATE_DOWN | INPUT_STATE_PRESSED);
 }
 
 
-bool InputClass::IsDownPressed()
+bool InputClass::WasActionPressed(int action)
 {
-	// Do a bitwise and on the keyboard state to check if the key is currently being pressed.
-	if(m_keyboardState[DIK_DOWN] & 0x80)
-	{
-		return true;
-	}
+	return TestAction(m_keyboardState, action, INPUT_STATE_PRESSED);
+}
 
-	return false;
+
+bool InputClass::WasActionReleased(int action)
+{
+	return TestAction(m_keyboardState, action, INPUT_STATE_RELEASED);
 }
 
 
-bool InputClass::IsAPressed()
+void InputClass::BeginStep(long long endTime)
 {
-	// Do a bitwise and on the keyboard state to check if the key is currently being pressed.
-	if(m_keyboardState[DIK_A] & 0x80)
+	int count, i;
+
+
+	// Forget the last step's presses and releases, the keys that are down stay down.
+	for(i=0; i<256; i++)
 	{
-		return true;
+		m_stepState[i] &= INPUT_STATE_DOWN;
 	}
 
-	return false;
-}
-
+	// Apply the key events up to the end of the step in the order they happened.
+	count = 0;
+	while((count < m_stepEventCount) && (m_stepEvents[count].time <= endTime))
+	{
+		ApplyKey(m_stepState, m_stepEvents[count]);
+		count++;
+	}
 
-bool InputClass::IsZPressed()
-{
-	// Do a bitwise and on the keyboard state to check if the key is currently being pressed.
-	if(m_keyboardState[DIK_Z] & 0x80)
+	// Keep the rest for the later steps.
+	if(count > 0)
 	{
-		return true;
+		memmove(m_stepEvents, m_stepEvents + count, sizeof(InputEventType) * (m_stepEventCount - count));
+		m_stepEventCount -= count;
 	}
 
-	return false;
+	return;
 }
 
 
-bool InputClass::IsPgUpPressed()
+bool InputClass::IsStepActionActive(int action)
 {
-	// Do a bitwise and on the keyboard state to check if the key is currently being pressed.
-	if(m_keyboardState[DIK_PGUP] & 0x80)
-	{
-		return true;
-	}
-
-	return false;
+	return TestAction(m_stepState, action, INPUT_STATE_DOWN | INPUT_STATE_PRESSED);
 }
 
 
-bool InputClass::IsPgDownPressed()
+bool InputClass::TestAction(const unsigned char* keyboardState, int action, unsigned char state)
 {
-	// Do a bitwise and on the keyboard state to check if the key is currently being pressed.
-	if(m_keyboardState[DIK_PGDN] & 0x80)
+	int i;
+
+
+	// Check each key bound to the action.
+	for(i=0; i<m_bindingCount; i++)
 	{
-		return true;
+		if((m_bindings[i].action == action) && (keyboardState[m_bindings[i].key] & state))
+		{
+			return true;
+		}
 	}
 
 	return false;
-}
\ No newline at end of file
+}
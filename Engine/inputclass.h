@@ -5,6 +5,19 @@
 #define _INPUTCLASS_H_
 
 
+/////////////
+// GLOBALS //
+/////////////
+const int INPUT_METRICS = 3;
+const int INPUT_DEVICE_BUFFER = 256;
+const int INPUT_MAX_BINDINGS = 64;
+const int INPUT_MAX_ACTIONS = 32;
+const int INPUT_STEP_EVENTS = 1024;
+const unsigned char INPUT_STATE_DOWN = 0x80;
+const unsigned char INPUT_STATE_PRESSED = 0x01;
+const unsigned char INPUT_STATE_RELEASED = 0x02;
+
+
 ///////////////////////////////
 // PRE-PROCESSING DIRECTIVES //
 ///////////////////////////////
@@ -22,6 +35,13 @@
 // INCLUDES //
 //////////////
 #include <dinput.h>
+#include <atomic>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "inputqueueclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -29,6 +49,13 @@
 ////////////////////////////////////////////////////////////////////////////////
 class InputClass
 {
+private:
+	struct BindingType
+	{
+		int action;
+		int key;
+	};
+
 public:
 	InputClass();
 	InputClass(const InputClass&);
@@ -36,36 +63,87 @@ public:
 
 	bool Initialize(HINSTANCE, HWND, int, int);
 	void Shutdown();
+
+	// Sample runs on the window thread, it reads every key change the keyboard buffered since the last sample and
+	// publishes them as timestamped events.  Frame runs once a frame and applies every event published since the last
+	// one, the checks below see the result.
+	bool Sample();
 	bool Frame();
 
+	void AddMetrics();
+	void RemoveMetrics();
+
+	// The events the last frame applied in the order they happened, and the time of the oldest of them or zero if there
+	// were none.
+	int GetEventCount();
+	const InputEventType& GetEvent(int);
+	long long GetInputTime();
+
 	void GetMouseLocation(int&, int&);
 
-	bool IsSpacePressed();
-	bool IsEscapePressed();
-	bool IsLeftPressed();
-	bool IsRightPressed();
-	bool IsUpPressed();
-	bool IsDownPressed();
-	bool IsAPressed();
-	bool IsZPressed();
-	bool IsPgUpPressed();
-	bool IsPgDownPressed();
+	// Keys are DirectInput key codes.  A key is down if it was down at the end of the last frame, and pressed or
+	// released if it went down or up at any time during it, so a tap shorter than a frame is still seen.
+	bool IsKeyDown(int);
+	bool WasKeyPressed(int);
+	bool WasKeyReleased(int);
+
+	// Actions are numbers below INPUT_MAX_ACTIONS, each bound to one or more keys.  An action is down, pressed or
+	// released if any of its keys is.  An active action is down or was pressed during the frame, for actions that are
+	// held so that a tap still counts.
+	bool BindAction(int, int);
+	void ClearActions();
+	bool IsActionDown(int);
+	bool IsActionActive(int);
+	bool WasActionPressed(int);
+	bool WasActionReleased(int);
+
+	// A fixed step sees its own key state, built from the key events timestamped up to the end of the step so the same
+	// keys give the same steps whatever the frame rate.  BeginStep applies them, events after the step wait for a
+	// later one.  A step action is active if one of its keys was down at any time during the step.
+	void BeginStep(long long);
+	bool IsStepActionActive(int);
 
 private:
-	bool ReadKeyboard();
+	bool ReadKeyboard(long long);
 	bool ReadMouse();
-	void ProcessInput();
+	bool PublishKey(long long, int, bool);
+	void ProcessInput(const InputEventType&);
+	void ApplyKey(unsigned char*, const InputEventType&);
+	bool TestAction(const unsigned char*, int, unsigned char);
 
 private:
 	IDirectInput8* m_directInput;
 	IDirectInputDevice8* m_keyboard;
 	IDirectInputDevice8* m_mouse;
-
-	unsigned char m_keyboardState[256];
+	InputQueueClass* m_Queue;
+
+	// Only the window thread touches the device data and what it has published so far.  If the keyboard buffer or the
+	// queue overflows, or the keyboard is lost, the whole keyboard state is read back and whatever differs from what
+	// was published is sent with a later sample.
+	DIDEVICEOBJECTDATA m_keyboardData[INPUT_DEVICE_BUFFER];
+	unsigned char m_keyboardSample[256];
+	unsigned char m_publishedState[256];
+	bool m_resync;
+	long long m_lastSampleTime;
 	DIMOUSESTATE m_mouseState;
+	int m_mouseMoveX, m_mouseMoveY;
+	std::atomic<int> m_droppedEvents;
 
+	// Only the frame touches the state built from the events and the action bindings.
+	InputEventType* m_events;
+	int m_eventCount;
+	long long m_inputTime;
+	unsigned char m_keyboardState[256];
+	BindingType m_bindings[INPUT_MAX_BINDINGS];
+	int m_bindingCount;
 	int m_screenWidth, m_screenHeight;
 	int m_mouseX, m_mouseY;
+	int m_metrics[INPUT_METRICS];
+
+	// The key events the frames applied that no step has reached yet, and the key state the steps see.
+	InputEventType* m_stepEvents;
+	int m_stepEventCount;
+	unsigned char m_stepState[256];
 };
 
 #endif
\ No newline at end of file
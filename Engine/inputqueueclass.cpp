@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: inputqueueclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "inputqueueclass.h"
+
+
+InputQueueClass::InputQueueClass()
+{
+	m_events = 0;
+	m_writeIndex = 0;
+	m_readIndex = 0;
+}
+
+
+InputQueueClass::InputQueueClass(const InputQueueClass& other)
+{
+}
+
+
+InputQueueClass::~InputQueueClass()
+{
+}
+
+
+bool InputQueueClass::Initialize()
+{
+	// Create the event array.
+	m_events = new InputEventType[INPUT_QUEUE_SIZE];
+	if(!m_events)
+	{
+		return false;
+	}
+
+	m_writeIndex.store(0);
+	m_readIndex.store(0);
+
+	return true;
+}
+
+
+void InputQueueClass::Shutdown()
+{
+	// Release the event array.
+	if(m_events)
+	{
+		delete [] m_events;
+		m_events = 0;
+	}
+
+	return;
+}
+
+
+bool InputQueueClass::Push(const InputEventType& event)
+{
+	unsigned int writeIndex;
+
+
+	writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+	if(writeIndex - m_readIndex.load(std::memory_order_acquire) >= (unsigned int)INPUT_QUEUE_SIZE)
+	{
+		return false;
+	}
+
+	// Write the event before moving the index on, the popping thread only reads it once it sees the new index.
+	m_events[writeIndex % INPUT_QUEUE_SIZE] = event;
+	m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+
+	return true;
+}
+
+
+bool InputQueueClass::Pop(InputEventType& event)
+{
+	unsigned int readIndex;
+
+
+	readIndex = m_readIndex.load(std::memory_order_relaxed);
+	if(readIndex == m_writeIndex.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	// Read the event before moving the index on, the pushing thread only reuses the slot once it sees the new index.
+	event = m_events[readIndex % INPUT_QUEUE_SIZE];
+	m_readIndex.store(readIndex + 1, std::memory_order_release);
+
+	return true;
+}
+
+
+int InputQueueClass::GetCount()
+{
+	return (int)(m_writeIndex.load(std::memory_order_acquire) - m_readIndex.load(std::memory_order_acquire));
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: inputqueueclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _INPUTQUEUECLASS_H_
+#define _INPUTQUEUECLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int INPUT_QUEUE_SIZE = 1024;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+enum InputEvent
+{
+	INPUT_KEY_DOWN,
+	INPUT_KEY_UP,
+	INPUT_MOUSE_MOVE
+};
+
+// The time is a ClockClass timestamp.  Buffered key changes carry when the keyboard reported them, changes found by
+// reading the state back and mouse moves carry the time of the sample that saw them.  Key events carry the key code,
+// mouse moves carry how far the mouse moved.
+struct InputEventType
+{
+	long long time;
+	int type;
+	int key;
+	int x, y;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: InputQueueClass
+////////////////////////////////////////////////////////////////////////////////
+class InputQueueClass
+{
+public:
+	InputQueueClass();
+	InputQueueClass(const InputQueueClass&);
+	~InputQueueClass();
+
+	bool Initialize();
+	void Shutdown();
+
+	// One thread pushes and one thread pops, neither ever waits on the other.  Push returns false if the queue is full
+	// and Pop returns false if it is empty.
+	bool Push(const InputEventType&);
+	bool Pop(InputEventType&);
+
+	int GetCount();
+
+private:
+	InputEventType* m_events;
+
+	// The indices only ever go up, the slot of an event is its index modulo the queue size.  Only the pushing thread
+	// moves the write index and only the popping thread moves the read index, they are kept on separate cache lines.
+	std::atomic<unsigned int> m_writeIndex;
+	char m_writePadding[60];
+	std::atomic<unsigned int> m_readIndex;
+	char m_readPadding[60];
+};
+
+#endif
@@ -0,0 +1,679 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "jobsystemclass.h"
+#include "profilerclass.h"
+#include "cpuclass.h"
+#include "statsoverlayclass.h"
+#include <string.h>
+
+
+JobSystemClass* JobSystemClass::m_instance = 0;
+unsigned int JobSystemClass::m_generation = 0;
+JOB_THREAD_LOCAL JobSystemClass::QueueType* JobSystemClass::m_threadQueue = 0;
+JOB_THREAD_LOCAL unsigned int JobSystemClass::m_threadGeneration = 0;
+
+
+JobSystemClass::JobSystemClass()
+{
+	int i;
+
+
+	m_queues = 0;
+	m_queueCount = 0;
+	m_threadExitKeyValid = false;
+	m_workers = 0;
+	m_workerCount = 0;
+	m_running = false;
+	m_queuedJobs = 0;
+	m_unqueuedJobs = 0;
+	m_sleepingWorkers = 0;
+	memset(&m_stats, 0, sizeof(StatsType));
+
+	for(i=0; i<JOB_METRICS; i++)
+	{
+		m_metrics[i] = -1;
+	}
+}
+
+
+JobSystemClass::JobSystemClass(const JobSystemClass& other)
+{
+}
+
+
+JobSystemClass::~JobSystemClass()
+{
+}
+
+
+bool JobSystemClass::Initialize(int threadCount)
+{
+	int i;
+
+
+	// Use one thread for each hardware thread by default, the main thread is one of them.  Some queues are left over
+	// for other threads that add jobs.
+	if(threadCount < 1)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+
+	threadCount = (threadCount < 1) ? 1 : ((threadCount > JOB_MAX_THREADS / 2) ? JOB_MAX_THREADS / 2 : threadCount);
+
+	// Create a queue for every thread that may add jobs.
+	m_queues = new QueueType[JOB_MAX_THREADS];
+	if(!m_queues)
+	{
+		return false;
+	}
+
+	for(i=0; i<JOB_MAX_THREADS; i++)
+	{
+		m_queues[i].top = 0;
+		m_queues[i].bottom = 0;
+		m_queues[i].jobsRun = 0;
+		m_queues[i].jobsStolen = 0;
+		m_queues[i].jobsInline = 0;
+		m_queues[i].inUse = false;
+		m_queues[i].random = (unsigned int)(i + 1) * 2654435761u;
+	}
+
+	m_queueCount = 0;
+	m_queuedJobs = 0;
+	m_unqueuedJobs = 0;
+	m_sleepingWorkers = 0;
+
+	// Create the key that hands a thread's queue back when it exits.
+#ifdef _WIN32
+	m_threadExitKey = FlsAlloc(&JobSystemClass::ThreadExit);
+	if(m_threadExitKey == FLS_OUT_OF_INDEXES)
+	{
+		return false;
+	}
+#else
+	if(pthread_key_create(&m_threadExitKey, &JobSystemClass::ThreadExit) != 0)
+	{
+		return false;
+	}
+#endif
+	m_threadExitKeyValid = true;
+
+	// Queues a thread took under an earlier job system went with it.
+	m_instance = this;
+	m_generation++;
+
+	// The calling thread is the main thread and always gets the first queue.
+	GetThreadQueue();
+
+	// Start the workers, they stay alive until shutdown and sleep whenever there is nothing to do.
+	m_workerCount = threadCount - 1;
+	m_running = true;
+
+	if(m_workerCount > 0)
+	{
+		m_workers = new std::thread[m_workerCount];
+		if(!m_workers)
+		{
+			return false;
+		}
+
+		for(i=0; i<m_workerCount; i++)
+		{
+			m_workers[i] = std::thread(&JobSystemClass::WorkerThread, this);
+		}
+	}
+
+	// Show how much work was spread over the threads in the stats overlay.
+	m_metrics[0] = StatsOverlayClass::AddCounter("Jobs", "Threads", "");
+	m_metrics[1] = StatsOverlayClass::AddCounter("Jobs", "Run", "/frame");
+	m_metrics[2] = StatsOverlayClass::AddCounter("Jobs", "Stolen", "/frame");
+	m_metrics[3] = StatsOverlayClass::AddCounter("Jobs", "Inline", "/frame");
+
+	StatsOverlayClass::SetCounter(m_metrics[0], m_workerCount + 1);
+
+	return true;
+}
+
+
+void JobSystemClass::Shutdown()
+{
+	int i;
+
+
+	// Take the job metrics off the overlay.
+	for(i=0; i<JOB_METRICS; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
+	// Wake the workers and wait for them to finish, every job has been waited on by now.
+	if(m_workers)
+	{
+		m_running = false;
+
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_sleepCondition.notify_all();
+		}
+
+		for(i=0; i<m_workerCount; i++)
+		{
+			m_workers[i].join();
+		}
+
+		delete [] m_workers;
+		m_workers = 0;
+	}
+
+	m_workerCount = 0;
+	m_running = false;
+
+	// Jobs added from here on run on the thread adding them.
+	m_instance = 0;
+	m_threadQueue = 0;
+
+	// Release the thread exit key, the queues are all released below.  On Windows this calls the callback for every
+	// thread still holding a queue, which does nothing now there is no job system.
+	if(m_threadExitKeyValid)
+	{
+#ifdef _WIN32
+		FlsFree(m_threadExitKey);
+#else
+		pthread_key_delete(m_threadExitKey);
+#endif
+		m_threadExitKeyValid = false;
+	}
+
+	// Release the queues.
+	if(m_queues)
+	{
+		delete [] m_queues;
+		m_queues = 0;
+	}
+
+	return;
+}
+
+
+void JobSystemClass::Frame()
+{
+	int i, count;
+
+
+	// Gather the counts every thread made during the frame.
+	m_stats.threads = m_workerCount + 1;
+	m_stats.jobsRun = 0;
+	m_stats.jobsStolen = 0;
+	m_stats.jobsInline = m_unqueuedJobs.exchange(0, std::memory_order_relaxed);
+
+	count = m_queueCount.load();
+	for(i=0; i<count; i++)
+	{
+		m_stats.jobsRun += m_queues[i].jobsRun.exchange(0, std::memory_order_relaxed);
+		m_stats.jobsStolen += m_queues[i].jobsStolen.exchange(0, std::memory_order_relaxed);
+		m_stats.jobsInline += m_queues[i].jobsInline.exchange(0, std::memory_order_relaxed);
+	}
+
+	StatsOverlayClass::SetCounter(m_metrics[1], m_stats.jobsRun);
+	StatsOverlayClass::SetCounter(m_metrics[2], m_stats.jobsStolen);
+	StatsOverlayClass::SetCounter(m_metrics[3], m_stats.jobsInline);
+
+	return;
+}
+
+
+void JobSystemClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+void JobSystemClass::Run(JobFunction function, void* data, int start, int end, JobCounterType* counter)
+{
+	JobType job;
+
+
+	job.function = function;
+	job.data = data;
+	job.start = start;
+	job.end = end;
+	job.counter = counter;
+
+	if(counter)
+	{
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	AddJob(job);
+	WakeWorkers(1);
+
+	return;
+}
+
+
+void JobSystemClass::Wait(JobCounterType* counter)
+{
+	QueueType* queue;
+
+
+	queue = m_instance ? GetThreadQueue() : 0;
+
+	// Rather than sleep, run other jobs until the ones being waited on are done.  They may be running on other threads
+	// so there can be nothing left to run for a while.
+	while(counter->pending.load(std::memory_order_acquire) > 0)
+	{
+		if(!m_instance || !RunNext(queue))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	return;
+}
+
+
+void JobSystemClass::ParallelFor(JobFunction function, void* data, int count, int grain)
+{
+	JobCounterType counter;
+	JobType job;
+	int size, start, jobCount;
+
+
+	if(count <= 0)
+	{
+		return;
+	}
+
+	// Split the range a few times more than there are threads so a thread that is held up does not hold up the rest.
+	size = (count + (GetThreadCount() * JOB_SPLIT_FACTOR) - 1) / (GetThreadCount() * JOB_SPLIT_FACTOR);
+	size = (size < grain) ? grain : size;
+	size = (size < 1) ? 1 : size;
+
+	// Anything that fits in one range is run straight away.
+	if(!m_instance || (size >= count))
+	{
+		function(data, 0, count);
+		return;
+	}
+
+	// Add every range but the first, the calling thread runs that itself while the others are stolen.
+	jobCount = (count - 1) / size;
+	counter.pending.store(jobCount, std::memory_order_relaxed);
+
+	job.function = function;
+	job.data = data;
+	job.counter = &counter;
+
+	for(start=size; start<count; start+=size)
+	{
+		job.start = start;
+		job.end = (start + size < count) ? (start + size) : count;
+		AddJob(job);
+	}
+
+	WakeWorkers(jobCount);
+
+	function(data, 0, size);
+
+	Wait(&counter);
+
+	return;
+}
+
+
+int JobSystemClass::GetThreadCount()
+{
+	return m_instance ? (m_instance->m_workerCount + 1) : 1;
+}
+
+
+void JobSystemClass::WorkerThread()
+{
+	QueueType* queue;
+	int spin;
+
+
+	PROFILE_THREAD("Worker");
+	CpuThreadClass cpuThread("Worker");
+
+	queue = GetThreadQueue();
+
+	spin = 0;
+
+	while(m_running.load(std::memory_order_relaxed))
+	{
+		if(RunNext(queue))
+		{
+			spin = 0;
+			continue;
+		}
+
+		// Keep looking for a little while since more jobs often follow, then sleep until some are added.
+		if(spin < JOB_SPIN_COUNT)
+		{
+			spin++;
+			std::this_thread::yield();
+			continue;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+
+			m_sleepingWorkers++;
+			while(m_running && (m_queuedJobs <= 0))
+			{
+				m_sleepCondition.wait(lock);
+			}
+			m_sleepingWorkers--;
+		}
+
+		spin = 0;
+	}
+
+	// Hand the queue back, it is empty since every job has been waited on.
+	if(queue)
+	{
+		ReleaseQueue(queue);
+	}
+
+	return;
+}
+
+
+JobSystemClass::QueueType* JobSystemClass::GetThreadQueue()
+{
+	// A thread adding its first job takes a queue for itself.  One it took under an earlier job system was freed with it.
+	if(!m_threadQueue || (m_threadGeneration != m_generation))
+	{
+		m_threadQueue = AcquireQueue();
+		m_threadGeneration = m_generation;
+	}
+
+	return m_threadQueue;
+}
+
+
+JobSystemClass::QueueType* JobSystemClass::AcquireQueue()
+{
+	bool expected;
+	int i, count;
+
+
+	// Claim the first free queue and make sure the thieves look at it.
+	for(i=0; i<JOB_MAX_THREADS; i++)
+	{
+		expected = false;
+		if(m_instance->m_queues[i].inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+		{
+			count = m_instance->m_queueCount.load();
+			while((count < i + 1) && !m_instance->m_queueCount.compare_exchange_weak(count, i + 1))
+			{
+			}
+
+			// Have the queue handed back when the thread exits.
+#ifdef _WIN32
+			FlsSetValue(m_instance->m_threadExitKey, &m_instance->m_queues[i]);
+#else
+			pthread_setspecific(m_instance->m_threadExitKey, &m_instance->m_queues[i]);
+#endif
+
+			return &m_instance->m_queues[i];
+		}
+	}
+
+	return 0;
+}
+
+
+void JobSystemClass::ReleaseQueue(QueueType* queue)
+{
+	JobType job;
+
+
+	// Run anything still in the queue, once it is handed back the other threads no longer steal from it.
+	while(Pop(queue, job))
+	{
+		m_instance->m_queuedJobs.fetch_sub(1);
+		Execute(job);
+		queue->jobsRun.fetch_add(1, std::memory_order_relaxed);
+	}
+
+#ifdef _WIN32
+	FlsSetValue(m_instance->m_threadExitKey, 0);
+#else
+	pthread_setspecific(m_instance->m_threadExitKey, 0);
+#endif
+
+	m_threadQueue = 0;
+	queue->inUse.store(false, std::memory_order_release);
+
+	return;
+}
+
+
+void JOB_THREAD_EXIT JobSystemClass::ThreadExit(void* data)
+{
+	// The queue of a thread that exits after shutdown has already gone.
+	if(!m_instance || !data)
+	{
+		return;
+	}
+
+	ReleaseQueue((QueueType*)data);
+
+	return;
+}
+
+
+void JobSystemClass::AddJob(const JobType& job)
+{
+	QueueType* queue;
+
+
+	// Without a job system every job runs on the thread adding it.
+	if(!m_instance)
+	{
+		Execute(job);
+		return;
+	}
+
+	queue = GetThreadQueue();
+
+	// If the queue is full, or every queue is taken, then the job is run now.
+	if(!queue || !Push(queue, job))
+	{
+		Execute(job);
+
+		if(queue)
+		{
+			queue->jobsInline.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			m_instance->m_unqueuedJobs.fetch_add(1, std::memory_order_relaxed);
+		}
+		return;
+	}
+
+	m_instance->m_queuedJobs.fetch_add(1);
+
+	return;
+}
+
+
+void JobSystemClass::WakeWorkers(int jobCount)
+{
+	// Only take the lock when a worker is asleep, a sleeping worker checks the job count under the same lock so the
+	// wake up cannot be missed.
+	if(!m_instance || (m_instance->m_sleepingWorkers.load() == 0))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_instance->m_sleepMutex);
+
+	if(jobCount > 1)
+	{
+		m_instance->m_sleepCondition.notify_all();
+	}
+	else
+	{
+		m_instance->m_sleepCondition.notify_one();
+	}
+
+	return;
+}
+
+
+bool JobSystemClass::Push(QueueType* queue, const JobType& job)
+{
+	unsigned int bottom, top;
+
+
+	bottom = queue->bottom.load(std::memory_order_relaxed);
+	top = queue->top.load(std::memory_order_acquire);
+
+	// The indices only ever go up, their difference is the number of jobs even once they wrap.
+	if((int)(bottom - top) >= JOB_QUEUE_SIZE)
+	{
+		return false;
+	}
+
+	queue->jobs[bottom & (JOB_QUEUE_SIZE - 1)] = job;
+	queue->bottom.store(bottom + 1, std::memory_order_release);
+
+	return true;
+}
+
+
+bool JobSystemClass::Pop(QueueType* queue, JobType& job)
+{
+	unsigned int bottom, top;
+	bool result;
+
+
+	// Take the newest job, claiming it before looking at the top so a thief cannot take it at the same time.
+	bottom = queue->bottom.load(std::memory_order_relaxed) - 1;
+	queue->bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	top = queue->top.load(std::memory_order_relaxed);
+
+	if((int)(bottom - top) < 0)
+	{
+		// The queue was empty.
+		queue->bottom.store(bottom + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	job = queue->jobs[bottom & (JOB_QUEUE_SIZE - 1)];
+	if(bottom != top)
+	{
+		return true;
+	}
+
+	// This was the last job so a thief may be after it too, whoever moves the top first gets it.
+	result = queue->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	queue->bottom.store(bottom + 1, std::memory_order_relaxed);
+
+	return result;
+}
+
+
+bool JobSystemClass::Steal(QueueType* queue, JobType& job)
+{
+	unsigned int bottom, top;
+
+
+	// Take the oldest job.  It is copied out before it is claimed, the owner cannot write over it until the top moves
+	// so the copy is good whenever the claim succeeds.  If the claim fails the copy is thrown away.
+	top = queue->top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	bottom = queue->bottom.load(std::memory_order_acquire);
+
+	if((int)(bottom - top) <= 0)
+	{
+		return false;
+	}
+
+	job = queue->jobs[top & (JOB_QUEUE_SIZE - 1)];
+
+	return queue->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+
+bool JobSystemClass::RunNext(QueueType* queue)
+{
+	QueueType* victim;
+	JobType job;
+	unsigned int random;
+	int count, first, i;
+
+
+	// Run the newest job this thread added, its data is most likely still in the cache.
+	if(queue && Pop(queue, job))
+	{
+		m_instance->m_queuedJobs.fetch_sub(1);
+		Execute(job);
+		queue->jobsRun.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Otherwise steal from another thread, starting from a different one each time so they are not all after the same.
+	count = m_instance->m_queueCount.load(std::memory_order_relaxed);
+	if(count < 2)
+	{
+		return false;
+	}
+
+	random = queue ? queue->random : 1;
+	random ^= random << 13;
+	random ^= random >> 17;
+	random ^= random << 5;
+	if(queue)
+	{
+		queue->random = random;
+	}
+
+	first = (int)(random % (unsigned int)count);
+
+	for(i=0; i<count; i++)
+	{
+		victim = &m_instance->m_queues[(first + i) % count];
+		if((victim == queue) || !victim->inUse.load(std::memory_order_relaxed))
+		{
+			continue;
+		}
+
+		if(Steal(victim, job))
+		{
+			m_instance->m_queuedJobs.fetch_sub(1);
+			Execute(job);
+
+			if(queue)
+			{
+				queue->jobsRun.fetch_add(1, std::memory_order_relaxed);
+				queue->jobsStolen.fetch_add(1, std::memory_order_relaxed);
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void JobSystemClass::Execute(const JobType& job)
+{
+	job.function(job.data, job.start, job.end);
+
+	// Nothing touches the counter after this, the thread waiting on it may be about to let it go.
+	if(job.counter)
+	{
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	return;
+}
@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _JOBSYSTEMCLASS_H_
+#define _JOBSYSTEMCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int JOB_MAX_THREADS = 64;
+const int JOB_QUEUE_SIZE = 1024;
+const int JOB_SPIN_COUNT = 64;
+const int JOB_SPLIT_FACTOR = 4;
+const int JOB_METRICS = 4;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+
+///////////////////////////////
+// PRE-PROCESSING DIRECTIVES //
+///////////////////////////////
+#ifdef _MSC_VER
+#define JOB_THREAD_LOCAL __declspec(thread)
+#else
+#define JOB_THREAD_LOCAL __thread
+#endif
+
+// The thread exit callback is a fiber local storage callback on Windows and a thread key destructor elsewhere.
+#ifdef _WIN32
+#define JOB_THREAD_EXIT WINAPI
+typedef DWORD JobThreadKey;
+#else
+#define JOB_THREAD_EXIT
+typedef pthread_key_t JobThreadKey;
+#endif
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// A job runs a function over the range [start, end) of whatever the data points at.
+typedef void (*JobFunction)(void*, int, int);
+
+// A counter starts at zero, goes up for every job run against it and back down as they finish, so waiting on it waits
+// for all of them.  A job that depends on others waits on their counter, the wait runs other jobs until it is done.
+struct JobCounterType
+{
+	std::atomic<int> pending;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: JobSystemClass
+////////////////////////////////////////////////////////////////////////////////
+class JobSystemClass
+{
+private:
+	struct JobType
+	{
+		JobFunction function;
+		void* data;
+		int start, end;
+		JobCounterType* counter;
+	};
+
+	// Every thread that runs jobs owns a Chase-Lev deque.  The owner pushes and pops at the bottom and every other thread
+	// steals from the top, the only contention is over the last job.  The indices are kept on separate cache lines.
+	struct QueueType
+	{
+		std::atomic<unsigned int> top;
+		char topPadding[60];
+		std::atomic<unsigned int> bottom;
+		char bottomPadding[60];
+		JobType jobs[JOB_QUEUE_SIZE];
+		std::atomic<int> jobsRun, jobsStolen, jobsInline;
+		std::atomic<bool> inUse;
+		unsigned int random;
+	};
+
+	// Calls a member function with the range, for ParallelFor on a class.
+	template<class T>
+	struct MemberJobType
+	{
+		T* object;
+		void (T::*function)(int, int);
+
+		static void Run(void* data, int start, int end)
+		{
+			MemberJobType* job = (MemberJobType*)data;
+			(job->object->*(job->function))(start, end);
+		}
+	};
+
+public:
+	// Counts for the last frame, stolen jobs were run by a thread other than the one that added them and inline jobs
+	// were run straight away by the thread adding them because its queue was full or every queue was taken.
+	struct StatsType
+	{
+		int threads;
+		int jobsRun, jobsStolen, jobsInline;
+	};
+
+public:
+	JobSystemClass();
+	JobSystemClass(const JobSystemClass&);
+	~JobSystemClass();
+
+	bool Initialize(int);
+	void Shutdown();
+	void Frame();
+	void GetStats(StatsType&);
+
+	// Run adds a job and returns straight away, Wait runs jobs until the counter reaches zero.  Without a job system the
+	// job runs on the calling thread before Run returns.  Any thread may add jobs, the first one it adds takes it one of
+	// the JOB_MAX_THREADS queues, at most half of which go to workers.  The queue is handed back when the thread exits,
+	// after running whatever is left in it.  While every queue is taken the jobs of a thread without one run as they are
+	// added.  Every thread other than the workers has to be done adding jobs before Shutdown.
+	static void Run(JobFunction, void*, int, int, JobCounterType*);
+	static void Wait(JobCounterType*);
+
+	// ParallelFor splits [0, count) into at least grain sized ranges, a few per thread so the threads that finish first
+	// can steal the rest, and returns once they have all run.
+	static void ParallelFor(JobFunction, void*, int, int);
+
+	template<class T>
+	static void ParallelFor(T* object, void (T::*function)(int, int), int count, int grain)
+	{
+		MemberJobType<T> job;
+
+
+		job.object = object;
+		job.function = function;
+
+		ParallelFor(&MemberJobType<T>::Run, &job, count, grain);
+
+		return;
+	}
+
+	// The number of threads that run jobs, including the main thread, or one without a job system.
+	static int GetThreadCount();
+
+private:
+	void WorkerThread();
+
+	static QueueType* GetThreadQueue();
+	static QueueType* AcquireQueue();
+	static void ReleaseQueue(QueueType*);
+	static void JOB_THREAD_EXIT ThreadExit(void*);
+	static void AddJob(const JobType&);
+	static void WakeWorkers(int);
+	static bool Push(QueueType*, const JobType&);
+	static bool Pop(QueueType*, JobType&);
+	static bool Steal(QueueType*, JobType&);
+	static bool RunNext(QueueType*);
+	static void Execute(const JobType&);
+
+private:
+	static JobSystemClass* m_instance;
+	static unsigned int m_generation;
+	static JOB_THREAD_LOCAL QueueType* m_threadQueue;
+	static JOB_THREAD_LOCAL unsigned int m_threadGeneration;
+
+	QueueType* m_queues;
+	std::atomic<int> m_queueCount;
+	JobThreadKey m_threadExitKey;
+	bool m_threadExitKeyValid;
+	std::thread* m_workers;
+	int m_workerCount;
+	std::atomic<bool> m_running;
+
+	// Workers that run out of jobs spin for a while and then sleep until a job is added.
+	std::atomic<int> m_queuedJobs;
+	std::atomic<int> m_unqueuedJobs;
+	std::atomic<int> m_sleepingWorkers;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCondition;
+
+	StatsType m_stats;
+	int m_metrics[JOB_METRICS];
+};
+
+#endif
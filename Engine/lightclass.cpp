@@ -21,38 +21,38 @@ LightClass::~LightClass()
 
 void LightClass::SetAmbientColor(float red, float green, float blue, float alpha)
 {
-	m_ambientColor = D3DXVECTOR4(red, green, blue, alpha);
+	m_ambientColor = Vector4(red, green, blue, alpha);
 	return;
 }
 
 
 void LightClass::SetDiffuseColor(float red, float green, float blue, float alpha)
 {
-	m_diffuseColor = D3DXVECTOR4(red, green, blue, alpha);
+	m_diffuseColor = Vector4(red, green, blue, alpha);
 	return;
 }
 
 
 void LightClass::SetDirection(float x, float y, float z)
 {
-	m_direction = D3DXVECTOR3(x, y, z);
+	m_direction = Vector3(x, y, z);
 	return;
 }
 
 
-D3DXVECTOR4 LightClass::GetAmbientColor()
+Vector4 LightClass::GetAmbientColor()
 {
 	return m_ambientColor;
 }
 
 
-D3DXVECTOR4 LightClass::GetDiffuseColor()
+Vector4 LightClass::GetDiffuseColor()
 {
 	return m_diffuseColor;
 }
 
 
-D3DXVECTOR3 LightClass::GetDirection()
+Vector3 LightClass::GetDirection()
 {
 	return m_direction;
 }
\ No newline at end of file
@@ -5,10 +5,10 @@
 #define _LIGHTCLASS_H_
 
 
-//////////////
-// INCLUDES //
-//////////////
-#include <d3dx10math.h>
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mathclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -25,14 +25,14 @@ public:
 	void SetDiffuseColor(float, float, float, float);
 	void SetDirection(float, float, float);
 
-	D3DXVECTOR4 GetAmbientColor();
-	D3DXVECTOR4 GetDiffuseColor();
-	D3DXVECTOR3 GetDirection();
+	Vector4 GetAmbientColor();
+	Vector4 GetDiffuseColor();
+	Vector3 GetDirection();
 
 private:
-	D3DXVECTOR4 m_ambientColor;
-	D3DXVECTOR4 m_diffuseColor;
-	D3DXVECTOR3 m_direction;
+	Vector4 m_ambientColor;
+	Vector4 m_diffuseColor;
+	Vector3 m_direction;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,439 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: lightmapclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "lightmapclass.h"
+#include "jobsystemclass.h"
+#include "clockclass.h"
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+
+LightMapClass::LightMapClass()
+{
+	m_occlusion = 0;
+	m_lightData = 0;
+	m_shadowsBaked = false;
+	m_sweep = 0;
+	m_occlusionBakeTime = 0.0f;
+	m_shadowBakeTime = 0.0f;
+}
+
+
+LightMapClass::LightMapClass(const LightMapClass& other)
+{
+}
+
+
+LightMapClass::~LightMapClass()
+{
+}
+
+
+bool LightMapClass::Initialize(int width, int height, float texelSize)
+{
+	// Store the dimensions of the light map and the world space distance between two texels.
+	m_width = width;
+	m_height = height;
+	m_texelSize = texelSize;
+
+	// Create the array the occlusion of each sweep direction is accumulated into.
+	m_occlusion = new float[m_width * m_height];
+	if(!m_occlusion)
+	{
+		return false;
+	}
+
+	// Create the two channel light map array.
+	m_lightData = new unsigned char[m_width * m_height * 2];
+	if(!m_lightData)
+	{
+		return false;
+	}
+
+	// Start out unoccluded and fully lit until the first bake.
+	memset(m_lightData, 255, m_width * m_height * 2);
+
+	return true;
+}
+
+
+void LightMapClass::Shutdown()
+{
+	// Release the light map array.
+	if(m_lightData)
+	{
+		delete [] m_lightData;
+		m_lightData = 0;
+	}
+
+	// Release the occlusion array.
+	if(m_occlusion)
+	{
+		delete [] m_occlusion;
+		m_occlusion = 0;
+	}
+
+	return;
+}
+
+
+bool LightMapClass::BakeOcclusion(const float* heights, int heightPitch)
+{
+	StopwatchClass stopwatch;
+	float angle;
+	int i, count;
+	bool result;
+
+
+	stopwatch.Start();
+
+	// Clear the accumulated horizon angles.
+	count = m_width * m_height;
+	memset(m_occlusion, 0, sizeof(float) * count);
+
+	// Sweep the height field once for each direction around the horizon.
+	for(i=0; i<OCCLUSION_DIRECTIONS; i++)
+	{
+		angle = (float)i * (6.28318531f / (float)OCCLUSION_DIRECTIONS);
+
+		result = Sweep(heights, heightPitch, cosf(angle), sinf(angle), SWEEP_OCCLUSION);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	// Average the sine of the horizon angles and store the remaining visibility in the red channel.
+	for(i=0; i<count; i++)
+	{
+		m_lightData[i * 2] = (unsigned char)((1.0f - (m_occlusion[i] / (float)OCCLUSION_DIRECTIONS)) * 255.0f + 0.5f);
+	}
+
+	// Store how long the bake took in milliseconds.
+	m_occlusionBakeTime = stopwatch.GetMilliseconds();
+
+	return true;
+}
+
+
+bool LightMapClass::BakeShadows(const float* heights, int heightPitch, float lightX, float lightY, float lightZ)
+{
+	StopwatchClass stopwatch;
+	float length, horizontalLength;
+	int i;
+	bool result;
+
+
+	stopwatch.Start();
+
+	// Remember the direction the shadows were baked for.
+	m_lightX = lightX;
+	m_lightY = lightY;
+	m_lightZ = lightZ;
+	m_shadowsBaked = true;
+
+	length = sqrtf((lightX * lightX) + (lightY * lightY) + (lightZ * lightZ));
+	horizontalLength = sqrtf((lightX * lightX) + (lightZ * lightZ));
+
+	if((length <= 0.0f) || (lightY > 0.0f))
+	{
+		// The sun is below the horizon so nothing is lit by it.
+		for(i=0; i<m_width * m_height; i++)
+		{
+			m_lightData[(i * 2) + 1] = 0;
+		}
+	}
+	else if(horizontalLength <= (length * 0.0001f))
+	{
+		// The sun is straight overhead so nothing casts a shadow.
+		for(i=0; i<m_width * m_height; i++)
+		{
+			m_lightData[(i * 2) + 1] = 255;
+		}
+	}
+	else
+	{
+		// The ray towards the sun rises this much for every unit it travels across the terrain.
+		m_shadowSlope = -lightY / horizontalLength;
+
+		// Sweep along the direction the light travels so every occluder is visited before the texels it shadows.
+		result = Sweep(heights, heightPitch, lightX / horizontalLength, lightZ / horizontalLength, SWEEP_SHADOW);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	// Store how long the bake took in milliseconds.
+	m_shadowBakeTime = stopwatch.GetMilliseconds();
+
+	return true;
+}
+
+
+bool LightMapClass::HasLightChanged(float lightX, float lightY, float lightZ)
+{
+	if(!m_shadowsBaked)
+	{
+		return true;
+	}
+
+	return (lightX != m_lightX) || (lightY != m_lightY) || (lightZ != m_lightZ);
+}
+
+
+const unsigned char* LightMapClass::GetLightData()
+{
+	return m_lightData;
+}
+
+
+int LightMapClass::GetLightPitch()
+{
+	return m_width * 2;
+}
+
+
+float LightMapClass::GetOcclusionBakeTime()
+{
+	return m_occlusionBakeTime;
+}
+
+
+float LightMapClass::GetShadowBakeTime()
+{
+	return m_shadowBakeTime;
+}
+
+
+bool LightMapClass::Sweep(const float* heights, int heightPitch, float directionX, float directionZ, SweepMode mode)
+{
+	SweepType sweep;
+	float majorDirection, minorDirection, slope;
+	int i, lastOffset;
+
+
+	sweep.mode = mode;
+	sweep.heights = heights;
+	sweep.heightPitch = heightPitch;
+
+	// March one texel at a time along whichever axis the direction is closest to.
+	sweep.majorX = fabsf(directionX) >= fabsf(directionZ);
+	majorDirection = sweep.majorX ? directionX : directionZ;
+	minorDirection = sweep.majorX ? directionZ : directionX;
+
+	sweep.reverse = majorDirection < 0.0f;
+	sweep.majorCount = sweep.majorX ? m_width : m_height;
+	sweep.minorCount = sweep.majorX ? m_height : m_width;
+
+	// Each step moves one texel along the major axis and slope texels along the minor axis.
+	slope = minorDirection / fabsf(majorDirection);
+	sweep.stepLength = m_texelSize * sqrtf(1.0f + (slope * slope));
+
+	// Every line shares the same rounded minor offsets, so lines started one texel apart never overlap or leave gaps.
+	sweep.offsets = new int[sweep.majorCount];
+	if(!sweep.offsets)
+	{
+		return false;
+	}
+
+	for(i=0; i<sweep.majorCount; i++)
+	{
+		sweep.offsets[i] = (int)floorf(((float)i * slope) + 0.5f);
+	}
+
+	// Start enough lines beyond the edges that every texel is covered by exactly one of them.
+	lastOffset = sweep.offsets[sweep.majorCount - 1];
+	sweep.firstLine = (lastOffset > 0) ? -lastOffset : 0;
+	sweep.lastLine = (lastOffset < 0) ? (sweep.minorCount - 1 - lastOffset) : (sweep.minorCount - 1);
+
+	// Split the lines into jobs of whole batches, every line writes different texels so they can run in any order.
+	m_sweep = &sweep;
+	JobSystemClass::ParallelFor(this, &LightMapClass::SweepLines, sweep.lastLine - sweep.firstLine + 1, SWEEP_BATCH_LINES);
+	m_sweep = 0;
+
+	// Release the offset table.
+	delete [] sweep.offsets;
+	sweep.offsets = 0;
+
+	return true;
+}
+
+
+void LightMapClass::SweepLines(int startLine, int endLine)
+{
+	const SweepType* sweep;
+	float *lineHeights, *lineResults;
+	int* hull;
+	int firstStep[SWEEP_BATCH_LINES], lastStep[SWEEP_BATCH_LINES];
+	int batchStart, batchCount, step, major, minor, x, z, i, index;
+
+
+	// The range counts from the first line of the sweep.
+	sweep = m_sweep;
+	startLine += sweep->firstLine;
+	endLine += sweep->firstLine;
+
+	// Create the scratch arrays, each line in a batch gets a slot for every step.
+	lineHeights = new float[SWEEP_BATCH_LINES * sweep->majorCount];
+	lineResults = new float[SWEEP_BATCH_LINES * sweep->majorCount];
+	hull = new int[sweep->majorCount];
+
+	for(batchStart=startLine; batchStart<endLine; batchStart+=SWEEP_BATCH_LINES)
+	{
+		batchCount = (endLine - batchStart < SWEEP_BATCH_LINES) ? (endLine - batchStart) : SWEEP_BATCH_LINES;
+
+		for(i=0; i<batchCount; i++)
+		{
+			firstStep[i] = sweep->majorCount;
+			lastStep[i] = -1;
+		}
+
+		// Step the whole batch of lines together, at each step neighbouring lines read neighbouring texels
+		// so the cache lines fetched for one step are still around for the next however the sweep is angled.
+		for(step=0; step<sweep->majorCount; step++)
+		{
+			major = sweep->reverse ? (sweep->majorCount - 1 - step) : step;
+
+			for(i=0; i<batchCount; i++)
+			{
+				minor = batchStart + i + sweep->offsets[step];
+				if((minor < 0) || (minor >= sweep->minorCount))
+				{
+					continue;
+				}
+
+				x = sweep->majorX ? major : minor;
+				z = sweep->majorX ? minor : major;
+
+				lineHeights[(i * sweep->majorCount) + step] = *(const float*)((const char*)sweep->heights + (z * sweep->heightPitch) + (x * sizeof(float)));
+
+				// The steps a line spends inside the map are always contiguous.
+				firstStep[i] = (step < firstStep[i]) ? step : firstStep[i];
+				lastStep[i] = step;
+			}
+		}
+
+		// Solve each line on its own contiguous copy of the heights.
+		for(i=0; i<batchCount; i++)
+		{
+			if(sweep->mode == SWEEP_SHADOW)
+			{
+				ShadowLine(lineHeights + (i * sweep->majorCount), lineResults + (i * sweep->majorCount), firstStep[i], lastStep[i] + 1, sweep->stepLength);
+			}
+			else
+			{
+				OcclusionLine(lineHeights + (i * sweep->majorCount), lineResults + (i * sweep->majorCount), hull, firstStep[i], lastStep[i] + 1, sweep->stepLength);
+			}
+		}
+
+		// Write the results back in the same order they were gathered.
+		for(step=0; step<sweep->majorCount; step++)
+		{
+			major = sweep->reverse ? (sweep->majorCount - 1 - step) : step;
+
+			for(i=0; i<batchCount; i++)
+			{
+				minor = batchStart + i + sweep->offsets[step];
+				if((minor < 0) || (minor >= sweep->minorCount))
+				{
+					continue;
+				}
+
+				x = sweep->majorX ? major : minor;
+				z = sweep->majorX ? minor : major;
+				index = (z * m_width) + x;
+
+				if(sweep->mode == SWEEP_SHADOW)
+				{
+					m_lightData[(index * 2) + 1] = (unsigned char)((lineResults[(i * sweep->majorCount) + step] * 255.0f) + 0.5f);
+				}
+				else
+				{
+					m_occlusion[index] += lineResults[(i * sweep->majorCount) + step];
+				}
+			}
+		}
+	}
+
+	// Release the scratch arrays.
+	delete [] hull;
+	delete [] lineResults;
+	delete [] lineHeights;
+
+	return;
+}
+
+
+void LightMapClass::OcclusionLine(const float* heights, float* results, int* hull, int startStep, int endStep, float stepLength)
+{
+	int step, hullSize, top, below;
+	float slope;
+
+
+	// The highest horizon behind a texel always lies on the upper convex hull of the texels before it.
+	hullSize = 0;
+	for(step=startStep; step<endStep; step++)
+	{
+		// Pop hull points that fall below the line from the point beneath them to this texel.
+		while(hullSize >= 2)
+		{
+			top = hull[hullSize - 1];
+			below = hull[hullSize - 2];
+
+			if((float)(top - below) * (heights[step] - heights[below]) < (heights[top] - heights[below]) * (float)(step - below))
+			{
+				break;
+			}
+
+			hullSize--;
+		}
+
+		// Store the sine of the elevation angle to the horizon point.
+		results[step] = 0.0f;
+		if(hullSize > 0)
+		{
+			top = hull[hullSize - 1];
+			slope = (heights[top] - heights[step]) / ((float)(step - top) * stepLength);
+			if(slope > 0.0f)
+			{
+				results[step] = slope / sqrtf(1.0f + (slope * slope));
+			}
+		}
+
+		hull[hullSize] = step;
+		hullSize++;
+	}
+
+	return;
+}
+
+
+void LightMapClass::ShadowLine(const float* heights, float* results, int startStep, int endStep, float stepLength)
+{
+	int step;
+	float rise, maxHeight, height, visibility;
+
+
+	// A texel is shadowed when any earlier texel pokes above the ray from it towards the sun.
+	// Offsetting each height by how far the ray has risen turns that into a running maximum.
+	rise = stepLength * m_shadowSlope;
+	maxHeight = -FLT_MAX;
+
+	for(step=startStep; step<endStep; step++)
+	{
+		height = heights[step] + ((float)step * rise);
+
+		// Fade over a short height range rather than switching hard between lit and shadowed.
+		visibility = 1.0f - ((maxHeight - height) / SHADOW_SOFTNESS);
+		results[step] = (visibility < 0.0f) ? 0.0f : ((visibility > 1.0f) ? 1.0f : visibility);
+
+		if(height > maxHeight)
+		{
+			maxHeight = height;
+		}
+	}
+
+	return;
+}
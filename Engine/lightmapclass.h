@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: lightmapclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _LIGHTMAPCLASS_H_
+#define _LIGHTMAPCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int OCCLUSION_DIRECTIONS = 8;
+const float SHADOW_SOFTNESS = 0.25f;
+const int SWEEP_BATCH_LINES = 16;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: LightMapClass
+////////////////////////////////////////////////////////////////////////////////
+class LightMapClass
+{
+private:
+	enum SweepMode
+	{
+		SWEEP_OCCLUSION,
+		SWEEP_SHADOW
+	};
+
+	struct SweepType
+	{
+		SweepMode mode;
+		const float* heights;
+		int heightPitch;
+		bool majorX, reverse;
+		int majorCount, minorCount;
+		int firstLine, lastLine;
+		int* offsets;
+		float stepLength;
+	};
+
+public:
+	LightMapClass();
+	LightMapClass(const LightMapClass&);
+	~LightMapClass();
+
+	bool Initialize(int, int, float);
+	void Shutdown();
+
+	bool BakeOcclusion(const float*, int);
+	bool BakeShadows(const float*, int, float, float, float);
+	bool HasLightChanged(float, float, float);
+
+	// Two channel unsigned normalized data, red is ambient occlusion and green is sun visibility.
+	const unsigned char* GetLightData();
+	int GetLightPitch();
+
+	float GetOcclusionBakeTime();
+	float GetShadowBakeTime();
+
+private:
+	bool Sweep(const float*, int, float, float, SweepMode);
+	void SweepLines(int, int);
+	void OcclusionLine(const float*, float*, int*, int, int, float);
+	void ShadowLine(const float*, float*, int, int, float);
+
+private:
+	int m_width, m_height;
+	float m_texelSize;
+	float* m_occlusion;
+	unsigned char* m_lightData;
+	float m_lightX, m_lightY, m_lightZ;
+	bool m_shadowsBaked;
+	float m_shadowSlope;
+	const SweepType* m_sweep;
+	float m_occlusionBakeTime, m_shadowBakeTime;
+};
+
+#endif
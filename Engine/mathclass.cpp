@@ -0,0 +1,809 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mathclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "mathclass.h"
+#include <string.h>
+#if defined(ENGINE_MATH_SSE)
+#include <emmintrin.h>
+#elif defined(ENGINE_MATH_NEON)
+#include <arm_neon.h>
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Matrix rows are held in one register, a vector times a matrix is the sum of
+// each row scaled by one component of the vector.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(ENGINE_MATH_SSE)
+typedef __m128 RowType;
+
+static inline RowType LoadRow(const float* data) { return _mm_loadu_ps(data); }
+static inline void StoreRow(float* data, RowType row) { _mm_storeu_ps(data, row); }
+static inline RowType AddRows(RowType a, RowType b) { return _mm_add_ps(a, b); }
+static inline RowType ScaleRow(RowType row, float scale) { return _mm_mul_ps(row, _mm_set1_ps(scale)); }
+static inline RowType ZeroRow() { return _mm_setzero_ps(); }
+#elif defined(ENGINE_MATH_NEON)
+typedef float32x4_t RowType;
+
+static inline RowType LoadRow(const float* data) { return vld1q_f32(data); }
+static inline void StoreRow(float* data, RowType row) { vst1q_f32(data, row); }
+static inline RowType AddRows(RowType a, RowType b) { return vaddq_f32(a, b); }
+static inline RowType ScaleRow(RowType row, float scale) { return vmulq_n_f32(row, scale); }
+static inline RowType ZeroRow() { return vdupq_n_f32(0.0f); }
+#else
+struct RowType
+{
+	float v[4];
+};
+
+static inline RowType LoadRow(const float* data)
+{
+	RowType row;
+
+
+	row.v[0] = data[0];
+	row.v[1] = data[1];
+	row.v[2] = data[2];
+	row.v[3] = data[3];
+
+	return row;
+}
+
+static inline void StoreRow(float* data, RowType row)
+{
+	data[0] = row.v[0];
+	data[1] = row.v[1];
+	data[2] = row.v[2];
+	data[3] = row.v[3];
+	return;
+}
+
+static inline RowType AddRows(RowType a, RowType b)
+{
+	a.v[0] += b.v[0];
+	a.v[1] += b.v[1];
+	a.v[2] += b.v[2];
+	a.v[3] += b.v[3];
+	return a;
+}
+
+static inline RowType ScaleRow(RowType row, float scale)
+{
+	row.v[0] *= scale;
+	row.v[1] *= scale;
+	row.v[2] *= scale;
+	row.v[3] *= scale;
+	return row;
+}
+
+static inline RowType ZeroRow()
+{
+	RowType row;
+
+
+	row.v[0] = 0.0f;
+	row.v[1] = 0.0f;
+	row.v[2] = 0.0f;
+	row.v[3] = 0.0f;
+
+	return row;
+}
+#endif
+
+
+// The point form adds the fourth row unscaled, the terms are paired to shorten the dependency chain.
+static inline RowType TransformPoint(float x, float y, float z, RowType row0, RowType row1, RowType row2, RowType row3)
+{
+	return AddRows(AddRows(ScaleRow(row0, x), ScaleRow(row1, y)), AddRows(ScaleRow(row2, z), row3));
+}
+
+static inline RowType TransformVector(float x, float y, float z, float w, RowType row0, RowType row1, RowType row2, RowType row3)
+{
+	return AddRows(AddRows(ScaleRow(row0, x), ScaleRow(row1, y)), AddRows(ScaleRow(row2, z), ScaleRow(row3, w)));
+}
+
+// The matrix constructor leaves it uninitialized, the builders below start from all zeros and set the terms they use.
+static inline void ZeroMatrix(Matrix* out)
+{
+	StoreRow(out->m[0], ZeroRow());
+	StoreRow(out->m[1], ZeroRow());
+	StoreRow(out->m[2], ZeroRow());
+	StoreRow(out->m[3], ZeroRow());
+	return;
+}
+
+
+Matrix Matrix::operator*(const Matrix& other) const
+{
+	Matrix result;
+
+
+	MatrixMultiply(&result, this, &other);
+
+	return result;
+}
+
+
+Vector3* Vec3TransformCoord(Vector3* out, const Vector3* v, const Matrix* m)
+{
+	float result[4], invW;
+
+
+	StoreRow(result, TransformPoint(v->x, v->y, v->z, LoadRow(m->m[0]), LoadRow(m->m[1]), LoadRow(m->m[2]), LoadRow(m->m[3])));
+
+	// Project back to w of one.
+	invW = (result[3] != 0.0f) ? 1.0f / result[3] : 0.0f;
+	out->x = result[0] * invW;
+	out->y = result[1] * invW;
+	out->z = result[2] * invW;
+
+	return out;
+}
+
+
+Vector3* Vec3TransformNormal(Vector3* out, const Vector3* v, const Matrix* m)
+{
+	Vector3 result;
+
+
+	// Directions ignore the translation row.
+	result.x = (v->x * m->_11) + (v->y * m->_21) + (v->z * m->_31);
+	result.y = (v->x * m->_12) + (v->y * m->_22) + (v->z * m->_32);
+	result.z = (v->x * m->_13) + (v->y * m->_23) + (v->z * m->_33);
+	*out = result;
+
+	return out;
+}
+
+
+Vector4* Vec4Transform(Vector4* out, const Vector4* v, const Matrix* m)
+{
+	float result[4];
+
+
+	StoreRow(result, TransformVector(v->x, v->y, v->z, v->w, LoadRow(m->m[0]), LoadRow(m->m[1]), LoadRow(m->m[2]), LoadRow(m->m[3])));
+	memcpy(out, result, sizeof(Vector4));
+
+	return out;
+}
+
+
+Vector4* Vec3TransformArray(Vector4* out, int outStride, const Vector3* in, int inStride, const Matrix* m, int count)
+{
+	RowType row0, row1, row2, row3;
+	const char* source;
+	char* destination;
+	const float* v;
+	int i;
+
+
+	row0 = LoadRow(m->m[0]);
+	row1 = LoadRow(m->m[1]);
+	row2 = LoadRow(m->m[2]);
+	row3 = LoadRow(m->m[3]);
+
+	source = (const char*)in;
+	destination = (char*)out;
+
+	// The matrix stays in registers for the whole batch.
+	for(i=0; i<count; i++)
+	{
+		v = (const float*)source;
+		StoreRow((float*)destination, TransformPoint(v[0], v[1], v[2], row0, row1, row2, row3));
+
+		source += inStride;
+		destination += outStride;
+	}
+
+	return out;
+}
+
+
+Vector3* Vec3TransformCoordArray(Vector3* out, int outStride, const Vector3* in, int inStride, const Matrix* m, int count)
+{
+	RowType row0, row1, row2, row3;
+	const char* source;
+	char* destination;
+	const float* v;
+	float result[4], invW;
+	int i;
+
+
+	row0 = LoadRow(m->m[0]);
+	row1 = LoadRow(m->m[1]);
+	row2 = LoadRow(m->m[2]);
+	row3 = LoadRow(m->m[3]);
+
+	source = (const char*)in;
+	destination = (char*)out;
+
+	for(i=0; i<count; i++)
+	{
+		v = (const float*)source;
+		StoreRow(result, TransformPoint(v[0], v[1], v[2], row0, row1, row2, row3));
+
+		invW = (result[3] != 0.0f) ? 1.0f / result[3] : 0.0f;
+		((float*)destination)[0] = result[0] * invW;
+		((float*)destination)[1] = result[1] * invW;
+		((float*)destination)[2] = result[2] * invW;
+
+		source += inStride;
+		destination += outStride;
+	}
+
+	return out;
+}
+
+
+Vector4* Vec4TransformArray(Vector4* out, int outStride, const Vector4* in, int inStride, const Matrix* m, int count)
+{
+	RowType row0, row1, row2, row3;
+	const char* source;
+	char* destination;
+	const float* v;
+	int i;
+
+
+	row0 = LoadRow(m->m[0]);
+	row1 = LoadRow(m->m[1]);
+	row2 = LoadRow(m->m[2]);
+	row3 = LoadRow(m->m[3]);
+
+	source = (const char*)in;
+	destination = (char*)out;
+
+	for(i=0; i<count; i++)
+	{
+		v = (const float*)source;
+		StoreRow((float*)destination, TransformVector(v[0], v[1], v[2], v[3], row0, row1, row2, row3));
+
+		source += inStride;
+		destination += outStride;
+	}
+
+	return out;
+}
+
+
+Matrix* MatrixIdentity(Matrix* out)
+{
+	ZeroMatrix(out);
+	out->_11 = 1.0f;
+	out->_22 = 1.0f;
+	out->_33 = 1.0f;
+	out->_44 = 1.0f;
+
+	return out;
+}
+
+
+Matrix* MatrixTranspose(Matrix* out, const Matrix* m)
+{
+	Matrix result;
+	int i, j;
+
+
+	// Work on a copy so the output can be the input.
+	for(i=0; i<4; i++)
+	{
+		for(j=0; j<4; j++)
+		{
+			result.m[i][j] = m->m[j][i];
+		}
+	}
+
+	*out = result;
+
+	return out;
+}
+
+
+Matrix* MatrixMultiply(Matrix* out, const Matrix* a, const Matrix* b)
+{
+	RowType row0, row1, row2, row3;
+	RowType result[4];
+	int i;
+
+
+	row0 = LoadRow(b->m[0]);
+	row1 = LoadRow(b->m[1]);
+	row2 = LoadRow(b->m[2]);
+	row3 = LoadRow(b->m[3]);
+
+	// Each row of the result is that row of a transformed by b, all rows are finished before storing so out can alias a or b.
+	for(i=0; i<4; i++)
+	{
+		result[i] = TransformVector(a->m[i][0], a->m[i][1], a->m[i][2], a->m[i][3], row0, row1, row2, row3);
+	}
+
+	for(i=0; i<4; i++)
+	{
+		StoreRow(out->m[i], result[i]);
+	}
+
+	return out;
+}
+
+
+Matrix* MatrixTranslation(Matrix* out, float x, float y, float z)
+{
+	MatrixIdentity(out);
+	out->_41 = x;
+	out->_42 = y;
+	out->_43 = z;
+
+	return out;
+}
+
+
+Matrix* MatrixRotationQuaternion(Matrix* out, const Quaternion* q)
+{
+	float xx, yy, zz, xy, xz, yz, wx, wy, wz;
+
+
+	xx = q->x * q->x;
+	yy = q->y * q->y;
+	zz = q->z * q->z;
+	xy = q->x * q->y;
+	xz = q->x * q->z;
+	yz = q->y * q->z;
+	wx = q->w * q->x;
+	wy = q->w * q->y;
+	wz = q->w * q->z;
+
+	out->_11 = 1.0f - 2.0f * (yy + zz);
+	out->_12 = 2.0f * (xy + wz);
+	out->_13 = 2.0f * (xz - wy);
+	out->_14 = 0.0f;
+
+	out->_21 = 2.0f * (xy - wz);
+	out->_22 = 1.0f - 2.0f * (xx + zz);
+	out->_23 = 2.0f * (yz + wx);
+	out->_24 = 0.0f;
+
+	out->_31 = 2.0f * (xz + wy);
+	out->_32 = 2.0f * (yz - wx);
+	out->_33 = 1.0f - 2.0f * (xx + yy);
+	out->_34 = 0.0f;
+
+	out->_41 = 0.0f;
+	out->_42 = 0.0f;
+	out->_43 = 0.0f;
+	out->_44 = 1.0f;
+
+	return out;
+}
+
+
+Matrix* MatrixRotationYawPitchRoll(Matrix* out, float yaw, float pitch, float roll)
+{
+	Quaternion rotation;
+
+
+	// Roll about Z is applied first, then pitch about X and finally yaw about Y.
+	QuaternionRotationYawPitchRoll(&rotation, yaw, pitch, roll);
+	MatrixRotationQuaternion(out, &rotation);
+
+	return out;
+}
+
+
+Matrix* MatrixLookAtLH(Matrix* out, const Vector3* eye, const Vector3* at, const Vector3* up)
+{
+	Vector3 xAxis, yAxis, zAxis;
+
+
+	zAxis = *at - *eye;
+	Vec3Normalize(&zAxis, &zAxis);
+	Vec3Cross(&xAxis, up, &zAxis);
+	Vec3Normalize(&xAxis, &xAxis);
+	Vec3Cross(&yAxis, &zAxis, &xAxis);
+
+	out->_11 = xAxis.x;
+	out->_12 = yAxis.x;
+	out->_13 = zAxis.x;
+	out->_14 = 0.0f;
+
+	out->_21 = xAxis.y;
+	out->_22 = yAxis.y;
+	out->_23 = zAxis.y;
+	out->_24 = 0.0f;
+
+	out->_31 = xAxis.z;
+	out->_32 = yAxis.z;
+	out->_33 = zAxis.z;
+	out->_34 = 0.0f;
+
+	out->_41 = -Vec3Dot(&xAxis, eye);
+	out->_42 = -Vec3Dot(&yAxis, eye);
+	out->_43 = -Vec3Dot(&zAxis, eye);
+	out->_44 = 1.0f;
+
+	return out;
+}
+
+
+Matrix* MatrixPerspectiveFovLH(Matrix* out, float fieldOfView, float aspect, float screenNear, float screenDepth)
+{
+	float yScale;
+
+
+	yScale = 1.0f / tanf(fieldOfView * 0.5f);
+
+	// Depth is mapped to 0 at the near plane and 1 at the far plane.
+	ZeroMatrix(out);
+	out->_11 = yScale / aspect;
+	out->_22 = yScale;
+	out->_33 = screenDepth / (screenDepth - screenNear);
+	out->_34 = 1.0f;
+	out->_43 = -screenNear * screenDepth / (screenDepth - screenNear);
+
+	return out;
+}
+
+
+Matrix* MatrixOrthoLH(Matrix* out, float width, float height, float screenNear, float screenDepth)
+{
+	ZeroMatrix(out);
+	out->_11 = 2.0f / width;
+	out->_22 = 2.0f / height;
+	out->_33 = 1.0f / (screenDepth - screenNear);
+	out->_43 = screenNear / (screenNear - screenDepth);
+	out->_44 = 1.0f;
+
+	return out;
+}
+
+
+Quaternion* QuaternionIdentity(Quaternion* out)
+{
+	*out = Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+	return out;
+}
+
+
+Quaternion* QuaternionRotationYawPitchRoll(Quaternion* out, float yaw, float pitch, float roll)
+{
+	float sinYaw, cosYaw, sinPitch, cosPitch, sinRoll, cosRoll;
+
+
+	sinYaw = sinf(yaw * 0.5f);
+	cosYaw = cosf(yaw * 0.5f);
+	sinPitch = sinf(pitch * 0.5f);
+	cosPitch = cosf(pitch * 0.5f);
+	sinRoll = sinf(roll * 0.5f);
+	cosRoll = cosf(roll * 0.5f);
+
+	out->x = (cosYaw * sinPitch * cosRoll) + (sinYaw * cosPitch * sinRoll);
+	out->y = (sinYaw * cosPitch * cosRoll) - (cosYaw * sinPitch * sinRoll);
+	out->z = (cosYaw * cosPitch * sinRoll) - (sinYaw * sinPitch * cosRoll);
+	out->w = (cosYaw * cosPitch * cosRoll) + (sinYaw * sinPitch * sinRoll);
+
+	return out;
+}
+
+
+Quaternion* QuaternionMultiply(Quaternion* out, const Quaternion* a, const Quaternion* b)
+{
+	Quaternion result;
+
+
+	// The result rotates by a and then by b, matching the order of matrix multiplication.
+	result.x = (b->w * a->x) + (b->x * a->w) + (b->y * a->z) - (b->z * a->y);
+	result.y = (b->w * a->y) - (b->x * a->z) + (b->y * a->w) + (b->z * a->x);
+	result.z = (b->w * a->z) + (b->x * a->y) - (b->y * a->x) + (b->z * a->w);
+	result.w = (b->w * a->w) - (b->x * a->x) - (b->y * a->y) - (b->z * a->z);
+	*out = result;
+
+	return out;
+}
+
+
+Quaternion* QuaternionNormalize(Quaternion* out, const Quaternion* q)
+{
+	float length;
+
+
+	length = sqrtf((q->x * q->x) + (q->y * q->y) + (q->z * q->z) + (q->w * q->w));
+	if(length > 0.0f)
+	{
+		*out = Quaternion(q->x / length, q->y / length, q->z / length, q->w / length);
+	}
+	else
+	{
+		QuaternionIdentity(out);
+	}
+
+	return out;
+}
+
+
+Quaternion* QuaternionSlerp(Quaternion* out, const Quaternion* a, const Quaternion* b, float t)
+{
+	Quaternion end;
+	float cosAngle, angle, sinAngle, scaleA, scaleB;
+
+
+	// Take the short way round.
+	end = *b;
+	cosAngle = (a->x * b->x) + (a->y * b->y) + (a->z * b->z) + (a->w * b->w);
+	if(cosAngle < 0.0f)
+	{
+		end = Quaternion(-b->x, -b->y, -b->z, -b->w);
+		cosAngle = -cosAngle;
+	}
+
+	// Nearly parallel rotations fall back to a linear blend to avoid dividing by a tiny sine.
+	if(cosAngle > 0.9995f)
+	{
+		scaleA = 1.0f - t;
+		scaleB = t;
+	}
+	else
+	{
+		angle = acosf(cosAngle);
+		sinAngle = sinf(angle);
+		scaleA = sinf((1.0f - t) * angle) / sinAngle;
+		scaleB = sinf(t * angle) / sinAngle;
+	}
+
+	out->x = (a->x * scaleA) + (end.x * scaleB);
+	out->y = (a->y * scaleA) + (end.y * scaleB);
+	out->z = (a->z * scaleA) + (end.z * scaleB);
+	out->w = (a->w * scaleA) + (end.w * scaleB);
+
+	return QuaternionNormalize(out, out);
+}
+
+
+Frustum* FrustumFromMatrix(Frustum* out, const Matrix* m)
+{
+	float length;
+	int i;
+
+
+	// Pull the planes out of the combined view projection matrix, clip space depth runs from 0 to 1.
+	// Left and right.
+	out->planes[0].a = m->_14 + m->_11;
+	out->planes[0].b = m->_24 + m->_21;
+	out->planes[0].c = m->_34 + m->_31;
+	out->planes[0].d = m->_44 + m->_41;
+
+	out->planes[1].a = m->_14 - m->_11;
+	out->planes[1].b = m->_24 - m->_21;
+	out->planes[1].c = m->_34 - m->_31;
+	out->planes[1].d = m->_44 - m->_41;
+
+	// Bottom and top.
+	out->planes[2].a = m->_14 + m->_12;
+	out->planes[2].b = m->_24 + m->_22;
+	out->planes[2].c = m->_34 + m->_32;
+	out->planes[2].d = m->_44 + m->_42;
+
+	out->planes[3].a = m->_14 - m->_12;
+	out->planes[3].b = m->_24 - m->_22;
+	out->planes[3].c = m->_34 - m->_32;
+	out->planes[3].d = m->_44 - m->_42;
+
+	// Near and far.
+	out->planes[4].a = m->_13;
+	out->planes[4].b = m->_23;
+	out->planes[4].c = m->_33;
+	out->planes[4].d = m->_43;
+
+	out->planes[5].a = m->_14 - m->_13;
+	out->planes[5].b = m->_24 - m->_23;
+	out->planes[5].c = m->_34 - m->_33;
+	out->planes[5].d = m->_44 - m->_43;
+
+	// Normalize the planes so distances come out in world units.
+	for(i=0; i<6; i++)
+	{
+		length = sqrtf((out->planes[i].a * out->planes[i].a) + (out->planes[i].b * out->planes[i].b) + (out->planes[i].c * out->planes[i].c));
+		if(length > 0.0f)
+		{
+			out->planes[i].a /= length;
+			out->planes[i].b /= length;
+			out->planes[i].c /= length;
+			out->planes[i].d /= length;
+		}
+	}
+
+	return out;
+}
+
+
+bool FrustumCheckPoint(const Frustum* frustum, const Vector3* point)
+{
+	return FrustumCheckSphere(frustum, point, 0.0f);
+}
+
+
+bool FrustumCheckSphere(const Frustum* frustum, const Vector3* center, float radius)
+{
+	const Plane* plane;
+	int i;
+
+
+	for(i=0; i<6; i++)
+	{
+		plane = &frustum->planes[i];
+		if((plane->a * center->x) + (plane->b * center->y) + (plane->c * center->z) + plane->d < -radius)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool FrustumCheckBox(const Frustum* frustum, const Vector3* boxMin, const Vector3* boxMax)
+{
+	const Plane* plane;
+	Vector3 corner;
+	int i;
+
+
+	// Only the corner furthest along each plane normal needs testing.
+	for(i=0; i<6; i++)
+	{
+		plane = &frustum->planes[i];
+		corner.x = (plane->a >= 0.0f) ? boxMax->x : boxMin->x;
+		corner.y = (plane->b >= 0.0f) ? boxMax->y : boxMin->y;
+		corner.z = (plane->c >= 0.0f) ? boxMax->z : boxMin->z;
+
+		if((plane->a * corner.x) + (plane->b * corner.y) + (plane->c * corner.z) + plane->d < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+int FrustumCheckSpheres(const Frustum* frustum, const Vector4* spheres, int count, bool* visible)
+{
+	Vector3 center;
+	int i, visibleCount;
+#if defined(ENGINE_MATH_SSE)
+	__m128 x, y, z, radius, distance, inside, negativeRadius;
+	int j, mask;
+
+
+	visibleCount = 0;
+
+	// Four spheres at a time, transposed so each register holds one component of all four.
+	for(i=0; i+4<=count; i+=4)
+	{
+		x = _mm_loadu_ps(&spheres[i].x);
+		y = _mm_loadu_ps(&spheres[i + 1].x);
+		z = _mm_loadu_ps(&spheres[i + 2].x);
+		radius = _mm_loadu_ps(&spheres[i + 3].x);
+		_MM_TRANSPOSE4_PS(x, y, z, radius);
+
+		negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+		inside = _mm_cmpeq_ps(x, x);
+
+		// The distance is summed in the same order as FrustumCheckSphere so both give the same answer on the boundary.
+		for(j=0; j<6; j++)
+		{
+			distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(frustum->planes[j].a)), _mm_mul_ps(y, _mm_set1_ps(frustum->planes[j].b)));
+			distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(frustum->planes[j].c))), _mm_set1_ps(frustum->planes[j].d));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		mask = _mm_movemask_ps(inside);
+		for(j=0; j<4; j++)
+		{
+			visible[i + j] = ((mask >> j) & 1) != 0;
+			visibleCount += visible[i + j] ? 1 : 0;
+		}
+	}
+#elif defined(ENGINE_MATH_NEON)
+	float32x4x4_t packed;
+	float32x4_t distance, negativeRadius;
+	uint32x4_t inside;
+	int j;
+
+
+	visibleCount = 0;
+
+	// Four spheres at a time, the interleaved load splits the components into one register each.
+	for(i=0; i+4<=count; i+=4)
+	{
+		packed = vld4q_f32(&spheres[i].x);
+		negativeRadius = vnegq_f32(packed.val[3]);
+		inside = vdupq_n_u32(0xffffffff);
+
+		// Separate multiplies and adds in the same order as FrustumCheckSphere, a fused multiply add would round differently.
+		for(j=0; j<6; j++)
+		{
+			distance = vaddq_f32(vmulq_n_f32(packed.val[0], frustum->planes[j].a), vmulq_n_f32(packed.val[1], frustum->planes[j].b));
+			distance = vaddq_f32(vaddq_f32(distance, vmulq_n_f32(packed.val[2], frustum->planes[j].c)), vdupq_n_f32(frustum->planes[j].d));
+			inside = vandq_u32(inside, vcgeq_f32(distance, negativeRadius));
+		}
+
+		visible[i] = vgetq_lane_u32(inside, 0) != 0;
+		visible[i + 1] = vgetq_lane_u32(inside, 1) != 0;
+		visible[i + 2] = vgetq_lane_u32(inside, 2) != 0;
+		visible[i + 3] = vgetq_lane_u32(inside, 3) != 0;
+
+		for(j=0; j<4; j++)
+		{
+			visibleCount += visible[i + j] ? 1 : 0;
+		}
+	}
+#else
+	visibleCount = 0;
+	i = 0;
+#endif
+
+	// Finish the remainder one sphere at a time.
+	for(; i<count; i++)
+	{
+		center = Vector3(spheres[i].x, spheres[i].y, spheres[i].z);
+		visible[i] = FrustumCheckSphere(frustum, &center, spheres[i].w);
+		visibleCount += visible[i] ? 1 : 0;
+	}
+
+	return visibleCount;
+}
+
+
+void StreamCopy(void* destination, const void* source, int size)
+{
+#if defined(ENGINE_MATH_SSE)
+	char* output;
+	const char* input;
+	int head;
+
+
+	output = (char*)destination;
+	input = (const char*)source;
+
+	// The streaming stores need a 16 byte aligned destination, copy up to the first boundary normally.
+	head = (int)((16 - ((size_t)output & 15)) & 15);
+	if(head > size)
+	{
+		head = size;
+	}
+
+	memcpy(output, input, head);
+	output += head;
+	input += head;
+	size -= head;
+
+	// Write whole 16 byte blocks straight to memory, the write combining buffers join them into full lines.
+	for(; size>=64; size-=64, output+=64, input+=64)
+	{
+		_mm_stream_si128((__m128i*)output, _mm_loadu_si128((const __m128i*)input));
+		_mm_stream_si128((__m128i*)(output + 16), _mm_loadu_si128((const __m128i*)(input + 16)));
+		_mm_stream_si128((__m128i*)(output + 32), _mm_loadu_si128((const __m128i*)(input + 32)));
+		_mm_stream_si128((__m128i*)(output + 48), _mm_loadu_si128((const __m128i*)(input + 48)));
+	}
+
+	for(; size>=16; size-=16, output+=16, input+=16)
+	{
+		_mm_stream_si128((__m128i*)output, _mm_loadu_si128((const __m128i*)input));
+	}
+
+	// Copy whatever is left over normally.
+	memcpy(output, input, size);
+#else
+	memcpy(destination, source, size);
+#endif
+
+	return;
+}
+
+
+void StreamFence()
+{
+#if defined(ENGINE_MATH_SSE)
+	_mm_sfence();
+#endif
+
+	return;
+}
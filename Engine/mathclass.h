@@ -0,0 +1,213 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mathclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MATHCLASS_H_
+#define _MATHCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const float MATH_PI = 3.141592654f;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <math.h>
+
+
+// Pick the vector instruction set, define ENGINE_MATH_SCALAR to build the plain C++ reference versions instead.
+#if !defined(ENGINE_MATH_SCALAR)
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define ENGINE_MATH_SSE
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ENGINE_MATH_NEON
+#endif
+#endif
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// The types match the memory layout of the shader constant buffers so they can be copied straight into them.
+// Matrices are row major and vectors multiply from the left, the same conventions the D3DX helpers used.
+struct Vector2
+{
+	float x, y;
+
+	Vector2() {}
+	Vector2(float x, float y) : x(x), y(y) {}
+};
+
+struct Vector3
+{
+	float x, y, z;
+
+	Vector3() {}
+	Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+	Vector3 operator+(const Vector3& other) const { return Vector3(x + other.x, y + other.y, z + other.z); }
+	Vector3 operator-(const Vector3& other) const { return Vector3(x - other.x, y - other.y, z - other.z); }
+	Vector3 operator*(float scale) const { return Vector3(x * scale, y * scale, z * scale); }
+	Vector3 operator-() const { return Vector3(-x, -y, -z); }
+	Vector3& operator+=(const Vector3& other) { x += other.x; y += other.y; z += other.z; return *this; }
+	Vector3& operator-=(const Vector3& other) { x -= other.x; y -= other.y; z -= other.z; return *this; }
+	Vector3& operator*=(float scale) { x *= scale; y *= scale; z *= scale; return *this; }
+	bool operator==(const Vector3& other) const { return (x == other.x) && (y == other.y) && (z == other.z); }
+	bool operator!=(const Vector3& other) const { return !(*this == other); }
+};
+
+struct Vector4
+{
+	float x, y, z, w;
+
+	Vector4() {}
+	Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	Vector4(const Vector3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+	Vector4 operator+(const Vector4& other) const { return Vector4(x + other.x, y + other.y, z + other.z, w + other.w); }
+	Vector4 operator-(const Vector4& other) const { return Vector4(x - other.x, y - other.y, z - other.z, w - other.w); }
+	Vector4 operator*(float scale) const { return Vector4(x * scale, y * scale, z * scale, w * scale); }
+	bool operator==(const Vector4& other) const { return (x == other.x) && (y == other.y) && (z == other.z) && (w == other.w); }
+	bool operator!=(const Vector4& other) const { return !(*this == other); }
+};
+
+struct Quaternion
+{
+	float x, y, z, w;
+
+	Quaternion() {}
+	Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+};
+
+struct Matrix
+{
+	union
+	{
+		struct
+		{
+			float _11, _12, _13, _14;
+			float _21, _22, _23, _24;
+			float _31, _32, _33, _34;
+			float _41, _42, _43, _44;
+		};
+		float m[4][4];
+	};
+
+	Matrix() {}
+
+	Matrix operator*(const Matrix&) const;
+};
+
+// A plane is the set of points where a*x + b*y + c*z + d is zero, the normal points into the frustum.
+struct Plane
+{
+	float a, b, c, d;
+};
+
+struct Frustum
+{
+	Plane planes[6];
+};
+
+
+//////////////////////
+// VECTOR FUNCTIONS //
+//////////////////////
+inline float Vec3Dot(const Vector3* a, const Vector3* b)
+{
+	return (a->x * b->x) + (a->y * b->y) + (a->z * b->z);
+}
+
+inline Vector3* Vec3Cross(Vector3* out, const Vector3* a, const Vector3* b)
+{
+	Vector3 result;
+
+
+	result.x = (a->y * b->z) - (a->z * b->y);
+	result.y = (a->z * b->x) - (a->x * b->z);
+	result.z = (a->x * b->y) - (a->y * b->x);
+	*out = result;
+
+	return out;
+}
+
+inline float Vec3Length(const Vector3* v)
+{
+	return sqrtf(Vec3Dot(v, v));
+}
+
+inline Vector3* Vec3Normalize(Vector3* out, const Vector3* v)
+{
+	float length;
+
+
+	length = Vec3Length(v);
+	if(length > 0.0f)
+	{
+		*out = *v * (1.0f / length);
+	}
+	else
+	{
+		*out = Vector3(0.0f, 0.0f, 0.0f);
+	}
+
+	return out;
+}
+
+Vector3* Vec3TransformCoord(Vector3*, const Vector3*, const Matrix*);
+Vector3* Vec3TransformNormal(Vector3*, const Vector3*, const Matrix*);
+Vector4* Vec4Transform(Vector4*, const Vector4*, const Matrix*);
+
+// Batch transforms, the strides are in bytes so the vectors can sit inside larger vertex structures.
+Vector4* Vec3TransformArray(Vector4*, int, const Vector3*, int, const Matrix*, int);
+Vector3* Vec3TransformCoordArray(Vector3*, int, const Vector3*, int, const Matrix*, int);
+Vector4* Vec4TransformArray(Vector4*, int, const Vector4*, int, const Matrix*, int);
+
+
+//////////////////////
+// MATRIX FUNCTIONS //
+//////////////////////
+Matrix* MatrixIdentity(Matrix*);
+Matrix* MatrixTranspose(Matrix*, const Matrix*);
+Matrix* MatrixMultiply(Matrix*, const Matrix*, const Matrix*);
+Matrix* MatrixTranslation(Matrix*, float, float, float);
+Matrix* MatrixRotationQuaternion(Matrix*, const Quaternion*);
+Matrix* MatrixRotationYawPitchRoll(Matrix*, float, float, float);
+Matrix* MatrixLookAtLH(Matrix*, const Vector3*, const Vector3*, const Vector3*);
+Matrix* MatrixPerspectiveFovLH(Matrix*, float, float, float, float);
+Matrix* MatrixOrthoLH(Matrix*, float, float, float, float);
+
+
+//////////////////////////
+// QUATERNION FUNCTIONS //
+//////////////////////////
+Quaternion* QuaternionIdentity(Quaternion*);
+Quaternion* QuaternionRotationYawPitchRoll(Quaternion*, float, float, float);
+Quaternion* QuaternionMultiply(Quaternion*, const Quaternion*, const Quaternion*);
+Quaternion* QuaternionNormalize(Quaternion*, const Quaternion*);
+Quaternion* QuaternionSlerp(Quaternion*, const Quaternion*, const Quaternion*, float);
+
+
+///////////////////////
+// FRUSTUM FUNCTIONS //
+///////////////////////
+Frustum* FrustumFromMatrix(Frustum*, const Matrix*);
+bool FrustumCheckPoint(const Frustum*, const Vector3*);
+bool FrustumCheckSphere(const Frustum*, const Vector3*, float);
+bool FrustumCheckBox(const Frustum*, const Vector3*, const Vector3*);
+
+// Tests packed x, y, z, radius spheres and writes one visible flag per sphere, returns the number visible.
+int FrustumCheckSpheres(const Frustum*, const Vector4*, int, bool*);
+
+
+//////////////////////
+// MEMORY FUNCTIONS //
+//////////////////////
+// Copies into memory the CPU will not read again, such as a mapped buffer, with stores that go around the cache.  The
+// stores are only ordered with the ones that follow after StreamFence, which has to be called before the unmap.
+void StreamCopy(void*, const void*, int);
+void StreamFence();
+
+#endif
@@ -0,0 +1,283 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: normalmapclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "normalmapclass.h"
+#include "profilerclass.h"
+#include "jobsystemclass.h"
+#include "clockclass.h"
+#include <emmintrin.h>
+#include <string.h>
+#include <math.h>
+
+
+NormalMapClass::NormalMapClass()
+{
+	m_heights = 0;
+	m_normals = 0;
+	m_sourceHeights = 0;
+	m_sourceStride = 0;
+	m_bakeTime = 0.0f;
+}
+
+
+NormalMapClass::NormalMapClass(const NormalMapClass& other)
+{
+}
+
+
+NormalMapClass::~NormalMapClass()
+{
+}
+
+
+bool NormalMapClass::Initialize(int heightMapWidth, int heightMapHeight, int scale)
+{
+	// Store the dimensions of the source height map and how many texels each height map cell is baked into.
+	m_heightMapWidth = heightMapWidth;
+	m_heightMapHeight = heightMapHeight;
+	m_scale = scale;
+
+	// Each cell between two height map samples becomes scale texels, with the last sample landing on the final texel.
+	m_width = ((m_heightMapWidth - 1) * m_scale) + 1;
+	m_height = ((m_heightMapHeight - 1) * m_scale) + 1;
+
+	// The upsampled heights carry a one texel border so the gradient kernel never has to branch at the edges.
+	m_paddedWidth = m_width + 2;
+
+	// Create the upsampled height array.
+	m_heights = new float[m_paddedWidth * (m_height + 2)];
+	if(!m_heights)
+	{
+		return false;
+	}
+
+	// Create the two channel normal map array.
+	m_normals = new signed char[m_width * m_height * 2];
+	if(!m_normals)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+void NormalMapClass::Shutdown()
+{
+	// Release the normal map array.
+	if(m_normals)
+	{
+		delete [] m_normals;
+		m_normals = 0;
+	}
+
+	// Release the upsampled height array.
+	if(m_heights)
+	{
+		delete [] m_heights;
+		m_heights = 0;
+	}
+
+	return;
+}
+
+
+bool NormalMapClass::Bake(const float* heights, int heightStride)
+{
+	StopwatchClass stopwatch;
+
+
+	PROFILE_ZONE("Normal Map");
+
+	stopwatch.Start();
+
+	// Upsample the height map into the padded height array, the rows are split into jobs.
+	m_sourceHeights = heights;
+	m_sourceStride = heightStride;
+
+	JobSystemClass::ParallelFor(this, &NormalMapClass::UpsampleRows, m_height, NORMAL_MAP_JOB_ROWS);
+
+	m_sourceHeights = 0;
+
+	// Replicate the first and last rows into the border so the kernel clamps at the top and bottom edges.
+	memcpy(m_heights, m_heights + m_paddedWidth, sizeof(float) * m_paddedWidth);
+	memcpy(m_heights + ((m_height + 1) * m_paddedWidth), m_heights + (m_height * m_paddedWidth), sizeof(float) * m_paddedWidth);
+
+	// Now that every row and its neighbours are available derive the normals from the height gradients.
+	JobSystemClass::ParallelFor(this, &NormalMapClass::BakeRows, m_height, NORMAL_MAP_JOB_ROWS);
+
+	// Store how long the bake took in milliseconds.
+	m_bakeTime = stopwatch.GetMilliseconds();
+
+	return true;
+}
+
+
+int NormalMapClass::GetWidth()
+{
+	return m_width;
+}
+
+
+int NormalMapClass::GetHeight()
+{
+	return m_height;
+}
+
+
+int NormalMapClass::GetScale()
+{
+	return m_scale;
+}
+
+
+const signed char* NormalMapClass::GetNormalData()
+{
+	return m_normals;
+}
+
+
+int NormalMapClass::GetNormalPitch()
+{
+	return m_width * 2;
+}
+
+
+const float* NormalMapClass::GetHeightData()
+{
+	// Skip the border row and column.
+	return m_heights + m_paddedWidth + 1;
+}
+
+
+int NormalMapClass::GetHeightPitch()
+{
+	return m_paddedWidth * sizeof(float);
+}
+
+
+float NormalMapClass::GetBakeTime()
+{
+	return m_bakeTime;
+}
+
+
+void NormalMapClass::UpsampleRows(int startRow, int endRow)
+{
+	const float* heights;
+	int heightStride, x, y, i, j, i1, j1;
+	float fx, fy, invScale, top, bottom;
+	float* row;
+
+
+	PROFILE_ZONE("Upsample");
+
+	heights = m_sourceHeights;
+	heightStride = m_sourceStride;
+	invScale = 1.0f / (float)m_scale;
+
+	for(y=startRow; y<endRow; y++)
+	{
+		// Find the two height map rows this texel row lies between.
+		j = y / m_scale;
+		j1 = (j + 1 < m_heightMapHeight) ? (j + 1) : j;
+		fy = (float)(y % m_scale) * invScale;
+
+		row = m_heights + ((y + 1) * m_paddedWidth) + 1;
+
+		for(x=0; x<m_width; x++)
+		{
+			// Find the two height map columns this texel lies between.
+			i = x / m_scale;
+			i1 = (i + 1 < m_heightMapWidth) ? (i + 1) : i;
+			fx = (float)(x % m_scale) * invScale;
+
+			// Bilinearly interpolate the four surrounding height samples.
+			top = heights[((j * m_heightMapWidth) + i) * heightStride];
+			top += (heights[((j * m_heightMapWidth) + i1) * heightStride] - top) * fx;
+
+			bottom = heights[((j1 * m_heightMapWidth) + i) * heightStride];
+			bottom += (heights[((j1 * m_heightMapWidth) + i1) * heightStride] - bottom) * fx;
+
+			row[x] = top + ((bottom - top) * fy);
+		}
+
+		// Replicate the first and last texel into the border columns.
+		row[-1] = row[0];
+		row[m_width] = row[m_width - 1];
+	}
+
+	return;
+}
+
+
+void NormalMapClass::BakeRows(int startRow, int endRow)
+{
+	int x, y;
+	const float *previousRow, *row, *nextRow;
+	signed char* output;
+	float gradientScale, dx, dz, factor;
+	__m128 scale, one, half, three, encodeScale, gradientX, gradientZ, lengthSquared, invLength, estimate;
+	__m128i encodedX, encodedZ, packed;
+
+
+	PROFILE_ZONE("Bake");
+
+	// Central differences span two texels, and each texel is 1/scale of a height map cell.
+	gradientScale = 0.5f * (float)m_scale;
+
+	scale = _mm_set1_ps(gradientScale);
+	one = _mm_set1_ps(1.0f);
+	half = _mm_set1_ps(0.5f);
+	three = _mm_set1_ps(3.0f);
+	encodeScale = _mm_set1_ps(-127.0f);
+
+	for(y=startRow; y<endRow; y++)
+	{
+		previousRow = m_heights + (y * m_paddedWidth) + 1;
+		row = m_heights + ((y + 1) * m_paddedWidth) + 1;
+		nextRow = m_heights + ((y + 2) * m_paddedWidth) + 1;
+
+		output = m_normals + (y * m_width * 2);
+
+		// Process four texels at a time.
+		for(x=0; (x + 4)<=m_width; x+=4)
+		{
+			// Get the height gradient along x and z.
+			gradientX = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row + x + 1), _mm_loadu_ps(row + x - 1)), scale);
+			gradientZ = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(nextRow + x), _mm_loadu_ps(previousRow + x)), scale);
+
+			// The surface normal is (-dx, 1, -dz), so its squared length is dx*dx + dz*dz + 1.
+			lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(gradientX, gradientX), _mm_mul_ps(gradientZ, gradientZ)), one);
+
+			// Refine the reciprocal square root estimate with one Newton-Raphson step.
+			estimate = _mm_rsqrt_ps(lengthSquared);
+			invLength = _mm_mul_ps(_mm_mul_ps(half, estimate), _mm_sub_ps(three, _mm_mul_ps(lengthSquared, _mm_mul_ps(estimate, estimate))));
+
+			// Normalize, negate and scale x and z into the signed 8 bit range.
+			encodedX = _mm_cvtps_epi32(_mm_mul_ps(gradientX, _mm_mul_ps(invLength, encodeScale)));
+			encodedZ = _mm_cvtps_epi32(_mm_mul_ps(gradientZ, _mm_mul_ps(invLength, encodeScale)));
+
+			// Interleave into x0 z0 x1 z1 x2 z2 x3 z3 and narrow to bytes.
+			packed = _mm_packs_epi32(encodedX, encodedZ);
+			packed = _mm_unpacklo_epi16(packed, _mm_srli_si128(packed, 8));
+			packed = _mm_packs_epi16(packed, packed);
+
+			_mm_storel_epi64((__m128i*)(output + (x * 2)), packed);
+		}
+
+		// Finish off any remaining texels one at a time.
+		for(; x<m_width; x++)
+		{
+			dx = (row[x + 1] - row[x - 1]) * gradientScale;
+			dz = (nextRow[x] - previousRow[x]) * gradientScale;
+
+			factor = -127.0f / sqrtf((dx * dx) + (dz * dz) + 1.0f);
+
+			output[(x * 2)] = (signed char)nearbyintf(dx * factor);
+			output[(x * 2) + 1] = (signed char)nearbyintf(dz * factor);
+		}
+	}
+
+	return;
+}
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: normalmapclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _NORMALMAPCLASS_H_
+#define _NORMALMAPCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int NORMAL_MAP_JOB_ROWS = 16;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: NormalMapClass
+////////////////////////////////////////////////////////////////////////////////
+class NormalMapClass
+{
+public:
+	NormalMapClass();
+	NormalMapClass(const NormalMapClass&);
+	~NormalMapClass();
+
+	bool Initialize(int, int, int);
+	void Shutdown();
+	bool Bake(const float*, int);
+
+	int GetWidth();
+	int GetHeight();
+	int GetScale();
+
+	// Two channel (x, z) signed normalized normals, two bytes per texel.
+	const signed char* GetNormalData();
+	int GetNormalPitch();
+
+	// Bilinearly upsampled heights the normals were derived from.
+	const float* GetHeightData();
+	int GetHeightPitch();
+
+	float GetBakeTime();
+
+private:
+	void UpsampleRows(int, int);
+	void BakeRows(int, int);
+
+private:
+	int m_heightMapWidth, m_heightMapHeight;
+	int m_scale;
+	int m_width, m_height;
+	int m_paddedWidth;
+	float* m_heights;
+	signed char* m_normals;
+	const float* m_sourceHeights;
+	int m_sourceStride;
+	float m_bakeTime;
+};
+
+#endif
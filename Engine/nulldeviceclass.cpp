@@ -0,0 +1,410 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: nulldeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "nulldeviceclass.h"
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Null resources only count themselves, buffers keep their bytes so they can
+// still be mapped and written.
+////////////////////////////////////////////////////////////////////////////////
+class NullBuffer : public RenderBuffer
+{
+public:
+	void Release()
+	{
+		counters->resourcesReleased++;
+		counters->liveResources--;
+		delete [] data;
+		delete this;
+	}
+
+	NullDeviceClass::CountersType* counters;
+	char* data;
+	int byteWidth;
+};
+
+class NullTexture : public RenderTexture
+{
+public:
+	void Release()
+	{
+		counters->resourcesReleased++;
+		counters->liveResources--;
+		delete this;
+	}
+
+	NullDeviceClass::CountersType* counters;
+};
+
+class NullShader : public RenderProgram
+{
+public:
+	void Release()
+	{
+		counters->resourcesReleased++;
+		counters->liveResources--;
+		delete this;
+	}
+
+	NullDeviceClass::CountersType* counters;
+};
+
+class NullInputLayout : public RenderInputLayout
+{
+public:
+	void Release()
+	{
+		counters->resourcesReleased++;
+		counters->liveResources--;
+		delete this;
+	}
+
+	NullDeviceClass::CountersType* counters;
+};
+
+class NullSampler : public RenderSampler
+{
+public:
+	void Release()
+	{
+		counters->resourcesReleased++;
+		counters->liveResources--;
+		delete this;
+	}
+
+	NullDeviceClass::CountersType* counters;
+};
+
+
+NullDeviceClass::NullDeviceClass()
+{
+	memset(&m_counters, 0, sizeof(CountersType));
+	m_fenceValue = 0;
+}
+
+
+NullDeviceClass::NullDeviceClass(const NullDeviceClass& other)
+{
+}
+
+
+NullDeviceClass::~NullDeviceClass()
+{
+}
+
+
+bool NullDeviceClass::Initialize(int screenWidth, int screenHeight, float screenDepth, float screenNear)
+{
+	// Create the same matrices a real device would so the frame transforms are unchanged.
+	InitializeMatrices(screenWidth, screenHeight, screenDepth, screenNear);
+
+	return true;
+}
+
+
+void NullDeviceClass::Shutdown()
+{
+	return;
+}
+
+
+void NullDeviceClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	return;
+}
+
+
+void NullDeviceClass::EndScene()
+{
+	m_counters.frames++;
+	return;
+}
+
+
+void NullDeviceClass::SetVSync(bool enabled)
+{
+	// There is no display to wait for.
+	return;
+}
+
+
+void NullDeviceClass::GetVideoCardInfo(char* cardName, int& memory)
+{
+	strcpy(cardName, "Null Device");
+	memory = 0;
+	return;
+}
+
+
+void NullDeviceClass::BindDepthState(bool enable)
+{
+	m_counters.renderStateChanges++;
+	return;
+}
+
+
+void NullDeviceClass::BindBlendState(bool enable)
+{
+	m_counters.renderStateChanges++;
+	return;
+}
+
+
+RenderBuffer* NullDeviceClass::CreateBuffer(RenderBufferType type, RenderUsage usage, int byteWidth, const void* data)
+{
+	NullBuffer* buffer;
+
+
+	buffer = new NullBuffer;
+	if(!buffer)
+	{
+		return 0;
+	}
+
+	// Keep a copy of the contents so mapping hands back real memory.
+	buffer->counters = &m_counters;
+	buffer->byteWidth = byteWidth;
+	buffer->data = new char[byteWidth];
+	if(!buffer->data)
+	{
+		delete buffer;
+		return 0;
+	}
+
+	if(data)
+	{
+		memcpy(buffer->data, data, byteWidth);
+		m_counters.bytesInitialized += byteWidth;
+	}
+
+	m_counters.buffersCreated++;
+	m_counters.liveResources++;
+
+	return buffer;
+}
+
+
+RenderTexture* NullDeviceClass::CreateTexture(int width, int height, RenderFormat format, RenderUsage usage, const void* data, int pitch)
+{
+	NullTexture* texture;
+
+
+	texture = new NullTexture;
+	if(!texture)
+	{
+		return 0;
+	}
+
+	texture->counters = &m_counters;
+
+	m_counters.texturesCreated++;
+	m_counters.liveResources++;
+
+	return texture;
+}
+
+
+RenderTexture* NullDeviceClass::CreateTextureFromFile(const char* filename)
+{
+	return CreateTexture(0, 0, RENDER_FORMAT_R8G8B8A8_UNORM, RENDER_USAGE_STATIC, 0, 0);
+}
+
+
+RenderProgram* NullDeviceClass::CreateVertexShader(const char* filename, const char* entryPoint)
+{
+	NullShader* shader;
+
+
+	shader = new NullShader;
+	if(!shader)
+	{
+		return 0;
+	}
+
+	shader->counters = &m_counters;
+
+	m_counters.shadersCreated++;
+	m_counters.liveResources++;
+
+	return shader;
+}
+
+
+RenderProgram* NullDeviceClass::CreatePixelShader(const char* filename, const char* entryPoint)
+{
+	return CreateVertexShader(filename, entryPoint);
+}
+
+
+RenderInputLayout* NullDeviceClass::CreateInputLayout(const RenderInputElementType* elements, int elementCount, RenderProgram* vertexShader)
+{
+	NullInputLayout* layout;
+
+
+	layout = new NullInputLayout;
+	if(!layout)
+	{
+		return 0;
+	}
+
+	layout->counters = &m_counters;
+
+	m_counters.layoutsCreated++;
+	m_counters.liveResources++;
+
+	return layout;
+}
+
+
+RenderSampler* NullDeviceClass::CreateSampler(RenderAddressMode addressMode)
+{
+	NullSampler* sampler;
+
+
+	sampler = new NullSampler;
+	if(!sampler)
+	{
+		return 0;
+	}
+
+	sampler->counters = &m_counters;
+
+	m_counters.samplersCreated++;
+	m_counters.liveResources++;
+
+	return sampler;
+}
+
+
+void* NullDeviceClass::LockBuffer(RenderBuffer* buffer, RenderMapMode mode)
+{
+	m_counters.bufferMaps++;
+
+	if(mode == RENDER_MAP_DISCARD)
+	{
+		m_counters.bufferRenames++;
+		m_counters.bytesMapped += ((NullBuffer*)buffer)->byteWidth;
+	}
+
+	return ((NullBuffer*)buffer)->data;
+}
+
+
+void NullDeviceClass::UnlockBuffer(RenderBuffer* buffer)
+{
+	return;
+}
+
+
+void NullDeviceClass::UpdateTexture(RenderTexture* texture, const void* data, int pitch)
+{
+	m_counters.textureUpdates++;
+	return;
+}
+
+
+void NullDeviceClass::BindVertexBuffer(RenderBuffer* buffer, int stride)
+{
+	m_counters.vertexBufferBinds++;
+	return;
+}
+
+
+void NullDeviceClass::BindIndexBuffer(RenderBuffer* buffer)
+{
+	m_counters.indexBufferBinds++;
+	return;
+}
+
+
+void NullDeviceClass::BindInputLayout(RenderInputLayout* layout)
+{
+	m_counters.layoutBinds++;
+	return;
+}
+
+
+void NullDeviceClass::BindVertexShader(RenderProgram* shader)
+{
+	m_counters.shaderBinds++;
+	return;
+}
+
+
+void NullDeviceClass::BindPixelShader(RenderProgram* shader)
+{
+	m_counters.shaderBinds++;
+	return;
+}
+
+
+void NullDeviceClass::BindVSConstantBuffer(int slot, RenderBuffer* buffer)
+{
+	m_counters.constantBufferBinds++;
+	return;
+}
+
+
+void NullDeviceClass::BindPSConstantBuffer(int slot, RenderBuffer* buffer)
+{
+	m_counters.constantBufferBinds++;
+	return;
+}
+
+
+void NullDeviceClass::BindPSTexture(int slot, RenderTexture* texture)
+{
+	m_counters.textureBinds++;
+	return;
+}
+
+
+void NullDeviceClass::BindPSSampler(int slot, RenderSampler* sampler)
+{
+	m_counters.samplerBinds++;
+	return;
+}
+
+
+void NullDeviceClass::DrawIndexed(int indexCount, int baseVertex)
+{
+	m_counters.draws++;
+	m_counters.indicesDrawn += indexCount;
+	return;
+}
+
+
+unsigned long long NullDeviceClass::InsertFence()
+{
+	// Nothing is ever queued, so every fence is complete as soon as it is inserted.
+	m_fenceValue++;
+	return m_fenceValue;
+}
+
+
+bool NullDeviceClass::IsFenceComplete(unsigned long long fence)
+{
+	return true;
+}
+
+
+const NullDeviceClass::CountersType& NullDeviceClass::GetCounters()
+{
+	return m_counters;
+}
+
+
+void NullDeviceClass::ResetCounters()
+{
+	int liveResources;
+
+
+	// Resources that are still alive stay counted across a reset.
+	liveResources = m_counters.liveResources;
+	memset(&m_counters, 0, sizeof(CountersType));
+	m_counters.liveResources = liveResources;
+
+	return;
+}
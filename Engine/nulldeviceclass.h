@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: nulldeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _NULLDEVICECLASS_H_
+#define _NULLDEVICECLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: NullDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+class NullDeviceClass : public RenderDeviceClass
+{
+public:
+	// A discard map is counted as a rename along with the whole buffer it replaces, a no overwrite map renames nothing.
+	struct CountersType
+	{
+		int buffersCreated, texturesCreated, shadersCreated, layoutsCreated, samplersCreated;
+		int resourcesReleased, liveResources;
+		int bufferMaps, bufferRenames, bytesMapped, bytesInitialized, textureUpdates;
+		int vertexBufferBinds, indexBufferBinds, layoutBinds, shaderBinds;
+		int constantBufferBinds, textureBinds, samplerBinds, renderStateChanges;
+		int draws, indicesDrawn;
+		int frames;
+	};
+
+public:
+	NullDeviceClass();
+	NullDeviceClass(const NullDeviceClass&);
+	~NullDeviceClass();
+
+	bool Initialize(int, int, float, float);
+	void Shutdown();
+
+	void BeginScene(float, float, float, float);
+	void EndScene();
+	void SetVSync(bool);
+
+	void GetVideoCardInfo(char*, int&);
+
+	RenderBuffer* CreateBuffer(RenderBufferType, RenderUsage, int, const void*);
+	RenderTexture* CreateTexture(int, int, RenderFormat, RenderUsage, const void*, int);
+	RenderTexture* CreateTextureFromFile(const char*);
+	RenderProgram* CreateVertexShader(const char*, const char*);
+	RenderProgram* CreatePixelShader(const char*, const char*);
+	RenderInputLayout* CreateInputLayout(const RenderInputElementType*, int, RenderProgram*);
+	RenderSampler* CreateSampler(RenderAddressMode);
+
+	void UpdateTexture(RenderTexture*, const void*, int);
+	void DrawIndexed(int, int);
+
+	unsigned long long InsertFence();
+	bool IsFenceComplete(unsigned long long);
+
+	const CountersType& GetCounters();
+	void ResetCounters();
+
+protected:
+	void BindDepthState(bool);
+	void BindBlendState(bool);
+	void* LockBuffer(RenderBuffer*, RenderMapMode);
+	void UnlockBuffer(RenderBuffer*);
+	void BindVertexBuffer(RenderBuffer*, int);
+	void BindIndexBuffer(RenderBuffer*);
+	void BindInputLayout(RenderInputLayout*);
+	void BindVertexShader(RenderProgram*);
+	void BindPixelShader(RenderProgram*);
+	void BindVSConstantBuffer(int, RenderBuffer*);
+	void BindPSConstantBuffer(int, RenderBuffer*);
+	void BindPSTexture(int, RenderTexture*);
+	void BindPSSampler(int, RenderSampler*);
+
+private:
+	CountersType m_counters;
+	unsigned long long m_fenceValue;
+};
+
+#endif
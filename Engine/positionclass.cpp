@@ -14,6 +14,14 @@ PositionClass::PositionClass()
 	m_rotationY = 0.0f;
 	m_rotationZ = 0.0f;
 
+	m_previousPositionX = 0.0f;
+	m_previousPositionY = 0.0f;
+	m_previousPositionZ = 0.0f;
+
+	m_previousRotationX = 0.0f;
+	m_previousRotationY = 0.0f;
+	m_previousRotationZ = 0.0f;
+
 	m_frameTime = 0.0f;
 
 	m_forwardSpeed   = 0.0f;
@@ -42,6 +50,11 @@ void PositionClass::SetPosition(float x, float y, float z)
 	m_positionX = x;
 	m_positionY = y;
 	m_positionZ = z;
+
+	// Jump straight to the new position rather than interpolating towards it.
+	m_previousPositionX = x;
+	m_previousPositionY = y;
+	m_previousPositionZ = z;
 	return;
 }
 
@@ -51,6 +64,10 @@ void PositionClass::SetRotation(float x, float y, float z)
 	m_rotationX = x;
 	m_rotationY = y;
 	m_rotationZ = z;
+
+	m_previousRotationX = x;
+	m_previousRotationY = y;
+	m_previousRotationZ = z;
 	return;
 }
 
@@ -80,6 +97,65 @@ void PositionClass::SetFrameTime(float time)
 }
 
 
+void PositionClass::SaveState()
+{
+	// Keep the state of the last tick so the frames between ticks can be interpolated.
+	m_previousPositionX = m_positionX;
+	m_previousPositionY = m_positionY;
+	m_previousPositionZ = m_positionZ;
+
+	m_previousRotationX = m_rotationX;
+	m_previousRotationY = m_rotationY;
+	m_previousRotationZ = m_rotationZ;
+
+	return;
+}
+
+
+void PositionClass::GetInterpolatedPosition(float alpha, float& x, float& y, float& z)
+{
+	x = m_previousPositionX + (m_positionX - m_previousPositionX) * alpha;
+	y = m_previousPositionY + (m_positionY - m_previousPositionY) * alpha;
+	z = m_previousPositionZ + (m_positionZ - m_previousPositionZ) * alpha;
+	return;
+}
+
+
+void PositionClass::GetInterpolatedRotation(float alpha, float& x, float& y, float& z)
+{
+	float difference;
+
+
+	x = m_previousRotationX + (m_rotationX - m_previousRotationX) * alpha;
+	z = m_previousRotationZ + (m_rotationZ - m_previousRotationZ) * alpha;
+
+	// The yaw wraps around at 360 degrees so turn the short way across the wrap.
+	difference = m_rotationY - m_previousRotationY;
+	if(difference > 180.0f)
+	{
+		difference -= 360.0f;
+	}
+	else if(difference < -180.0f)
+	{
+		difference += 360.0f;
+	}
+
+	y = m_previousRotationY + difference * alpha;
+
+	// Keep the rotation in the 0 to 360 range.
+	if(y < 0.0f)
+	{
+		y += 360.0f;
+	}
+	else if(y > 360.0f)
+	{
+		y -= 360.0f;
+	}
+
+	return;
+}
+
+
 void PositionClass::MoveForward(bool keydown)
 {
 	float radians;
@@ -29,6 +29,10 @@ public:
 
 	void SetFrameTime(float);
 
+	void SaveState();
+	void GetInterpolatedPosition(float, float&, float&, float&);
+	void GetInterpolatedRotation(float, float&, float&, float&);
+
 	void MoveForward(bool);
 	void MoveBackward(bool);
 	void MoveUpward(bool);
@@ -41,6 +45,8 @@ public:
 private:
 	float m_positionX, m_positionY, m_positionZ;
 	float m_rotationX, m_rotationY, m_rotationZ;
+	float m_previousPositionX, m_previousPositionY, m_previousPositionZ;
+	float m_previousRotationX, m_previousRotationY, m_previousRotationZ;
 
 	float m_frameTime;
 
@@ -0,0 +1,551 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: profilerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "profilerclass.h"
+#include "clockclass.h"
+#include "statsoverlayclass.h"
+#include <stdio.h>
+#include <string.h>
+
+
+ProfilerClass* ProfilerClass::m_instance = 0;
+PROFILER_THREAD_LOCAL ProfilerClass::ThreadBufferType* ProfilerClass::m_threadBuffer = 0;
+
+
+ProfilerClass::ProfilerClass()
+{
+	m_buffers = 0;
+	m_captureFilename[0] = 0;
+	m_captureFrames = 0;
+	memset(&m_stats, 0, sizeof(StatsType));
+}
+
+
+ProfilerClass::ProfilerClass(const ProfilerClass& other)
+{
+}
+
+
+ProfilerClass::~ProfilerClass()
+{
+}
+
+
+bool ProfilerClass::Initialize()
+{
+	int i;
+
+
+	// Create the thread buffers.
+	m_buffers = new ThreadBufferType[PROFILER_MAX_THREADS];
+	if(!m_buffers)
+	{
+		return false;
+	}
+
+	for(i=0; i<PROFILER_MAX_THREADS; i++)
+	{
+		m_buffers[i].writeIndex.store(0);
+		m_buffers[i].readIndex.store(0);
+		m_buffers[i].droppedEvents.store(0);
+		m_buffers[i].inUse.store(false);
+		m_buffers[i].name.store("Thread");
+		m_buffers[i].depth = 0;
+		m_buffers[i].suppressed = 0;
+	}
+
+	m_instance = this;
+
+	// The calling thread is the main thread and always gets the first buffer.
+	m_threadBuffer = AcquireBuffer("Main");
+
+	return true;
+}
+
+
+void ProfilerClass::Shutdown()
+{
+	int i;
+
+
+	// Take the zones off the overlay.
+	for(i=0; i<(int)m_zoneMetrics.size(); i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_zoneMetrics[i]);
+	}
+	m_zoneMetrics.clear();
+	m_lastZoneMetrics.clear();
+
+	// Stop recording, every other thread has finished by now.
+	m_instance = 0;
+	m_threadBuffer = 0;
+
+	// Release the thread buffers.
+	if(m_buffers)
+	{
+		delete [] m_buffers;
+		m_buffers = 0;
+	}
+
+	return;
+}
+
+
+void ProfilerClass::EndFrame()
+{
+	StopwatchClass stopwatch;
+	int i, j, parent;
+
+
+
+	m_nodes.clear();
+	m_stats.events = 0;
+	m_stats.droppedEvents = 0;
+	m_stats.threads = 0;
+
+	for(i=0; i<PROFILER_MAX_THREADS; i++)
+	{
+		// Zones that were still open at the end of the last frame start this frame's tree.
+		parent = -1;
+		for(j=0; j<(int)m_openZones[i].size(); j++)
+		{
+			m_openZones[i][j].node = FindNode(i, parent, m_openZones[i][j].name);
+			parent = m_openZones[i][j].node;
+		}
+
+		DrainBuffer(i);
+
+		if(m_buffers[i].inUse.load(std::memory_order_relaxed))
+		{
+			m_stats.threads++;
+		}
+	}
+
+	// Flatten the tree depth first for each thread.
+	m_zones.clear();
+	for(i=0; i<PROFILER_MAX_THREADS; i++)
+	{
+		SortZones(i, -1, 0);
+	}
+
+	UpdateMetrics();
+
+	// Write the trace out once the capture has run for the frames it was asked to.
+	if(m_captureFrames > 0)
+	{
+		m_captureFrames--;
+		if(m_captureFrames == 0)
+		{
+			WriteTrace();
+			m_captureEvents.clear();
+		}
+	}
+
+	m_stats.aggregateTime = stopwatch.GetMilliseconds();
+
+	return;
+}
+
+
+void ProfilerClass::GetZones(const ZoneType*& zones, int& count)
+{
+	zones = m_zones.empty() ? 0 : &m_zones[0];
+	count = (int)m_zones.size();
+	return;
+}
+
+
+void ProfilerClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+void ProfilerClass::StartCapture(int frames, const char* filename)
+{
+	if(strlen(filename) >= sizeof(m_captureFilename))
+	{
+		return;
+	}
+
+	strcpy(m_captureFilename, filename);
+	m_captureEvents.clear();
+	m_captureFrames = frames;
+
+	return;
+}
+
+
+bool ProfilerClass::IsCapturing()
+{
+	return m_captureFrames > 0;
+}
+
+
+void ProfilerClass::BeginZone(const char* name)
+{
+	ThreadBufferType* buffer;
+	unsigned int writeIndex;
+
+
+	if(!m_instance)
+	{
+		return;
+	}
+
+	// A thread that was not started with PROFILE_THREAD takes a buffer the first time it opens a zone.
+	buffer = m_threadBuffer;
+	if(!buffer)
+	{
+		buffer = AcquireBuffer("Thread");
+		if(!buffer)
+		{
+			return;
+		}
+
+		m_threadBuffer = buffer;
+	}
+
+	// Leave room for the end of every zone already open so ends are never dropped, a dropped begin drops everything
+	// inside it as well.
+	writeIndex = buffer->writeIndex.load(std::memory_order_relaxed);
+	if((buffer->suppressed > 0) || (writeIndex - buffer->readIndex.load(std::memory_order_acquire) + buffer->depth + 2 > PROFILER_BUFFER_EVENTS))
+	{
+		buffer->suppressed++;
+		buffer->droppedEvents.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer->events[writeIndex % PROFILER_BUFFER_EVENTS].name = name;
+	buffer->events[writeIndex % PROFILER_BUFFER_EVENTS].time = ClockClass::GetTimestamp();
+	buffer->events[writeIndex % PROFILER_BUFFER_EVENTS].begin = 1;
+	buffer->writeIndex.store(writeIndex + 1, std::memory_order_release);
+	buffer->depth++;
+
+	return;
+}
+
+
+void ProfilerClass::EndZone()
+{
+	ThreadBufferType* buffer;
+	unsigned int writeIndex;
+
+
+	buffer = m_threadBuffer;
+	if(!m_instance || !buffer)
+	{
+		return;
+	}
+
+	// The end of a dropped zone is dropped with it.
+	if(buffer->suppressed > 0)
+	{
+		buffer->suppressed--;
+		buffer->droppedEvents.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	if(buffer->depth == 0)
+	{
+		return;
+	}
+
+	writeIndex = buffer->writeIndex.load(std::memory_order_relaxed);
+	buffer->events[writeIndex % PROFILER_BUFFER_EVENTS].name = 0;
+	buffer->events[writeIndex % PROFILER_BUFFER_EVENTS].time = ClockClass::GetTimestamp();
+	buffer->events[writeIndex % PROFILER_BUFFER_EVENTS].begin = 0;
+	buffer->writeIndex.store(writeIndex + 1, std::memory_order_release);
+	buffer->depth--;
+
+	return;
+}
+
+
+bool ProfilerClass::BeginThread(const char* name)
+{
+	if(!m_instance || m_threadBuffer)
+	{
+		return false;
+	}
+
+	m_threadBuffer = AcquireBuffer(name);
+
+	return (m_threadBuffer != 0);
+}
+
+
+void ProfilerClass::EndThread()
+{
+	ThreadBufferType* buffer;
+
+
+	// Hand the buffer back so the next short lived thread can use it, anything not yet read is still read as normal.
+	buffer = m_threadBuffer;
+	if(!buffer)
+	{
+		return;
+	}
+
+	m_threadBuffer = 0;
+	buffer->inUse.store(false, std::memory_order_release);
+
+	return;
+}
+
+
+void ProfilerClass::DrainBuffer(int thread)
+{
+	ThreadBufferType* buffer;
+	unsigned int readIndex, writeIndex;
+	const EventType* event;
+	OpenZoneType zone;
+	CaptureEventType captureEvent;
+	NodeType* node;
+
+
+	buffer = &m_buffers[thread];
+	readIndex = buffer->readIndex.load(std::memory_order_relaxed);
+	writeIndex = buffer->writeIndex.load(std::memory_order_acquire);
+
+	while(readIndex != writeIndex)
+	{
+		event = &buffer->events[readIndex % PROFILER_BUFFER_EVENTS];
+
+		if(event->begin)
+		{
+			// Open the zone under the innermost open zone.
+			zone.name = event->name;
+			zone.startTime = event->time;
+			zone.node = FindNode(thread, m_openZones[thread].empty() ? -1 : m_openZones[thread].back().node, event->name);
+			m_openZones[thread].push_back(zone);
+		}
+		else if(!m_openZones[thread].empty())
+		{
+			// Close the innermost zone and add its time to its node.
+			node = &m_nodes[m_openZones[thread].back().node];
+			node->time += event->time - m_openZones[thread].back().startTime;
+			node->calls++;
+			m_openZones[thread].pop_back();
+		}
+
+		if(m_captureFrames > 0)
+		{
+			captureEvent.name = event->name;
+			captureEvent.time = event->time;
+			captureEvent.begin = event->begin;
+			captureEvent.thread = thread;
+			m_captureEvents.push_back(captureEvent);
+		}
+
+		readIndex++;
+		m_stats.events++;
+	}
+
+	// Let the writer reuse the space.
+	buffer->readIndex.store(readIndex, std::memory_order_release);
+
+	m_stats.droppedEvents += buffer->droppedEvents.exchange(0, std::memory_order_relaxed);
+
+	return;
+}
+
+
+int ProfilerClass::FindNode(int thread, int parent, const char* name)
+{
+	NodeType node;
+	int i;
+
+
+	// Calls to the same zone from the same parent are merged into one node.
+	for(i=0; i<(int)m_nodes.size(); i++)
+	{
+		if((m_nodes[i].thread == thread) && (m_nodes[i].parent == parent) && ((m_nodes[i].name == name) || (strcmp(m_nodes[i].name, name) == 0)))
+		{
+			return i;
+		}
+	}
+
+	node.name = name;
+	node.parent = parent;
+	node.thread = thread;
+	node.time = 0;
+	node.calls = 0;
+	m_nodes.push_back(node);
+
+	return (int)m_nodes.size() - 1;
+}
+
+
+void ProfilerClass::SortZones(int thread, int parent, int depth)
+{
+	ZoneType zone;
+	int i;
+
+
+	for(i=0; i<(int)m_nodes.size(); i++)
+	{
+		if((m_nodes[i].thread == thread) && (m_nodes[i].parent == parent))
+		{
+			zone.name = m_nodes[i].name;
+			zone.depth = depth;
+			zone.thread = thread;
+			zone.time = ClockClass::ToMilliseconds(m_nodes[i].time);
+			zone.calls = m_nodes[i].calls;
+			m_zones.push_back(zone);
+
+			SortZones(thread, i, depth + 1);
+		}
+	}
+
+	return;
+}
+
+
+void ProfilerClass::UpdateMetrics()
+{
+	char name[STATS_NAME_LENGTH];
+	int i, j, indent, length, handle;
+	bool seen;
+
+
+	// Show the main thread's zones in the overlay, its zones come first in the list.  The names are indented by depth,
+	// and a zone that was not run this frame stays in the overlay at zero so the lines do not jump around.
+	m_lastZoneMetrics.swap(m_zoneMetrics);
+	m_zoneMetrics.clear();
+
+	for(i=0; (i<(int)m_zones.size()) && (m_zones[i].thread == m_zones[0].thread) && (i<PROFILER_OVERLAY_ZONES); i++)
+	{
+		indent = (m_zones[i].depth < 4) ? m_zones[i].depth * 2 : 8;
+		for(j=0; j<indent; j++)
+		{
+			name[j] = ' ';
+		}
+
+		length = (int)strlen(m_zones[i].name);
+		if(length > STATS_NAME_LENGTH - 1 - indent)
+		{
+			length = STATS_NAME_LENGTH - 1 - indent;
+		}
+
+		memcpy(&name[indent], m_zones[i].name, length);
+		name[indent + length] = 0;
+
+		handle = StatsOverlayClass::AddGauge("Profile", name, 2, "ms");
+		if(handle >= 0)
+		{
+			StatsOverlayClass::SetGauge(handle, m_zones[i].time);
+			m_zoneMetrics.push_back(handle);
+		}
+	}
+
+	for(i=0; i<(int)m_lastZoneMetrics.size(); i++)
+	{
+		seen = false;
+		for(j=0; (j<(int)m_zoneMetrics.size()) && !seen; j++)
+		{
+			seen = (m_zoneMetrics[j] == m_lastZoneMetrics[i]);
+		}
+
+		if(!seen)
+		{
+			StatsOverlayClass::SetGauge(m_lastZoneMetrics[i], 0.0f);
+			m_zoneMetrics.push_back(m_lastZoneMetrics[i]);
+		}
+	}
+
+	return;
+}
+
+
+bool ProfilerClass::WriteTrace()
+{
+	FILE* file;
+	long long baseTime;
+	bool used[PROFILER_MAX_THREADS];
+	unsigned int i;
+	int j;
+
+
+	if(m_captureEvents.empty())
+	{
+		return false;
+	}
+
+	file = fopen(m_captureFilename, "w");
+	if(!file)
+	{
+		return false;
+	}
+
+	// Write the events in the Chrome trace event format with the times in microseconds from the first event.
+	fprintf(file, "{\"traceEvents\":[\n");
+
+	// Name only the threads that recorded something during the capture.
+	for(j=0; j<PROFILER_MAX_THREADS; j++)
+	{
+		used[j] = false;
+	}
+
+	for(i=0; i<m_captureEvents.size(); i++)
+	{
+		used[m_captureEvents[i].thread] = true;
+	}
+
+	for(j=0; j<PROFILER_MAX_THREADS; j++)
+	{
+		if(!used[j])
+		{
+			continue;
+		}
+
+		fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}},\n", j, m_buffers[j].name.load(), j);
+	}
+
+	baseTime = m_captureEvents[0].time;
+	for(i=0; i<m_captureEvents.size(); i++)
+	{
+		if(m_captureEvents[i].begin)
+		{
+			fprintf(file, "{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%d}", m_captureEvents[i].name, 
+					(m_captureEvents[i].time - baseTime) / 1000.0, m_captureEvents[i].thread);
+		}
+		else
+		{
+			fprintf(file, "{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%d}", (m_captureEvents[i].time - baseTime) / 1000.0, 
+					m_captureEvents[i].thread);
+		}
+
+		fprintf(file, (i + 1 < m_captureEvents.size()) ? ",\n" : "\n");
+	}
+
+	fprintf(file, "]}\n");
+	fclose(file);
+
+	return true;
+}
+
+
+ProfilerClass::ThreadBufferType* ProfilerClass::AcquireBuffer(const char* name)
+{
+	bool expected;
+	int i;
+
+
+	// Claim the first free buffer, the writer state is reset but the indices carry on so unread events survive.
+	for(i=0; i<PROFILER_MAX_THREADS; i++)
+	{
+		expected = false;
+		if(m_instance->m_buffers[i].inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+		{
+			m_instance->m_buffers[i].name.store(name, std::memory_order_relaxed);
+			m_instance->m_buffers[i].depth = 0;
+			m_instance->m_buffers[i].suppressed = 0;
+			return &m_instance->m_buffers[i];
+		}
+	}
+
+	return 0;
+}
+
@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: profilerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _PROFILERCLASS_H_
+#define _PROFILERCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int PROFILER_MAX_THREADS = 40;
+const unsigned int PROFILER_BUFFER_EVENTS = 8192;
+const int PROFILER_OVERLAY_ZONES = 16;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <vector>
+
+
+///////////////////////////////
+// PRE-PROCESSING DIRECTIVES //
+///////////////////////////////
+#ifdef _MSC_VER
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILER_THREAD_LOCAL __thread
+#endif
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+// Zones only exist in builds that define ENGINE_PROFILE, anywhere else the macros are empty.  Zone and thread names
+// must be string literals since only the pointer is recorded.
+#ifdef ENGINE_PROFILE
+#define PROFILE_ZONE(name) ProfileZoneClass PROFILER_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) ProfileThreadClass PROFILER_CONCAT(profileThread, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_THREAD(name)
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ProfilerClass
+////////////////////////////////////////////////////////////////////////////////
+class ProfilerClass
+{
+public:
+	// One line of the last frame's zone tree, the zones are listed depth first for each thread in turn.
+	struct ZoneType
+	{
+		const char* name;
+		int depth, thread;
+		float time;
+		int calls;
+	};
+
+	struct StatsType
+	{
+		int events, droppedEvents;
+		int threads;
+		float aggregateTime;
+	};
+
+private:
+	struct EventType
+	{
+		const char* name;
+		long long time;
+		int begin;
+	};
+
+	// Each thread writes into its own ring buffer and the main thread reads it back, so the only shared state is the
+	// pair of indices.  The depth and suppressed counts are only touched by the writing thread.
+	struct ThreadBufferType
+	{
+		EventType events[PROFILER_BUFFER_EVENTS];
+		std::atomic<unsigned int> writeIndex;
+		std::atomic<unsigned int> readIndex;
+		std::atomic<int> droppedEvents;
+		std::atomic<bool> inUse;
+		std::atomic<const char*> name;
+		int depth, suppressed;
+	};
+
+	struct OpenZoneType
+	{
+		const char* name;
+		long long startTime;
+		int node;
+	};
+
+	struct NodeType
+	{
+		const char* name;
+		int parent, thread;
+		long long time;
+		int calls;
+	};
+
+	struct CaptureEventType
+	{
+		const char* name;
+		long long time;
+		int begin, thread;
+	};
+
+public:
+	ProfilerClass();
+	ProfilerClass(const ProfilerClass&);
+	~ProfilerClass();
+
+	bool Initialize();
+	void Shutdown();
+
+	void EndFrame();
+	void GetZones(const ZoneType*&, int&);
+	void GetStats(StatsType&);
+
+	void StartCapture(int, const char*);
+	bool IsCapturing();
+
+	static void BeginZone(const char*);
+	static void EndZone();
+	static bool BeginThread(const char*);
+	static void EndThread();
+
+private:
+	void DrainBuffer(int);
+	int FindNode(int, int, const char*);
+	void SortZones(int, int, int);
+	bool WriteTrace();
+	void UpdateMetrics();
+
+	static ThreadBufferType* AcquireBuffer(const char*);
+
+private:
+	static ProfilerClass* m_instance;
+	static PROFILER_THREAD_LOCAL ThreadBufferType* m_threadBuffer;
+
+	ThreadBufferType* m_buffers;
+	std::vector<OpenZoneType> m_openZones[PROFILER_MAX_THREADS];
+	std::vector<NodeType> m_nodes;
+	std::vector<ZoneType> m_zones;
+	std::vector<CaptureEventType> m_captureEvents;
+	std::vector<int> m_zoneMetrics, m_lastZoneMetrics;
+	char m_captureFilename[256];
+	int m_captureFrames;
+	StatsType m_stats;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ProfileZoneClass
+////////////////////////////////////////////////////////////////////////////////
+class ProfileZoneClass
+{
+public:
+	ProfileZoneClass(const char* name)
+	{
+		ProfilerClass::BeginZone(name);
+	}
+
+	~ProfileZoneClass()
+	{
+		ProfilerClass::EndZone();
+	}
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ProfileThreadClass
+////////////////////////////////////////////////////////////////////////////////
+class ProfileThreadClass
+{
+public:
+	ProfileThreadClass(const char* name)
+	{
+		m_started = ProfilerClass::BeginThread(name);
+	}
+
+	~ProfileThreadClass()
+	{
+		// A thread that already had a buffer, such as the main thread running a worker's share itself, keeps it.
+		if(m_started)
+		{
+			ProfilerClass::EndThread();
+		}
+	}
+
+private:
+	bool m_started;
+};
+
+#endif
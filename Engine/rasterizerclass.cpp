@@ -0,0 +1,1019 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: rasterizerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "rasterizerclass.h"
+#include "profilerclass.h"
+#include "jobsystemclass.h"
+#include "clockclass.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <emmintrin.h>
+
+
+// Bilinear sample of a four channel float texture, a missing texture samples as white.
+static __m128 SampleTexture(const RasterTextureType* texture, bool wrap, float u, float v)
+{
+	float x, y, fracX, fracY;
+	int x0, y0, x1, y1;
+	__m128 t00, t10, t01, t11, top, bottom;
+
+
+	if(!texture || !texture->texels)
+	{
+		return _mm_set1_ps(1.0f);
+	}
+
+	// Move to texel space with texel centers on the integers.
+	x = u * (float)texture->width - 0.5f;
+	y = v * (float)texture->height - 0.5f;
+
+	fracX = x - floorf(x);
+	fracY = y - floorf(y);
+
+	x0 = (int)floorf(x);
+	y0 = (int)floorf(y);
+	x1 = x0 + 1;
+	y1 = y0 + 1;
+
+	if(wrap)
+	{
+		x0 = ((x0 % texture->width) + texture->width) % texture->width;
+		x1 = ((x1 % texture->width) + texture->width) % texture->width;
+		y0 = ((y0 % texture->height) + texture->height) % texture->height;
+		y1 = ((y1 % texture->height) + texture->height) % texture->height;
+	}
+	else
+	{
+		x0 = (x0 < 0) ? 0 : ((x0 >= texture->width) ? texture->width - 1 : x0);
+		x1 = (x1 < 0) ? 0 : ((x1 >= texture->width) ? texture->width - 1 : x1);
+		y0 = (y0 < 0) ? 0 : ((y0 >= texture->height) ? texture->height - 1 : y0);
+		y1 = (y1 < 0) ? 0 : ((y1 >= texture->height) ? texture->height - 1 : y1);
+	}
+
+	t00 = _mm_loadu_ps(texture->texels + (y0 * texture->width + x0) * 4);
+	t10 = _mm_loadu_ps(texture->texels + (y0 * texture->width + x1) * 4);
+	t01 = _mm_loadu_ps(texture->texels + (y1 * texture->width + x0) * 4);
+	t11 = _mm_loadu_ps(texture->texels + (y1 * texture->width + x1) * 4);
+
+	top = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), _mm_set1_ps(fracX)));
+	bottom = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), _mm_set1_ps(fracX)));
+
+	return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(fracY)));
+}
+
+
+// The same lighting as terrain.ps, ambient scaled by occlusion plus shadowed Lambert diffuse.
+static __m128 ShadeTerrain(const RasterDrawType* draw, float u, float v)
+{
+	float normalMap[4], lightMap[4];
+	float normalX, normalY, normalZ, lightIntensity;
+	__m128 color;
+
+
+	_mm_storeu_ps(normalMap, SampleTexture(draw->textures[0], draw->wrapAddress, u, v));
+	_mm_storeu_ps(lightMap, SampleTexture(draw->textures[1], draw->wrapAddress, u, v));
+
+	// Rebuild the upward pointing normal from its x and z components.
+	normalX = normalMap[0];
+	normalZ = normalMap[1];
+	normalY = 1.0f - normalX * normalX - normalZ * normalZ;
+	normalY = (normalY > 0.0f) ? sqrtf((normalY < 1.0f) ? normalY : 1.0f) : 0.0f;
+
+	color = _mm_mul_ps(_mm_loadu_ps(draw->constants), _mm_set1_ps(lightMap[0]));
+
+	lightIntensity = -(normalX * draw->constants[8] + normalY * draw->constants[9] + normalZ * draw->constants[10]);
+	lightIntensity = (lightIntensity < 1.0f) ? lightIntensity : 1.0f;
+
+	if(lightIntensity > 0.0f)
+	{
+		color = _mm_add_ps(color, _mm_mul_ps(_mm_loadu_ps(draw->constants + 4), _mm_set1_ps(lightIntensity * lightMap[1])));
+	}
+
+	return _mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+
+// The same test as font.ps, black texels are transparent and the rest take the color of the glyph's vertices.
+static __m128 ShadeFont(const RasterDrawType* draw, const float* vertexColor, float u, float v)
+{
+	float color[4];
+
+
+	_mm_storeu_ps(color, SampleTexture(draw->textures[0], draw->wrapAddress, u, v));
+
+	if(color[0] == 0.0f)
+	{
+		color[3] = 0.0f;
+		return _mm_loadu_ps(color);
+	}
+
+	color[3] = 1.0f;
+
+	return _mm_mul_ps(_mm_loadu_ps(color), _mm_loadu_ps(vertexColor));
+}
+
+
+RasterizerClass::RasterizerClass()
+{
+	m_workers = 0;
+	m_frame = 0;
+	m_threadCount = 0;
+	m_setupSize = 0;
+}
+
+
+RasterizerClass::RasterizerClass(const RasterizerClass& other)
+{
+}
+
+
+RasterizerClass::~RasterizerClass()
+{
+}
+
+
+bool RasterizerClass::Initialize(int width, int height)
+{
+	int guardBand;
+	bool result;
+
+
+	m_width = width;
+	m_height = height;
+
+	// Edge functions are evaluated in 32 bit integers, which holds twice the area of a triangle up to 2^22 square pixels
+	// at four bits of subpixel precision.  Triangles are clipped to a guard band small enough to stay inside that.
+	guardBand = 256;
+	while((guardBand > 8) && ((long long)(m_width + guardBand * 2 + 8) * (long long)(m_height + guardBand * 2 + 8) > (1 << 22)))
+	{
+		guardBand -= 8;
+	}
+
+	if((long long)(m_width + guardBand * 2 + 8) * (long long)(m_height + guardBand * 2 + 8) > (1 << 22))
+	{
+		return false;
+	}
+
+	// Store the guard band as a scale of the viewport in normalized device coordinates.
+	m_guardX = (float)(m_width + guardBand * 2) / (float)m_width;
+	m_guardY = (float)(m_height + guardBand * 2) / (float)m_height;
+
+	// The screen is split into square tiles that are each rendered by a single worker.
+	m_tilesX = (m_width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	m_tilesY = (m_height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	m_tileCount = m_tilesX * m_tilesY;
+
+	// Create the finished frame.
+	m_frame = new unsigned char[m_width * m_height * 4];
+	if(!m_frame)
+	{
+		return false;
+	}
+
+	memset(m_frame, 0, m_width * m_height * 4);
+
+	// Use one worker for each thread in the job system by default.
+	result = CreateWorkers(JobSystemClass::GetThreadCount());
+	if(!result)
+	{
+		return false;
+	}
+
+	memset(&m_stats, 0, sizeof(StatsType));
+
+	m_clearColor[0] = 0.0f;
+	m_clearColor[1] = 0.0f;
+	m_clearColor[2] = 0.0f;
+	m_clearColor[3] = 1.0f;
+
+	return true;
+}
+
+
+void RasterizerClass::Shutdown()
+{
+	// Release the workers.
+	ReleaseWorkers();
+
+	// Release the finished frame.
+	if(m_frame)
+	{
+		delete [] m_frame;
+		m_frame = 0;
+	}
+
+	return;
+}
+
+
+void RasterizerClass::BeginFrame(float red, float green, float blue, float alpha)
+{
+	// Tiles are cleared by their workers at the end of the frame.
+	m_clearColor[0] = red;
+	m_clearColor[1] = green;
+	m_clearColor[2] = blue;
+	m_clearColor[3] = alpha;
+
+	m_draws.clear();
+	m_vertices.clear();
+	m_indices.clear();
+	m_triangleDraws.clear();
+
+	return;
+}
+
+
+void RasterizerClass::AddDraw(const RasterDrawType& draw, const RasterVertexType* vertices, int vertexCount, const unsigned int* indices, int indexCount)
+{
+	unsigned int baseVertex;
+	int drawIndex, i;
+
+
+	baseVertex = (unsigned int)m_vertices.size();
+	drawIndex = (int)m_draws.size();
+
+	// Copy the draw state and the transformed vertices, the triangles are only set up once the frame is finished.
+	m_draws.push_back(draw);
+	m_vertices.insert(m_vertices.end(), vertices, vertices + vertexCount);
+
+	// Queue the triangles, dropping any with an index past the end of the vertices.
+	for(i=0; i<indexCount-2; i+=3)
+	{
+		if((indices[i] < (unsigned int)vertexCount) && (indices[i+1] < (unsigned int)vertexCount) && (indices[i+2] < (unsigned int)vertexCount))
+		{
+			m_indices.push_back(baseVertex + indices[i]);
+			m_indices.push_back(baseVertex + indices[i+1]);
+			m_indices.push_back(baseVertex + indices[i+2]);
+			m_triangleDraws.push_back(drawIndex);
+		}
+	}
+
+	return;
+}
+
+
+void RasterizerClass::EndFrame()
+{
+	StopwatchClass stopwatch;
+	int triangleCount, setupCount, i, j;
+
+
+	stopwatch.Start();
+
+	// Empty the bins from the last frame, the vectors keep their memory.
+	for(i=0; i<m_threadCount; i++)
+	{
+		m_workers[i].triangles.clear();
+		for(j=0; j<m_tileCount; j++)
+		{
+			m_workers[i].bins[j].clear();
+		}
+		m_workers[i].pixelsShaded = 0;
+	}
+
+	// Small frames are set up by one worker, splitting them up would cost more than it saves.
+	triangleCount = (int)m_triangleDraws.size();
+	setupCount = triangleCount / RASTER_MIN_SETUP_TRIANGLES;
+	setupCount = (setupCount < 1) ? 1 : ((setupCount > m_threadCount) ? m_threadCount : setupCount);
+	m_setupSize = (triangleCount + setupCount - 1) / setupCount;
+
+	// Each worker sets up and bins a contiguous range of triangles as a job of its own.  Binning the workers in order
+	// keeps every tile in submission order, which the depth and blend state of the frame depend on.
+	JobSystemClass::ParallelFor(this, &RasterizerClass::SetupTriangles, setupCount, 1);
+
+	m_stats.setupTime = stopwatch.Lap();
+
+	// Every worker then takes tiles until none are left.
+	m_nextTile = 0;
+
+	JobSystemClass::ParallelFor(this, &RasterizerClass::RasterizeTiles, m_threadCount, 1);
+
+	// Gather the statistics for the frame.
+	m_stats.triangles = triangleCount;
+	m_stats.trianglesSetup = 0;
+	m_stats.binnedTriangles = 0;
+	m_stats.pixelsShaded = 0;
+
+	for(i=0; i<m_threadCount; i++)
+	{
+		m_stats.trianglesSetup += (int)m_workers[i].triangles.size();
+		for(j=0; j<m_tileCount; j++)
+		{
+			m_stats.binnedTriangles += (int)m_workers[i].bins[j].size();
+		}
+		m_stats.pixelsShaded += m_workers[i].pixelsShaded;
+	}
+
+	m_stats.rasterTime = stopwatch.GetMilliseconds();
+
+	return;
+}
+
+
+const unsigned char* RasterizerClass::GetFrameData()
+{
+	return m_frame;
+}
+
+
+int RasterizerClass::GetFramePitch()
+{
+	return m_width * 4;
+}
+
+
+bool RasterizerClass::SaveFrame(const char* filename)
+{
+	FILE* filePtr;
+	unsigned char header[54];
+	unsigned char* row;
+	int rowSize, imageSize, i, x, y;
+	unsigned int value;
+
+
+	// Bitmap rows are three bytes a pixel padded to four bytes and stored bottom up.
+	rowSize = (m_width * 3 + 3) & ~3;
+	imageSize = rowSize * m_height;
+
+	// Fill in the file header and the info header, every field is little endian.
+	memset(header, 0, sizeof(header));
+	header[0] = 'B';
+	header[1] = 'M';
+
+	for(i=0; i<4; i++)
+	{
+		value = (unsigned int)(sizeof(header) + imageSize);
+		header[2 + i] = (unsigned char)(value >> (i * 8));
+
+		value = (unsigned int)sizeof(header);
+		header[10 + i] = (unsigned char)(value >> (i * 8));
+
+		value = 40;
+		header[14 + i] = (unsigned char)(value >> (i * 8));
+
+		value = (unsigned int)m_width;
+		header[18 + i] = (unsigned char)(value >> (i * 8));
+
+		value = (unsigned int)m_height;
+		header[22 + i] = (unsigned char)(value >> (i * 8));
+
+		value = (unsigned int)imageSize;
+		header[34 + i] = (unsigned char)(value >> (i * 8));
+	}
+
+	header[26] = 1;
+	header[28] = 24;
+
+	row = new unsigned char[rowSize];
+	if(!row)
+	{
+		return false;
+	}
+
+	memset(row, 0, rowSize);
+
+	// Open the bitmap file for writing in binary.
+	filePtr = fopen(filename, "wb");
+	if(!filePtr)
+	{
+		delete [] row;
+		return false;
+	}
+
+	fwrite(header, 1, sizeof(header), filePtr);
+
+	for(y=m_height-1; y>=0; y--)
+	{
+		for(x=0; x<m_width; x++)
+		{
+			row[x * 3 + 0] = m_frame[(y * m_width + x) * 4 + 0];
+			row[x * 3 + 1] = m_frame[(y * m_width + x) * 4 + 1];
+			row[x * 3 + 2] = m_frame[(y * m_width + x) * 4 + 2];
+		}
+
+		fwrite(row, 1, rowSize, filePtr);
+	}
+
+	fclose(filePtr);
+
+	delete [] row;
+	row = 0;
+
+	return true;
+}
+
+
+void RasterizerClass::SetThreadCount(int threadCount)
+{
+	CreateWorkers(threadCount);
+	return;
+}
+
+
+int RasterizerClass::GetThreadCount()
+{
+	return m_threadCount;
+}
+
+
+void RasterizerClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+bool RasterizerClass::CreateWorkers(int threadCount)
+{
+	int i;
+
+
+	ReleaseWorkers();
+
+	m_threadCount = (threadCount < 1) ? 1 : threadCount;
+
+	m_workers = new WorkerType[m_threadCount];
+	if(!m_workers)
+	{
+		return false;
+	}
+
+	// Each worker has its own bins and a color and depth buffer for the tile it is working on.
+	for(i=0; i<m_threadCount; i++)
+	{
+		m_workers[i].bins.resize(m_tileCount);
+		m_workers[i].pixelsShaded = 0;
+
+		m_workers[i].color = new float[RASTER_TILE_SIZE * RASTER_TILE_SIZE * 4];
+		m_workers[i].depth = new float[RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+		if(!m_workers[i].color || !m_workers[i].depth)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+void RasterizerClass::ReleaseWorkers()
+{
+	int i;
+
+
+	if(m_workers)
+	{
+		for(i=0; i<m_threadCount; i++)
+		{
+			delete [] m_workers[i].color;
+			delete [] m_workers[i].depth;
+		}
+
+		delete [] m_workers;
+		m_workers = 0;
+	}
+
+	return;
+}
+
+
+void RasterizerClass::SetupTriangles(int startWorker, int endWorker)
+{
+	const RasterVertexType* vertices;
+	const unsigned int* indices;
+	int triangleCount, workerIndex, first, last, i;
+
+
+	PROFILE_ZONE("Setup");
+
+	triangleCount = (int)m_triangleDraws.size();
+	if(triangleCount == 0)
+	{
+		return;
+	}
+
+	vertices = &m_vertices[0];
+	indices = &m_indices[0];
+
+	for(workerIndex=startWorker; workerIndex<endWorker; workerIndex++)
+	{
+		first = workerIndex * m_setupSize;
+		last = (first + m_setupSize < triangleCount) ? (first + m_setupSize) : triangleCount;
+
+		for(i=first; i<last; i++)
+		{
+			ClipTriangle(&m_workers[workerIndex], &vertices[indices[i*3]], &vertices[indices[i*3+1]], &vertices[indices[i*3+2]], m_triangleDraws[i]);
+		}
+	}
+
+	return;
+}
+
+
+void RasterizerClass::RasterizeTiles(int startWorker, int endWorker)
+{
+	WorkerType* worker;
+	const std::vector<int>* bin;
+	int workerIndex, tile, tileX, tileY, i, j;
+
+
+	PROFILE_ZONE("Tiles");
+
+	for(workerIndex=startWorker; workerIndex<endWorker; workerIndex++)
+	{
+		worker = &m_workers[workerIndex];
+
+		// Take the next tile until they are all done.
+		for(tile=m_nextTile++; tile<m_tileCount; tile=m_nextTile++)
+		{
+			tileX = (tile % m_tilesX) * RASTER_TILE_SIZE;
+			tileY = (tile / m_tilesX) * RASTER_TILE_SIZE;
+
+			ClearTile(worker);
+
+			// Draw the triangles binned by every worker in the order they were submitted.
+			for(i=0; i<m_threadCount; i++)
+			{
+				bin = &m_workers[i].bins[tile];
+				for(j=0; j<(int)bin->size(); j++)
+				{
+					RasterizeTriangle(worker, &m_workers[i].triangles[(*bin)[j]], tileX, tileY);
+				}
+			}
+
+			ResolveTile(worker, tileX, tileY);
+		}
+	}
+
+	return;
+}
+
+
+int RasterizerClass::GetOutCode(const RasterVertexType* vertex)
+{
+	int code;
+
+
+	code = 0;
+
+	if(vertex->z < 0.0f)                       code |= CLIP_NEAR;
+	if(vertex->z > vertex->w)                  code |= CLIP_FAR;
+	if(vertex->x < -m_guardX * vertex->w)      code |= CLIP_LEFT;
+	if(vertex->x > m_guardX * vertex->w)       code |= CLIP_RIGHT;
+	if(vertex->y > m_guardY * vertex->w)       code |= CLIP_TOP;
+	if(vertex->y < -m_guardY * vertex->w)      code |= CLIP_BOTTOM;
+
+	return code;
+}
+
+
+float RasterizerClass::GetPlaneDistance(const RasterVertexType* vertex, int plane)
+{
+	switch(plane)
+	{
+		case CLIP_NEAR:   return vertex->z;
+		case CLIP_LEFT:   return m_guardX * vertex->w + vertex->x;
+		case CLIP_RIGHT:  return m_guardX * vertex->w - vertex->x;
+		case CLIP_TOP:    return m_guardY * vertex->w - vertex->y;
+		case CLIP_BOTTOM: return m_guardY * vertex->w + vertex->y;
+	}
+
+	return vertex->w - vertex->z;
+}
+
+
+void RasterizerClass::ClipTriangle(WorkerType* worker, const RasterVertexType* vertex0, const RasterVertexType* vertex1, const RasterVertexType* vertex2,
+								   int draw)
+{
+	RasterVertexType polygon[2][9];
+	int code0, code1, code2, clipCodes, plane, input, count, newCount, i, j, next;
+	float distance, nextDistance, t;
+	const RasterVertexType* current;
+	const RasterVertexType* following;
+	RasterVertexType* output;
+
+
+	code0 = GetOutCode(vertex0);
+	code1 = GetOutCode(vertex1);
+	code2 = GetOutCode(vertex2);
+
+	// Throw the triangle away if it is completely outside any one plane.
+	if(code0 & code1 & code2)
+	{
+		return;
+	}
+
+	// Only the near plane and the guard band need real clipping, the rest is handled by the screen bounds.
+	clipCodes = (code0 | code1 | code2) & ~CLIP_FAR;
+	if(!clipCodes)
+	{
+		SetupTriangle(worker, vertex0, vertex1, vertex2, draw);
+		return;
+	}
+
+	polygon[0][0] = *vertex0;
+	polygon[0][1] = *vertex1;
+	polygon[0][2] = *vertex2;
+	count = 3;
+	input = 0;
+
+	// Clip the polygon against each plane a vertex is outside of, interpolating every attribute in clip space.
+	for(plane=CLIP_NEAR; plane<=CLIP_BOTTOM; plane<<=1)
+	{
+		if(!(clipCodes & plane))
+		{
+			continue;
+		}
+
+		output = polygon[1 - input];
+		newCount = 0;
+
+		for(i=0; i<count; i++)
+		{
+			next = (i + 1) % count;
+			current = &polygon[input][i];
+			following = &polygon[input][next];
+
+			distance = GetPlaneDistance(current, plane);
+			nextDistance = GetPlaneDistance(following, plane);
+
+			if(distance >= 0.0f)
+			{
+				output[newCount++] = *current;
+			}
+
+			if((distance >= 0.0f) != (nextDistance >= 0.0f))
+			{
+				t = distance / (distance - nextDistance);
+				output[newCount].x = current->x + (following->x - current->x) * t;
+				output[newCount].y = current->y + (following->y - current->y) * t;
+				output[newCount].z = current->z + (following->z - current->z) * t;
+				output[newCount].w = current->w + (following->w - current->w) * t;
+				output[newCount].u = current->u + (following->u - current->u) * t;
+				output[newCount].v = current->v + (following->v - current->v) * t;
+				for(j=0; j<4; j++)
+				{
+					output[newCount].color[j] = current->color[j] + (following->color[j] - current->color[j]) * t;
+				}
+				newCount++;
+			}
+		}
+
+		count = newCount;
+		input = 1 - input;
+
+		if(count < 3)
+		{
+			return;
+		}
+	}
+
+	// Split the clipped polygon back into a fan of triangles.
+	for(i=1; i<count-1; i++)
+	{
+		SetupTriangle(worker, &polygon[input][0], &polygon[input][i], &polygon[input][i+1], draw);
+	}
+
+	return;
+}
+
+
+void RasterizerClass::SetupTriangle(WorkerType* worker, const RasterVertexType* vertex0, const RasterVertexType* vertex1, const RasterVertexType* vertex2,
+									int draw)
+{
+	const RasterVertexType* vertices[3];
+	TriangleType triangle;
+	float invW[3], z[3], scaleX, scaleY;
+	int x[3], y[3], i, a, b, minX, minY, maxX, maxY, tileX0, tileY0, tileX1, tileY1, tileX, tileY, index, centerX, centerY;
+	long long area, edge;
+	bool covered;
+
+
+	vertices[0] = vertex0;
+	vertices[1] = vertex1;
+	vertices[2] = vertex2;
+
+	scaleX = (float)(m_width << RASTER_SUBPIXEL_BITS) * 0.5f;
+	scaleY = (float)(m_height << RASTER_SUBPIXEL_BITS) * 0.5f;
+
+	// Divide by w and snap to the subpixel grid, screen y points down.
+	for(i=0; i<3; i++)
+	{
+		invW[i] = 1.0f / vertices[i]->w;
+		x[i] = (int)floorf(vertices[i]->x * invW[i] * scaleX + scaleX + 0.5f);
+		y[i] = (int)floorf(-vertices[i]->y * invW[i] * scaleY + scaleY + 0.5f);
+		z[i] = vertices[i]->z * invW[i];
+	}
+
+	// Front faces are clockwise on screen, cull the back faces and anything with no area.
+	area = (long long)(x[1] - x[0]) * (long long)(y[2] - y[0]) - (long long)(x[2] - x[0]) * (long long)(y[1] - y[0]);
+	if(area <= 0)
+	{
+		return;
+	}
+
+	// Find the pixels whose centers can be inside the triangle.
+	minX = (x[0] < x[1]) ? ((x[0] < x[2]) ? x[0] : x[2]) : ((x[1] < x[2]) ? x[1] : x[2]);
+	minY = (y[0] < y[1]) ? ((y[0] < y[2]) ? y[0] : y[2]) : ((y[1] < y[2]) ? y[1] : y[2]);
+	maxX = (x[0] > x[1]) ? ((x[0] > x[2]) ? x[0] : x[2]) : ((x[1] > x[2]) ? x[1] : x[2]);
+	maxY = (y[0] > y[1]) ? ((y[0] > y[2]) ? y[0] : y[2]) : ((y[1] > y[2]) ? y[1] : y[2]);
+
+	triangle.minX = (minX - 8 + 15) >> RASTER_SUBPIXEL_BITS;
+	triangle.minY = (minY - 8 + 15) >> RASTER_SUBPIXEL_BITS;
+	triangle.maxX = (maxX - 8) >> RASTER_SUBPIXEL_BITS;
+	triangle.maxY = (maxY - 8) >> RASTER_SUBPIXEL_BITS;
+
+	triangle.minX = (triangle.minX < 0) ? 0 : triangle.minX;
+	triangle.minY = (triangle.minY < 0) ? 0 : triangle.minY;
+	triangle.maxX = (triangle.maxX >= m_width) ? m_width - 1 : triangle.maxX;
+	triangle.maxY = (triangle.maxY >= m_height) ? m_height - 1 : triangle.maxY;
+
+	if((triangle.minX > triangle.maxX) || (triangle.minY > triangle.maxY))
+	{
+		return;
+	}
+
+	// Edge i runs between the other two vertices, the top left rule biases the rest so shared edges are only drawn once.
+	for(i=0; i<3; i++)
+	{
+		a = (i + 1) % 3;
+		b = (i + 2) % 3;
+
+		triangle.originX[i] = x[a];
+		triangle.originY[i] = y[a];
+		triangle.deltaX[i] = x[b] - x[a];
+		triangle.deltaY[i] = y[b] - y[a];
+		triangle.bias[i] = ((triangle.deltaY[i] < 0) || ((triangle.deltaY[i] == 0) && (triangle.deltaX[i] > 0))) ? 0 : -1;
+	}
+
+	// Depth interpolates linearly on screen, the texture coordinates are divided by w for perspective correction.
+	triangle.invArea = 1.0f / (float)area;
+
+	triangle.z = z[0];
+	triangle.dz1 = z[1] - z[0];
+	triangle.dz2 = z[2] - z[0];
+
+	triangle.iw = invW[0];
+	triangle.diw1 = invW[1] - invW[0];
+	triangle.diw2 = invW[2] - invW[0];
+
+	triangle.uw = vertex0->u * invW[0];
+	triangle.duw1 = vertex1->u * invW[1] - triangle.uw;
+	triangle.duw2 = vertex2->u * invW[2] - triangle.uw;
+
+	triangle.vw = vertex0->v * invW[0];
+	triangle.dvw1 = vertex1->v * invW[1] - triangle.vw;
+	triangle.dvw2 = vertex2->v * invW[2] - triangle.vw;
+
+	// The color is not interpolated, like the nointerpolation color in font.vs it comes from the first vertex.
+	memcpy(triangle.color, vertex0->color, sizeof(triangle.color));
+
+	triangle.draw = draw;
+
+	index = (int)worker->triangles.size();
+	worker->triangles.push_back(triangle);
+
+	// Bin the triangle into every tile its bounds touch.
+	tileX0 = triangle.minX / RASTER_TILE_SIZE;
+	tileY0 = triangle.minY / RASTER_TILE_SIZE;
+	tileX1 = triangle.maxX / RASTER_TILE_SIZE;
+	tileY1 = triangle.maxY / RASTER_TILE_SIZE;
+
+	for(tileY=tileY0; tileY<=tileY1; tileY++)
+	{
+		for(tileX=tileX0; tileX<=tileX1; tileX++)
+		{
+			// Large triangles skip the tiles where one of the edges is negative at the tile's best corner.
+			covered = true;
+			if((tileX0 != tileX1) || (tileY0 != tileY1))
+			{
+				for(i=0; i<3; i++)
+				{
+					centerX = ((triangle.deltaY[i] > 0) ? tileX * RASTER_TILE_SIZE : tileX * RASTER_TILE_SIZE + RASTER_TILE_SIZE - 1) * 16 + 8;
+					centerY = ((triangle.deltaX[i] > 0) ? tileY * RASTER_TILE_SIZE + RASTER_TILE_SIZE - 1 : tileY * RASTER_TILE_SIZE) * 16 + 8;
+
+					edge = (long long)triangle.deltaX[i] * (long long)(centerY - triangle.originY[i]) -
+						   (long long)triangle.deltaY[i] * (long long)(centerX - triangle.originX[i]) + triangle.bias[i];
+					if(edge < 0)
+					{
+						covered = false;
+					}
+				}
+			}
+
+			if(covered)
+			{
+				worker->bins[tileY * m_tilesX + tileX].push_back(index);
+			}
+		}
+	}
+
+	return;
+}
+
+
+void RasterizerClass::RasterizeTriangle(WorkerType* worker, const TriangleType* triangle, int tileX, int tileY)
+{
+	const RasterDrawType* draw;
+	int startX, endX, startY, endY, x, y, i, lane, mask, row, pixelX, pixelY;
+	int stepX[3];
+	__m128i edge[3], edgeStep[3], laneSteps[3], coverage;
+	__m128 lanes, weight1, weight2, z, depth, pass, iw, uw, vw, invArea;
+	float u[4], v[4];
+	float* depthRow;
+	float* colorRow;
+	float* pixel;
+	__m128 color, destination, blended, alphaMask;
+
+
+	draw = &m_draws[triangle->draw];
+	alphaMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+
+	// Walk the part of the triangle bounds inside this tile in rows of four pixel groups.
+	startX = (triangle->minX > tileX) ? triangle->minX : tileX;
+	endX = (triangle->maxX < tileX + RASTER_TILE_SIZE - 1) ? triangle->maxX : tileX + RASTER_TILE_SIZE - 1;
+	startY = (triangle->minY > tileY) ? triangle->minY : tileY;
+	endY = (triangle->maxY < tileY + RASTER_TILE_SIZE - 1) ? triangle->maxY : tileY + RASTER_TILE_SIZE - 1;
+
+	startX &= ~3;
+
+	for(i=0; i<3; i++)
+	{
+		stepX[i] = -triangle->deltaY[i] * (1 << RASTER_SUBPIXEL_BITS);
+		laneSteps[i] = _mm_setr_epi32(0, stepX[i], stepX[i] * 2, stepX[i] * 3);
+		edgeStep[i] = _mm_set1_epi32(stepX[i] * 4);
+	}
+
+	invArea = _mm_set1_ps(triangle->invArea);
+
+	for(y=startY; y<=endY; y++)
+	{
+		// Evaluate the edges at the first pixel center of the row.
+		pixelX = (startX << RASTER_SUBPIXEL_BITS) + 8;
+		pixelY = (y << RASTER_SUBPIXEL_BITS) + 8;
+
+		for(i=0; i<3; i++)
+		{
+			edge[i] = _mm_add_epi32(_mm_set1_epi32(triangle->deltaX[i] * (pixelY - triangle->originY[i]) -
+												   triangle->deltaY[i] * (pixelX - triangle->originX[i]) + triangle->bias[i]), laneSteps[i]);
+		}
+
+		row = (y - tileY) * RASTER_TILE_SIZE + (startX - tileX);
+		depthRow = worker->depth + row;
+		colorRow = worker->color + row * 4;
+
+		for(x=startX; x<=endX; x+=4)
+		{
+			// A pixel is covered when none of its edge values are negative.
+			coverage = _mm_or_si128(_mm_or_si128(edge[0], edge[1]), edge[2]);
+			mask = ~_mm_movemask_ps(_mm_castsi128_ps(coverage)) & 15;
+
+			if(mask)
+			{
+				lanes = _mm_castsi128_ps(_mm_cmpgt_epi32(coverage, _mm_set1_epi32(-1)));
+
+				weight1 = _mm_mul_ps(_mm_cvtepi32_ps(edge[1]), invArea);
+				weight2 = _mm_mul_ps(_mm_cvtepi32_ps(edge[2]), invArea);
+
+				// Depth test and write against the tile's depth buffer.
+				if(draw->depthEnable)
+				{
+					z = _mm_add_ps(_mm_set1_ps(triangle->z), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle->dz1), weight1),
+																	   _mm_mul_ps(_mm_set1_ps(triangle->dz2), weight2)));
+					depth = _mm_loadu_ps(depthRow);
+					pass = _mm_and_ps(lanes, _mm_cmplt_ps(z, depth));
+					_mm_storeu_ps(depthRow, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, depth)));
+					mask = _mm_movemask_ps(pass);
+				}
+
+				if(mask)
+				{
+					// Interpolate the texture coordinates with perspective correction.
+					iw = _mm_add_ps(_mm_set1_ps(triangle->iw), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle->diw1), weight1),
+																		 _mm_mul_ps(_mm_set1_ps(triangle->diw2), weight2)));
+					uw = _mm_add_ps(_mm_set1_ps(triangle->uw), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle->duw1), weight1),
+																		 _mm_mul_ps(_mm_set1_ps(triangle->duw2), weight2)));
+					vw = _mm_add_ps(_mm_set1_ps(triangle->vw), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle->dvw1), weight1),
+																		 _mm_mul_ps(_mm_set1_ps(triangle->dvw2), weight2)));
+
+					_mm_storeu_ps(u, _mm_div_ps(uw, iw));
+					_mm_storeu_ps(v, _mm_div_ps(vw, iw));
+
+					// Shade each pixel that passed, blending with premultiplied alpha when it is on.
+					for(lane=0; lane<4; lane++)
+					{
+						if(!(mask & (1 << lane)))
+						{
+							continue;
+						}
+
+						if(draw->shader == RASTER_SHADER_TERRAIN)
+						{
+							color = ShadeTerrain(draw, u[lane], v[lane]);
+						}
+						else
+						{
+							color = ShadeFont(draw, triangle->color, u[lane], v[lane]);
+						}
+
+						pixel = colorRow + lane * 4;
+
+						if(draw->blendEnable)
+						{
+							// The color channels blend one and inverse source alpha, the alpha channel is written as it comes out of the shader.
+							destination = _mm_loadu_ps(pixel);
+							blended = _mm_add_ps(color, _mm_mul_ps(destination, _mm_sub_ps(_mm_set1_ps(1.0f), _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3)))));
+							color = _mm_or_ps(_mm_andnot_ps(alphaMask, blended), _mm_and_ps(alphaMask, color));
+						}
+
+						_mm_storeu_ps(pixel, color);
+						worker->pixelsShaded++;
+					}
+				}
+			}
+
+			for(i=0; i<3; i++)
+			{
+				edge[i] = _mm_add_epi32(edge[i], edgeStep[i]);
+			}
+
+			depthRow += 4;
+			colorRow += 16;
+		}
+	}
+
+	return;
+}
+
+
+void RasterizerClass::ClearTile(WorkerType* worker)
+{
+	__m128 clearColor, clearDepth;
+	int i;
+
+
+	clearColor = _mm_loadu_ps(m_clearColor);
+	clearDepth = _mm_set1_ps(1.0f);
+
+	for(i=0; i<RASTER_TILE_SIZE * RASTER_TILE_SIZE; i++)
+	{
+		_mm_storeu_ps(worker->color + i * 4, clearColor);
+	}
+
+	for(i=0; i<RASTER_TILE_SIZE * RASTER_TILE_SIZE; i+=4)
+	{
+		_mm_storeu_ps(worker->depth + i, clearDepth);
+	}
+
+	return;
+}
+
+
+void RasterizerClass::ResolveTile(WorkerType* worker, int tileX, int tileY)
+{
+	__m128 zero, one, scale, color;
+	__m128i pixels[4], packed;
+	const float* source;
+	unsigned char* destination;
+	int width, height, x, y, i, value;
+
+
+	zero = _mm_setzero_ps();
+	one = _mm_set1_ps(1.0f);
+	scale = _mm_set1_ps(255.0f);
+
+	// Only the part of the tile on the screen is copied out.
+	width = (m_width - tileX < RASTER_TILE_SIZE) ? m_width - tileX : RASTER_TILE_SIZE;
+	height = (m_height - tileY < RASTER_TILE_SIZE) ? m_height - tileY : RASTER_TILE_SIZE;
+
+	for(y=0; y<height; y++)
+	{
+		source = worker->color + y * RASTER_TILE_SIZE * 4;
+		destination = m_frame + ((tileY + y) * m_width + tileX) * 4;
+
+		// Convert four pixels at a time to bytes, swizzling red and blue.
+		for(x=0; x+4<=width; x+=4)
+		{
+			for(i=0; i<4; i++)
+			{
+				color = _mm_loadu_ps(source + (x + i) * 4);
+				pixels[i] = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 0, 1, 2)), zero), one), scale));
+			}
+
+			packed = _mm_packus_epi16(_mm_packs_epi32(pixels[0], pixels[1]), _mm_packs_epi32(pixels[2], pixels[3]));
+			_mm_storeu_si128((__m128i*)(destination + x * 4), packed);
+		}
+
+		for(; x<width; x++)
+		{
+			color = _mm_loadu_ps(source + x * 4);
+			pixels[0] = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 0, 1, 2)), zero), one), scale));
+
+			value = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(pixels[0], pixels[0]), pixels[0]));
+			memcpy(destination + x * 4, &value, 4);
+		}
+	}
+
+	return;
+}
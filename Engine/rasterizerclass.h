@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: rasterizerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RASTERIZERCLASS_H_
+#define _RASTERIZERCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int RASTER_TILE_SIZE = 64;
+const int RASTER_SUBPIXEL_BITS = 4;
+const int RASTER_MIN_SETUP_TRIANGLES = 256;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include <atomic>
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+enum RasterShader
+{
+	RASTER_SHADER_TERRAIN,
+	RASTER_SHADER_FONT
+};
+
+// Textures hold four floats per texel so a bilinear tap filters a whole texel at once.
+struct RasterTextureType
+{
+	int width, height;
+	float* texels;
+};
+
+// A clip space vertex as it leaves the vertex stage.
+struct RasterVertexType
+{
+	float x, y, z, w;
+	float u, v;
+	float color[4];
+};
+
+// Everything the pixel stage needs for one draw, the constants are the pixel shader constant buffer.
+struct RasterDrawType
+{
+	RasterShader shader;
+	const RasterTextureType* textures[2];
+	bool wrapAddress;
+	bool depthEnable, blendEnable;
+	float constants[12];
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RasterizerClass
+////////////////////////////////////////////////////////////////////////////////
+class RasterizerClass
+{
+public:
+	struct StatsType
+	{
+		int triangles, trianglesSetup, binnedTriangles, pixelsShaded;
+		float setupTime, rasterTime;
+	};
+
+private:
+	enum ClipPlane
+	{
+		CLIP_NEAR = 1,
+		CLIP_FAR = 2,
+		CLIP_LEFT = 4,
+		CLIP_RIGHT = 8,
+		CLIP_TOP = 16,
+		CLIP_BOTTOM = 32
+	};
+
+	// Edges are stored in 28.4 fixed point, edge i is the one opposite vertex i.
+	struct TriangleType
+	{
+		int originX[3], originY[3];
+		int deltaX[3], deltaY[3], bias[3];
+		int minX, minY, maxX, maxY;
+		float invArea;
+		float z, dz1, dz2;
+		float iw, diw1, diw2;
+		float uw, duw1, duw2;
+		float vw, dvw1, dvw2;
+		float color[4];
+		int draw;
+	};
+
+	struct WorkerType
+	{
+		std::vector<TriangleType> triangles;
+		std::vector<std::vector<int> > bins;
+		float* color;
+		float* depth;
+		int pixelsShaded;
+	};
+
+public:
+	RasterizerClass();
+	RasterizerClass(const RasterizerClass&);
+	~RasterizerClass();
+
+	bool Initialize(int, int);
+	void Shutdown();
+
+	void BeginFrame(float, float, float, float);
+	void AddDraw(const RasterDrawType&, const RasterVertexType*, int, const unsigned int*, int);
+	void EndFrame();
+
+	// The finished frame is stored top down as four byte blue, green, red, alpha pixels.
+	const unsigned char* GetFrameData();
+	int GetFramePitch();
+	bool SaveFrame(const char*);
+
+	void SetThreadCount(int);
+	int GetThreadCount();
+	void GetStats(StatsType&);
+
+private:
+	bool CreateWorkers(int);
+	void ReleaseWorkers();
+
+	void SetupTriangles(int, int);
+	void RasterizeTiles(int, int);
+
+	int GetOutCode(const RasterVertexType*);
+	float GetPlaneDistance(const RasterVertexType*, int);
+	void ClipTriangle(WorkerType*, const RasterVertexType*, const RasterVertexType*, const RasterVertexType*, int);
+	void SetupTriangle(WorkerType*, const RasterVertexType*, const RasterVertexType*, const RasterVertexType*, int);
+	void RasterizeTriangle(WorkerType*, const TriangleType*, int, int);
+	void ClearTile(WorkerType*);
+	void ResolveTile(WorkerType*, int, int);
+
+private:
+	int m_width, m_height;
+	int m_tilesX, m_tilesY, m_tileCount;
+	float m_guardX, m_guardY;
+	int m_threadCount;
+	WorkerType* m_workers;
+	int m_setupSize;
+	std::atomic<int> m_nextTile;
+
+	std::vector<RasterDrawType> m_draws;
+	std::vector<RasterVertexType> m_vertices;
+	std::vector<unsigned int> m_indices;
+	std::vector<int> m_triangleDraws;
+
+	float m_clearColor[4];
+	unsigned char* m_frame;
+	StatsType m_stats;
+};
+
+#endif
@@ -0,0 +1,398 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderdeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "renderdeviceclass.h"
+#include <string.h>
+
+
+std::atomic<unsigned int> RenderResource::m_nextId(0);
+
+
+RenderResource::RenderResource()
+{
+	m_id = ++m_nextId;
+}
+
+
+RenderResource::~RenderResource()
+{
+}
+
+
+unsigned int RenderResource::GetId()
+{
+	return m_id;
+}
+
+
+RenderBuffer::RenderBuffer()
+{
+	shadow = 0;
+	shadowSize = 0;
+	shadowCapacity = 0;
+	shadowValid = false;
+}
+
+
+RenderBuffer::~RenderBuffer()
+{
+	if(shadow)
+	{
+		delete [] shadow;
+		shadow = 0;
+	}
+}
+
+
+RenderDeviceClass::RenderDeviceClass()
+{
+	ResetStateCache();
+	ResetStateCounters();
+}
+
+
+RenderDeviceClass::RenderDeviceClass(const RenderDeviceClass& other)
+{
+}
+
+
+RenderDeviceClass::~RenderDeviceClass()
+{
+}
+
+
+void RenderDeviceClass::GetProjectionMatrix(Matrix& projectionMatrix)
+{
+	projectionMatrix = m_projectionMatrix;
+	return;
+}
+
+
+void RenderDeviceClass::GetWorldMatrix(Matrix& worldMatrix)
+{
+	worldMatrix = m_worldMatrix;
+	return;
+}
+
+
+void RenderDeviceClass::GetOrthoMatrix(Matrix& orthoMatrix)
+{
+	orthoMatrix = m_orthoMatrix;
+	return;
+}
+
+
+void RenderDeviceClass::InitializeMatrices(int screenWidth, int screenHeight, float screenDepth, float screenNear)
+{
+	float fieldOfView, screenAspect;
+
+
+	// Setup the projection matrix.
+	fieldOfView = MATH_PI / 4.0f;
+	screenAspect = (float)screenWidth / (float)screenHeight;
+
+	// Create the projection matrix for 3D rendering.
+	MatrixPerspectiveFovLH(&m_projectionMatrix, fieldOfView, screenAspect, screenNear, screenDepth);
+
+    // Initialize the world matrix to the identity matrix.
+    MatrixIdentity(&m_worldMatrix);
+
+	// Create an orthographic projection matrix for 2D rendering.
+	MatrixOrthoLH(&m_orthoMatrix, (float)screenWidth, (float)screenHeight, screenNear, screenDepth);
+
+	return;
+}
+
+
+void RenderDeviceClass::TurnZBufferOn()
+{
+	if(CheckState(m_depthState, 1))
+	{
+		BindDepthState(true);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::TurnZBufferOff()
+{
+	if(CheckState(m_depthState, 0))
+	{
+		BindDepthState(false);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::TurnOnAlphaBlending()
+{
+	if(CheckState(m_blendState, 1))
+	{
+		BindBlendState(true);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::TurnOffAlphaBlending()
+{
+	if(CheckState(m_blendState, 0))
+	{
+		BindBlendState(false);
+	}
+
+	return;
+}
+
+
+void* RenderDeviceClass::MapBuffer(RenderBuffer* buffer, RenderMapMode mode)
+{
+	// Whatever is written through the pointer is unknown to the cache, so the next update always goes through.
+	buffer->shadowValid = false;
+	m_stateCounters.uploadsIssued++;
+
+	return LockBuffer(buffer, mode);
+}
+
+
+void RenderDeviceClass::UnmapBuffer(RenderBuffer* buffer)
+{
+	UnlockBuffer(buffer);
+	return;
+}
+
+
+bool RenderDeviceClass::UpdateBuffer(RenderBuffer* buffer, const void* data, int size)
+{
+	void* mappedData;
+
+
+	// Skip the upload if the buffer already holds exactly these bytes.
+	if(buffer->shadowValid && (buffer->shadowSize == size) && (memcmp(buffer->shadow, data, size) == 0))
+	{
+		m_stateCounters.uploadsSkipped++;
+		return true;
+	}
+
+	// Lock the buffer and copy the new contents in.
+	mappedData = LockBuffer(buffer, RENDER_MAP_DISCARD);
+	if(!mappedData)
+	{
+		return false;
+	}
+
+	memcpy(mappedData, data, size);
+
+	UnlockBuffer(buffer);
+
+	m_stateCounters.uploadsIssued++;
+
+	// Keep a copy of what was uploaded to compare the next update against.
+	if(buffer->shadowCapacity < size)
+	{
+		if(buffer->shadow)
+		{
+			delete [] buffer->shadow;
+		}
+
+		buffer->shadow = new char[size];
+		buffer->shadowCapacity = buffer->shadow ? size : 0;
+	}
+
+	buffer->shadowValid = false;
+	if(buffer->shadow)
+	{
+		memcpy(buffer->shadow, data, size);
+		buffer->shadowSize = size;
+		buffer->shadowValid = true;
+	}
+
+	return true;
+}
+
+
+void RenderDeviceClass::SetVertexBuffer(RenderBuffer* buffer, int stride)
+{
+	// A new stride needs a new bind even for the same buffer.
+	if(stride != m_vertexStride)
+	{
+		m_vertexBuffer = RENDER_STATE_UNKNOWN;
+		m_vertexStride = stride;
+	}
+
+	if(CheckBinding(m_vertexBuffer, buffer))
+	{
+		BindVertexBuffer(buffer, stride);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::SetIndexBuffer(RenderBuffer* buffer)
+{
+	if(CheckBinding(m_indexBuffer, buffer))
+	{
+		BindIndexBuffer(buffer);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::SetInputLayout(RenderInputLayout* layout)
+{
+	if(CheckBinding(m_inputLayout, layout))
+	{
+		BindInputLayout(layout);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::SetVertexShader(RenderProgram* shader)
+{
+	if(CheckBinding(m_vertexShader, shader))
+	{
+		BindVertexShader(shader);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::SetPixelShader(RenderProgram* shader)
+{
+	if(CheckBinding(m_pixelShader, shader))
+	{
+		BindPixelShader(shader);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::SetVSConstantBuffer(int slot, RenderBuffer* buffer)
+{
+	// Slots past the end of the cache are always bound.
+	if((slot < 0) || (slot >= RENDER_STATE_SLOTS) || CheckBinding(m_vsConstantBuffers[slot], buffer))
+	{
+		BindVSConstantBuffer(slot, buffer);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::SetPSConstantBuffer(int slot, RenderBuffer* buffer)
+{
+	if((slot < 0) || (slot >= RENDER_STATE_SLOTS) || CheckBinding(m_psConstantBuffers[slot], buffer))
+	{
+		BindPSConstantBuffer(slot, buffer);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::SetPSTexture(int slot, RenderTexture* texture)
+{
+	if((slot < 0) || (slot >= RENDER_STATE_SLOTS) || CheckBinding(m_psTextures[slot], texture))
+	{
+		BindPSTexture(slot, texture);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::SetPSSampler(int slot, RenderSampler* sampler)
+{
+	if((slot < 0) || (slot >= RENDER_STATE_SLOTS) || CheckBinding(m_psSamplers[slot], sampler))
+	{
+		BindPSSampler(slot, sampler);
+	}
+
+	return;
+}
+
+
+void RenderDeviceClass::GetStateCounters(StateCountersType& counters)
+{
+	counters = m_stateCounters;
+	return;
+}
+
+
+void RenderDeviceClass::ResetStateCounters()
+{
+	memset(&m_stateCounters, 0, sizeof(StateCountersType));
+	return;
+}
+
+
+void RenderDeviceClass::ResetStateCache()
+{
+	int i;
+
+
+	// Forget everything that is bound so the next call of each kind reaches the device.
+	m_depthState = -1;
+	m_blendState = -1;
+
+	m_vertexBuffer = RENDER_STATE_UNKNOWN;
+	m_vertexStride = 0;
+	m_indexBuffer = RENDER_STATE_UNKNOWN;
+	m_inputLayout = RENDER_STATE_UNKNOWN;
+	m_vertexShader = RENDER_STATE_UNKNOWN;
+	m_pixelShader = RENDER_STATE_UNKNOWN;
+
+	for(i=0; i<RENDER_STATE_SLOTS; i++)
+	{
+		m_vsConstantBuffers[i] = RENDER_STATE_UNKNOWN;
+		m_psConstantBuffers[i] = RENDER_STATE_UNKNOWN;
+		m_psTextures[i] = RENDER_STATE_UNKNOWN;
+		m_psSamplers[i] = RENDER_STATE_UNKNOWN;
+	}
+
+	return;
+}
+
+
+bool RenderDeviceClass::CheckBinding(unsigned int& boundId, RenderResource* resource)
+{
+	unsigned int id;
+
+
+	// Compare ids rather than pointers, a released resource's address can be reused by the next one created.
+	id = resource ? resource->GetId() : 0;
+	if(id == boundId)
+	{
+		m_stateCounters.bindsSkipped++;
+		return false;
+	}
+
+	boundId = id;
+	m_stateCounters.bindsIssued++;
+
+	return true;
+}
+
+
+bool RenderDeviceClass::CheckState(int& currentState, int state)
+{
+	if(currentState == state)
+	{
+		m_stateCounters.stateChangesSkipped++;
+		return false;
+	}
+
+	currentState = state;
+	m_stateCounters.stateChangesIssued++;
+
+	return true;
+}
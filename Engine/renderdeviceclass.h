@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RENDERDEVICECLASS_H_
+#define _RENDERDEVICECLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int RENDER_STATE_SLOTS = 8;
+const unsigned int RENDER_STATE_UNKNOWN = 0xffffffff;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mathclass.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+enum RenderBufferType
+{
+	RENDER_BUFFER_VERTEX,
+	RENDER_BUFFER_INDEX,
+	RENDER_BUFFER_CONSTANT
+};
+
+// Dynamic resources can be rewritten after creation, buffers through MapBuffer and textures through UpdateTexture.
+enum RenderUsage
+{
+	RENDER_USAGE_STATIC,
+	RENDER_USAGE_DYNAMIC
+};
+
+// A discard map hands back fresh memory and the old contents stay with any draw still using them, a no overwrite
+// map hands back the buffer itself and the caller promises not to touch anything a draw in flight may still read.
+enum RenderMapMode
+{
+	RENDER_MAP_DISCARD,
+	RENDER_MAP_NO_OVERWRITE
+};
+
+enum RenderFormat
+{
+	RENDER_FORMAT_R32G32_FLOAT,
+	RENDER_FORMAT_R32G32B32_FLOAT,
+	RENDER_FORMAT_R32G32B32A32_FLOAT,
+	RENDER_FORMAT_R8G8_SNORM,
+	RENDER_FORMAT_R8G8_UNORM,
+	RENDER_FORMAT_R8G8B8A8_UNORM
+};
+
+enum RenderAddressMode
+{
+	RENDER_ADDRESS_WRAP,
+	RENDER_ADDRESS_CLAMP
+};
+
+struct RenderInputElementType
+{
+	const char* semanticName;
+	int semanticIndex;
+	RenderFormat format;
+	int offset;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Resource handles, each device derives its own resources from these and
+// frees them when they are released.
+////////////////////////////////////////////////////////////////////////////////
+class RenderResource
+{
+public:
+	RenderResource();
+	virtual ~RenderResource();
+	virtual void Release() = 0;
+
+	// Every resource gets a new id, so the state cache never mistakes a new resource at a freed address for a bound one.
+	unsigned int GetId();
+
+private:
+	unsigned int m_id;
+	static std::atomic<unsigned int> m_nextId;
+};
+
+class RenderBuffer : public RenderResource
+{
+public:
+	RenderBuffer();
+	~RenderBuffer();
+
+	// The contents last uploaded through UpdateBuffer, kept so an upload that changes nothing can be skipped.  The copy
+	// only ever grows so uploads of varying sizes do not allocate every time.
+	char* shadow;
+	int shadowSize, shadowCapacity;
+	bool shadowValid;
+};
+
+class RenderTexture : public RenderResource {};
+class RenderProgram : public RenderResource {};
+class RenderInputLayout : public RenderResource {};
+class RenderSampler : public RenderResource {};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+class RenderDeviceClass
+{
+public:
+	struct StateCountersType
+	{
+		int bindsIssued, bindsSkipped;
+		int uploadsIssued, uploadsSkipped;
+		int stateChangesIssued, stateChangesSkipped;
+	};
+
+public:
+	RenderDeviceClass();
+	RenderDeviceClass(const RenderDeviceClass&);
+	virtual ~RenderDeviceClass();
+
+	virtual void Shutdown() = 0;
+
+	virtual void BeginScene(float, float, float, float) = 0;
+	virtual void EndScene() = 0;
+	virtual void SetVSync(bool) = 0;
+
+	void GetProjectionMatrix(Matrix&);
+	void GetWorldMatrix(Matrix&);
+	void GetOrthoMatrix(Matrix&);
+
+	virtual void GetVideoCardInfo(char*, int&) = 0;
+
+	void TurnZBufferOn();
+	void TurnZBufferOff();
+	void TurnOnAlphaBlending();
+	void TurnOffAlphaBlending();
+
+	// Resource creation, each returns null on failure.
+	virtual RenderBuffer* CreateBuffer(RenderBufferType, RenderUsage, int, const void*) = 0;
+	virtual RenderTexture* CreateTexture(int, int, RenderFormat, RenderUsage, const void*, int) = 0;
+	virtual RenderTexture* CreateTextureFromFile(const char*) = 0;
+	virtual RenderProgram* CreateVertexShader(const char*, const char*) = 0;
+	virtual RenderProgram* CreatePixelShader(const char*, const char*) = 0;
+	virtual RenderInputLayout* CreateInputLayout(const RenderInputElementType*, int, RenderProgram*) = 0;
+	virtual RenderSampler* CreateSampler(RenderAddressMode) = 0;
+
+	// Dynamic resource updates, UpdateBuffer rewrites a whole buffer and skips the upload when nothing changed.
+	void* MapBuffer(RenderBuffer*, RenderMapMode);
+	void UnmapBuffer(RenderBuffer*);
+	bool UpdateBuffer(RenderBuffer*, const void*, int);
+	virtual void UpdateTexture(RenderTexture*, const void*, int) = 0;
+
+	// Pipeline state, every draw is an indexed triangle list with 32 bit indices.  Binding what is already bound is skipped.
+	void SetVertexBuffer(RenderBuffer*, int);
+	void SetIndexBuffer(RenderBuffer*);
+	void SetInputLayout(RenderInputLayout*);
+	void SetVertexShader(RenderProgram*);
+	void SetPixelShader(RenderProgram*);
+	void SetVSConstantBuffer(int, RenderBuffer*);
+	void SetPSConstantBuffer(int, RenderBuffer*);
+	void SetPSTexture(int, RenderTexture*);
+	void SetPSSampler(int, RenderSampler*);
+	virtual void DrawIndexed(int, int) = 0;
+
+	// A fence marks a point in the commands sent so far, it is complete once the GPU has finished everything before it.
+	// The values count up from one, zero is always complete.
+	virtual unsigned long long InsertFence() = 0;
+	virtual bool IsFenceComplete(unsigned long long) = 0;
+
+	void GetStateCounters(StateCountersType&);
+	void ResetStateCounters();
+	void ResetStateCache();
+
+protected:
+	void InitializeMatrices(int, int, float, float);
+
+	// The calls that reach the device once the state cache has decided they are needed.
+	virtual void BindDepthState(bool) = 0;
+	virtual void BindBlendState(bool) = 0;
+	virtual void* LockBuffer(RenderBuffer*, RenderMapMode) = 0;
+	virtual void UnlockBuffer(RenderBuffer*) = 0;
+	virtual void BindVertexBuffer(RenderBuffer*, int) = 0;
+	virtual void BindIndexBuffer(RenderBuffer*) = 0;
+	virtual void BindInputLayout(RenderInputLayout*) = 0;
+	virtual void BindVertexShader(RenderProgram*) = 0;
+	virtual void BindPixelShader(RenderProgram*) = 0;
+	virtual void BindVSConstantBuffer(int, RenderBuffer*) = 0;
+	virtual void BindPSConstantBuffer(int, RenderBuffer*) = 0;
+	virtual void BindPSTexture(int, RenderTexture*) = 0;
+	virtual void BindPSSampler(int, RenderSampler*) = 0;
+
+private:
+	bool CheckBinding(unsigned int&, RenderResource*);
+	bool CheckState(int&, int);
+
+protected:
+	Matrix m_projectionMatrix;
+	Matrix m_worldMatrix;
+	Matrix m_orthoMatrix;
+
+private:
+	int m_depthState, m_blendState;
+	unsigned int m_vertexBuffer, m_indexBuffer, m_inputLayout, m_vertexShader, m_pixelShader;
+	int m_vertexStride;
+	unsigned int m_vsConstantBuffers[RENDER_STATE_SLOTS];
+	unsigned int m_psConstantBuffers[RENDER_STATE_SLOTS];
+	unsigned int m_psTextures[RENDER_STATE_SLOTS];
+	unsigned int m_psSamplers[RENDER_STATE_SLOTS];
+	StateCountersType m_stateCounters;
+};
+
+#endif
@@ -0,0 +1,337 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderthreadclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "renderthreadclass.h"
+#include "profilerclass.h"
+#include "clockclass.h"
+#include "cpuclass.h"
+#include "statsoverlayclass.h"
+#include <string.h>
+
+
+RenderThreadClass::RenderThreadClass()
+{
+	int i;
+
+
+	m_slots = 0;
+	m_function = 0;
+	m_data = 0;
+	m_release = 0;
+	m_running = false;
+	m_failed = false;
+	m_submitted = 0;
+	m_rendered = 0;
+	m_sleepingThreads = 0;
+	memset(&m_stats, 0, sizeof(StatsType));
+	memset(&m_result, 0, sizeof(FrameResultType));
+	m_resultReady = false;
+
+	for(i=0; i<RENDER_THREAD_METRICS; i++)
+	{
+		m_metrics[i] = -1;
+	}
+}
+
+
+RenderThreadClass::RenderThreadClass(const RenderThreadClass& other)
+{
+}
+
+
+RenderThreadClass::~RenderThreadClass()
+{
+}
+
+
+bool RenderThreadClass::Initialize(RenderFunction function, void* data)
+{
+	int i;
+
+
+	m_function = function;
+	m_data = data;
+
+	// Create the packet slots, each packet's text snapshot grows to fit on first use.
+	m_slots = new SlotType[RENDER_THREAD_PACKETS];
+	if(!m_slots)
+	{
+		return false;
+	}
+
+	for(i=0; i<RENDER_THREAD_PACKETS; i++)
+	{
+		m_slots[i] = SlotType();
+	}
+
+	m_submitted = 0;
+	m_rendered = 0;
+	m_failed = false;
+
+	// Start the render thread, it sleeps until the first packet is submitted.
+	m_running = true;
+	m_thread = std::thread(&RenderThreadClass::RenderThread, this);
+
+	// Show how far behind the render thread runs and how long each thread waits for the other in the stats overlay.
+	m_metrics[0] = StatsOverlayClass::AddGauge("Render thread", "Latency", 2, "ms");
+	m_metrics[1] = StatsOverlayClass::AddGauge("Render thread", "Queued", 2, "ms");
+	m_metrics[2] = StatsOverlayClass::AddGauge("Render thread", "Render", 2, "ms");
+	m_metrics[3] = StatsOverlayClass::AddGauge("Render thread", "Main wait", 2, "ms");
+	m_metrics[4] = StatsOverlayClass::AddGauge("Render thread", "Render wait", 2, "ms");
+	m_metrics[5] = StatsOverlayClass::AddGauge("Render thread", "Input to photon", 2, "ms");
+
+	return true;
+}
+
+
+void RenderThreadClass::Shutdown()
+{
+	int i;
+
+
+	// Take the render thread metrics off the overlay.
+	for(i=0; i<RENDER_THREAD_METRICS; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
+	// Let the render thread draw what it has been given and wait for it to finish.
+	if(m_thread.joinable())
+	{
+		m_running = false;
+		Wake();
+
+		m_thread.join();
+	}
+
+	// Release the packets.
+	if(m_slots)
+	{
+		for(i=0; i<RENDER_THREAD_PACKETS; i++)
+		{
+			TextClass::ReleaseSnapshot(m_slots[i].packet.text);
+		}
+
+		delete [] m_slots;
+		m_slots = 0;
+	}
+
+	// Release the member function the packets were drawn with.
+	if(m_release)
+	{
+		m_release(m_data);
+		m_release = 0;
+	}
+
+	m_function = 0;
+	m_data = 0;
+
+	return;
+}
+
+
+FramePacketType* RenderThreadClass::BeginPacket()
+{
+	SlotType* slot;
+	unsigned int submitted;
+	long long waitStart;
+
+
+	submitted = m_submitted.load(std::memory_order_relaxed);
+	waitStart = ClockClass::GetTimestamp();
+
+	// Wait for the render thread to finish with the oldest packet if every slot is in use.
+	if(submitted - m_rendered.load(std::memory_order_acquire) >= (unsigned int)RENDER_THREAD_PACKETS)
+	{
+		PROFILE_ZONE("Wait For Render");
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+
+		m_sleepingThreads++;
+		while(submitted - m_rendered.load(std::memory_order_acquire) >= (unsigned int)RENDER_THREAD_PACKETS)
+		{
+			m_sleepCondition.wait(lock);
+		}
+		m_sleepingThreads--;
+	}
+
+	m_stats.mainWait = ClockClass::ToMilliseconds(ClockClass::GetTimestamp() - waitStart);
+
+	slot = &m_slots[submitted % RENDER_THREAD_PACKETS];
+
+	// The render thread's times and result for the packet that was last in this slot came back with it.
+	m_resultReady = slot->rendered;
+	if(slot->rendered)
+	{
+		m_result = slot->result;
+
+		m_stats.latency = ClockClass::ToMilliseconds(slot->renderEnd - slot->packet.startTime);
+		m_stats.queueTime = ClockClass::ToMilliseconds(slot->renderStart - slot->packet.submitTime);
+		m_stats.renderTime = ClockClass::ToMilliseconds(slot->renderEnd - slot->renderStart);
+		m_stats.renderWait = slot->waitTime;
+
+		if(slot->packet.inputTime != 0)
+		{
+			m_stats.inputLatency = ClockClass::ToMilliseconds(slot->renderEnd - slot->packet.inputTime);
+		}
+
+		slot->rendered = false;
+	}
+
+	slot->packet.frame = (int)submitted;
+
+	return &slot->packet;
+}
+
+
+bool RenderThreadClass::GetResult(FrameResultType& result)
+{
+	result = m_result;
+	return m_resultReady;
+}
+
+
+void RenderThreadClass::SubmitPacket()
+{
+	m_slots[m_submitted.load(std::memory_order_relaxed) % RENDER_THREAD_PACKETS].packet.submitTime = ClockClass::GetTimestamp();
+
+	// Hand the packet over, everything written to it is visible to the render thread once it sees the new count.
+	m_submitted.fetch_add(1, std::memory_order_seq_cst);
+	Wake();
+
+	return;
+}
+
+
+void RenderThreadClass::Flush()
+{
+	unsigned int submitted;
+
+
+	submitted = m_submitted.load(std::memory_order_relaxed);
+	if(m_rendered.load(std::memory_order_acquire) == submitted)
+	{
+		return;
+	}
+
+	PROFILE_ZONE("Flush Render");
+
+	std::unique_lock<std::mutex> lock(m_sleepMutex);
+
+	m_sleepingThreads++;
+	while(m_rendered.load(std::memory_order_acquire) != submitted)
+	{
+		m_sleepCondition.wait(lock);
+	}
+	m_sleepingThreads--;
+
+	return;
+}
+
+
+bool RenderThreadClass::HasFailed()
+{
+	return m_failed.load(std::memory_order_relaxed);
+}
+
+
+void RenderThreadClass::Frame()
+{
+	StatsOverlayClass::SetGauge(m_metrics[0], m_stats.latency);
+	StatsOverlayClass::SetGauge(m_metrics[1], m_stats.queueTime);
+	StatsOverlayClass::SetGauge(m_metrics[2], m_stats.renderTime);
+	StatsOverlayClass::SetGauge(m_metrics[3], m_stats.mainWait);
+	StatsOverlayClass::SetGauge(m_metrics[4], m_stats.renderWait);
+	StatsOverlayClass::SetGauge(m_metrics[5], m_stats.inputLatency);
+
+	return;
+}
+
+
+void RenderThreadClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+void RenderThreadClass::RenderThread()
+{
+	SlotType* slot;
+	unsigned int rendered;
+	long long waitStart;
+
+
+	PROFILE_THREAD("Render");
+	CpuThreadClass cpuThread("Render");
+
+	rendered = 0;
+
+	while(true)
+	{
+		waitStart = ClockClass::GetTimestamp();
+
+		// Sleep until the main thread submits a packet, on shutdown the packets already submitted are still drawn.
+		if(m_submitted.load(std::memory_order_acquire) == rendered)
+		{
+			PROFILE_ZONE("Wait For Packet");
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+
+			m_sleepingThreads++;
+			while(m_running && (m_submitted.load(std::memory_order_acquire) == rendered))
+			{
+				m_sleepCondition.wait(lock);
+			}
+			m_sleepingThreads--;
+		}
+
+		if(m_submitted.load(std::memory_order_acquire) == rendered)
+		{
+			break;
+		}
+
+		slot = &m_slots[rendered % RENDER_THREAD_PACKETS];
+		slot->renderStart = ClockClass::GetTimestamp();
+		memset(&slot->result, 0, sizeof(FrameResultType));
+		slot->waitTime = ClockClass::ToMilliseconds(slot->renderStart - waitStart);
+
+		// Once a frame has failed the rest are only handed back, so the main thread never waits on a slot forever.
+		if(!m_failed.load(std::memory_order_relaxed))
+		{
+			PROFILE_ZONE("Render Frame");
+
+			if(!m_function(m_data, slot->packet, slot->result))
+			{
+				m_failed = true;
+			}
+		}
+
+		slot->renderEnd = ClockClass::GetTimestamp();
+		slot->rendered = true;
+
+		// Hand the slot back to the main thread.
+		rendered++;
+		m_rendered.store(rendered, std::memory_order_seq_cst);
+		Wake();
+	}
+
+	return;
+}
+
+
+void RenderThreadClass::Wake()
+{
+	// Only take the lock when the other thread is asleep, a sleeping thread checks the counts under the same lock so the
+	// wake up cannot be missed.
+	if(m_sleepingThreads.load() == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_sleepMutex);
+	m_sleepCondition.notify_all();
+
+	return;
+}
@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderthreadclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RENDERTHREADCLASS_H_
+#define _RENDERTHREADCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int RENDER_THREAD_PACKETS = 2;
+const int RENDER_THREAD_METRICS = 6;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mathclass.h"
+#include "renderdeviceclass.h"
+#include "drawlistclass.h"
+#include "textclass.h"
+#include "ringbufferclass.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// Everything the render thread needs to draw one frame, filled in on the main thread and not changed again until the
+// render thread is done with it.  The resources it points at are only changed on the main thread after a Flush.  The
+// input time is when the oldest input the frame applied was seen, or zero if there was none.
+struct FramePacketType
+{
+	int frame;
+	long long startTime, submitTime, inputTime;
+	Matrix worldMatrix, viewMatrix, projectionMatrix, orthoMatrix;
+	DrawPacketType terrain;
+	RenderTexture *normalMap, *lightMap;
+	Vector4 ambientColor, diffuseColor;
+	Vector3 lightDirection;
+	TextSnapshotType text;
+	bool vsync, saveFrame;
+};
+
+// What the render thread counted while drawing a packet.  It comes back to the main thread with the slot, the stats
+// overlay is only ever written from there.
+struct FrameResultType
+{
+	RingBufferClass::StatsType ringBuffer;
+	int textBytesUploaded, textBytesSaved;
+};
+
+// Draws a packet and fills in its result, returns false if the application can not go on.
+typedef bool (*RenderFunction)(void*, const FramePacketType&, FrameResultType&);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderThreadClass
+////////////////////////////////////////////////////////////////////////////////
+class RenderThreadClass
+{
+private:
+	// The times and the result are filled in by the render thread and handed back with the slot.
+	struct SlotType
+	{
+		FramePacketType packet;
+		FrameResultType result;
+		long long renderStart, renderEnd;
+		float waitTime;
+		bool rendered;
+	};
+
+	// Calls a member function, for rendering with a class.
+	template<class T>
+	struct MemberRenderType
+	{
+		T* object;
+		bool (T::*function)(const FramePacketType&, FrameResultType&);
+
+		static bool Run(void* data, const FramePacketType& packet, FrameResultType& result)
+		{
+			MemberRenderType* render = (MemberRenderType*)data;
+			return (render->object->*(render->function))(packet, result);
+		}
+
+		static void Release(void* data)
+		{
+			delete (MemberRenderType*)data;
+		}
+	};
+
+public:
+	// Times for the last rendered frame in milliseconds.  The latency runs from the start of the main thread's frame to
+	// the end of the present, the queue time is how long the packet waited for the render thread and the waits are how
+	// long each thread was held up by the other.  The input latency runs from when the input was seen to the end of the
+	// present of the first frame that showed it, for the last frame that had any.
+	struct StatsType
+	{
+		float latency, queueTime, renderTime;
+		float mainWait, renderWait;
+		float inputLatency;
+	};
+
+public:
+	RenderThreadClass();
+	RenderThreadClass(const RenderThreadClass&);
+	~RenderThreadClass();
+
+	bool Initialize(RenderFunction, void*);
+	void Shutdown();
+
+	template<class T>
+	bool Initialize(T* object, bool (T::*function)(const FramePacketType&, FrameResultType&))
+	{
+		MemberRenderType<T>* render;
+
+
+		render = new MemberRenderType<T>;
+		if(!render)
+		{
+			return false;
+		}
+
+		render->object = object;
+		render->function = function;
+
+		m_release = &MemberRenderType<T>::Release;
+
+		return Initialize(&MemberRenderType<T>::Run, render);
+	}
+
+	// The main thread fills in the next packet while the render thread draws the last one.  BeginPacket waits if every
+	// packet is still queued or being drawn.  GetResult then hands back the result of the frame that was last drawn in
+	// the packet, it returns false if the packet has not been drawn before.
+	FramePacketType* BeginPacket();
+	bool GetResult(FrameResultType&);
+	void SubmitPacket();
+
+	// Waits until every packet submitted has been drawn.  Until the next packet is submitted the render thread does not
+	// touch the device, so the main thread can use it.
+	void Flush();
+
+	bool HasFailed();
+	void Frame();
+	void GetStats(StatsType&);
+
+private:
+	void RenderThread();
+	void Wake();
+
+private:
+	SlotType* m_slots;
+	RenderFunction m_function;
+	void* m_data;
+	void (*m_release)(void*);
+	std::thread m_thread;
+	std::atomic<bool> m_running, m_failed;
+
+	// The packets are handed over through two counts, the slot of a packet is its number modulo the slot count.  Only the
+	// main thread adds to the submitted count and only the render thread adds to the rendered count.
+	std::atomic<unsigned int> m_submitted, m_rendered;
+
+	// A thread that has to wait for the other sleeps until it moves its count on.
+	std::atomic<int> m_sleepingThreads;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCondition;
+
+	StatsType m_stats;
+	FrameResultType m_result;
+	bool m_resultReady;
+	int m_metrics[RENDER_THREAD_METRICS];
+};
+
+#endif
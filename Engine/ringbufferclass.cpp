@@ -0,0 +1,397 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringbufferclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "ringbufferclass.h"
+#include "statsoverlayclass.h"
+#include <string.h>
+
+
+RingBufferClass::RingBufferClass()
+{
+	int i;
+
+
+	m_buffer = 0;
+	m_size = 0;
+	m_head = 0;
+	m_tail = 0;
+	m_keep = 0;
+	m_frameAllocations = 0;
+	m_firstFrame = 0;
+	m_frameCount = 0;
+	m_wrapCount = 0;
+	m_discardCount = 0;
+	memset(&m_stats, 0, sizeof(StatsType));
+	memset(&m_frameStats, 0, sizeof(StatsType));
+
+	for(i=0; i<RING_BUFFER_METRICS; i++)
+	{
+		m_metrics[i] = -1;
+	}
+}
+
+
+RingBufferClass::RingBufferClass(const RingBufferClass& other)
+{
+}
+
+
+RingBufferClass::~RingBufferClass()
+{
+}
+
+
+bool RingBufferClass::Initialize(RenderDeviceClass* device, int size)
+{
+	// Create the dynamic vertex buffer that every allocation is made from.
+	m_buffer = device->CreateBuffer(RENDER_BUFFER_VERTEX, RENDER_USAGE_DYNAMIC, size, 0);
+	if(!m_buffer)
+	{
+		return false;
+	}
+
+	m_size = size;
+	Reset();
+
+	// Show how much of the buffer is in use in the stats overlay.
+	m_metrics[0] = StatsOverlayClass::AddCounter("Ring buffer", "Allocated", "KB");
+	m_metrics[1] = StatsOverlayClass::AddCounter("Ring buffer", "In flight", "KB");
+	m_metrics[2] = StatsOverlayClass::AddCounter("Ring buffer", "Wraps", "");
+	m_metrics[3] = StatsOverlayClass::AddCounter("Ring buffer", "Discards", "");
+	m_metrics[4] = StatsOverlayClass::AddCounter("Ring buffer", "Failed", "/frame");
+
+	return true;
+}
+
+
+void RingBufferClass::Shutdown()
+{
+	int i;
+
+
+	// Take the ring buffer's metrics off the overlay.
+	for(i=0; i<RING_BUFFER_METRICS; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
+	// Release the buffer.
+	if(m_buffer)
+	{
+		m_buffer->Release();
+		m_buffer = 0;
+	}
+
+	m_size = 0;
+	Reset();
+
+	return;
+}
+
+
+void* RingBufferClass::Map(RenderDeviceClass* device, int vertexCount, int stride, AllocationType& allocation)
+{
+	RenderMapMode mode;
+	char* data;
+	int size;
+	bool result, wrapped;
+
+
+	size = vertexCount * stride;
+	if((size <= 0) || (stride <= 0))
+	{
+		m_stats.failedAllocations++;
+		return 0;
+	}
+
+	// Free the space of every frame the GPU has finished drawing.
+	while((m_frameCount > 0) && device->IsFenceComplete(GetOldestFence()))
+	{
+		RetireFrame();
+	}
+
+	// Normally the new vertices go after the ones already written and the driver is told nothing in use is overwritten.
+	mode = RENDER_MAP_NO_OVERWRITE;
+
+	result = Reserve(size, stride, allocation, wrapped);
+	if(!result)
+	{
+		// If nothing has been written this frame yet then the driver can rename the whole buffer, the frames still in
+		// flight keep the old copy.  Otherwise a draw already recorded this frame would lose its vertices.
+		if((m_frameAllocations > 0) || (size > m_size))
+		{
+			m_stats.failedAllocations++;
+			return 0;
+		}
+
+		Reset();
+		Reserve(size, stride, allocation, wrapped);
+		mode = RENDER_MAP_DISCARD;
+
+		m_stats.discards++;
+	}
+
+	if(wrapped)
+	{
+		m_stats.wraps++;
+	}
+
+	data = (char*)device->MapBuffer(m_buffer, mode);
+	if(!data)
+	{
+		m_stats.failedAllocations++;
+		return 0;
+	}
+
+	m_stats.allocations++;
+	m_stats.bytesAllocated += size;
+
+	return data + allocation.offset;
+}
+
+
+void RingBufferClass::Unmap(RenderDeviceClass* device)
+{
+	device->UnmapBuffer(m_buffer);
+	return;
+}
+
+
+bool RingBufferClass::Reuse(const AllocationType& allocation)
+{
+	if(allocation.size <= 0)
+	{
+		return false;
+	}
+
+	// Once the head is a whole lap past the allocation its space has been handed out again, and a reset moves the head on
+	// by more than a lap so nothing from before it is kept.
+	if(m_head - allocation.position > m_size)
+	{
+		return false;
+	}
+
+	// Hold the tail back so the space is not handed out while this frame is in flight.  The frame now has something in
+	// the buffer, so it gets a fence and the buffer is not renamed under it.
+	if(allocation.position < m_tail)
+	{
+		m_tail = allocation.position;
+	}
+
+	if(allocation.position < m_keep)
+	{
+		m_keep = allocation.position;
+	}
+
+	m_frameAllocations++;
+
+	return true;
+}
+
+
+void RingBufferClass::EndFrame(RenderDeviceClass* device, StatsType& stats)
+{
+	// Put a fence after the frame's draws so its space can be reused once the GPU has passed it.
+	if(m_frameAllocations > 0)
+	{
+		CloseFrame(device->InsertFence());
+	}
+
+	// Hand back the counts for the frame and start again for the next one.
+	m_stats.bytesInFlight = GetBytesInFlight();
+	stats = m_stats;
+	memset(&m_stats, 0, sizeof(StatsType));
+
+	return;
+}
+
+
+void RingBufferClass::UpdateMetrics(const StatsType& stats)
+{
+	// Keep the counts for the last frame and add its wraps and discards to the totals.
+	m_frameStats = stats;
+	m_wrapCount += stats.wraps;
+	m_discardCount += stats.discards;
+
+	StatsOverlayClass::SetCounter(m_metrics[0], m_frameStats.bytesAllocated / 1024);
+	StatsOverlayClass::SetCounter(m_metrics[1], m_frameStats.bytesInFlight / 1024);
+	StatsOverlayClass::SetCounter(m_metrics[2], m_wrapCount);
+	StatsOverlayClass::SetCounter(m_metrics[3], m_discardCount);
+	StatsOverlayClass::SetCounter(m_metrics[4], m_frameStats.failedAllocations);
+	StatsOverlayClass::SetWarning(m_metrics[4], m_frameStats.failedAllocations > 0);
+
+	return;
+}
+
+
+RenderBuffer* RingBufferClass::GetBuffer()
+{
+	return m_buffer;
+}
+
+
+void RingBufferClass::GetStats(StatsType& stats)
+{
+	stats = m_frameStats;
+	return;
+}
+
+
+bool RingBufferClass::Reserve(int size, int alignment, AllocationType& allocation, bool& wrapped)
+{
+	long long lap, position;
+	int offset;
+
+
+	wrapped = false;
+
+	if((size <= 0) || (alignment <= 0) || (size > m_size))
+	{
+		return false;
+	}
+
+	// An empty buffer starts again from the beginning of a lap so a large block has the most room.
+	if(m_head == m_tail)
+	{
+		m_head = ((m_head + m_size - 1) / m_size) * m_size;
+		m_tail = m_head;
+		m_keep = m_head;
+	}
+
+	// Blocks start on a multiple of the alignment within the buffer, for vertices that is the stride so the base vertex
+	// is whole.  A block that does not fit before the end of the buffer goes at the start of the next lap.
+	lap = (m_head / m_size) * m_size;
+	offset = (int)(m_head - lap);
+	offset = ((offset + alignment - 1) / alignment) * alignment;
+	if(offset + size > m_size)
+	{
+		lap += m_size;
+		offset = 0;
+		wrapped = true;
+	}
+
+	// The head is never more than a lap ahead of the tail, past that it would write over space still in use.
+	position = lap + offset;
+	if(position + size - m_tail > m_size)
+	{
+		wrapped = false;
+		return false;
+	}
+
+	m_head = position + size;
+	m_frameAllocations++;
+
+	allocation.position = position;
+	allocation.offset = offset;
+	allocation.size = size;
+
+	return true;
+}
+
+
+bool RingBufferClass::CloseFrame(unsigned long long fence)
+{
+	int index;
+
+
+	if(m_frameAllocations == 0)
+	{
+		return false;
+	}
+
+	// If too many frames are in flight then the fence joins the newest one, a later fence also covers the earlier frame
+	// and the joined frame keeps whatever either of them reused.
+	if(m_frameCount == RING_BUFFER_FRAMES)
+	{
+		index = (m_firstFrame + m_frameCount - 1) % RING_BUFFER_FRAMES;
+		if(m_frames[index].keep < m_keep)
+		{
+			m_keep = m_frames[index].keep;
+		}
+	}
+	else
+	{
+		index = (m_firstFrame + m_frameCount) % RING_BUFFER_FRAMES;
+		m_frameCount++;
+	}
+
+	m_frames[index].fence = fence;
+	m_frames[index].end = m_head;
+	m_frames[index].keep = m_keep;
+
+	// The next frame has reused nothing yet.
+	m_keep = m_head;
+	m_frameAllocations = 0;
+
+	return true;
+}
+
+
+void RingBufferClass::RetireFrame()
+{
+	int index, i;
+
+
+	if(m_frameCount == 0)
+	{
+		return;
+	}
+
+	// Everything up to the end of the oldest frame is free again, apart from anything a later frame reused.
+	m_tail = m_frames[m_firstFrame].end;
+	m_firstFrame = (m_firstFrame + 1) % RING_BUFFER_FRAMES;
+	m_frameCount--;
+
+	for(i=0; i<m_frameCount; i++)
+	{
+		index = (m_firstFrame + i) % RING_BUFFER_FRAMES;
+		if(m_frames[index].keep < m_tail)
+		{
+			m_tail = m_frames[index].keep;
+		}
+	}
+
+	if(m_keep < m_tail)
+	{
+		m_tail = m_keep;
+	}
+
+	return;
+}
+
+
+void RingBufferClass::Reset()
+{
+	// Start again a whole lap past the head so no allocation from before the reset can be reused.
+	if(m_size > 0)
+	{
+		m_head = (((m_head + m_size - 1) / m_size) + 1) * m_size;
+	}
+
+	m_tail = m_head;
+	m_keep = m_head;
+	m_frameAllocations = 0;
+	m_firstFrame = 0;
+	m_frameCount = 0;
+
+	return;
+}
+
+
+unsigned long long RingBufferClass::GetOldestFence()
+{
+	return (m_frameCount > 0) ? m_frames[m_firstFrame].fence : 0;
+}
+
+
+int RingBufferClass::GetFramesInFlight()
+{
+	return m_frameCount;
+}
+
+
+int RingBufferClass::GetBytesInFlight()
+{
+	return (int)(m_head - m_tail);
+}
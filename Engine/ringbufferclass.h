@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringbufferclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RINGBUFFERCLASS_H_
+#define _RINGBUFFERCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int RING_BUFFER_FRAMES = 8;
+const int RING_BUFFER_METRICS = 5;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RingBufferClass
+////////////////////////////////////////////////////////////////////////////////
+class RingBufferClass
+{
+private:
+	// Where a finished frame's allocations end, where the oldest allocation it reused starts and the fence the GPU passes
+	// once it has drawn them.
+	struct FrameType
+	{
+		unsigned long long fence;
+		long long end, keep;
+	};
+
+public:
+	// Where an allocation is in the buffer.  The position counts up through the laps of the ring and is never reused, the
+	// offset is where it lies in the buffer itself.
+	struct AllocationType
+	{
+		long long position;
+		int offset, size;
+	};
+
+	// Counts for the last frame, a wrap goes back to the start of the buffer and a discard hands the whole buffer back
+	// to the driver to be renamed.
+	struct StatsType
+	{
+		int allocations, bytesAllocated;
+		int failedAllocations;
+		int wraps, discards;
+		int bytesInFlight;
+	};
+
+public:
+	RingBufferClass();
+	RingBufferClass(const RingBufferClass&);
+	~RingBufferClass();
+
+	bool Initialize(RenderDeviceClass*, int);
+	void Shutdown();
+
+	// Map hands back room for a number of vertices of the given stride and where it is, or null if the buffer is full.
+	// The buffer stays mapped until Unmap.  Reuse draws an earlier allocation again this frame without writing it, it
+	// returns false once its space has been written over or the buffer renamed.  EndFrame is called once the frame's
+	// draws have all been sent, after that its allocations are reused once the GPU is done with them.  It hands back the
+	// frame's counts, which are put in the stats overlay with UpdateMetrics on the main thread.
+	void* Map(RenderDeviceClass*, int, int, AllocationType&);
+	void Unmap(RenderDeviceClass*);
+	bool Reuse(const AllocationType&);
+	void EndFrame(RenderDeviceClass*, StatsType&);
+	void UpdateMetrics(const StatsType&);
+
+	RenderBuffer* GetBuffer();
+	void GetStats(StatsType&);
+
+	// The allocator on its own, without a device.  Reserve finds room for a block at a multiple of the alignment, or
+	// returns false if the space is still in use.  CloseFrame ends the current frame under a fence and RetireFrame frees
+	// the oldest closed frame, whose fence must be complete.  Reset forgets every allocation, as when the buffer is renamed.
+	bool Reserve(int, int, AllocationType&, bool&);
+	bool CloseFrame(unsigned long long);
+	void RetireFrame();
+	void Reset();
+	unsigned long long GetOldestFence();
+	int GetFramesInFlight();
+	int GetBytesInFlight();
+
+private:
+	RenderBuffer* m_buffer;
+	int m_size;
+	long long m_head, m_tail, m_keep;
+	int m_frameAllocations;
+	FrameType m_frames[RING_BUFFER_FRAMES];
+	int m_firstFrame, m_frameCount;
+	StatsType m_stats, m_frameStats;
+	int m_wrapCount, m_discardCount;
+	int m_metrics[RING_BUFFER_METRICS];
+};
+
+#endif
@@ -0,0 +1,425 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shadercacheclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "shadercacheclass.h"
+#include "clockclass.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+ShaderCacheClass::ShaderCacheClass()
+{
+	m_filename[0] = 0;
+	m_mappedData = 0;
+	m_mappedSize = 0;
+	m_fileHandle = 0;
+	m_mappingHandle = 0;
+	m_dirty = false;
+	memset(&m_stats, 0, sizeof(StatsType));
+}
+
+
+ShaderCacheClass::ShaderCacheClass(const ShaderCacheClass& other)
+{
+}
+
+
+ShaderCacheClass::~ShaderCacheClass()
+{
+}
+
+
+bool ShaderCacheClass::Initialize(const char* filename)
+{
+	StopwatchClass stopwatch;
+
+
+	if(strlen(filename) >= sizeof(m_filename))
+	{
+		return false;
+	}
+
+	strcpy(m_filename, filename);
+
+	stopwatch.Start();
+
+	// Map the whole cache file in one go, a missing or damaged file just means an empty cache.
+	if(MapFile())
+	{
+		if(!ReadEntries())
+		{
+			ReleaseEntries();
+			UnmapFile();
+		}
+	}
+
+	m_stats.bytesMapped = m_mappedSize;
+	m_stats.mapTime = stopwatch.GetMilliseconds();
+
+	return true;
+}
+
+
+void ShaderCacheClass::Shutdown()
+{
+	// Write out anything compiled during this run.
+	if(m_dirty)
+	{
+		Save();
+	}
+
+	ReleaseEntries();
+	UnmapFile();
+
+	return;
+}
+
+
+bool ShaderCacheClass::Find(unsigned long long key, const void*& data, int& size)
+{
+	unsigned int i;
+
+
+	for(i=0; i<m_entries.size(); i++)
+	{
+		if(m_entries[i].key == key)
+		{
+			data = m_entries[i].data;
+			size = m_entries[i].size;
+			m_stats.hits++;
+			return true;
+		}
+	}
+
+	m_stats.misses++;
+
+	return false;
+}
+
+
+bool ShaderCacheClass::Store(unsigned long long key, const void* data, int size)
+{
+	EntryType entry;
+	char* copy;
+
+
+	if(size <= 0)
+	{
+		return false;
+	}
+
+	copy = new char[size];
+	if(!copy)
+	{
+		return false;
+	}
+
+	memcpy(copy, data, size);
+
+	entry.key = key;
+	entry.data = copy;
+	entry.size = size;
+	entry.owned = true;
+	m_entries.push_back(entry);
+
+	m_stats.stores++;
+	m_dirty = true;
+
+	return true;
+}
+
+
+bool ShaderCacheClass::Save()
+{
+	FileHeaderType header;
+	FileEntryType* table;
+	unsigned int i, offset;
+	char* copy;
+	FILE* file;
+	size_t count;
+
+
+	// The mapped file is about to be overwritten so take a copy of every entry still pointing into it.
+	for(i=0; i<m_entries.size(); i++)
+	{
+		if(!m_entries[i].owned)
+		{
+			copy = new char[m_entries[i].size];
+			if(!copy)
+			{
+				return false;
+			}
+
+			memcpy(copy, m_entries[i].data, m_entries[i].size);
+			m_entries[i].data = copy;
+			m_entries[i].owned = true;
+		}
+	}
+
+	UnmapFile();
+
+	// Build the header and the entry table.
+	memcpy(header.magic, "SHDC", 4);
+	header.version = SHADER_CACHE_VERSION;
+	header.entryCount = (unsigned int)m_entries.size();
+	header.padding = 0;
+
+	table = new FileEntryType[m_entries.size() + 1];
+	if(!table)
+	{
+		return false;
+	}
+
+	offset = sizeof(FileHeaderType) + sizeof(FileEntryType) * header.entryCount;
+	for(i=0; i<m_entries.size(); i++)
+	{
+		table[i].key = m_entries[i].key;
+		table[i].offset = offset;
+		table[i].size = m_entries[i].size;
+		offset += m_entries[i].size;
+	}
+
+	// Write the file.
+	file = fopen(m_filename, "wb");
+	if(!file)
+	{
+		delete [] table;
+		return false;
+	}
+
+	count = fwrite(&header, sizeof(FileHeaderType), 1, file);
+	count += fwrite(table, sizeof(FileEntryType), header.entryCount, file);
+	for(i=0; i<m_entries.size(); i++)
+	{
+		count += fwrite(m_entries[i].data, m_entries[i].size, 1, file);
+	}
+
+	fclose(file);
+
+	delete [] table;
+
+	if(count != 1 + header.entryCount * 2)
+	{
+		return false;
+	}
+
+	m_dirty = false;
+
+	return true;
+}
+
+
+void ShaderCacheClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+unsigned long long ShaderCacheClass::HashShader(const char* source, int sourceSize, const char* entryPoint, const char* profile, unsigned int flags)
+{
+	unsigned long long hash;
+
+
+	// Hash every input of the compiler, the source length and the string terminators keep neighbouring fields from running together.
+	hash = 14695981039346656037ULL;
+	hash = HashBytes(hash, &sourceSize, sizeof(int));
+	hash = HashBytes(hash, source, sourceSize);
+	hash = HashBytes(hash, entryPoint, (int)strlen(entryPoint) + 1);
+	hash = HashBytes(hash, profile, (int)strlen(profile) + 1);
+	hash = HashBytes(hash, &flags, sizeof(unsigned int));
+	hash = HashBytes(hash, &SHADER_CACHE_VERSION, sizeof(unsigned int));
+
+	return hash;
+}
+
+
+bool ShaderCacheClass::MapFile()
+{
+#ifdef _WIN32
+	HANDLE file, mapping;
+	DWORD size;
+	void* data;
+
+
+	file = CreateFileA(m_filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	size = GetFileSize(file, NULL);
+	if((size == INVALID_FILE_SIZE) || (size == 0))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_mappedData = (const char*)data;
+	m_mappedSize = (int)size;
+#else
+	struct stat fileInfo;
+	int file;
+	void* data;
+
+
+	file = open(m_filename, O_RDONLY);
+	if(file < 0)
+	{
+		return false;
+	}
+
+	if((fstat(file, &fileInfo) != 0) || (fileInfo.st_size == 0))
+	{
+		close(file);
+		return false;
+	}
+
+	data = mmap(0, fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	// The mapping stays valid after the descriptor is closed.
+	close(file);
+
+	if(data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_mappedData = (const char*)data;
+	m_mappedSize = (int)fileInfo.st_size;
+#endif
+
+	return true;
+}
+
+
+void ShaderCacheClass::UnmapFile()
+{
+	if(!m_mappedData)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_mappedData);
+	CloseHandle(m_mappingHandle);
+	CloseHandle(m_fileHandle);
+	m_mappingHandle = 0;
+	m_fileHandle = 0;
+#else
+	munmap((void*)m_mappedData, m_mappedSize);
+#endif
+
+	m_mappedData = 0;
+	m_mappedSize = 0;
+
+	return;
+}
+
+
+bool ShaderCacheClass::ReadEntries()
+{
+	const FileHeaderType* header;
+	const FileEntryType* table;
+	EntryType entry;
+	unsigned int i;
+
+
+	// Check the header before trusting anything in the file.
+	if(m_mappedSize < (int)sizeof(FileHeaderType))
+	{
+		return false;
+	}
+
+	header = (const FileHeaderType*)m_mappedData;
+	if((memcmp(header->magic, "SHDC", 4) != 0) || (header->version != SHADER_CACHE_VERSION))
+	{
+		return false;
+	}
+
+	if(header->entryCount > (m_mappedSize - sizeof(FileHeaderType)) / sizeof(FileEntryType))
+	{
+		return false;
+	}
+
+	table = (const FileEntryType*)(m_mappedData + sizeof(FileHeaderType));
+
+	// The entries point straight into the mapping so a hit costs no copy.
+	for(i=0; i<header->entryCount; i++)
+	{
+		if((table[i].offset > (unsigned int)m_mappedSize) || (table[i].size > (unsigned int)m_mappedSize - table[i].offset))
+		{
+			return false;
+		}
+
+		entry.key = table[i].key;
+		entry.data = m_mappedData + table[i].offset;
+		entry.size = (int)table[i].size;
+		entry.owned = false;
+		m_entries.push_back(entry);
+	}
+
+	return true;
+}
+
+
+void ShaderCacheClass::ReleaseEntries()
+{
+	unsigned int i;
+
+
+	for(i=0; i<m_entries.size(); i++)
+	{
+		if(m_entries[i].owned)
+		{
+			delete [] m_entries[i].data;
+		}
+	}
+
+	m_entries.clear();
+
+	return;
+}
+
+
+unsigned long long ShaderCacheClass::HashBytes(unsigned long long hash, const void* data, int size)
+{
+	const unsigned char* bytes;
+	int i;
+
+
+	// 64 bit FNV-1a.
+	bytes = (const unsigned char*)data;
+	for(i=0; i<size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shadercacheclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SHADERCACHECLASS_H_
+#define _SHADERCACHECLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int SHADER_CACHE_VERSION = 1;
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ShaderCacheClass
+////////////////////////////////////////////////////////////////////////////////
+class ShaderCacheClass
+{
+public:
+	struct StatsType
+	{
+		int hits, misses, stores;
+		int bytesMapped;
+		float mapTime;
+	};
+
+private:
+	// The file is a header, a table of entries and then the byte code of every entry.
+	struct FileHeaderType
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned int entryCount;
+		unsigned int padding;
+	};
+
+	struct FileEntryType
+	{
+		unsigned long long key;
+		unsigned int offset;
+		unsigned int size;
+	};
+
+	// Entries point either into the mapped file or at a copy owned by the cache.
+	struct EntryType
+	{
+		unsigned long long key;
+		const char* data;
+		int size;
+		bool owned;
+	};
+
+public:
+	ShaderCacheClass();
+	ShaderCacheClass(const ShaderCacheClass&);
+	~ShaderCacheClass();
+
+	bool Initialize(const char*);
+	void Shutdown();
+
+	bool Find(unsigned long long, const void*&, int&);
+	bool Store(unsigned long long, const void*, int);
+	bool Save();
+
+	void GetStats(StatsType&);
+
+	static unsigned long long HashShader(const char*, int, const char*, const char*, unsigned int);
+
+private:
+	bool MapFile();
+	void UnmapFile();
+	bool ReadEntries();
+	void ReleaseEntries();
+
+	static unsigned long long HashBytes(unsigned long long, const void*, int);
+
+private:
+	char m_filename[256];
+	const char* m_mappedData;
+	int m_mappedSize;
+	void* m_fileHandle;
+	void* m_mappingHandle;
+	std::vector<EntryType> m_entries;
+	bool m_dirty;
+	StatsType m_stats;
+};
+
+#endif
@@ -0,0 +1,845 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: softwaredeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "softwaredeviceclass.h"
+#include "profilerclass.h"
+#include <stdio.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Software resources live in system memory, textures are expanded to four
+// floats a texel when they are created or updated.
+////////////////////////////////////////////////////////////////////////////////
+class SoftwareBuffer : public RenderBuffer
+{
+public:
+	void Release()
+	{
+		delete [] data;
+		delete this;
+	}
+
+	char* data;
+	int byteWidth;
+};
+
+class SoftwareTexture : public RenderTexture
+{
+public:
+	void Release()
+	{
+		delete [] texture.texels;
+		delete this;
+	}
+
+	RasterTextureType texture;
+	RenderFormat format;
+};
+
+// The device runs the engine's own shaders, which it recognizes by their entry points.
+class SoftwareShader : public RenderProgram
+{
+public:
+	void Release()
+	{
+		delete this;
+	}
+
+	RasterShader shader;
+};
+
+class SoftwareInputLayout : public RenderInputLayout
+{
+public:
+	void Release()
+	{
+		delete this;
+	}
+
+	int positionOffset;
+	int texCoordOffset;
+	int colorOffset;
+};
+
+class SoftwareSampler : public RenderSampler
+{
+public:
+	void Release()
+	{
+		delete this;
+	}
+
+	bool wrap;
+};
+
+
+SoftwareDeviceClass::SoftwareDeviceClass()
+{
+	m_Rasterizer = 0;
+	m_vertexBuffer = 0;
+	m_vertexStride = 0;
+	m_indexBuffer = 0;
+	m_layout = 0;
+	m_vertexShader = 0;
+	m_pixelShader = 0;
+	m_vsConstantBuffer = 0;
+	m_psConstantBuffer = 0;
+	m_textures[0] = 0;
+	m_textures[1] = 0;
+	m_sampler = 0;
+	m_fenceValue = 0;
+}
+
+
+SoftwareDeviceClass::SoftwareDeviceClass(const SoftwareDeviceClass& other)
+{
+}
+
+
+SoftwareDeviceClass::~SoftwareDeviceClass()
+{
+}
+
+
+bool SoftwareDeviceClass::Initialize(int screenWidth, int screenHeight, float screenDepth, float screenNear)
+{
+	bool result;
+
+
+	m_screenWidth = screenWidth;
+	m_screenHeight = screenHeight;
+
+	// Create the rasterizer object.
+	m_Rasterizer = new RasterizerClass;
+	if(!m_Rasterizer)
+	{
+		return false;
+	}
+
+	// Initialize the rasterizer object.
+	result = m_Rasterizer->Initialize(screenWidth, screenHeight);
+	if(!result)
+	{
+		return false;
+	}
+
+	// The depth buffer starts on and blending off, the same as the hardware device.
+	m_depthEnable = true;
+	m_blendEnable = false;
+
+	// Create the same matrices the hardware device would.
+	InitializeMatrices(screenWidth, screenHeight, screenDepth, screenNear);
+
+	return true;
+}
+
+
+void SoftwareDeviceClass::Shutdown()
+{
+	// Release the rasterizer object.
+	if(m_Rasterizer)
+	{
+		m_Rasterizer->Shutdown();
+		delete m_Rasterizer;
+		m_Rasterizer = 0;
+	}
+
+	return;
+}
+
+
+void SoftwareDeviceClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	m_Rasterizer->BeginFrame(red, green, blue, alpha);
+	return;
+}
+
+
+void SoftwareDeviceClass::EndScene()
+{
+	PROFILE_ZONE("Rasterize");
+
+	// The frame is only rasterized once every draw has been submitted.
+	m_Rasterizer->EndFrame();
+	return;
+}
+
+
+void SoftwareDeviceClass::SetVSync(bool enabled)
+{
+	// The frame is copied to the window with GDI which has no vertical sync.
+	return;
+}
+
+
+void SoftwareDeviceClass::GetVideoCardInfo(char* cardName, int& memory)
+{
+	sprintf(cardName, "Software Rasterizer (%d threads)", m_Rasterizer->GetThreadCount());
+	memory = 0;
+	return;
+}
+
+
+void SoftwareDeviceClass::BindDepthState(bool enable)
+{
+	m_depthEnable = enable;
+	return;
+}
+
+
+void SoftwareDeviceClass::BindBlendState(bool enable)
+{
+	m_blendEnable = enable;
+	return;
+}
+
+
+RenderBuffer* SoftwareDeviceClass::CreateBuffer(RenderBufferType type, RenderUsage usage, int byteWidth, const void* data)
+{
+	SoftwareBuffer* buffer;
+
+
+	buffer = new SoftwareBuffer;
+	if(!buffer)
+	{
+		return 0;
+	}
+
+	buffer->byteWidth = byteWidth;
+	buffer->data = new char[byteWidth];
+	if(!buffer->data)
+	{
+		delete buffer;
+		return 0;
+	}
+
+	if(data)
+	{
+		memcpy(buffer->data, data, byteWidth);
+	}
+	else
+	{
+		memset(buffer->data, 0, byteWidth);
+	}
+
+	return buffer;
+}
+
+
+RenderTexture* SoftwareDeviceClass::CreateTexture(int width, int height, RenderFormat format, RenderUsage usage, const void* data, int pitch)
+{
+	SoftwareTexture* texture;
+	bool result;
+
+
+	texture = new SoftwareTexture;
+	if(!texture)
+	{
+		return 0;
+	}
+
+	texture->format = format;
+	texture->texture.width = width;
+	texture->texture.height = height;
+	texture->texture.texels = new float[width * height * 4];
+	if(!texture->texture.texels)
+	{
+		delete texture;
+		return 0;
+	}
+
+	// Expand the initial data to floats.
+	result = ConvertTexels(texture->texture.texels, width, height, format, data, pitch);
+	if(!result)
+	{
+		texture->Release();
+		return 0;
+	}
+
+	return texture;
+}
+
+
+RenderTexture* SoftwareDeviceClass::CreateTextureFromFile(const char* filename)
+{
+	// The only texture file the engine loads is the uncompressed font DDS.
+	return LoadDDS(filename);
+}
+
+
+RenderProgram* SoftwareDeviceClass::CreateVertexShader(const char* filename, const char* entryPoint)
+{
+	SoftwareShader* shader;
+
+
+	// Both vertex shaders are the same world, view, projection transform.
+	if((strcmp(entryPoint, "TerrainVertexShader") != 0) && (strcmp(entryPoint, "FontVertexShader") != 0))
+	{
+		return 0;
+	}
+
+	shader = new SoftwareShader;
+	if(!shader)
+	{
+		return 0;
+	}
+
+	// Only the pixel shader decides how a draw is shaded.
+	shader->shader = RASTER_SHADER_TERRAIN;
+
+	return shader;
+}
+
+
+RenderProgram* SoftwareDeviceClass::CreatePixelShader(const char* filename, const char* entryPoint)
+{
+	SoftwareShader* shader;
+	RasterShader type;
+
+
+	if(strcmp(entryPoint, "TerrainPixelShader") == 0)
+	{
+		type = RASTER_SHADER_TERRAIN;
+	}
+	else if(strcmp(entryPoint, "FontPixelShader") == 0)
+	{
+		type = RASTER_SHADER_FONT;
+	}
+	else
+	{
+		return 0;
+	}
+
+	shader = new SoftwareShader;
+	if(!shader)
+	{
+		return 0;
+	}
+
+	shader->shader = type;
+
+	return shader;
+}
+
+
+RenderInputLayout* SoftwareDeviceClass::CreateInputLayout(const RenderInputElementType* elements, int elementCount, RenderProgram* vertexShader)
+{
+	SoftwareInputLayout* layout;
+	int i;
+
+
+	layout = new SoftwareInputLayout;
+	if(!layout)
+	{
+		return 0;
+	}
+
+	// The vertex stage reads a position, one set of texture coordinates and an optional color.
+	layout->positionOffset = -1;
+	layout->texCoordOffset = -1;
+	layout->colorOffset = -1;
+
+	for(i=0; i<elementCount; i++)
+	{
+		if((strcmp(elements[i].semanticName, "POSITION") == 0) && (elements[i].format == RENDER_FORMAT_R32G32B32_FLOAT))
+		{
+			layout->positionOffset = elements[i].offset;
+		}
+
+		if((strcmp(elements[i].semanticName, "TEXCOORD") == 0) && (elements[i].semanticIndex == 0) && (elements[i].format == RENDER_FORMAT_R32G32_FLOAT))
+		{
+			layout->texCoordOffset = elements[i].offset;
+		}
+
+		if((strcmp(elements[i].semanticName, "COLOR") == 0) && (elements[i].semanticIndex == 0) && (elements[i].format == RENDER_FORMAT_R32G32B32A32_FLOAT))
+		{
+			layout->colorOffset = elements[i].offset;
+		}
+	}
+
+	if((layout->positionOffset < 0) || (layout->texCoordOffset < 0))
+	{
+		delete layout;
+		return 0;
+	}
+
+	return layout;
+}
+
+
+RenderSampler* SoftwareDeviceClass::CreateSampler(RenderAddressMode addressMode)
+{
+	SoftwareSampler* sampler;
+
+
+	sampler = new SoftwareSampler;
+	if(!sampler)
+	{
+		return 0;
+	}
+
+	sampler->wrap = (addressMode == RENDER_ADDRESS_WRAP);
+
+	return sampler;
+}
+
+
+void* SoftwareDeviceClass::LockBuffer(RenderBuffer* buffer, RenderMapMode mode)
+{
+	return ((SoftwareBuffer*)buffer)->data;
+}
+
+
+void SoftwareDeviceClass::UnlockBuffer(RenderBuffer* buffer)
+{
+	return;
+}
+
+
+void SoftwareDeviceClass::UpdateTexture(RenderTexture* texture, const void* data, int pitch)
+{
+	SoftwareTexture* softwareTexture;
+
+
+	softwareTexture = (SoftwareTexture*)texture;
+
+	ConvertTexels(softwareTexture->texture.texels, softwareTexture->texture.width, softwareTexture->texture.height, softwareTexture->format, data, pitch);
+
+	return;
+}
+
+
+void SoftwareDeviceClass::BindVertexBuffer(RenderBuffer* buffer, int stride)
+{
+	m_vertexBuffer = buffer;
+	m_vertexStride = stride;
+	return;
+}
+
+
+void SoftwareDeviceClass::BindIndexBuffer(RenderBuffer* buffer)
+{
+	m_indexBuffer = buffer;
+	return;
+}
+
+
+void SoftwareDeviceClass::BindInputLayout(RenderInputLayout* layout)
+{
+	m_layout = layout;
+	return;
+}
+
+
+void SoftwareDeviceClass::BindVertexShader(RenderProgram* shader)
+{
+	m_vertexShader = shader;
+	return;
+}
+
+
+void SoftwareDeviceClass::BindPixelShader(RenderProgram* shader)
+{
+	m_pixelShader = shader;
+	return;
+}
+
+
+void SoftwareDeviceClass::BindVSConstantBuffer(int slot, RenderBuffer* buffer)
+{
+	if(slot == 0)
+	{
+		m_vsConstantBuffer = buffer;
+	}
+
+	return;
+}
+
+
+void SoftwareDeviceClass::BindPSConstantBuffer(int slot, RenderBuffer* buffer)
+{
+	if(slot == 0)
+	{
+		m_psConstantBuffer = buffer;
+	}
+
+	return;
+}
+
+
+void SoftwareDeviceClass::BindPSTexture(int slot, RenderTexture* texture)
+{
+	if((slot >= 0) && (slot < 2))
+	{
+		m_textures[slot] = texture;
+	}
+
+	return;
+}
+
+
+void SoftwareDeviceClass::BindPSSampler(int slot, RenderSampler* sampler)
+{
+	if(slot == 0)
+	{
+		m_sampler = sampler;
+	}
+
+	return;
+}
+
+
+void SoftwareDeviceClass::DrawIndexed(int indexCount, int baseVertex)
+{
+	SoftwareBuffer* vertexBuffer;
+	SoftwareBuffer* indexBuffer;
+	SoftwareBuffer* vsConstants;
+	SoftwareBuffer* psConstants;
+	SoftwareInputLayout* layout;
+	RasterDrawType draw;
+	const Matrix* matrices;
+	const unsigned int* indices;
+	const char* vertexData;
+	const float* texCoord;
+	const float* color;
+	Matrix world, view, projection, transform;
+	unsigned int maxIndex;
+	int vertexCount, i;
+
+
+	if(!m_vertexBuffer || !m_indexBuffer || !m_layout || !m_vertexShader || !m_pixelShader || !m_vsConstantBuffer || (m_vertexStride <= 0))
+	{
+		return;
+	}
+
+	vertexBuffer = (SoftwareBuffer*)m_vertexBuffer;
+	indexBuffer = (SoftwareBuffer*)m_indexBuffer;
+	vsConstants = (SoftwareBuffer*)m_vsConstantBuffer;
+	psConstants = (SoftwareBuffer*)m_psConstantBuffer;
+	layout = (SoftwareInputLayout*)m_layout;
+
+	// The vertex constants are the transposed world, view and projection matrices.
+	if(vsConstants->byteWidth < (int)sizeof(float) * 48)
+	{
+		return;
+	}
+
+	matrices = (const Matrix*)vsConstants->data;
+
+	// Transpose them back and combine them into one row vector transform, world times view times projection.
+	MatrixTranspose(&world, &matrices[0]);
+	MatrixTranspose(&view, &matrices[1]);
+	MatrixTranspose(&projection, &matrices[2]);
+	MatrixMultiply(&transform, &world, &view);
+	MatrixMultiply(&transform, &transform, &projection);
+
+	if(indexCount > indexBuffer->byteWidth / (int)sizeof(unsigned int))
+	{
+		indexCount = indexBuffer->byteWidth / (int)sizeof(unsigned int);
+	}
+
+	// The vertex stage only runs over the vertices from the base vertex up to the highest one the indices use.
+	indices = (const unsigned int*)indexBuffer->data;
+	maxIndex = 0;
+	for(i=0; i<indexCount; i++)
+	{
+		if(indices[i] > maxIndex)
+		{
+			maxIndex = indices[i];
+		}
+	}
+
+	vertexCount = vertexBuffer->byteWidth / m_vertexStride - baseVertex;
+	if((indexCount == 0) || (baseVertex < 0) || ((int)maxIndex >= vertexCount))
+	{
+		return;
+	}
+
+	vertexCount = maxIndex + 1;
+	vertexData = vertexBuffer->data + (baseVertex * m_vertexStride);
+
+	if((int)m_vertices.size() < vertexCount)
+	{
+		m_vertices.resize(vertexCount);
+	}
+
+	if(vertexCount > 0)
+	{
+		Vec3TransformArray((Vector4*)&m_vertices[0].x, sizeof(RasterVertexType), (const Vector3*)(vertexData + layout->positionOffset), m_vertexStride,
+						   &transform, vertexCount);
+	}
+
+	for(i=0; i<vertexCount; i++)
+	{
+		texCoord = (const float*)(vertexData + i * m_vertexStride + layout->texCoordOffset);
+
+		m_vertices[i].u = texCoord[0];
+		m_vertices[i].v = texCoord[1];
+	}
+
+	// Vertices without a color are white.
+	for(i=0; i<vertexCount; i++)
+	{
+		if(layout->colorOffset >= 0)
+		{
+			color = (const float*)(vertexData + i * m_vertexStride + layout->colorOffset);
+			memcpy(m_vertices[i].color, color, sizeof(m_vertices[i].color));
+		}
+		else
+		{
+			m_vertices[i].color[0] = 1.0f;
+			m_vertices[i].color[1] = 1.0f;
+			m_vertices[i].color[2] = 1.0f;
+			m_vertices[i].color[3] = 1.0f;
+		}
+	}
+
+	// Capture the pixel stage state, the rasterizer keeps its own copy until the frame is finished.
+	draw.shader = ((SoftwareShader*)m_pixelShader)->shader;
+	draw.textures[0] = m_textures[0] ? &((SoftwareTexture*)m_textures[0])->texture : 0;
+	draw.textures[1] = m_textures[1] ? &((SoftwareTexture*)m_textures[1])->texture : 0;
+	draw.wrapAddress = m_sampler ? ((SoftwareSampler*)m_sampler)->wrap : false;
+	draw.depthEnable = m_depthEnable;
+	draw.blendEnable = m_blendEnable;
+
+	memset(draw.constants, 0, sizeof(draw.constants));
+	if(psConstants)
+	{
+		memcpy(draw.constants, psConstants->data, (psConstants->byteWidth < (int)sizeof(draw.constants)) ? psConstants->byteWidth : sizeof(draw.constants));
+	}
+
+	m_Rasterizer->AddDraw(draw, &m_vertices[0], vertexCount, indices, indexCount);
+
+	return;
+}
+
+
+unsigned long long SoftwareDeviceClass::InsertFence()
+{
+	// Every draw has copied what it needs out of the buffers by the time it returns, so every fence is already complete.
+	m_fenceValue++;
+	return m_fenceValue;
+}
+
+
+bool SoftwareDeviceClass::IsFenceComplete(unsigned long long fence)
+{
+	return true;
+}
+
+
+const unsigned char* SoftwareDeviceClass::GetFrameData()
+{
+	return m_Rasterizer->GetFrameData();
+}
+
+
+int SoftwareDeviceClass::GetFramePitch()
+{
+	return m_Rasterizer->GetFramePitch();
+}
+
+
+bool SoftwareDeviceClass::SaveFrame(const char* filename)
+{
+	return m_Rasterizer->SaveFrame(filename);
+}
+
+
+void SoftwareDeviceClass::SetThreadCount(int threadCount)
+{
+	m_Rasterizer->SetThreadCount(threadCount);
+	return;
+}
+
+
+int SoftwareDeviceClass::GetThreadCount()
+{
+	return m_Rasterizer->GetThreadCount();
+}
+
+
+void SoftwareDeviceClass::GetStats(RasterizerClass::StatsType& stats)
+{
+	m_Rasterizer->GetStats(stats);
+	return;
+}
+
+
+bool SoftwareDeviceClass::ConvertTexels(float* texels, int width, int height, RenderFormat format, const void* data, int pitch)
+{
+	const unsigned char* row;
+	float value;
+	int x, y;
+
+
+	if(!data)
+	{
+		memset(texels, 0, sizeof(float) * width * height * 4);
+		return true;
+	}
+
+	for(y=0; y<height; y++)
+	{
+		row = (const unsigned char*)data + y * pitch;
+
+		for(x=0; x<width; x++)
+		{
+			// Missing channels read as zero and a missing alpha as one, the same as the hardware.
+			texels[0] = 0.0f;
+			texels[1] = 0.0f;
+			texels[2] = 0.0f;
+			texels[3] = 1.0f;
+
+			switch(format)
+			{
+				case RENDER_FORMAT_R8G8_SNORM:
+					value = (float)((const signed char*)row)[x * 2] / 127.0f;
+					texels[0] = (value < -1.0f) ? -1.0f : value;
+					value = (float)((const signed char*)row)[x * 2 + 1] / 127.0f;
+					texels[1] = (value < -1.0f) ? -1.0f : value;
+					break;
+
+				case RENDER_FORMAT_R8G8_UNORM:
+					texels[0] = (float)row[x * 2] / 255.0f;
+					texels[1] = (float)row[x * 2 + 1] / 255.0f;
+					break;
+
+				case RENDER_FORMAT_R8G8B8A8_UNORM:
+					texels[0] = (float)row[x * 4] / 255.0f;
+					texels[1] = (float)row[x * 4 + 1] / 255.0f;
+					texels[2] = (float)row[x * 4 + 2] / 255.0f;
+					texels[3] = (float)row[x * 4 + 3] / 255.0f;
+					break;
+
+				case RENDER_FORMAT_R32G32_FLOAT:
+					memcpy(texels, row + x * 8, 8);
+					break;
+
+				case RENDER_FORMAT_R32G32B32_FLOAT:
+					memcpy(texels, row + x * 12, 12);
+					break;
+
+				case RENDER_FORMAT_R32G32B32A32_FLOAT:
+					memcpy(texels, row + x * 16, 16);
+					break;
+
+				default:
+					return false;
+			}
+
+			texels += 4;
+		}
+	}
+
+	return true;
+}
+
+
+RenderTexture* SoftwareDeviceClass::LoadDDS(const char* filename)
+{
+	FILE* filePtr;
+	unsigned char header[128];
+	unsigned int masks[4], shifts[4], maximums[4];
+	unsigned int flags, fourCC, bitCount, pixel;
+	unsigned char* image;
+	SoftwareTexture* texture;
+	float* texels;
+	int width, height, i, j, count;
+
+
+	// Open the texture file in binary.
+	filePtr = fopen(filename, "rb");
+	if(!filePtr)
+	{
+		return 0;
+	}
+
+	count = (int)fread(header, 1, sizeof(header), filePtr);
+	if((count != sizeof(header)) || (memcmp(header, "DDS ", 4) != 0))
+	{
+		fclose(filePtr);
+		return 0;
+	}
+
+	// Read the fields of the header that describe the top level image.
+	height = header[12] | (header[13] << 8) | (header[14] << 16) | (header[15] << 24);
+	width = header[16] | (header[17] << 8) | (header[18] << 16) | (header[19] << 24);
+	flags = header[80] | (header[81] << 8) | (header[82] << 16) | ((unsigned int)header[83] << 24);
+	fourCC = header[84] | (header[85] << 8) | (header[86] << 16) | ((unsigned int)header[87] << 24);
+	bitCount = header[88] | (header[89] << 8) | (header[90] << 16) | ((unsigned int)header[91] << 24);
+
+	for(i=0; i<4; i++)
+	{
+		masks[i] = header[92 + i * 4] | (header[93 + i * 4] << 8) | (header[94 + i * 4] << 16) | ((unsigned int)header[95 + i * 4] << 24);
+	}
+
+	// Only uncompressed 32 bit color is supported, which is what the font is saved as.
+	if(!(flags & 0x40) || (fourCC != 0) || (bitCount != 32) || (width <= 0) || (height <= 0))
+	{
+		fclose(filePtr);
+		return 0;
+	}
+
+	// Images without an alpha channel are opaque.
+	if(!(flags & 0x1))
+	{
+		masks[3] = 0;
+	}
+
+	for(i=0; i<4; i++)
+	{
+		shifts[i] = 0;
+		maximums[i] = 0;
+		if(masks[i])
+		{
+			while(!(masks[i] & (1u << shifts[i])))
+			{
+				shifts[i]++;
+			}
+			maximums[i] = masks[i] >> shifts[i];
+		}
+	}
+
+	image = new unsigned char[width * height * 4];
+	if(!image)
+	{
+		fclose(filePtr);
+		return 0;
+	}
+
+	count = (int)fread(image, 1, width * height * 4, filePtr);
+	fclose(filePtr);
+
+	if(count != width * height * 4)
+	{
+		delete [] image;
+		return 0;
+	}
+
+	texture = (SoftwareTexture*)CreateTexture(width, height, RENDER_FORMAT_R32G32B32A32_FLOAT, RENDER_USAGE_STATIC, 0, 0);
+	if(!texture)
+	{
+		delete [] image;
+		return 0;
+	}
+
+	// Pull each channel out through its mask.
+	texels = texture->texture.texels;
+
+	for(i=0; i<width * height; i++)
+	{
+		pixel = image[i * 4] | (image[i * 4 + 1] << 8) | (image[i * 4 + 2] << 16) | ((unsigned int)image[i * 4 + 3] << 24);
+
+		for(j=0; j<4; j++)
+		{
+			texels[i * 4 + j] = maximums[j] ? (float)((pixel & masks[j]) >> shifts[j]) / (float)maximums[j] : ((j == 3) ? 1.0f : 0.0f);
+		}
+	}
+
+	delete [] image;
+	image = 0;
+
+	return texture;
+}
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: softwaredeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SOFTWAREDEVICECLASS_H_
+#define _SOFTWAREDEVICECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+#include "rasterizerclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SoftwareDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+class SoftwareDeviceClass : public RenderDeviceClass
+{
+public:
+	SoftwareDeviceClass();
+	SoftwareDeviceClass(const SoftwareDeviceClass&);
+	~SoftwareDeviceClass();
+
+	bool Initialize(int, int, float, float);
+	void Shutdown();
+
+	void BeginScene(float, float, float, float);
+	void EndScene();
+	void SetVSync(bool);
+
+	void GetVideoCardInfo(char*, int&);
+
+	RenderBuffer* CreateBuffer(RenderBufferType, RenderUsage, int, const void*);
+	RenderTexture* CreateTexture(int, int, RenderFormat, RenderUsage, const void*, int);
+	RenderTexture* CreateTextureFromFile(const char*);
+	RenderProgram* CreateVertexShader(const char*, const char*);
+	RenderProgram* CreatePixelShader(const char*, const char*);
+	RenderInputLayout* CreateInputLayout(const RenderInputElementType*, int, RenderProgram*);
+	RenderSampler* CreateSampler(RenderAddressMode);
+
+	void UpdateTexture(RenderTexture*, const void*, int);
+	void DrawIndexed(int, int);
+
+	unsigned long long InsertFence();
+	bool IsFenceComplete(unsigned long long);
+
+	// The last finished frame, top down blue, green, red, alpha bytes.
+	const unsigned char* GetFrameData();
+	int GetFramePitch();
+	bool SaveFrame(const char*);
+
+	void SetThreadCount(int);
+	int GetThreadCount();
+	void GetStats(RasterizerClass::StatsType&);
+
+protected:
+	void BindDepthState(bool);
+	void BindBlendState(bool);
+	void* LockBuffer(RenderBuffer*, RenderMapMode);
+	void UnlockBuffer(RenderBuffer*);
+	void BindVertexBuffer(RenderBuffer*, int);
+	void BindIndexBuffer(RenderBuffer*);
+	void BindInputLayout(RenderInputLayout*);
+	void BindVertexShader(RenderProgram*);
+	void BindPixelShader(RenderProgram*);
+	void BindVSConstantBuffer(int, RenderBuffer*);
+	void BindPSConstantBuffer(int, RenderBuffer*);
+	void BindPSTexture(int, RenderTexture*);
+	void BindPSSampler(int, RenderSampler*);
+
+private:
+	bool ConvertTexels(float*, int, int, RenderFormat, const void*, int);
+	RenderTexture* LoadDDS(const char*);
+
+private:
+	RasterizerClass* m_Rasterizer;
+	int m_screenWidth, m_screenHeight;
+	bool m_depthEnable, m_blendEnable;
+
+	RenderBuffer* m_vertexBuffer;
+	int m_vertexStride;
+	RenderBuffer* m_indexBuffer;
+	RenderInputLayout* m_layout;
+	RenderProgram* m_vertexShader;
+	RenderProgram* m_pixelShader;
+	RenderBuffer* m_vsConstantBuffer;
+	RenderBuffer* m_psConstantBuffer;
+	RenderTexture* m_textures[2];
+	RenderSampler* m_sampler;
+	unsigned long long m_fenceValue;
+
+	std::vector<RasterVertexType> m_vertices;
+};
+
+#endif
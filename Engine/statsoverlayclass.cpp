@@ -0,0 +1,799 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statsoverlayclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "statsoverlayclass.h"
+#include "clockclass.h"
+#include <string.h>
+#include <math.h>
+
+
+StatsOverlayClass* StatsOverlayClass::m_instance = 0;
+
+static const long long STATS_SCALES[STATS_MAX_PRECISION + 1] = { 1, 10, 100, 1000, 10000 };
+
+
+StatsOverlayClass::StatsOverlayClass()
+{
+	int i;
+
+
+	m_screenWidth = 0;
+	m_screenHeight = 0;
+	m_metrics = 0;
+	m_metricCount = 0;
+	m_freeMetric = -1;
+	m_groupCount = 0;
+	m_layoutValid = false;
+
+	for(i=0; i<STATS_HASH_BUCKETS; i++)
+	{
+		m_buckets[i] = -1;
+	}
+
+	for(i=0; i<4; i++)
+	{
+		m_overlayMetrics[i] = -1;
+	}
+
+	memset(&m_stats, 0, sizeof(StatsType));
+}
+
+
+StatsOverlayClass::StatsOverlayClass(const StatsOverlayClass& other)
+{
+}
+
+
+StatsOverlayClass::~StatsOverlayClass()
+{
+}
+
+
+bool StatsOverlayClass::Initialize(int screenWidth, int screenHeight)
+{
+	// Store the screen size for laying the metrics out.
+	m_screenWidth = screenWidth;
+	m_screenHeight = screenHeight;
+
+	// Create the metric array.
+	m_metrics = new MetricType[STATS_MAX_METRICS];
+	if(!m_metrics)
+	{
+		return false;
+	}
+
+	memset(m_metrics, 0, sizeof(MetricType) * STATS_MAX_METRICS);
+
+	// Any subsystem created from here on can add metrics.
+	m_instance = this;
+
+	// The overlay shows what it costs itself.
+	m_overlayMetrics[0] = AddCounter("Overlay", "Metrics", "");
+	m_overlayMetrics[1] = AddCounter("Overlay", "Hidden", "");
+	m_overlayMetrics[2] = AddCounter("Overlay", "Lines", "/frame");
+	m_overlayMetrics[3] = AddGauge("Overlay", "Update", 3, "ms");
+
+	return true;
+}
+
+
+void StatsOverlayClass::Shutdown()
+{
+	// Stop taking metrics before the array goes.
+	if(m_instance == this)
+	{
+		m_instance = 0;
+	}
+
+	// Release the metric array, the sentences went with the text object.
+	if(m_metrics)
+	{
+		delete [] m_metrics;
+		m_metrics = 0;
+	}
+
+	return;
+}
+
+
+bool StatsOverlayClass::Frame(TextClass* text)
+{
+	StopwatchClass stopwatch;
+	char line[TEXT_SENTENCE_LENGTH + 1];
+	MetricType* metric;
+	GroupType* group;
+	int i;
+	bool result;
+
+
+	PROFILE_ZONE("Overlay");
+
+	m_stats.hiddenMetrics = 0;
+	m_stats.linesFormatted = 0;
+
+	// Place the metrics again only when some have been added or removed.
+	if(!m_layoutValid)
+	{
+		Layout();
+	}
+
+	// Draw the heading of each group that has moved, groups without a metric on screen have no heading.
+	for(i=0; i<m_groupCount; i++)
+	{
+		group = &m_groups[i];
+		if(!group->changed)
+		{
+			continue;
+		}
+
+		if(group->positionX < 0)
+		{
+			if(group->sentence >= 0)
+			{
+				text->ReleaseSentence(group->sentence);
+				group->sentence = -1;
+			}
+
+			group->changed = false;
+			continue;
+		}
+
+		if(group->sentence < 0)
+		{
+			group->sentence = text->CreateSentence();
+			if(group->sentence < 0)
+			{
+				continue;
+			}
+		}
+
+		result = text->UpdateSentence(group->sentence, group->name, group->positionX, group->positionY, 1.0f, 1.0f, 1.0f);
+		if(!result)
+		{
+			return false;
+		}
+
+		group->changed = false;
+		m_stats.linesFormatted++;
+	}
+
+	// Format only the metrics whose shown value, warning or position has changed.
+	for(i=0; i<m_metricCount; i++)
+	{
+		metric = &m_metrics[i];
+
+		// Give the sentence of a removed metric back to the pool.
+		if(!metric->inUse)
+		{
+			if(metric->sentence >= 0)
+			{
+				text->ReleaseSentence(metric->sentence);
+				metric->sentence = -1;
+			}
+			continue;
+		}
+
+		if(metric->positionX < 0)
+		{
+			m_stats.hiddenMetrics++;
+
+			if(metric->sentence >= 0)
+			{
+				text->ReleaseSentence(metric->sentence);
+				metric->sentence = -1;
+			}
+			continue;
+		}
+
+		if(!metric->changed)
+		{
+			continue;
+		}
+
+		// A metric that finds the text pool empty stays changed and tries again next frame.
+		if(metric->sentence < 0)
+		{
+			metric->sentence = text->CreateSentence();
+			if(metric->sentence < 0)
+			{
+				m_stats.hiddenMetrics++;
+				continue;
+			}
+		}
+
+		FormatMetric(*metric, line);
+
+		if(metric->warning)
+		{
+			result = text->UpdateSentence(metric->sentence, line, metric->positionX, metric->positionY, 1.0f, 0.0f, 0.0f);
+		}
+		else
+		{
+			result = text->UpdateSentence(metric->sentence, line, metric->positionX, metric->positionY, 0.0f, 1.0f, 0.0f);
+		}
+
+		if(!result)
+		{
+			return false;
+		}
+
+		metric->changed = false;
+		m_stats.linesFormatted++;
+	}
+
+	m_stats.updateTime = stopwatch.GetMilliseconds();
+
+	// Show the cost of this frame's update, it is formatted on the next one.
+	SetCounter(m_overlayMetrics[0], m_stats.metrics);
+	SetCounter(m_overlayMetrics[1], m_stats.hiddenMetrics);
+	SetCounter(m_overlayMetrics[2], m_stats.linesFormatted);
+	SetGauge(m_overlayMetrics[3], m_stats.updateTime);
+
+	return true;
+}
+
+
+void StatsOverlayClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+
+int StatsOverlayClass::AddCounter(const char* group, const char* name, const char* unit)
+{
+	if(!m_instance)
+	{
+		return -1;
+	}
+
+	return m_instance->AddMetric(group, name, STATS_METRIC_COUNTER, 0, unit);
+}
+
+
+int StatsOverlayClass::AddGauge(const char* group, const char* name, int precision, const char* unit)
+{
+	if(!m_instance)
+	{
+		return -1;
+	}
+
+	// Keep the precision inside the table of scales.
+	if(precision < 0)
+	{
+		precision = 0;
+	}
+
+	if(precision > STATS_MAX_PRECISION)
+	{
+		precision = STATS_MAX_PRECISION;
+	}
+
+	return m_instance->AddMetric(group, name, STATS_METRIC_GAUGE, precision, unit);
+}
+
+
+int StatsOverlayClass::AddLabel(const char* group, const char* name)
+{
+	if(!m_instance)
+	{
+		return -1;
+	}
+
+	return m_instance->AddMetric(group, name, STATS_METRIC_LABEL, 0, "");
+}
+
+
+void StatsOverlayClass::RemoveMetric(int handle)
+{
+	StatsOverlayClass* overlay;
+	MetricType* metric;
+	int* link;
+
+
+	overlay = m_instance;
+	if(!overlay || (handle < 0) || (handle >= overlay->m_metricCount) || !overlay->m_metrics[handle].inUse)
+	{
+		return;
+	}
+
+	metric = &overlay->m_metrics[handle];
+
+	// Unlink the metric from its hash bucket.
+	link = &overlay->m_buckets[metric->hash % STATS_HASH_BUCKETS];
+	while(*link != handle)
+	{
+		link = &overlay->m_metrics[*link].next;
+	}
+
+	*link = metric->next;
+
+	// Free the slot, its sentence is kept until the next frame gives it back or a new metric takes the slot over.
+	metric->inUse = false;
+	metric->next = overlay->m_freeMetric;
+	overlay->m_freeMetric = handle;
+
+	overlay->m_groups[metric->group].metricCount--;
+	overlay->m_stats.metrics--;
+	overlay->m_layoutValid = false;
+
+	return;
+}
+
+
+void StatsOverlayClass::SetCounter(int handle, int value)
+{
+	MetricType* metric;
+
+
+	if(!m_instance || (handle < 0))
+	{
+		return;
+	}
+
+	metric = &m_instance->m_metrics[handle];
+	if(metric->value != value)
+	{
+		metric->value = value;
+		metric->changed = true;
+	}
+
+	return;
+}
+
+
+void StatsOverlayClass::SetGauge(int handle, float value)
+{
+	MetricType* metric;
+	double scaled;
+	long long shown;
+
+
+	if(!m_instance || (handle < 0))
+	{
+		return;
+	}
+
+	metric = &m_instance->m_metrics[handle];
+
+	// Round to the shown precision, clamped so the conversion cannot overflow and with anything that is not a number as zero.
+	scaled = (double)value * (double)STATS_SCALES[metric->precision];
+	if(!(scaled == scaled))
+	{
+		scaled = 0.0;
+	}
+
+	if(scaled > 1.0e15) { scaled = 1.0e15; }
+	if(scaled < -1.0e15) { scaled = -1.0e15; }
+
+	shown = (long long)floor(scaled + 0.5);
+	if(metric->value != shown)
+	{
+		metric->value = shown;
+		metric->changed = true;
+	}
+
+	return;
+}
+
+
+void StatsOverlayClass::SetLabel(int handle, const char* label)
+{
+	MetricType* metric;
+
+
+	if(!m_instance || (handle < 0))
+	{
+		return;
+	}
+
+	metric = &m_instance->m_metrics[handle];
+	if(strncmp(metric->label, label, STATS_LABEL_LENGTH - 1) != 0)
+	{
+		CopyName(metric->label, label, STATS_LABEL_LENGTH);
+		metric->changed = true;
+	}
+
+	return;
+}
+
+
+void StatsOverlayClass::SetWarning(int handle, bool warning)
+{
+	MetricType* metric;
+
+
+	if(!m_instance || (handle < 0))
+	{
+		return;
+	}
+
+	metric = &m_instance->m_metrics[handle];
+	if(metric->warning != warning)
+	{
+		metric->warning = warning;
+		metric->changed = true;
+	}
+
+	return;
+}
+
+
+int StatsOverlayClass::AddMetric(const char* groupName, const char* name, StatsMetricKind kind, int precision, const char* unit)
+{
+	MetricType* metric;
+	char shortName[STATS_NAME_LENGTH];
+	unsigned int hash;
+	int group, bucket, handle, sentence;
+
+
+	// Find the group the metric goes in.
+	group = AddGroup(groupName);
+	if(group < 0)
+	{
+		return -1;
+	}
+
+	// Names longer than the metric keeps are cut short, so look for the shortened name.
+	CopyName(shortName, name, STATS_NAME_LENGTH);
+	hash = HashName(shortName) ^ ((unsigned int)group * 0x9E3779B9u);
+	bucket = hash % STATS_HASH_BUCKETS;
+
+	// Return the metric if it already exists.
+	for(handle=m_buckets[bucket]; handle>=0; handle=m_metrics[handle].next)
+	{
+		if((m_metrics[handle].hash == hash) && (m_metrics[handle].group == group) && (strcmp(m_metrics[handle].name, shortName) == 0))
+		{
+			return handle;
+		}
+	}
+
+	// Take a free slot, or a new one off the end of the array.
+	if(m_freeMetric >= 0)
+	{
+		handle = m_freeMetric;
+		m_freeMetric = m_metrics[handle].next;
+	}
+	else if(m_metricCount < STATS_MAX_METRICS)
+	{
+		handle = m_metricCount;
+		m_metrics[handle].sentence = -1;
+		m_metricCount++;
+	}
+	else
+	{
+		return -1;
+	}
+
+	// Set the metric up, a slot taken over from a removed metric keeps its sentence.
+	metric = &m_metrics[handle];
+	sentence = metric->sentence;
+	memset(metric, 0, sizeof(MetricType));
+
+	metric->inUse = true;
+	metric->changed = true;
+	metric->kind = kind;
+	strcpy(metric->name, shortName);
+	metric->hash = hash;
+	metric->group = group;
+	metric->precision = precision;
+	metric->unit = unit ? unit : "";
+	metric->sentence = sentence;
+	metric->positionX = -1;
+	metric->positionY = -1;
+
+	// Link it into its hash bucket.
+	metric->next = m_buckets[bucket];
+	m_buckets[bucket] = handle;
+
+	m_groups[group].metricCount++;
+	m_stats.metrics++;
+	m_layoutValid = false;
+
+	return handle;
+}
+
+
+int StatsOverlayClass::AddGroup(const char* name)
+{
+	GroupType* group;
+	char shortName[STATS_NAME_LENGTH];
+	unsigned int hash;
+	int i;
+
+
+	CopyName(shortName, name, STATS_NAME_LENGTH);
+	hash = HashName(shortName);
+
+	// Groups are shown in the order they were first added and are never removed.
+	for(i=0; i<m_groupCount; i++)
+	{
+		if((m_groups[i].hash == hash) && (strcmp(m_groups[i].name, shortName) == 0))
+		{
+			return i;
+		}
+	}
+
+	if(m_groupCount >= STATS_MAX_GROUPS)
+	{
+		return -1;
+	}
+
+	group = &m_groups[m_groupCount];
+	strcpy(group->name, shortName);
+	group->hash = hash;
+	group->metricCount = 0;
+	group->changed = true;
+	group->sentence = -1;
+	group->positionX = -1;
+	group->positionY = -1;
+
+	m_groupCount++;
+
+	return m_groupCount - 1;
+}
+
+
+void StatsOverlayClass::Layout()
+{
+	MetricType* metric;
+	GroupType* group;
+	int linesPerColumn, column, line, columns, i, j, positionX, positionY;
+
+
+	// Fill columns down the screen from the left, a group starts a new column if its heading and first metric do not fit.
+	linesPerColumn = (m_screenHeight - (STATS_MARGIN * 2)) / STATS_LINE_HEIGHT;
+	columns = (m_screenWidth - STATS_MARGIN) / STATS_COLUMN_WIDTH;
+	column = 0;
+	line = 0;
+
+	for(i=0; i<m_groupCount; i++)
+	{
+		group = &m_groups[i];
+
+		// Anything past the last column is hidden.
+		positionX = -1;
+		positionY = -1;
+
+		if(group->metricCount > 0)
+		{
+			if(line + 2 > linesPerColumn)
+			{
+				column++;
+				line = 0;
+			}
+
+			if(column < columns)
+			{
+				positionX = STATS_MARGIN + (column * STATS_COLUMN_WIDTH);
+				positionY = STATS_MARGIN + (line * STATS_LINE_HEIGHT);
+				line++;
+			}
+		}
+
+		if((group->positionX != positionX) || (group->positionY != positionY))
+		{
+			group->positionX = positionX;
+			group->positionY = positionY;
+			group->changed = true;
+		}
+
+		if(positionX < 0)
+		{
+			// The group's metrics are hidden with it.
+			for(j=0; j<m_metricCount; j++)
+			{
+				if(m_metrics[j].inUse && (m_metrics[j].group == i))
+				{
+					m_metrics[j].positionX = -1;
+					m_metrics[j].positionY = -1;
+				}
+			}
+			continue;
+		}
+
+		// Place the group's metrics under its heading, indented a little.
+		for(j=0; j<m_metricCount; j++)
+		{
+			metric = &m_metrics[j];
+			if(!metric->inUse || (metric->group != i))
+			{
+				continue;
+			}
+
+			if(line >= linesPerColumn)
+			{
+				column++;
+				line = 0;
+			}
+
+			positionX = -1;
+			positionY = -1;
+			if(column < columns)
+			{
+				positionX = STATS_MARGIN + (column * STATS_COLUMN_WIDTH) + 10;
+				positionY = STATS_MARGIN + (line * STATS_LINE_HEIGHT);
+				line++;
+			}
+
+			if((metric->positionX != positionX) || (metric->positionY != positionY))
+			{
+				metric->positionX = positionX;
+				metric->positionY = positionY;
+				metric->changed = true;
+			}
+		}
+
+		// Leave a gap before the next group.
+		line++;
+	}
+
+	m_layoutValid = true;
+
+	return;
+}
+
+
+int StatsOverlayClass::FormatMetric(const MetricType& metric, char* line)
+{
+	int length;
+
+
+	// Build the line as the name, the value and the unit, cutting it short if it is longer than a sentence.
+	length = 0;
+	line[0] = 0;
+
+	length = AppendString(line, length, metric.name);
+	length = AppendString(line, length, ": ");
+
+	switch(metric.kind)
+	{
+		case STATS_METRIC_COUNTER:
+			length = AppendInteger(line, length, metric.value);
+			break;
+
+		case STATS_METRIC_GAUGE:
+			length = AppendFixed(line, length, metric.value, metric.precision);
+			break;
+
+		case STATS_METRIC_LABEL:
+			length = AppendString(line, length, metric.label);
+			break;
+	}
+
+	if(metric.unit[0])
+	{
+		length = AppendString(line, length, metric.unit);
+	}
+
+	return length;
+}
+
+
+unsigned int StatsOverlayClass::HashName(const char* name)
+{
+	unsigned int hash;
+
+
+	// FNV-1a over the characters of the name.
+	hash = 2166136261u;
+	while(*name)
+	{
+		hash ^= (unsigned char)*name;
+		hash *= 16777619u;
+		name++;
+	}
+
+	return hash;
+}
+
+
+void StatsOverlayClass::CopyName(char* destination, const char* source, int size)
+{
+	int i;
+
+
+	for(i=0; (i<size - 1) && source[i]; i++)
+	{
+		destination[i] = source[i];
+	}
+
+	destination[i] = 0;
+
+	return;
+}
+
+
+int StatsOverlayClass::AppendString(char* line, int length, const char* text)
+{
+	// Copy as much of the text as there is room for in a sentence.
+	while(*text && (length < TEXT_SENTENCE_LENGTH))
+	{
+		line[length] = *text;
+		length++;
+		text++;
+	}
+
+	line[length] = 0;
+
+	return length;
+}
+
+
+int StatsOverlayClass::AppendInteger(char* line, int length, long long value)
+{
+	char digits[24];
+	unsigned long long magnitude;
+	int count;
+
+
+	// Write the digits out backwards, working on the magnitude so the most negative value still works.
+	magnitude = (value < 0) ? (0ull - (unsigned long long)value) : (unsigned long long)value;
+	count = 0;
+	do
+	{
+		digits[count] = (char)('0' + (magnitude % 10));
+		magnitude /= 10;
+		count++;
+	}
+	while(magnitude > 0);
+
+	if(value < 0)
+	{
+		digits[count] = '-';
+		count++;
+	}
+
+	while((count > 0) && (length < TEXT_SENTENCE_LENGTH))
+	{
+		count--;
+		line[length] = digits[count];
+		length++;
+	}
+
+	line[length] = 0;
+
+	return length;
+}
+
+
+int StatsOverlayClass::AppendFixed(char* line, int length, long long value, int precision)
+{
+	unsigned long long magnitude, fraction;
+	int i;
+
+
+	if(precision == 0)
+	{
+		return AppendInteger(line, length, value);
+	}
+
+	// The value is already scaled by the precision, so split it into the whole part and the digits after the point.
+	magnitude = (value < 0) ? (0ull - (unsigned long long)value) : (unsigned long long)value;
+	fraction = magnitude % (unsigned long long)STATS_SCALES[precision];
+
+	if((value < 0) && (length < TEXT_SENTENCE_LENGTH))
+	{
+		line[length] = '-';
+		length++;
+	}
+
+	length = AppendInteger(line, length, (long long)(magnitude / (unsigned long long)STATS_SCALES[precision]));
+
+	if(length < TEXT_SENTENCE_LENGTH)
+	{
+		line[length] = '.';
+		length++;
+	}
+
+	// Write the fraction with its leading zeros.
+	for(i=precision - 1; (i>=0) && (length<TEXT_SENTENCE_LENGTH); i--)
+	{
+		line[length] = (char)('0' + ((fraction / (unsigned long long)STATS_SCALES[i]) % 10));
+		length++;
+	}
+
+	line[length] = 0;
+
+	return length;
+}
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statsoverlayclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _STATSOVERLAYCLASS_H_
+#define _STATSOVERLAYCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int STATS_MAX_METRICS = 448;
+const int STATS_MAX_GROUPS = 32;
+const int STATS_HASH_BUCKETS = 256;
+const int STATS_NAME_LENGTH = 24;
+const int STATS_LABEL_LENGTH = 32;
+const int STATS_MAX_PRECISION = 4;
+const int STATS_COLUMN_WIDTH = 260;
+const int STATS_LINE_HEIGHT = 20;
+const int STATS_MARGIN = 10;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "textclass.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+enum StatsMetricKind
+{
+	STATS_METRIC_COUNTER,
+	STATS_METRIC_GAUGE,
+	STATS_METRIC_LABEL
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: StatsOverlayClass
+////////////////////////////////////////////////////////////////////////////////
+class StatsOverlayClass
+{
+private:
+	// Counters and gauges keep the value as it will be shown, a gauge is scaled by its precision, so a new value that
+	// would look the same on screen is not formatted again.
+	struct MetricType
+	{
+		bool inUse, changed, warning;
+		StatsMetricKind kind;
+		char name[STATS_NAME_LENGTH];
+		unsigned int hash;
+		int group, next;
+		int precision;
+		const char* unit;
+		long long value;
+		char label[STATS_LABEL_LENGTH];
+		int sentence;
+		int positionX, positionY;
+	};
+
+	struct GroupType
+	{
+		char name[STATS_NAME_LENGTH];
+		unsigned int hash;
+		int metricCount;
+		bool changed;
+		int sentence;
+		int positionX, positionY;
+	};
+
+public:
+	// Counts for the last frame, the hidden metrics are the ones that did not fit on the screen or in the text pool.
+	struct StatsType
+	{
+		int metrics, hiddenMetrics;
+		int linesFormatted;
+		float updateTime;
+	};
+
+public:
+	StatsOverlayClass();
+	StatsOverlayClass(const StatsOverlayClass&);
+	~StatsOverlayClass();
+
+	bool Initialize(int, int);
+	void Shutdown();
+	bool Frame(TextClass*);
+	void GetStats(StatsType&);
+
+	// Metrics are found by group and name, adding one that already exists returns it again so a subsystem can look
+	// metrics up by name every frame.  The unit must outlive the metric, such as a string literal.  Everything here
+	// is not thread-safe, callers serialize through the frame graph by writing its overlay metrics resource or run
+	// on the main thread outside it.  A handle of -1, from an overlay that does not exist or is full, is ignored.
+	static int AddCounter(const char*, const char*, const char*);
+	static int AddGauge(const char*, const char*, int, const char*);
+	static int AddLabel(const char*, const char*);
+	static void RemoveMetric(int);
+
+	static void SetCounter(int, int);
+	static void SetGauge(int, float);
+	static void SetLabel(int, const char*);
+	static void SetWarning(int, bool);
+
+private:
+	int AddMetric(const char*, const char*, StatsMetricKind, int, const char*);
+	int AddGroup(const char*);
+	void Layout();
+	int FormatMetric(const MetricType&, char*);
+
+	static unsigned int HashName(const char*);
+	static void CopyName(char*, const char*, int);
+	static int AppendString(char*, int, const char*);
+	static int AppendInteger(char*, int, long long);
+	static int AppendFixed(char*, int, long long, int);
+
+private:
+	static StatsOverlayClass* m_instance;
+
+	int m_screenWidth, m_screenHeight;
+	MetricType* m_metrics;
+	int m_metricCount;
+	int m_freeMetric;
+	int m_buckets[STATS_HASH_BUCKETS];
+	GroupType m_groups[STATS_MAX_GROUPS];
+	int m_groupCount;
+	bool m_layoutValid;
+	int m_overlayMetrics[4];
+	StatsType m_stats;
+};
+
+#endif
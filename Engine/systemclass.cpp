@@ -7,6 +7,15 @@
 SystemClass::SystemClass()
 {
 	m_Application = 0;
+	m_Input = 0;
+	m_hwnd = NULL;
+	m_screenWidth = 0;
+	m_screenHeight = 0;
+	m_windowThreadId = 0;
+	m_running = false;
+	m_quit = false;
+	m_started = false;
+	m_startResult = false;
 }
 
 
@@ -22,16 +31,29 @@ SystemClass::~SystemClass()
 
 bool SystemClass::Initialize()
 {
-	int screenWidth, screenHeight;
 	bool result;
 
 
-	// Initialize the width and height of the screen to zero before sending the variables into the function.
-	screenWidth = 0;
-	screenHeight = 0;
+	// Start the window thread, it creates the window and the input object.
+	m_running = true;
+	m_quit = false;
+	m_started = false;
+	m_windowThread = std::thread(&SystemClass::WindowThread, this);
+
+	// Wait until the window is up before anything is created for it.
+	{
+		std::unique_lock<std::mutex> lock(m_startMutex);
+
+		while(!m_started)
+		{
+			m_startCondition.wait(lock);
+		}
+	}
 
-	// Initialize the windows api.
-	InitializeWindows(screenWidth, screenHeight);
+	if(!m_startResult)
+	{
+		return false;
+	}
 
 	// Create the application wrapper object.
 	m_Application = new ApplicationClass;
@@ -41,7 +63,7 @@ bool SystemClass::Initialize()
 	}
 
 	// Initialize the application wrapper object.
-	result = m_Application->Initialize(m_hinstance, m_hwnd, screenWidth, screenHeight);
+	result = m_Application->Initialize(m_hwnd, m_Input, m_screenWidth, m_screenHeight);
 	if(!result)
 	{
 		return false;
@@ -61,8 +83,14 @@ void SystemClass::Shutdown()
 		m_Application = 0;
 	}
 
-	// Shutdown the window.
-	ShutdownWindows();
+	// Stop the window thread, it releases the input object and the window before it ends.
+	if(m_windowThread.joinable())
+	{
+		m_running = false;
+		PostThreadMessage(m_windowThreadId, WM_NULL, 0, 0);
+
+		m_windowThread.join();
+	}
 	
 	return;
 }
@@ -70,26 +98,15 @@ void SystemClass::Shutdown()
 
 void SystemClass::Run()
 {
-	MSG msg;
 	bool done, result;
 
 
-	// Initialize the message structure.
-	ZeroMemory(&msg, sizeof(MSG));
-	
-	// Loop until there is a quit message from the window or the user.
+	// Loop until there is a quit message from the window or the user, the messages are handled on the window thread.
 	done = false;
 	while(!done)
 	{
-		// Handle the windows messages.
-		if(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
-		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-		}
-
 		// If windows signals to end the application then exit out.
-		if(msg.message == WM_QUIT)
+		if(m_quit.load())
 		{
 			done = true;
 		}
@@ -125,6 +142,86 @@ bool SystemClass::Frame()
 }
 
 
+void SystemClass::WindowThread()
+{
+	MSG msg;
+	bool result, sampling;
+
+
+	// Windows hands a window's messages to the thread that created it, so the window is created here.
+	InitializeWindows(m_screenWidth, m_screenHeight);
+	m_windowThreadId = GetCurrentThreadId();
+
+	// Create the input object.  The input object will be used to handle reading the keyboard and mouse input from the user.
+	m_Input = new InputClass;
+	result = (m_Input != 0);
+
+	// Initialize the input object, the devices are read from this thread from now on.
+	if(result)
+	{
+		result = m_Input->Initialize(m_hinstance, m_hwnd, m_screenWidth, m_screenHeight);
+		if(!result)
+		{
+			MessageBox(m_hwnd, L"Could not initialize the input object.", L"Error", MB_OK);
+		}
+	}
+
+	// Let the main thread go on.
+	{
+		std::lock_guard<std::mutex> lock(m_startMutex);
+
+		m_started = true;
+		m_startResult = result;
+	}
+	m_startCondition.notify_all();
+
+	// Keep the window responding until the application is shut down, even after a quit message or a failed read, since
+	// the device presents to it until then.
+	sampling = result;
+	while(m_running.load())
+	{
+		// Handle every waiting message rather than one a frame, so a burst of messages can not back up.
+		while(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+		{
+			if(msg.message == WM_QUIT)
+			{
+				m_quit = true;
+			}
+
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+		}
+
+		// Sample the keyboard and mouse and publish what changed to the frame.
+		if(sampling)
+		{
+			result = m_Input->Sample();
+			if(!result)
+			{
+				m_quit = true;
+				sampling = false;
+			}
+		}
+
+		// Sleep until a message arrives or the next sample is due.
+		MsgWaitForMultipleObjects(0, NULL, FALSE, INPUT_SAMPLE_INTERVAL, QS_ALLINPUT);
+	}
+
+	// Release the input object.
+	if(m_Input)
+	{
+		m_Input->Shutdown();
+		delete m_Input;
+		m_Input = 0;
+	}
+
+	// Shutdown the window.
+	ShutdownWindows();
+
+	return;
+}
+
+
 LRESULT CALLBACK SystemClass::MessageHandler(HWND hwnd, UINT umsg, WPARAM wparam, LPARAM lparam)
 {
 	return DefWindowProc(hwnd, umsg, wparam, lparam);
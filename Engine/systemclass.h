@@ -15,6 +15,10 @@
 // INCLUDES //
 //////////////
 #include <windows.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 
 ///////////////////////
@@ -43,12 +47,24 @@ private:
 	bool Frame();
 	void InitializeWindows(int&, int&);
 	void ShutdownWindows();
+	void WindowThread();
 
 private:
 	LPCWSTR m_applicationName;
 	HINSTANCE m_hinstance;
 	HWND m_hwnd;
+	int m_screenWidth, m_screenHeight;
 	ApplicationClass* m_Application;
+	InputClass* m_Input;
+
+	// The window is created, its messages handled and the input sampled on a thread of its own, so a burst of
+	// messages never holds up a frame and input is seen between frames.
+	std::thread m_windowThread;
+	DWORD m_windowThreadId;
+	std::atomic<bool> m_running, m_quit;
+	std::mutex m_startMutex;
+	std::condition_variable m_startCondition;
+	bool m_started, m_startResult;
 };
 
 
@@ -62,6 +78,7 @@ static LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 // GLOBALS //
 /////////////
 static SystemClass* ApplicationHandle = 0;
+const int INPUT_SAMPLE_INTERVAL = 1;
 
 
 #endif
\ No newline at end of file
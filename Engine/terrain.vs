@@ -20,13 +20,13 @@ cbuffer MatrixBuffer
 struct VertexInputType
 {
     float4 position : POSITION;
-	float3 normal : NORMAL;
+	float2 tex : TEXCOORD0;
 };
 
 struct PixelInputType
 {
     float4 position : SV_POSITION;
-	float3 normal : NORMAL;
+	float2 tex : TEXCOORD0;
 };
 
 
@@ -46,11 +46,8 @@ PixelInputType TerrainVertexShader(VertexInputType input)
     output.position = mul(output.position, viewMatrix);
     output.position = mul(output.position, projectionMatrix);
     
-	// Calculate the normal vector against the world matrix only.
-    output.normal = mul(input.normal, (float3x3)worldMatrix);
-	
-    // Normalize the normal vector.
-    output.normal = normalize(output.normal);
+	// Store the normal map texture coordinates for the pixel shader.
+	output.tex = input.tex;
 
     return output;
 }
\ No newline at end of file
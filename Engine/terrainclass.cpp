@@ -2,15 +2,35 @@
 // Filename: terrainclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "terrainclass.h"
+#include "profilerclass.h"
+#include "statsoverlayclass.h"
+#include "clockclass.h"
+#include "jobsystemclass.h"
 #include <cmath>
+#include <stdio.h>
 
 
 TerrainClass::TerrainClass()
 {
 	m_vertexBuffer = 0;
 	m_indexBuffer = 0;
+	m_vertexCount = 0;
+	m_indexCount = 0;
+	m_meshBytes = 0;
+	m_meshTime = 0.0f;
 	m_heightMap = 0;
-	m_terrainGeneratedToggle = false;
+	m_NormalMap = 0;
+	m_normalTexture = 0;
+	m_LightMap = 0;
+	m_lightTexture = 0;
+	m_lightMapDirty = false;
+	m_meshDirty = false;
+	m_lightTextureDirty = false;
+
+	for(int i=0; i<TERRAIN_METRICS; i++)
+	{
+		m_metrics[i] = -1;
+	}
 }
 
 
@@ -23,7 +43,7 @@ TerrainClass::~TerrainClass()
 {
 }
 
-bool TerrainClass::InitializeTerrain(ID3D11Device* device, int terrainWidth, int terrainHeight)
+bool TerrainClass::InitializeTerrain(RenderDeviceClass* device, int terrainWidth, int terrainHeight)
 {
 	int index;
 	float height = 0.0;
@@ -56,8 +76,15 @@ bool TerrainClass::InitializeTerrain(ID3D11Device* device, int terrainWidth, int
 
 
 	//even though we are generating a flat terrain, we still need to normalise it. 
-	// Calculate the normals for the terrain data.
-	result = CalculateNormals();
+	// Bake the normal map for the terrain data.
+	result = InitializeNormalMap(device);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Create the ambient occlusion and shadow light map, it is baked on the first update.
+	result = InitializeLightMap(device);
 	if(!result)
 	{
 		return false;
@@ -70,9 +97,12 @@ bool TerrainClass::InitializeTerrain(ID3D11Device* device, int terrainWidth, int
 		return false;
 	}
 
+	// Show the size of the terrain and its bake times in the stats overlay.
+	UpdateMetrics();
+
 	return true;
 }
-bool TerrainClass::Initialize(ID3D11Device* device, char* heightMapFilename)
+bool TerrainClass::Initialize(RenderDeviceClass* device, char* heightMapFilename)
 {
 	bool result;
 
@@ -87,8 +117,15 @@ bool TerrainClass::Initialize(ID3D11Device* device, char* heightMapFilename)
 	// Normalize the height of the height map.
 	NormalizeHeightMap();
 
-	// Calculate the normals for the terrain data.
-	result = CalculateNormals();
+	// Bake the normal map for the terrain data.
+	result = InitializeNormalMap(device);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Create the ambient occlusion and shadow light map, it is baked on the first update.
+	result = InitializeLightMap(device);
 	if(!result)
 	{
 		return false;
@@ -101,15 +138,31 @@ bool TerrainClass::Initialize(ID3D11Device* device, char* heightMapFilename)
 		return false;
 	}
 
+	// Show the size of the terrain and its bake times in the stats overlay.
+	UpdateMetrics();
+
 	return true;
 }
 
 
 void TerrainClass::Shutdown()
 {
+	// Take the terrain's metrics off the overlay.
+	for(int i=0; i<TERRAIN_METRICS; i++)
+	{
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
+	}
+
 	// Release the vertex and index buffer.
 	ShutdownBuffers();
 
+	// Release the light map.
+	ShutdownLightMap();
+
+	// Release the normal map.
+	ShutdownNormalMap();
+
 	// Release the height map data.
 	ShutdownHeightMap();
 
@@ -117,10 +170,10 @@ void TerrainClass::Shutdown()
 }
 
 
-void TerrainClass::Render(ID3D11DeviceContext* deviceContext)
+void TerrainClass::Render(DrawPacketType& packet)
 {
-	// Put the vertex and index buffers on the graphics pipeline to prepare them for drawing.
-	RenderBuffers(deviceContext);
+	// Put the vertex and index buffers in the draw packet to prepare them for drawing.
+	RenderBuffers(packet);
 
 	return;
 }
@@ -131,130 +184,227 @@ int TerrainClass::GetIndexCount()
 	return m_indexCount;
 }
 
-bool TerrainClass::GenerateHeightMap(ID3D11Device* device, bool keydown)
+
+int TerrainClass::GetMeshBytes()
 {
+	return m_meshBytes;
+}
+
+
+float TerrainClass::GetMeshTime()
+{
+	return m_meshTime;
+}
+
 
+RenderTexture* TerrainClass::GetNormalMap()
+{
+	return m_normalTexture;
+}
+
+
+bool TerrainClass::UpdateLightMap(Vector3 lightDirection)
+{
 	bool result;
-	//the toggle is just a bool that I use to make sure this is only called ONCE when you press a key
-	//until you release the key and start again. We dont want to be generating the terrain 500
-	//times per second. 
-	if(keydown&&(!m_terrainGeneratedToggle))
+
+
+	PROFILE_ZONE("Light Map");
+
+	// Nothing needs baking if neither the heights nor the light direction have changed.
+	if(!m_lightMapDirty && !m_LightMap->HasLightChanged(lightDirection.x, lightDirection.y, lightDirection.z))
 	{
-		int index;
-		float height = 0.0;
-		
+		return true;
+	}
 
-		//MidPoint();
-		/*for(int j=0; j<m_terrainHeight; j++)
+	// Ambient occlusion only depends on the heights so only bake it again when they have changed.
+	if(m_lightMapDirty)
+	{
+		result = m_LightMap->BakeOcclusion(m_NormalMap->GetHeightData(), m_NormalMap->GetHeightPitch());
+		if(!result)
 		{
-			for(int i=0; i<m_terrainWidth; i++)
-			{			
-				index = (m_terrainHeight * j) + i;
+			return false;
+		}
+	}
 
-				m_heightMap[index].x = (float)i;
-				m_heightMap[index].y=  i;
-				m_heightMap[index].z = (float)j;
-			}
-		}*/
+	// Sweep the shadows along the new light direction.
+	result = m_LightMap->BakeShadows(m_NormalMap->GetHeightData(), m_NormalMap->GetHeightPitch(), lightDirection.x, lightDirection.y, lightDirection.z);
+	if(!result)
+	{
+		return false;
+	}
 
+	// The texture is updated with the rest of the changes in Upload.
+	m_lightMapDirty = false;
+	m_lightTextureDirty = true;
 
-		
-		//GenerateRandomHeightMap();
+	return true;
+}
 
-		//loop through the terrain and set the hieghts how we want. This is where we generate the terrain
-		//in this case I will run a sin-wave through the terrain in one axis.
-		float sinValue = (rand()%12)+1;
-		float cosValue = (((float(rand()%200))/10)-10);
-		float sinMulti = (((float(rand()%100))/10)-5);
-		float cosMulti = (((float(rand()%50))/10)-2.5);
-		if(cosValue == 0)	cosValue = 1;
- 		for(int j=0; j<m_terrainHeight; j++)
-		{
-			for(int i=0; i<m_terrainWidth; i++)
-			{			
-				index = (m_terrainHeight * j) + i;
 
-				m_heightMap[index].x = (float)i;
-				m_heightMap[index].y+= (float)((sin((float)i/(m_terrainWidth/sinValue))*sinMulti) + (cos((float)j/cosValue)*cosMulti)); //magic numbers ahoy, just to ramp up the height of the sin function so its visible.
-				m_heightMap[index].z = (float)j;
-			}
-		}
-		
-		/*
-		for(int i=0; i<m_terrainWidth; i++)
-		{	
-			cosValue = (((float(rand()%200))/10)-10);
-			for(int j=0; j<m_terrainHeight; j++)
-			{	
-				index = (m_terrainWidth * i) + j;
-
-				m_heightMap[index].x = (float)j;
-				m_heightMap[index].y+= (cos((float)j/cosValue)*cosMulti); //magic numbers ahoy, just to ramp up the height of the sin function so its visible.
-				m_heightMap[index].z = (float)i;
-			}
-		}*/
+RenderTexture* TerrainClass::GetLightMap()
+{
+	return m_lightTexture;
+}
+
+
+bool TerrainClass::IsUploadPending()
+{
+	return m_meshDirty || m_lightTextureDirty;
+}
+
+
+bool TerrainClass::Upload(RenderDeviceClass* device)
+{
+	bool result;
+
 
-		result = CalculateNormals();
+	PROFILE_ZONE("Terrain Upload");
+
+	// New heights need a new normal map texture and a new mesh.
+	if(m_meshDirty)
+	{
+		result = CreateNormalTexture(device);
 		if(!result)
 		{
 			return false;
 		}
 
-		// Initialize the vertex and index buffer that hold the geometry for the terrain.
 		result = InitializeBuffers(device);
 		if(!result)
 		{
 			return false;
 		}
 
-		m_terrainGeneratedToggle = true;
+		m_meshDirty = false;
 	}
-	else
+
+	// Copy the baked light map into the texture.
+	if(m_lightTextureDirty)
 	{
-		m_terrainGeneratedToggle = false;
+		device->UpdateTexture(m_lightTexture, m_LightMap->GetLightData(), m_LightMap->GetLightPitch());
+		m_lightTextureDirty = false;
 	}
 
+	UpdateMetrics();
+
+	return true;
+}
+
+bool TerrainClass::GenerateHeightMap()
+{
+	int index;
+	float height = 0.0;
+	bool result;
+
+
+	PROFILE_ZONE("Height Map");
+
+	//MidPoint();
+	/*for(int j=0; j<m_terrainHeight; j++)
+	{
+		for(int i=0; i<m_terrainWidth; i++)
+		{			
+			index = (m_terrainHeight * j) + i;
+
+			m_heightMap[index].x = (float)i;
+			m_heightMap[index].y=  i;
+			m_heightMap[index].z = (float)j;
+		}
+	}*/
+
+
 	
+	//GenerateRandomHeightMap();
 
+	//loop through the terrain and set the hieghts how we want. This is where we generate the terrain
+	//in this case I will run a sin-wave through the terrain in one axis.
+	m_wave.sinValue = (rand()%12)+1;
+	m_wave.cosValue = (((float(rand()%200))/10)-10);
+	m_wave.sinMulti = (((float(rand()%100))/10)-5);
+	m_wave.cosMulti = (((float(rand()%50))/10)-2.5);
+	if(m_wave.cosValue == 0)	m_wave.cosValue = 1;
+
+	// Every row only touches its own heights so the rows are split into jobs.
+	JobSystemClass::ParallelFor(this, &TerrainClass::AddWaveRows, m_terrainHeight, 16);
+	
+	/*
+	for(int i=0; i<m_terrainWidth; i++)
+	{	
+		cosValue = (((float(rand()%200))/10)-10);
+		for(int j=0; j<m_terrainHeight; j++)
+		{	
+			index = (m_terrainWidth * i) + j;
+
+			m_heightMap[index].x = (float)j;
+			m_heightMap[index].y+= (cos((float)j/cosValue)*cosMulti); //magic numbers ahoy, just to ramp up the height of the sin function so its visible.
+			m_heightMap[index].z = (float)i;
+		}
+	}*/
+
+	// Re-bake the normal map from the new heights.
+	result = BakeNormalMap();
+	if(!result)
+	{
+		return false;
+	}
+
+	// The normal map texture and the mesh are built from the new heights in Upload.
+	m_meshDirty = true;
 
 	return true;
 }
+void TerrainClass::AddWaveRows(int startRow, int endRow)
+{
+	int index;
+
+
+	for(int j=startRow; j<endRow; j++)
+	{
+		for(int i=0; i<m_terrainWidth; i++)
+		{
+			index = (m_terrainHeight * j) + i;
+
+			m_heightMap[index].x = (float)i;
+			m_heightMap[index].y+= (float)((sin((float)i/(m_terrainWidth/m_wave.sinValue))*m_wave.sinMulti) + (cos((float)j/m_wave.cosValue)*m_wave.cosMulti)); //magic numbers ahoy, just to ramp up the height of the sin function so its visible.
+			m_heightMap[index].z = (float)j;
+		}
+	}
+
+	return;
+}
+
+
 bool TerrainClass::LoadHeightMap(char* filename)
 {
 	FILE* filePtr;
 	int error;
 	unsigned int count;
-	BITMAPFILEHEADER bitmapFileHeader;
-	BITMAPINFOHEADER bitmapInfoHeader;
+	unsigned char header[54];
+	unsigned int dataOffset;
 	int imageSize, i, j, k, index;
 	unsigned char* bitmapImage;
 	unsigned char height;
 
 
 	// Open the height map file in binary.
-	error = fopen_s(&filePtr, filename, "rb");
-	if(error != 0)
-	{
-		return false;
-	}
-
-	// Read in the file header.
-	count = fread(&bitmapFileHeader, sizeof(BITMAPFILEHEADER), 1, filePtr);
-	if(count != 1)
+	filePtr = fopen(filename, "rb");
+	if(!filePtr)
 	{
 		return false;
 	}
 
-	// Read in the bitmap info header.
-	count = fread(&bitmapInfoHeader, sizeof(BITMAPINFOHEADER), 1, filePtr);
-	if(count != 1)
+	// Read in the file header and the bitmap info header.
+	count = fread(header, 1, sizeof(header), filePtr);
+	if((count != sizeof(header)) || (header[0] != 'B') || (header[1] != 'M'))
 	{
+		fclose(filePtr);
 		return false;
 	}
 
-	// Save the dimensions of the terrain.
-	m_terrainWidth = bitmapInfoHeader.biWidth;
-	m_terrainHeight = bitmapInfoHeader.biHeight;
+	// Save the dimensions of the terrain and where the image data starts, every field is little endian.
+	dataOffset = header[10] | (header[11] << 8) | (header[12] << 16) | ((unsigned int)header[13] << 24);
+	m_terrainWidth = header[18] | (header[19] << 8) | (header[20] << 16) | (header[21] << 24);
+	m_terrainHeight = header[22] | (header[23] << 8) | (header[24] << 16) | (header[25] << 24);
 
 	// Calculate the size of the bitmap image data.
 	imageSize = m_terrainWidth * m_terrainHeight * 3;
@@ -267,7 +417,7 @@ bool TerrainClass::LoadHeightMap(char* filename)
 	}
 
 	// Move to the beginning of the bitmap data.
-	fseek(filePtr, bitmapFileHeader.bfOffBits, SEEK_SET);
+	fseek(filePtr, dataOffset, SEEK_SET);
 
 	// Read in the bitmap image data.
 	count = fread(bitmapImage, 1, imageSize, filePtr);
@@ -335,190 +485,213 @@ void TerrainClass::NormalizeHeightMap()
 }
 
 
-bool TerrainClass::CalculateNormals()
+void TerrainClass::ShutdownHeightMap()
 {
-	int i, j, index1, index2, index3, index, count;
-	float vertex1[3], vertex2[3], vertex3[3], vector1[3], vector2[3], sum[3], length;
-	VectorType* normals;
+	if(m_heightMap)
+	{
+		delete [] m_heightMap;
+		m_heightMap = 0;
+	}
 
+	return;
+}
+
+
+bool TerrainClass::InitializeNormalMap(RenderDeviceClass* device)
+{
+	bool result;
+
+
+	// Create the normal map object the first time the terrain is baked.
+	if(!m_NormalMap)
+	{
+		m_NormalMap = new NormalMapClass;
+		if(!m_NormalMap)
+		{
+			return false;
+		}
+
+		// Initialize the normal map at a multiple of the height map resolution.
+		result = m_NormalMap->Initialize(m_terrainWidth, m_terrainHeight, NORMAL_MAP_SCALE);
+		if(!result)
+		{
+			return false;
+		}
+	}
 
-	// Create a temporary array to hold the un-normalized normal vectors.
-	normals = new VectorType[(m_terrainHeight-1) * (m_terrainWidth-1)];
-	if(!normals)
+	// Bake the normals from the heights stored in the height map.
+	result = BakeNormalMap();
+	if(!result)
 	{
 		return false;
 	}
 
-	// Go through all the faces in the mesh and calculate their normals.
-	for(j=0; j<(m_terrainHeight-1); j++)
+	// Create the texture from the baked normals.
+	result = CreateNormalTexture(device);
+	if(!result)
 	{
-		for(i=0; i<(m_terrainWidth-1); i++)
-		{
-			index1 = (j * m_terrainHeight) + i;
-			index2 = (j * m_terrainHeight) + (i+1);
-			index3 = ((j+1) * m_terrainHeight) + i;
-
-			// Get three vertices from the face.
-			vertex1[0] = m_heightMap[index1].x;
-			vertex1[1] = m_heightMap[index1].y;
-			vertex1[2] = m_heightMap[index1].z;
-		
-			vertex2[0] = m_heightMap[index2].x;
-			vertex2[1] = m_heightMap[index2].y;
-			vertex2[2] = m_heightMap[index2].z;
-		
-			vertex3[0] = m_heightMap[index3].x;
-			vertex3[1] = m_heightMap[index3].y;
-			vertex3[2] = m_heightMap[index3].z;
-
-			// Calculate the two vectors for this face.
-			vector1[0] = vertex1[0] - vertex3[0];
-			vector1[1] = vertex1[1] - vertex3[1];
-			vector1[2] = vertex1[2] - vertex3[2];
-			vector2[0] = vertex3[0] - vertex2[0];
-			vector2[1] = vertex3[1] - vertex2[1];
-			vector2[2] = vertex3[2] - vertex2[2];
-
-			index = (j * (m_terrainHeight-1)) + i;
-
-			// Calculate the cross product of those two vectors to get the un-normalized value for this face normal.
-			normals[index].x = (vector1[1] * vector2[2]) - (vector1[2] * vector2[1]);
-			normals[index].y = (vector1[2] * vector2[0]) - (vector1[0] * vector2[2]);
-			normals[index].z = (vector1[0] * vector2[1]) - (vector1[1] * vector2[0]);
-		}
+		return false;
 	}
 
-	// Now go through all the vertices and take an average of each face normal 	
-	// that the vertex touches to get the averaged normal for that vertex.
-	for(j=0; j<m_terrainHeight; j++)
+	return true;
+}
+
+
+bool TerrainClass::BakeNormalMap()
+{
+	bool result;
+
+
+	// Bake the normals from the heights stored in the height map.
+	result = m_NormalMap->Bake(&m_heightMap[0].y, sizeof(HeightMapType) / sizeof(float));
+	if(!result)
 	{
-		for(i=0; i<m_terrainWidth; i++)
-		{
-			// Initialize the sum.
-			sum[0] = 0.0f;
-			sum[1] = 0.0f;
-			sum[2] = 0.0f;
+		return false;
+	}
 
-			// Initialize the count.
-			count = 0;
+	// The heights have changed so the light map has to be baked again.
+	m_lightMapDirty = true;
 
-			// Bottom left face.
-			if(((i-1) >= 0) && ((j-1) >= 0))
-			{
-				index = ((j-1) * (m_terrainHeight-1)) + (i-1);
+	return true;
+}
 
-				sum[0] += normals[index].x;
-				sum[1] += normals[index].y;
-				sum[2] += normals[index].z;
-				count++;
-			}
 
-			// Bottom right face.
-			if((i < (m_terrainWidth-1)) && ((j-1) >= 0))
-			{
-				index = ((j-1) * (m_terrainHeight-1)) + i;
+bool TerrainClass::CreateNormalTexture(RenderDeviceClass* device)
+{
+	// Release the texture from any previous bake.
+	if(m_normalTexture)
+	{
+		m_normalTexture->Release();
+		m_normalTexture = 0;
+	}
 
-				sum[0] += normals[index].x;
-				sum[1] += normals[index].y;
-				sum[2] += normals[index].z;
-				count++;
-			}
+	// Create the two channel normal map texture from the baked normals.
+	m_normalTexture = device->CreateTexture(m_NormalMap->GetWidth(), m_NormalMap->GetHeight(), RENDER_FORMAT_R8G8_SNORM, RENDER_USAGE_STATIC, 
+											m_NormalMap->GetNormalData(), m_NormalMap->GetNormalPitch());
+	if(!m_normalTexture)
+	{
+		return false;
+	}
 
-			// Upper left face.
-			if(((i-1) >= 0) && (j < (m_terrainHeight-1)))
-			{
-				index = (j * (m_terrainHeight-1)) + (i-1);
+	return true;
+}
 
-				sum[0] += normals[index].x;
-				sum[1] += normals[index].y;
-				sum[2] += normals[index].z;
-				count++;
-			}
 
-			// Upper right face.
-			if((i < (m_terrainWidth-1)) && (j < (m_terrainHeight-1)))
-			{
-				index = (j * (m_terrainHeight-1)) + i;
+void TerrainClass::ShutdownNormalMap()
+{
+	// Release the normal map texture.
+	if(m_normalTexture)
+	{
+		m_normalTexture->Release();
+		m_normalTexture = 0;
+	}
 
-				sum[0] += normals[index].x;
-				sum[1] += normals[index].y;
-				sum[2] += normals[index].z;
-				count++;
-			}
-			
-			// Take the average of the faces touching this vertex.
-			sum[0] = (sum[0] / (float)count);
-			sum[1] = (sum[1] / (float)count);
-			sum[2] = (sum[2] / (float)count);
+	// Release the normal map object.
+	if(m_NormalMap)
+	{
+		m_NormalMap->Shutdown();
+		delete m_NormalMap;
+		m_NormalMap = 0;
+	}
 
-			// Calculate the length of this normal.
-			length = sqrt((sum[0] * sum[0]) + (sum[1] * sum[1]) + (sum[2] * sum[2]));
-			
-			// Get an index to the vertex location in the height map array.
-			index = (j * m_terrainHeight) + i;
+	return;
+}
 
-			// Normalize the final shared normal for this vertex and store it in the height map array.
-			m_heightMap[index].nx = (sum[0] / length);
-			m_heightMap[index].ny = (sum[1] / length);
-			m_heightMap[index].nz = (sum[2] / length);
-		}
+
+bool TerrainClass::InitializeLightMap(RenderDeviceClass* device)
+{
+	bool result;
+
+
+	// Create the light map object, it matches the normal map so both share the same texture coordinates.
+	m_LightMap = new LightMapClass;
+	if(!m_LightMap)
+	{
+		return false;
 	}
 
-	// Release the temporary normals.
-	delete [] normals;
-	normals = 0;
+	// Initialize the light map object, each texel is 1/scale of a height map cell across.
+	result = m_LightMap->Initialize(m_NormalMap->GetWidth(), m_NormalMap->GetHeight(), 1.0f / (float)NORMAL_MAP_SCALE);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Create the two channel light map texture, it starts out unoccluded and fully lit and is updated whenever it is baked again.
+	m_lightTexture = device->CreateTexture(m_NormalMap->GetWidth(), m_NormalMap->GetHeight(), RENDER_FORMAT_R8G8_UNORM, RENDER_USAGE_DYNAMIC, 
+										   m_LightMap->GetLightData(), m_LightMap->GetLightPitch());
+	if(!m_lightTexture)
+	{
+		return false;
+	}
 
 	return true;
 }
 
 
-void TerrainClass::ShutdownHeightMap()
+void TerrainClass::ShutdownLightMap()
 {
-	if(m_heightMap)
+	// Release the light map texture.
+	if(m_lightTexture)
 	{
-		delete [] m_heightMap;
-		m_heightMap = 0;
+		m_lightTexture->Release();
+		m_lightTexture = 0;
+	}
+
+	// Release the light map object.
+	if(m_LightMap)
+	{
+		m_LightMap->Shutdown();
+		delete m_LightMap;
+		m_LightMap = 0;
 	}
 
 	return;
 }
 
 
-bool TerrainClass::InitializeBuffers(ID3D11Device* device)
+bool TerrainClass::InitializeBuffers(RenderDeviceClass* device)
 {
-	VertexType* vertices;
-	unsigned long* indices;
-	int index, i, j;
-	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-    D3D11_SUBRESOURCE_DATA vertexData, indexData;
-	HRESULT result;
+	VertexType quads[TERRAIN_STREAM_QUADS * 6];
+	char* vertices;
+	int vertexCount, index, offset, i, j;
 	int index1, index2, index3, index4;
+	float textureScaleU, textureScaleV, textureOffsetU, textureOffsetV;
+	StopwatchClass stopwatch;
+	bool result;
 
 
 	// Calculate the number of vertices in the terrain mesh.
-	m_vertexCount = (m_terrainWidth - 1) * (m_terrainHeight - 1) * 6;
-
-	// Set the index count to the same as the vertex count.
-	m_indexCount = m_vertexCount;
+	vertexCount = (m_terrainWidth - 1) * (m_terrainHeight - 1) * 6;
 
-	// Create the vertex array.
-	vertices = new VertexType[m_vertexCount];
-	if(!vertices)
+	// The buffers are only created again when the terrain changes size, otherwise the new mesh is written over the old.
+	if(!m_vertexBuffer || (vertexCount != m_vertexCount))
 	{
-		return false;
+		result = CreateBuffers(device, vertexCount);
+		if(!result)
+		{
+			return false;
+		}
 	}
 
-	// Create the index array.
-	indices = new unsigned long[m_indexCount];
-	if(!indices)
+	// Map each height map sample onto the centre of its texel in the normal map.
+	textureScaleU = (float)NORMAL_MAP_SCALE / (float)m_NormalMap->GetWidth();
+	textureScaleV = (float)NORMAL_MAP_SCALE / (float)m_NormalMap->GetHeight();
+	textureOffsetU = 0.5f / (float)m_NormalMap->GetWidth();
+	textureOffsetV = 0.5f / (float)m_NormalMap->GetHeight();
+
+	// Lock the vertex buffer, the mesh is built straight into it rather than in an array that is copied afterwards.
+	vertices = (char*)device->MapBuffer(m_vertexBuffer, RENDER_MAP_DISCARD);
+	if(!vertices)
 	{
 		return false;
 	}
 
-	// Initialize the index to the vertex buffer.
+	// Initialize the index into the staging block and the offset into the vertex buffer.
 	index = 0;
+	offset = 0;
 
-	// Load the vertex and index array with the terrain data.
+	// Build the quads a few at a time in the staging block and stream each full block out to the buffer.
 	for(j=0; j<(m_terrainHeight-1); j++){
 		for(i=0; i<(m_terrainWidth-1); i++){
 			index1 = (m_terrainHeight * j) + i;          // Bottom left.
@@ -528,127 +701,138 @@ bool TerrainClass::InitializeBuffers(ID3D11Device* device)
 
 			if((i%2 !=0 && j%2 ==0) || (i%2 ==0 && j%2 != 0)){
 				// Upper left.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index3].x, m_heightMap[index3].y, m_heightMap[index3].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index3].nx, m_heightMap[index3].ny, m_heightMap[index3].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index3].x, m_heightMap[index3].y, m_heightMap[index3].z);
+				quads[index].texture = Vector2((m_heightMap[index3].x * textureScaleU) + textureOffsetU, (m_heightMap[index3].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Upper right.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index4].x, m_heightMap[index4].y, m_heightMap[index4].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index4].nx, m_heightMap[index4].ny, m_heightMap[index4].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index4].x, m_heightMap[index4].y, m_heightMap[index4].z);
+				quads[index].texture = Vector2((m_heightMap[index4].x * textureScaleU) + textureOffsetU, (m_heightMap[index4].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Bottom right.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index2].x, m_heightMap[index2].y, m_heightMap[index2].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index2].nx, m_heightMap[index2].ny, m_heightMap[index2].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index2].x, m_heightMap[index2].y, m_heightMap[index2].z);
+				quads[index].texture = Vector2((m_heightMap[index2].x * textureScaleU) + textureOffsetU, (m_heightMap[index2].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Bottom right.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index2].x, m_heightMap[index2].y, m_heightMap[index2].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index2].nx, m_heightMap[index2].ny, m_heightMap[index2].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index2].x, m_heightMap[index2].y, m_heightMap[index2].z);
+				quads[index].texture = Vector2((m_heightMap[index2].x * textureScaleU) + textureOffsetU, (m_heightMap[index2].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Bottom left.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index1].x, m_heightMap[index1].y, m_heightMap[index1].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index1].nx, m_heightMap[index1].ny, m_heightMap[index1].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index1].x, m_heightMap[index1].y, m_heightMap[index1].z);
+				quads[index].texture = Vector2((m_heightMap[index1].x * textureScaleU) + textureOffsetU, (m_heightMap[index1].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Upper left.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index3].x, m_heightMap[index3].y, m_heightMap[index3].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index3].nx, m_heightMap[index3].ny, m_heightMap[index3].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index3].x, m_heightMap[index3].y, m_heightMap[index3].z);
+				quads[index].texture = Vector2((m_heightMap[index3].x * textureScaleU) + textureOffsetU, (m_heightMap[index3].z * textureScaleV) + textureOffsetV);
 				index++;
 
 			}else{
 				// Upper left.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index3].x, m_heightMap[index3].y, m_heightMap[index3].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index3].nx, m_heightMap[index3].ny, m_heightMap[index3].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index3].x, m_heightMap[index3].y, m_heightMap[index3].z);
+				quads[index].texture = Vector2((m_heightMap[index3].x * textureScaleU) + textureOffsetU, (m_heightMap[index3].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Upper right.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index4].x, m_heightMap[index4].y, m_heightMap[index4].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index4].nx, m_heightMap[index4].ny, m_heightMap[index4].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index4].x, m_heightMap[index4].y, m_heightMap[index4].z);
+				quads[index].texture = Vector2((m_heightMap[index4].x * textureScaleU) + textureOffsetU, (m_heightMap[index4].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Bottom left.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index1].x, m_heightMap[index1].y, m_heightMap[index1].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index1].nx, m_heightMap[index1].ny, m_heightMap[index1].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index1].x, m_heightMap[index1].y, m_heightMap[index1].z);
+				quads[index].texture = Vector2((m_heightMap[index1].x * textureScaleU) + textureOffsetU, (m_heightMap[index1].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Bottom left.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index1].x, m_heightMap[index1].y, m_heightMap[index1].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index1].nx, m_heightMap[index1].ny, m_heightMap[index1].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index1].x, m_heightMap[index1].y, m_heightMap[index1].z);
+				quads[index].texture = Vector2((m_heightMap[index1].x * textureScaleU) + textureOffsetU, (m_heightMap[index1].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Upper right.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index4].x, m_heightMap[index4].y, m_heightMap[index4].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index4].nx, m_heightMap[index4].ny, m_heightMap[index4].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index4].x, m_heightMap[index4].y, m_heightMap[index4].z);
+				quads[index].texture = Vector2((m_heightMap[index4].x * textureScaleU) + textureOffsetU, (m_heightMap[index4].z * textureScaleV) + textureOffsetV);
 				index++;
 
 				// Bottom right.
-				vertices[index].position = D3DXVECTOR3(m_heightMap[index2].x, m_heightMap[index2].y, m_heightMap[index2].z);
-				vertices[index].normal = D3DXVECTOR3(m_heightMap[index2].nx, m_heightMap[index2].ny, m_heightMap[index2].nz);
-				indices[index] = index;
+				quads[index].position = Vector3(m_heightMap[index2].x, m_heightMap[index2].y, m_heightMap[index2].z);
+				quads[index].texture = Vector2((m_heightMap[index2].x * textureScaleU) + textureOffsetU, (m_heightMap[index2].z * textureScaleV) + textureOffsetV);
 				index++;
 			}
+
+			if(index == TERRAIN_STREAM_QUADS * 6)
+			{
+				StreamCopy(vertices + offset, quads, sizeof(VertexType) * index);
+				offset += sizeof(VertexType) * index;
+				index = 0;
+			}
 		}
 	}
 
-	// Set up the description of the static vertex buffer.
-    vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    vertexBufferDesc.ByteWidth = sizeof(VertexType) * m_vertexCount;
-    vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    vertexBufferDesc.CPUAccessFlags = 0;
-    vertexBufferDesc.MiscFlags = 0;
-	vertexBufferDesc.StructureByteStride = 0;
+	// Write out the last partial block and make sure the streamed stores have all landed before the buffer is unlocked.
+	StreamCopy(vertices + offset, quads, sizeof(VertexType) * index);
+	StreamFence();
+
+	device->UnmapBuffer(m_vertexBuffer);
+
+	m_meshBytes = sizeof(VertexType) * m_vertexCount;
+	m_meshTime = stopwatch.GetMilliseconds();
+
+	return true;
+}
+
+
+bool TerrainClass::CreateBuffers(RenderDeviceClass* device, int vertexCount)
+{
+	unsigned int indices[TERRAIN_STREAM_QUADS * 6];
+	char* mappedIndices;
+	int count, i, j;
 
-	// Give the subresource structure a pointer to the vertex data.
-    vertexData.pSysMem = vertices;
-	vertexData.SysMemPitch = 0;
-	vertexData.SysMemSlicePitch = 0;
 
-	// Now create the vertex buffer.
-    result = device->CreateBuffer(&vertexBufferDesc, &vertexData, &m_vertexBuffer);
-	if(FAILED(result))
+	// Release the buffers from any previous size of the terrain.
+	ShutdownBuffers();
+
+	// Set the index count to the same as the vertex count.
+	m_vertexCount = vertexCount;
+	m_indexCount = vertexCount;
+
+	// Create the dynamic vertex buffer, the mesh is written into it every time the heights change.
+	m_vertexBuffer = device->CreateBuffer(RENDER_BUFFER_VERTEX, RENDER_USAGE_DYNAMIC, sizeof(VertexType) * m_vertexCount, 0);
+	if(!m_vertexBuffer)
 	{
 		return false;
 	}
 
-	// Set up the description of the static index buffer.
-    indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_indexCount;
-    indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    indexBufferDesc.CPUAccessFlags = 0;
-    indexBufferDesc.MiscFlags = 0;
-	indexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the index data.
-    indexData.pSysMem = indices;
-	indexData.SysMemPitch = 0;
-	indexData.SysMemSlicePitch = 0;
+	// Create the index buffer, it is dynamic only so it can be filled in place.
+	m_indexBuffer = device->CreateBuffer(RENDER_BUFFER_INDEX, RENDER_USAGE_DYNAMIC, sizeof(unsigned int) * m_indexCount, 0);
+	if(!m_indexBuffer)
+	{
+		return false;
+	}
 
-	// Create the index buffer.
-	result = device->CreateBuffer(&indexBufferDesc, &indexData, &m_indexBuffer);
-	if(FAILED(result))
+	mappedIndices = (char*)device->MapBuffer(m_indexBuffer, RENDER_MAP_DISCARD);
+	if(!mappedIndices)
 	{
 		return false;
 	}
 
-	// Release the arrays now that the buffers have been created and loaded.
-	delete [] vertices;
-	vertices = 0;
+	// Every vertex is used once so the indices just count up, they are written out a block at a time.
+	for(i=0; i<m_indexCount; i+=count)
+	{
+		count = (m_indexCount - i < TERRAIN_STREAM_QUADS * 6) ? m_indexCount - i : TERRAIN_STREAM_QUADS * 6;
+		for(j=0; j<count; j++)
+		{
+			indices[j] = i + j;
+		}
+
+		StreamCopy(mappedIndices + (sizeof(unsigned int) * i), indices, sizeof(unsigned int) * count);
+	}
+
+	StreamFence();
 
-	delete [] indices;
-	indices = 0;
+	device->UnmapBuffer(m_indexBuffer);
 
 	return true;
 }
@@ -674,24 +858,15 @@ void TerrainClass::ShutdownBuffers()
 }
 
 
-void TerrainClass::RenderBuffers(ID3D11DeviceContext* deviceContext)
+void TerrainClass::RenderBuffers(DrawPacketType& packet)
 {
-	unsigned int stride;
-	unsigned int offset;
-
-
-	// Set vertex buffer stride and offset.
-	stride = sizeof(VertexType); 
-	offset = 0;
-    
-	// Set the vertex buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-
-    // Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	// Set the vertex buffer that will be active in the input assembler when the packet is drawn.
+	packet.vertexBuffer = m_vertexBuffer;
+	packet.vertexStride = sizeof(VertexType);
 
-    // Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    // Set the index buffer and the number of indices to draw from it.
+	packet.indexBuffer = m_indexBuffer;
+	packet.indexCount = m_indexCount;
 
 	return;
 }
@@ -717,3 +892,24 @@ void TerrainClass::GenerateRandomHeightMap()
 		}
 	}
 }
+
+
+void TerrainClass::UpdateMetrics()
+{
+	// The metrics only change when the terrain is built or baked, adding them again just finds the existing ones.
+	m_metrics[0] = StatsOverlayClass::AddCounter("Terrain", "Triangles", "");
+	m_metrics[1] = StatsOverlayClass::AddGauge("Terrain", "Normal bake", 2, "ms");
+	m_metrics[2] = StatsOverlayClass::AddGauge("Terrain", "Occlusion bake", 2, "ms");
+	m_metrics[3] = StatsOverlayClass::AddGauge("Terrain", "Shadow bake", 2, "ms");
+	m_metrics[4] = StatsOverlayClass::AddGauge("Terrain", "Mesh build", 2, "ms");
+	m_metrics[5] = StatsOverlayClass::AddCounter("Terrain", "Mesh written", "KB");
+
+	StatsOverlayClass::SetCounter(m_metrics[0], m_indexCount / 3);
+	StatsOverlayClass::SetGauge(m_metrics[1], m_NormalMap->GetBakeTime());
+	StatsOverlayClass::SetGauge(m_metrics[2], m_LightMap->GetOcclusionBakeTime());
+	StatsOverlayClass::SetGauge(m_metrics[3], m_LightMap->GetShadowBakeTime());
+	StatsOverlayClass::SetGauge(m_metrics[4], m_meshTime);
+	StatsOverlayClass::SetCounter(m_metrics[5], m_meshBytes / 1024);
+
+	return;
+}
@@ -8,11 +8,27 @@
 //////////////
 // INCLUDES //
 //////////////
-#include <d3d11.h>
-#include <d3dx10math.h>
 #include <stdio.h>
 
 
+/////////////
+// GLOBALS //
+/////////////
+const int NORMAL_MAP_SCALE = 4;
+const int TERRAIN_STREAM_QUADS = 16;
+const int TERRAIN_METRICS = 6;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mathclass.h"
+#include "renderdeviceclass.h"
+#include "drawlistclass.h"
+#include "normalmapclass.h"
+#include "lightmapclass.h"
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: TerrainClass
 ////////////////////////////////////////////////////////////////////////////////
@@ -21,19 +37,20 @@ class TerrainClass
 private:
 	struct VertexType
 	{
-		D3DXVECTOR3 position;
-	    D3DXVECTOR3 normal;
+		Vector3 position;
+	    Vector2 texture;
 	};
 
 	struct HeightMapType 
 	{ 
 		float x, y, z;
-		float nx, ny, nz;
 	};
 
-	struct VectorType 
-	{ 
-		float x, y, z;
+	// The sine and cosine waves added to the heights each time new terrain is generated.
+	struct WaveType
+	{
+		float sinValue, cosValue;
+		float sinMulti, cosMulti;
 	};
 
 public:
@@ -41,30 +58,63 @@ public:
 	TerrainClass(const TerrainClass&);
 	~TerrainClass();
 
-	bool Initialize(ID3D11Device*, char*);
-	bool InitializeTerrain(ID3D11Device*, int terrainWidth, int terrainHeight);
+	bool Initialize(RenderDeviceClass*, char*);
+	bool InitializeTerrain(RenderDeviceClass*, int terrainWidth, int terrainHeight);
 	void Shutdown();
-	void Render(ID3D11DeviceContext*);
-	bool GenerateHeightMap(ID3D11Device* device, bool keydown);
+	void Render(DrawPacketType&);
+	bool GenerateHeightMap();
 	void GenerateRandomHeightMap();
 	int  GetIndexCount();
+	RenderTexture* GetNormalMap();
+
+	// The bytes written to the vertex buffer by the last mesh build and how long it took in milliseconds.
+	int GetMeshBytes();
+	float GetMeshTime();
+
+	bool UpdateLightMap(Vector3);
+	RenderTexture* GetLightMap();
+
+	// Generating and lighting only bake on the CPU, the textures and mesh they change are written to the device by
+	// Upload while nothing else is using it.
+	bool IsUploadPending();
+	bool Upload(RenderDeviceClass*);
 
 private:
 	bool LoadHeightMap(char*);
 	void NormalizeHeightMap();
-	bool CalculateNormals();
 	void ShutdownHeightMap();
+	void AddWaveRows(int, int);
 
-	bool InitializeBuffers(ID3D11Device*);
+	bool InitializeNormalMap(RenderDeviceClass*);
+	bool BakeNormalMap();
+	bool CreateNormalTexture(RenderDeviceClass*);
+	void ShutdownNormalMap();
+
+	bool InitializeLightMap(RenderDeviceClass*);
+	void ShutdownLightMap();
+
+	bool InitializeBuffers(RenderDeviceClass*);
+	bool CreateBuffers(RenderDeviceClass*, int);
 	void ShutdownBuffers();
-	void RenderBuffers(ID3D11DeviceContext*);
+	void RenderBuffers(DrawPacketType&);
+
+	void UpdateMetrics();
 	
 private:
-	bool m_terrainGeneratedToggle;
 	int m_terrainWidth, m_terrainHeight;
 	int m_vertexCount, m_indexCount;
-	ID3D11Buffer *m_vertexBuffer, *m_indexBuffer;
+	RenderBuffer *m_vertexBuffer, *m_indexBuffer;
 	HeightMapType* m_heightMap;
+	WaveType m_wave;
+	NormalMapClass* m_NormalMap;
+	RenderTexture* m_normalTexture;
+	LightMapClass* m_LightMap;
+	RenderTexture* m_lightTexture;
+	bool m_lightMapDirty;
+	bool m_meshDirty, m_lightTextureDirty;
+	int m_meshBytes;
+	float m_meshTime;
+	int m_metrics[TERRAIN_METRICS];
 };
 
 #endif
\ No newline at end of file
@@ -25,13 +25,13 @@ TerrainShaderClass::~TerrainShaderClass()
 }
 
 
-bool TerrainShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
+bool TerrainShaderClass::Initialize(RenderDeviceClass* device)
 {
 	bool result;
 
 
 	// Initialize the vertex and pixel shaders.
-	result = InitializeShader(device, hwnd, L"../Engine/terrain.vs", L"../Engine/terrain.ps");
+	result = InitializeShader(device, "../Engine/terrain.vs", "../Engine/terrain.ps");
 	if(!result)
 	{
 		return false;
@@ -50,180 +50,91 @@ void TerrainShaderClass::Shutdown()
 }
 
 
-bool TerrainShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount, D3DXMATRIX worldMatrix, D3DXMATRIX viewMatrix, 
-								D3DXMATRIX projectionMatrix, D3DXVECTOR4 ambientColor, D3DXVECTOR4 diffuseColor, D3DXVECTOR3 lightDirection)
+bool TerrainShaderClass::Render(DrawListClass* drawList, DrawPacketType& packet, Matrix worldMatrix, Matrix viewMatrix, 
+								Matrix projectionMatrix, RenderTexture* normalMap, RenderTexture* lightMap, 
+								Vector4 ambientColor, Vector4 diffuseColor, Vector3 lightDirection)
 {
 	bool result;
 
 
 	// Set the shader parameters that it will use for rendering.
-	result = SetShaderParameters(deviceContext, worldMatrix, viewMatrix, projectionMatrix, ambientColor, diffuseColor, lightDirection);
+	result = SetShaderParameters(drawList, packet, worldMatrix, viewMatrix, projectionMatrix, normalMap, lightMap, ambientColor, diffuseColor, lightDirection);
 	if(!result)
 	{
 		return false;
 	}
 
-	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	// Now submit the prepared buffers with the shader to the draw list.
+	result = RenderShader(drawList, packet);
+	if(!result)
+	{
+		return false;
+	}
 
 	return true;
 }
 
 
-bool TerrainShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* vsFilename, WCHAR* psFilename)
+bool TerrainShaderClass::InitializeShader(RenderDeviceClass* device, char* vsFilename, char* psFilename)
 {
-	HRESULT result;
-	ID3D10Blob* errorMessage;
-	ID3D10Blob* vertexShaderBuffer;
-	ID3D10Blob* pixelShaderBuffer;
-	D3D11_INPUT_ELEMENT_DESC polygonLayout[2];
-	unsigned int numElements;
-    D3D11_SAMPLER_DESC samplerDesc;
-	D3D11_BUFFER_DESC matrixBufferDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
-
-
-	// Initialize the pointers this function will use to null.
-	errorMessage = 0;
-	vertexShaderBuffer = 0;
-	pixelShaderBuffer = 0;
-
-    // Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename, NULL, NULL, "TerrainVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, 
-								   &vertexShaderBuffer, &errorMessage, NULL);
-	if(FAILED(result))
-	{
-		// If the shader failed to compile it should have writen something to the error message.
-		if(errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
-		}
-		// If there was nothing in the error message then it simply could not find the shader file itself.
-		else
-		{
-			MessageBox(hwnd, vsFilename, L"Missing Shader File", MB_OK);
-		}
+	RenderInputElementType polygonLayout[2];
+	int numElements;
 
-		return false;
-	}
-
-    // Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename, NULL, NULL, "TerrainPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, 
-								   &pixelShaderBuffer, &errorMessage, NULL);
-	if(FAILED(result))
-	{
-		// If the shader failed to compile it should have writen something to the error message.
-		if(errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage, hwnd, psFilename);
-		}
-		// If there was nothing in the error message then it simply could not find the file itself.
-		else
-		{
-			MessageBox(hwnd, psFilename, L"Missing Shader File", MB_OK);
-		}
-
-		return false;
-	}
 
-    // Create the vertex shader from the buffer.
-    result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_vertexShader);
-	if(FAILED(result))
+	// Compile and create the vertex shader.
+	m_vertexShader = device->CreateVertexShader(vsFilename, "TerrainVertexShader");
+	if(!m_vertexShader)
 	{
 		return false;
 	}
 
-    // Create the pixel shader from the buffer.
-    result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &m_pixelShader);
-	if(FAILED(result))
+	// Compile and create the pixel shader.
+	m_pixelShader = device->CreatePixelShader(psFilename, "TerrainPixelShader");
+	if(!m_pixelShader)
 	{
 		return false;
 	}
 
 	// Create the vertex input layout description.
-	polygonLayout[0].SemanticName = "POSITION";
-	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[0].InputSlot = 0;
-	polygonLayout[0].AlignedByteOffset = 0;
-	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[0].InstanceDataStepRate = 0;
-
-	polygonLayout[1].SemanticName = "NORMAL";
-	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[1].InputSlot = 0;
-	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[1].InstanceDataStepRate = 0;
+	// This setup needs to match the VertexType stucture in the TerrainClass and in the shader.
+	polygonLayout[0].semanticName = "POSITION";
+	polygonLayout[0].semanticIndex = 0;
+	polygonLayout[0].format = RENDER_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[0].offset = 0;
+
+	polygonLayout[1].semanticName = "TEXCOORD";
+	polygonLayout[1].semanticIndex = 0;
+	polygonLayout[1].format = RENDER_FORMAT_R32G32_FLOAT;
+	polygonLayout[1].offset = 12;
 
 	// Get a count of the elements in the layout.
     numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
 
 	// Create the vertex input layout.
-	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), 
-									   &m_layout);
-	if(FAILED(result))
+	m_layout = device->CreateInputLayout(polygonLayout, numElements, m_vertexShader);
+	if(!m_layout)
 	{
 		return false;
 	}
 
-	// Release the vertex shader buffer and pixel shader buffer since they are no longer needed.
-	vertexShaderBuffer->Release();
-	vertexShaderBuffer = 0;
-
-	pixelShaderBuffer->Release();
-	pixelShaderBuffer = 0;
-
-	// Create a texture sampler state description.
-    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-    samplerDesc.MipLODBias = 0.0f;
-    samplerDesc.MaxAnisotropy = 1;
-    samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
-    samplerDesc.BorderColor[0] = 0;
-	samplerDesc.BorderColor[1] = 0;
-	samplerDesc.BorderColor[2] = 0;
-	samplerDesc.BorderColor[3] = 0;
-    samplerDesc.MinLOD = 0;
-    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
-
-	// Create the texture sampler state.
-    result = device->CreateSamplerState(&samplerDesc, &m_sampleState);
-	if(FAILED(result))
+	// Create the texture sampler state.  Clamp so the normal map edges don't blend with the opposite side of the terrain.
+	m_sampleState = device->CreateSampler(RENDER_ADDRESS_CLAMP);
+	if(!m_sampleState)
 	{
 		return false;
 	}
 
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-    matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-    matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
-	if(FAILED(result))
+	// Create the dynamic matrix constant buffer that is in the vertex shader.
+	m_matrixBuffer = device->CreateBuffer(RENDER_BUFFER_CONSTANT, RENDER_USAGE_DYNAMIC, sizeof(MatrixBufferType), 0);
+	if(!m_matrixBuffer)
 	{
 		return false;
 	}
 
-	// Setup the description of the light dynamic constant buffer that is in the pixel shader.
-	// Note that ByteWidth always needs to be a multiple of 16 if using D3D11_BIND_CONSTANT_BUFFER or CreateBuffer will fail.
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &m_lightBuffer);
-	if(FAILED(result))
+	// Create the dynamic light constant buffer that is in the pixel shader.
+	// Note that the size always needs to be a multiple of 16 for constant buffers.
+	m_lightBuffer = device->CreateBuffer(RENDER_BUFFER_CONSTANT, RENDER_USAGE_DYNAMIC, sizeof(LightBufferType), 0);
+	if(!m_lightBuffer)
 	{
 		return false;
 	}
@@ -280,124 +191,64 @@ void TerrainShaderClass::ShutdownShader()
 }
 
 
-void TerrainShaderClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND hwnd, WCHAR* shaderFilename)
+bool TerrainShaderClass::SetShaderParameters(DrawListClass* drawList, DrawPacketType& packet, Matrix worldMatrix, Matrix viewMatrix, 
+											 Matrix projectionMatrix, RenderTexture* normalMap, RenderTexture* lightMap, 
+											 Vector4 ambientColor, Vector4 diffuseColor, Vector3 lightDirection)
 {
-	char* compileErrors;
-	unsigned long bufferSize, i;
-	ofstream fout;
-
+	MatrixBufferType* matrixData;
+	LightBufferType* lightData;
 
-	// Get a pointer to the error message text buffer.
-	compileErrors = (char*)(errorMessage->GetBufferPointer());
 
-	// Get the length of the message.
-	bufferSize = errorMessage->GetBufferSize();
-
-	// Open a file to write the error message to.
-	fout.open("shader-error.txt");
-
-	// Write out the error message.
-	for(i=0; i<bufferSize; i++)
-	{
-		fout << compileErrors[i];
-	}
-
-	// Close the file.
-	fout.close();
-
-	// Release the error message.
-	errorMessage->Release();
-	errorMessage = 0;
-
-	// Pop a message up on the screen to notify the user to check the text file for compile errors.
-	MessageBox(hwnd, L"Error compiling shader.  Check shader-error.txt for message.", shaderFilename, MB_OK);
-
-	return;
-}
-
-
-bool TerrainShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, D3DXMATRIX worldMatrix, D3DXMATRIX viewMatrix, 
-											 D3DXMATRIX projectionMatrix, D3DXVECTOR4 ambientColor, D3DXVECTOR4 diffuseColor, D3DXVECTOR3 lightDirection)
-{
-	HRESULT result;
-    D3D11_MAPPED_SUBRESOURCE mappedResource;
-	unsigned int bufferNumber;
-	MatrixBufferType* dataPtr;
-	LightBufferType* dataPtr2;
-
-
-	// Transpose the matrices to prepare them for the shader.
-	D3DXMatrixTranspose(&worldMatrix, &worldMatrix);
-	D3DXMatrixTranspose(&viewMatrix, &viewMatrix);
-	D3DXMatrixTranspose(&projectionMatrix, &projectionMatrix);
-
-	// Lock the constant buffer so it can be written to.
-	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
+	// Allocate the constants from the draw list, they are uploaded when the list is executed.
+	matrixData = (MatrixBufferType*)drawList->Allocate(sizeof(MatrixBufferType));
+	if(!matrixData)
 	{
 		return false;
 	}
 
-	// Get a pointer to the data in the constant buffer.
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
-
-	// Copy the matrices into the constant buffer.
-	dataPtr->world = worldMatrix;
-	dataPtr->view = viewMatrix;
-	dataPtr->projection = projectionMatrix;
-
-	// Unlock the constant buffer.
-    deviceContext->Unmap(m_matrixBuffer, 0);
+	// Transpose the matrices to prepare them for the shader.
+	MatrixTranspose(&matrixData->world, &worldMatrix);
+	MatrixTranspose(&matrixData->view, &viewMatrix);
+	MatrixTranspose(&matrixData->projection, &projectionMatrix);
 
-	// Set the position of the constant buffer in the vertex shader.
-	bufferNumber = 0;
+	// The matrices go to the first constant buffer in the vertex shader.
+	packet.vsConstantBuffer = m_matrixBuffer;
+	packet.vsConstants = matrixData;
+	packet.vsConstantsSize = sizeof(MatrixBufferType);
 
-	// Now set the constant buffer in the vertex shader with the updated values.
-    deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
+	// Set the baked normal map and the baked ambient occlusion and shadow light map in the pixel shader.
+	packet.textures[0] = normalMap;
+	packet.textures[1] = lightMap;
 
-	// Lock the light constant buffer so it can be written to.
-	result = deviceContext->Map(m_lightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
+	lightData = (LightBufferType*)drawList->Allocate(sizeof(LightBufferType));
+	if(!lightData)
 	{
 		return false;
 	}
 
-	// Get a pointer to the data in the constant buffer.
-	dataPtr2 = (LightBufferType*)mappedResource.pData;
-
 	// Copy the lighting variables into the constant buffer.
-	dataPtr2->ambientColor = ambientColor;
-	dataPtr2->diffuseColor = diffuseColor;
-	dataPtr2->lightDirection = lightDirection;
-	dataPtr2->padding = 0.0f;
-
-	// Unlock the constant buffer.
-	deviceContext->Unmap(m_lightBuffer, 0);
+	lightData->ambientColor = ambientColor;
+	lightData->diffuseColor = diffuseColor;
+	lightData->lightDirection = lightDirection;
+	lightData->padding = 0.0f;
 
-	// Set the position of the light constant buffer in the pixel shader.
-	bufferNumber = 0;
-
-	// Finally set the light constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &m_lightBuffer);
+	// The lighting variables go to the first constant buffer in the pixel shader.
+	packet.psConstantBuffer = m_lightBuffer;
+	packet.psConstants = lightData;
+	packet.psConstantsSize = sizeof(LightBufferType);
 
 	return true;
 }
 
 
-void TerrainShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, int indexCount)
+bool TerrainShaderClass::RenderShader(DrawListClass* drawList, DrawPacketType& packet)
 {
-	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(m_layout);
-
-    // Set the vertex and pixel shaders that will be used to render this triangle.
-    deviceContext->VSSetShader(m_vertexShader, NULL, 0);
-    deviceContext->PSSetShader(m_pixelShader, NULL, 0);
-
-	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &m_sampleState);
-
-	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
-
-	return;
-}
\ No newline at end of file
+	// Set the vertex input layout, the shaders and the sampler state for the draw.
+	packet.layout = m_layout;
+	packet.vertexShader = m_vertexShader;
+	packet.pixelShader = m_pixelShader;
+	packet.sampler = m_sampleState;
+
+	// Add the draw to the list.
+	return drawList->Submit(packet);
+}
@@ -5,14 +5,12 @@
 #define _TERRAINSHADERCLASS_H_
 
 
-//////////////
-// INCLUDES //
-//////////////
-#include <d3d11.h>
-#include <d3dx10math.h>
-#include <d3dx11async.h>
-#include <fstream>
-using namespace std;
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mathclass.h"
+#include "renderdeviceclass.h"
+#include "drawlistclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -23,16 +21,16 @@ class TerrainShaderClass
 private:
 	struct MatrixBufferType
 	{
-		D3DXMATRIX world;
-		D3DXMATRIX view;
-		D3DXMATRIX projection;
+		Matrix world;
+		Matrix view;
+		Matrix projection;
 	};
 
 	struct LightBufferType
 	{
-		D3DXVECTOR4 ambientColor;
-		D3DXVECTOR4 diffuseColor;
-		D3DXVECTOR3 lightDirection;
+		Vector4 ambientColor;
+		Vector4 diffuseColor;
+		Vector3 lightDirection;
 		float padding;
 	};
 
@@ -41,25 +39,25 @@ public:
 	TerrainShaderClass(const TerrainShaderClass&);
 	~TerrainShaderClass();
 
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(RenderDeviceClass*);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, D3DXMATRIX, D3DXMATRIX, D3DXMATRIX, D3DXVECTOR4, D3DXVECTOR4, D3DXVECTOR3);
+	bool Render(DrawListClass*, DrawPacketType&, Matrix, Matrix, Matrix, RenderTexture*, RenderTexture*, Vector4, Vector4, Vector3);
 
 private:
-	bool InitializeShader(ID3D11Device*, HWND, WCHAR*, WCHAR*);
+	bool InitializeShader(RenderDeviceClass*, char*, char*);
 	void ShutdownShader();
-	void OutputShaderErrorMessage(ID3D10Blob*, HWND, WCHAR*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, D3DXMATRIX, D3DXMATRIX, D3DXMATRIX, D3DXVECTOR4, D3DXVECTOR4, D3DXVECTOR3);
-	void RenderShader(ID3D11DeviceContext*, int);
+	bool SetShaderParameters(DrawListClass*, DrawPacketType&, Matrix, Matrix, Matrix, RenderTexture*, RenderTexture*, Vector4, Vector4, 
+							 Vector3);
+	bool RenderShader(DrawListClass*, DrawPacketType&);
 
 private:
-	ID3D11VertexShader* m_vertexShader;
-	ID3D11PixelShader* m_pixelShader;
-	ID3D11InputLayout* m_layout;
-	ID3D11SamplerState* m_sampleState;
-	ID3D11Buffer* m_matrixBuffer;
-	ID3D11Buffer* m_lightBuffer;
+	RenderProgram* m_vertexShader;
+	RenderProgram* m_pixelShader;
+	RenderInputLayout* m_layout;
+	RenderSampler* m_sampleState;
+	RenderBuffer* m_matrixBuffer;
+	RenderBuffer* m_lightBuffer;
 };
 
-#endif
\ No newline at end of file
+#endif
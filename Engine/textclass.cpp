@@ -2,21 +2,34 @@
 // Filename: textclass.cpp
 ///////////////////////////////////////////////////////////////////////////////
 #include "textclass.h"
+#include "statsoverlayclass.h"
+#include <string.h>
 
 
 TextClass::TextClass()
 {
+	int i;
+
+
 	m_Font = 0;
-	m_sentence1 = 0;
-	m_sentence2 = 0;
-	m_sentence3 = 0;
-	m_sentence4 = 0;
-	m_sentence5 = 0;
-	m_sentence6 = 0;
-	m_sentence7 = 0;
-	m_sentence8 = 0;
-	m_sentence9 = 0;
-	m_sentence10 = 0;
+	m_sentences = 0;
+	m_sentenceVertices = 0;
+	m_freeSentences = 0;
+	m_freeCount = 0;
+	m_version = 1;
+	m_indexBuffer = 0;
+	m_indexCount = 0;
+	m_baseVertex = 0;
+	memset(&m_allocation, 0, sizeof(RingBufferClass::AllocationType));
+	m_uploadVersion = 0;
+
+	for(i=0; i<5; i++)
+	{
+		m_metrics[i] = -1;
+	}
+
+	memset(&m_stats, 0, sizeof(StatsType));
+	memset(&m_frameStats, 0, sizeof(StatsType));
 }
 
 
@@ -30,9 +43,9 @@ TextClass::~TextClass()
 }
 
 
-bool TextClass::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, HWND hwnd, int screenWidth, int screenHeight, 
-						   D3DXMATRIX baseViewMatrix)
+bool TextClass::Initialize(RenderDeviceClass* device, int screenWidth, int screenHeight, Matrix baseViewMatrix)
 {
+	int i;
 	bool result;
 
 
@@ -51,89 +64,101 @@ bool TextClass::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceCont
 	}
 
 	// Initialize the font object.
-	result = m_Font->Initialize(device, "../Engine/data/fontdata.txt", L"../Engine/data/font.dds");
+	result = m_Font->Initialize(device, "../Engine/data/fontdata.txt", "../Engine/data/font.dds");
 	if(!result)
 	{
-		MessageBox(hwnd, L"Could not initialize the font object.", L"Error", MB_OK);
 		return false;
 	}
 
-	// Initialize the first sentence.
-	result = InitializeSentence(&m_sentence1, 150, device);
-	if(!result)
+	// Create the sentence pool.
+	m_sentences = new SentenceType[TEXT_MAX_SENTENCES];
+	if(!m_sentences)
 	{
 		return false;
 	}
 
-	// Initialize the second sentence.
-	result = InitializeSentence(&m_sentence2, 32, device);
-	if(!result)
+	// Create the glyph vertices of every sentence as one array, four vertices for each letter.
+	m_sentenceVertices = new VertexType[TEXT_MAX_SENTENCES * TEXT_SENTENCE_LENGTH * 4];
+	if(!m_sentenceVertices)
 	{
 		return false;
 	}
 
-	// Initialize the third sentence.
-	result = InitializeSentence(&m_sentence3, 16, device);
-	if(!result)
+	// Create the list of free sentences.
+	m_freeSentences = new int[TEXT_MAX_SENTENCES];
+	if(!m_freeSentences)
 	{
 		return false;
 	}
 
-	// Initialize the fourth sentence.
-	result = InitializeSentence(&m_sentence4, 16, device);
-	if(!result)
+	// Every sentence starts free, listed backwards so the first ones are handed out first.
+	for(i=0; i<TEXT_MAX_SENTENCES; i++)
 	{
-		return false;
-	}
+		m_sentences[i].inUse = false;
+		m_sentences[i].textValid = false;
+		m_sentences[i].vertices = m_sentenceVertices + (i * TEXT_SENTENCE_LENGTH * 4);
+		m_sentences[i].vertexCount = 0;
+		m_sentences[i].text[0] = 0;
 
-	// Initialize the fifth sentence.
-	result = InitializeSentence(&m_sentence5, 16, device);
-	if(!result)
-	{
-		return false;
+		m_freeSentences[i] = TEXT_MAX_SENTENCES - 1 - i;
 	}
 
-	// Initialize the sixth sentence.
-	result = InitializeSentence(&m_sentence6, 16, device);
+	m_freeCount = TEXT_MAX_SENTENCES;
+
+	// Create the index buffer every sentence is drawn with.
+	result = InitializeBatch(device);
 	if(!result)
 	{
 		return false;
 	}
 
-	// Initialize the seventh sentence.
-	result = InitializeSentence(&m_sentence7, 16, device);
-	if(!result)
+	// Show the text's own costs in the stats overlay.
+	m_metrics[0] = StatsOverlayClass::AddCounter("Text", "Sentences", "");
+	m_metrics[1] = StatsOverlayClass::AddCounter("Text", "Updated", "/frame");
+	m_metrics[2] = StatsOverlayClass::AddCounter("Text", "Skipped", "/frame");
+	m_metrics[3] = StatsOverlayClass::AddCounter("Text", "Uploaded", "KB");
+	m_metrics[4] = StatsOverlayClass::AddCounter("Text", "Saved", "KB");
+
+	return true;
+}
+
+
+void TextClass::Shutdown()
+{
+	int i;
+
+
+	// Take the text's metrics off the overlay.
+	for(i=0; i<5; i++)
 	{
-		return false;
+		StatsOverlayClass::RemoveMetric(m_metrics[i]);
+		m_metrics[i] = -1;
 	}
 
-	// Initialize the eighth sentence.
-	result = InitializeSentence(&m_sentence8, 16, device);
-	if(!result)
+	// Release the index buffer.
+	ReleaseBatch();
+
+	// Release the sentence pool.
+	if(m_freeSentences)
 	{
-		return false;
+		delete [] m_freeSentences;
+		m_freeSentences = 0;
 	}
 
-	// Initialize the ninth sentence.
-	result = InitializeSentence(&m_sentence9, 16, device);
-	if(!result)
+	if(m_sentenceVertices)
 	{
-		return false;
+		delete [] m_sentenceVertices;
+		m_sentenceVertices = 0;
 	}
 
-	// Initialize the tenth sentence.
-	result = InitializeSentence(&m_sentence10, 16, device);
-	if(!result)
+	if(m_sentences)
 	{
-		return false;
+		delete [] m_sentences;
+		m_sentences = 0;
 	}
 
-	return true;
-}
-
+	m_freeCount = 0;
 
-void TextClass::Shutdown()
-{
 	// Release the font object.
 	if(m_Font)
 	{
@@ -142,530 +167,394 @@ void TextClass::Shutdown()
 		m_Font = 0;
 	}
 
-	// Release the sentences.
-	ReleaseSentence(&m_sentence1);
-	ReleaseSentence(&m_sentence2);
-	ReleaseSentence(&m_sentence3);
-	ReleaseSentence(&m_sentence4);
-	ReleaseSentence(&m_sentence5);
-	ReleaseSentence(&m_sentence6);
-	ReleaseSentence(&m_sentence7);
-	ReleaseSentence(&m_sentence8);
-	ReleaseSentence(&m_sentence9);
-	ReleaseSentence(&m_sentence10);
-
 	return;
 }
 
 
-bool TextClass::Render(ID3D11DeviceContext* deviceContext, FontShaderClass* FontShader, D3DXMATRIX worldMatrix, D3DXMATRIX orthoMatrix)
+bool TextClass::TakeSnapshot(TextSnapshotType& snapshot)
 {
-	bool result;
+	int vertexCount, capacity, offset, i;
 
 
-	// Draw the sentences.
-	result = RenderSentence(m_sentence1, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
-	{
-		return false;
-	}
+	PROFILE_ZONE("Text Snapshot");
 
-	result = RenderSentence(m_sentence2, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
+	// Copy the sentences only if one of them has changed since this snapshot was last taken.
+	if(snapshot.version != m_version)
 	{
-		return false;
-	}
+		// Count the glyph vertices of every sentence in use.
+		vertexCount = 0;
+		for(i=0; i<TEXT_MAX_SENTENCES; i++)
+		{
+			if(m_sentences[i].inUse)
+			{
+				vertexCount += m_sentences[i].vertexCount;
+			}
+		}
 
-	result = RenderSentence(m_sentence3, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
-	{
-		return false;
-	}
+		// Make room for them in the snapshot, with some to spare since the sentences change length as their values change.
+		if(vertexCount > snapshot.capacity)
+		{
+			ReleaseSnapshot(snapshot);
 
-	result = RenderSentence(m_sentence4, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
-	{
-		return false;
-	}
+			capacity = vertexCount + (vertexCount / 2);
+			if(capacity > TEXT_MAX_SENTENCES * TEXT_SENTENCE_LENGTH * 4)
+			{
+				capacity = TEXT_MAX_SENTENCES * TEXT_SENTENCE_LENGTH * 4;
+			}
 
-	result = RenderSentence(m_sentence5, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
-	{
-		return false;
-	}
+			snapshot.vertices = new char[sizeof(VertexType) * capacity];
+			if(!snapshot.vertices)
+			{
+				return false;
+			}
 
-	result = RenderSentence(m_sentence6, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
-	{
-		return false;
-	}
+			snapshot.capacity = capacity;
+		}
 
-	result = RenderSentence(m_sentence7, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
-	{
-		return false;
-	}
+		// Copy the sentences in one after the other, only the sentences that changed had their glyphs built again.
+		offset = 0;
+		for(i=0; i<TEXT_MAX_SENTENCES; i++)
+		{
+			if(m_sentences[i].inUse && (m_sentences[i].vertexCount > 0))
+			{
+				memcpy(snapshot.vertices + offset, m_sentences[i].vertices, sizeof(VertexType) * m_sentences[i].vertexCount);
+				offset += sizeof(VertexType) * m_sentences[i].vertexCount;
+			}
+		}
 
-	result = RenderSentence(m_sentence8, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
-	{
-		return false;
+		snapshot.vertexCount = vertexCount;
+		snapshot.version = m_version;
 	}
 
-	result = RenderSentence(m_sentence9, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
-	{
-		return false;
-	}
+	// Every update for this frame has been made, keep the counts and start again for the next frame.
+	m_frameStats.sentences = TEXT_MAX_SENTENCES - m_freeCount;
+	m_frameStats.sentencesUpdated = m_stats.sentencesUpdated;
+	m_frameStats.sentencesSkipped = m_stats.sentencesSkipped;
+	memset(&m_stats, 0, sizeof(StatsType));
 
-	result = RenderSentence(m_sentence10, deviceContext, FontShader, worldMatrix, orthoMatrix);
-	if(!result)
-	{
-		return false;
-	}
+	StatsOverlayClass::SetCounter(m_metrics[0], m_frameStats.sentences);
+	StatsOverlayClass::SetCounter(m_metrics[1], m_frameStats.sentencesUpdated);
+	StatsOverlayClass::SetCounter(m_metrics[2], m_frameStats.sentencesSkipped);
 
 	return true;
 }
 
 
-bool TextClass::InitializeSentence(SentenceType** sentence, int maxLength, ID3D11Device* device)
+void TextClass::ReleaseSnapshot(TextSnapshotType& snapshot)
 {
-	VertexType* vertices;
-	unsigned long* indices;
-	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-    D3D11_SUBRESOURCE_DATA vertexData, indexData;
-	HRESULT result;
-	int i;
-
-
-	// Create a new sentence object.
-	*sentence = new SentenceType;
-	if(!*sentence)
+	if(snapshot.vertices)
 	{
-		return false;
+		delete [] snapshot.vertices;
+		snapshot.vertices = 0;
 	}
 
-	// Initialize the sentence buffers to null.
-	(*sentence)->vertexBuffer = 0;
-	(*sentence)->indexBuffer = 0;
+	snapshot.vertexCount = 0;
+	snapshot.capacity = 0;
+	snapshot.version = 0;
+
+	return;
+}
 
-	// Set the maximum length of the sentence.
-	(*sentence)->maxLength = maxLength;
 
-	// Set the number of vertices in the vertex array.
-	(*sentence)->vertexCount = 6 * maxLength;
+bool TextClass::Render(DrawListClass* drawList, FontShaderClass* FontShader, Matrix worldMatrix, Matrix orthoMatrix, RingBufferClass* ringBuffer,
+					   RenderDeviceClass* device, const TextSnapshotType& snapshot, int& bytesUploaded, int& bytesSaved)
+{
+	DrawPacketType packet;
+	bool result;
 
-	// Set the number of indexes in the index array.
-	(*sentence)->indexCount = (*sentence)->vertexCount;
 
-	// Create the vertex array.
-	vertices = new VertexType[(*sentence)->vertexCount];
-	if(!vertices)
+	PROFILE_ZONE("Text");
+
+	// Write the snapshot into this frame's part of the ring buffer, or draw last frame's copy again if nothing changed.
+	result = UpdateBatch(device, ringBuffer, snapshot, bytesUploaded, bytesSaved);
+	if(!result)
 	{
 		return false;
 	}
 
-	// Create the index array.
-	indices = new unsigned long[(*sentence)->indexCount];
-	if(!indices)
+	// There is nothing to draw if every sentence is blank or the ring buffer was full.
+	if(m_indexCount == 0)
 	{
-		return false;
+		return true;
 	}
 
-	// Initialize vertex array to zeros at first.
-	memset(vertices, 0, (sizeof(VertexType) * (*sentence)->vertexCount));
+	// All of the text is one draw over the scene.
+	memset(&packet, 0, sizeof(DrawPacketType));
+	packet.pass = DRAW_PASS_OVERLAY;
 
-	// Initialize the index array.
-	for(i=0; i<(*sentence)->indexCount; i++)
-	{
-		indices[i] = i;
-	}
+	// Set the vertex buffer that will be active in the input assembler when the packet is drawn.
+	packet.vertexBuffer = ringBuffer->GetBuffer();
+	packet.vertexStride = sizeof(VertexType);
+	packet.baseVertex = m_baseVertex;
 
-	// Set up the description of the dynamic vertex buffer.
-    vertexBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-    vertexBufferDesc.ByteWidth = sizeof(VertexType) * (*sentence)->vertexCount;
-    vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    vertexBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    vertexBufferDesc.MiscFlags = 0;
-	vertexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the vertex data.
-    vertexData.pSysMem = vertices;
-	vertexData.SysMemPitch = 0;
-	vertexData.SysMemSlicePitch = 0;
-
-	// Create the vertex buffer.
-    result = device->CreateBuffer(&vertexBufferDesc, &vertexData, &(*sentence)->vertexBuffer);
-	if(FAILED(result))
-	{
-		return false;
-	}
+	// Set the index buffer and the number of indices to draw from it, six for each glyph in the batch.
+	packet.indexBuffer = m_indexBuffer;
+	packet.indexCount = m_indexCount;
 
-	// Set up the description of the static index buffer.
-    indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = sizeof(unsigned long) * (*sentence)->indexCount;
-    indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    indexBufferDesc.CPUAccessFlags = 0;
-    indexBufferDesc.MiscFlags = 0;
-	indexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the index data.
-    indexData.pSysMem = indices;
-	indexData.SysMemPitch = 0;
-	indexData.SysMemSlicePitch = 0;
-
-	// Create the index buffer.
-	result = device->CreateBuffer(&indexBufferDesc, &indexData, &(*sentence)->indexBuffer);
-	if(FAILED(result))
+	// Submit the text using the font shader.
+	result = FontShader->Render(drawList, packet, worldMatrix, m_baseViewMatrix, orthoMatrix, m_Font->GetTexture());
+	if(!result)
 	{
 		return false;
 	}
 
-	// Release the vertex array as it is no longer needed.
-	delete [] vertices;
-	vertices = 0;
-
-	// Release the index array as it is no longer needed.
-	delete [] indices;
-	indices = 0;
-
 	return true;
 }
 
 
-bool TextClass::UpdateSentence(SentenceType* sentence, char* text, int positionX, int positionY, float red, float green, float blue,
-							   ID3D11DeviceContext* deviceContext)
+int TextClass::CreateSentence()
 {
-	int numLetters;
-	VertexType* vertices;
-	float drawX, drawY;
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	VertexType* verticesPtr;
-
-
-	// Store the color of the sentence.
-	sentence->red = red;
-	sentence->green = green;
-	sentence->blue = blue;
-
-	// Get the number of letters in the sentence.
-	numLetters = (int)strlen(text);
+	SentenceType* sentence;
+	int index;
 
-	// Check for possible buffer overflow.
-	if(numLetters > sentence->maxLength)
-	{
-		return false;
-	}
 
-	// Create the vertex array.
-	vertices = new VertexType[sentence->vertexCount];
-	if(!vertices)
+	// Take a sentence off the free list.
+	if(m_freeCount == 0)
 	{
-		return false;
+		return -1;
 	}
 
-	// Initialize vertex array to zeros at first.
-	memset(vertices, 0, (sizeof(VertexType) * sentence->vertexCount));
+	m_freeCount--;
+	index = m_freeSentences[m_freeCount];
 
-	// Calculate the X and Y pixel position on the screen to start drawing to.
-	drawX = (float)(((m_screenWidth / 2) * -1) + positionX);
-	drawY = (float)((m_screenHeight / 2) - positionY);
-
-	// Use the font class to build the vertex array from the sentence text and sentence draw location.
-	m_Font->BuildVertexArray((void*)vertices, text, drawX, drawY);
+	// A new sentence is blank and the first update always goes through.
+	sentence = &m_sentences[index];
+	sentence->inUse = true;
+	sentence->textValid = false;
+	sentence->vertexCount = 0;
+	sentence->text[0] = 0;
+	sentence->positionX = 0;
+	sentence->positionY = 0;
+	sentence->red = 0.0f;
+	sentence->green = 0.0f;
+	sentence->blue = 0.0f;
 
-	// Lock the vertex buffer so it can be written to.
-	result = deviceContext->Map(sentence->vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
-	{
-		return false;
-	}
-
-	// Get a pointer to the data in the vertex buffer.
-	verticesPtr = (VertexType*)mappedResource.pData;
+	return index;
+}
 
-	// Copy the data into the vertex buffer.
-	memcpy(verticesPtr, (void*)vertices, (sizeof(VertexType) * sentence->vertexCount));
 
-	// Unlock the vertex buffer.
-	deviceContext->Unmap(sentence->vertexBuffer, 0);
+void TextClass::ReleaseSentence(int index)
+{
+	SentenceType* sentence;
 
-	// Release the vertex array as it is no longer needed.
-	delete [] vertices;
-	vertices = 0;
 
-	return true;
-}
+	if((index < 0) || (index >= TEXT_MAX_SENTENCES) || !m_sentences[index].inUse)
+	{
+		return;
+	}
 
+	sentence = &m_sentences[index];
 
-void TextClass::ReleaseSentence(SentenceType** sentence)
-{
-	if(*sentence)
+	// Its glyphs have to come out of the next snapshot.
+	if(sentence->vertexCount > 0)
 	{
-		// Release the sentence vertex buffer.
-		if((*sentence)->vertexBuffer)
-		{
-			(*sentence)->vertexBuffer->Release();
-			(*sentence)->vertexBuffer = 0;
-		}
+		m_version++;
+	}
 
-		// Release the sentence index buffer.
-		if((*sentence)->indexBuffer)
-		{
-			(*sentence)->indexBuffer->Release();
-			(*sentence)->indexBuffer = 0;
-		}
+	sentence->inUse = false;
+	sentence->vertexCount = 0;
 
-		// Release the sentence.
-		delete *sentence;
-		*sentence = 0;
-	}
+	// Put the sentence back on the free list.
+	m_freeSentences[m_freeCount] = index;
+	m_freeCount++;
 
 	return;
 }
 
 
-bool TextClass::RenderSentence(SentenceType* sentence, ID3D11DeviceContext* deviceContext, FontShaderClass* FontShader, D3DXMATRIX worldMatrix, 
-							   D3DXMATRIX orthoMatrix)
+bool TextClass::UpdateSentence(int index, const char* text, int positionX, int positionY, float red, float green, float blue)
 {
-	unsigned int stride, offset;
-	D3DXVECTOR4 pixelColor;
-	bool result;
-
-
-	// Set vertex buffer stride and offset.
-    stride = sizeof(VertexType); 
-	offset = 0;
-
-	// Set the vertex buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetVertexBuffers(0, 1, &sentence->vertexBuffer, &stride, &offset);
-
-    // Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(sentence->indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-
-    // Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	SentenceType* sentence;
+	int numLetters;
+	float drawX, drawY;
 
-	// Create a pixel color vector with the input sentence color.
-	pixelColor = D3DXVECTOR4(sentence->red, sentence->green, sentence->blue, 1.0f);
 
-	// Render the text using the font shader.
-	result = FontShader->Render(deviceContext, sentence->indexCount, worldMatrix, m_baseViewMatrix, orthoMatrix, m_Font->GetTexture(), pixelColor);
-	if(!result)
+	if((index < 0) || (index >= TEXT_MAX_SENTENCES) || !m_sentences[index].inUse)
 	{
-		false;
+		return false;
 	}
 
-	return true;
-}
-
+	sentence = &m_sentences[index];
 
-bool TextClass::SetVideoCardInfo(char* videoCardName, int videoCardMemory, ID3D11DeviceContext* deviceContext)
-{
-	char dataString[150];
-	bool result;
-	char tempString[16];
-	char memoryString[32];
-
-
-	// Setup the video card name string.
-	strcpy_s(dataString, "Video Card: ");
-	strcat_s(dataString, videoCardName);
+	// Get the number of letters in the sentence.
+	numLetters = (int)strlen(text);
 
-	// Update the sentence vertex buffer with the new string information.
-	result = UpdateSentence(m_sentence1, dataString, 10, 10, 1.0f, 1.0f, 1.0f, deviceContext);
-	if(!result)
+	// Check for possible buffer overflow.
+	if(numLetters > TEXT_SENTENCE_LENGTH)
 	{
 		return false;
 	}
 
-	// Truncate the memory value to prevent buffer over flow.
-	if(videoCardMemory > 9999999)
+	// Nothing needs building if the sentence already shows this text in the same place and color.
+	if(sentence->textValid && (sentence->positionX == positionX) && (sentence->positionY == positionY) && (sentence->red == red) &&
+	   (sentence->green == green) && (sentence->blue == blue) && (strcmp(sentence->text, text) == 0))
 	{
-		videoCardMemory = 9999999;
+		m_stats.sentencesSkipped++;
+		return true;
 	}
 
-	// Convert the video memory integer value to a string format.
-	_itoa_s(videoCardMemory, tempString, 10);
+	// Store the text, position and color of the sentence.
+	strcpy(sentence->text, text);
+	sentence->positionX = positionX;
+	sentence->positionY = positionY;
+	sentence->red = red;
+	sentence->green = green;
+	sentence->blue = blue;
 
-	// Setup the video memory string.
-	strcpy_s(memoryString, "Video Memory: ");
-	strcat_s(memoryString, tempString);
-	strcat_s(memoryString, " MB");
+	// Calculate the X and Y pixel position on the screen to start drawing to.
+	drawX = (float)(((m_screenWidth / 2) * -1) + positionX);
+	drawY = (float)((m_screenHeight / 2) - positionY);
 
-	// Update the sentence vertex buffer with the new string information.
-	result = UpdateSentence(m_sentence2, memoryString, 10, 30, 1.0f, 1.0f, 1.0f, deviceContext);
-	if(!result)
-	{
-		return false;
-	}
+	// Use the font class to build the vertex array from the sentence text, draw location and color.
+	sentence->vertexCount = m_Font->BuildVertexArray((void*)sentence->vertices, sentence->text, drawX, drawY, Vector4(red, green, blue, 1.0f));
+	sentence->textValid = true;
+
+	// The next snapshot has to be copied again.
+	m_version++;
+
+	m_stats.sentencesUpdated++;
 
 	return true;
 }
 
 
-bool TextClass::SetFps(int fps, ID3D11DeviceContext* deviceContext)
+bool TextClass::InitializeBatch(RenderDeviceClass* device)
 {
-	char tempString[16];
-	char fpsString[16];
-	bool result;
+	unsigned int indices[TEXT_SENTENCE_LENGTH * 6];
+	char* mappedIndices;
+	int maxGlyphs, i, j;
+
 
+	// Every glyph is a quad of four vertices drawn as two triangles.
+	maxGlyphs = TEXT_MAX_SENTENCES * TEXT_SENTENCE_LENGTH;
 
-	// Truncate the fps to prevent a buffer over flow.
-	if(fps > 9999)
+	// Create the index buffer, it is dynamic only so it can be filled in place.
+	m_indexBuffer = device->CreateBuffer(RENDER_BUFFER_INDEX, RENDER_USAGE_DYNAMIC, sizeof(unsigned int) * maxGlyphs * 6, 0);
+	if(!m_indexBuffer)
 	{
-		fps = 9999;
+		return false;
 	}
 
-	// Convert the fps integer to string format.
-	_itoa_s(fps, tempString, 10);
-
-	// Setup the fps string.
-	strcpy_s(fpsString, "Fps: ");
-	strcat_s(fpsString, tempString);
-
-	// Update the sentence vertex buffer with the new string information.
-	result = UpdateSentence(m_sentence3, fpsString, 10, 70, 0.0f, 1.0f, 0.0f, deviceContext);
-	if(!result)
+	mappedIndices = (char*)device->MapBuffer(m_indexBuffer, RENDER_MAP_DISCARD);
+	if(!mappedIndices)
 	{
 		return false;
 	}
 
-	return true;
-}
-
-
-bool TextClass::SetCpu(int cpu, ID3D11DeviceContext* deviceContext)
-{
-	char tempString[16];
-	char cpuString[16];
-	bool result;
+	// The quads are top left, top right, bottom left and bottom right, both triangles are wound clockwise.  The indices
+	// are built one sentence's worth at a time and written out to the buffer.
+	for(i=0; i<maxGlyphs; i+=TEXT_SENTENCE_LENGTH)
+	{
+		for(j=0; j<TEXT_SENTENCE_LENGTH; j++)
+		{
+			indices[(j * 6) + 0] = ((i + j) * 4) + 0;
+			indices[(j * 6) + 1] = ((i + j) * 4) + 3;
+			indices[(j * 6) + 2] = ((i + j) * 4) + 2;
+			indices[(j * 6) + 3] = ((i + j) * 4) + 0;
+			indices[(j * 6) + 4] = ((i + j) * 4) + 1;
+			indices[(j * 6) + 5] = ((i + j) * 4) + 3;
+		}
 
+		StreamCopy(mappedIndices + (sizeof(unsigned int) * i * 6), indices, sizeof(indices));
+	}
 
-	// Convert the cpu integer to string format.
-	_itoa_s(cpu, tempString, 10);
+	StreamFence();
 
-	// Setup the cpu string.
-	strcpy_s(cpuString, "Cpu: ");
-	strcat_s(cpuString, tempString);
-	strcat_s(cpuString, "%");
+	device->UnmapBuffer(m_indexBuffer);
 
-	// Update the sentence vertex buffer with the new string information.
-	result = UpdateSentence(m_sentence4, cpuString, 10, 90, 0.0f, 1.0f, 0.0f, deviceContext);
-	if(!result)
-	{
-		return false;
-	}
+	m_indexCount = 0;
 
 	return true;
 }
 
 
-bool TextClass::SetCameraPosition(float posX, float posY, float posZ, ID3D11DeviceContext* deviceContext)
+bool TextClass::UpdateBatch(RenderDeviceClass* device, RingBufferClass* ringBuffer, const TextSnapshotType& snapshot, int& bytesUploaded,
+							int& bytesSaved)
 {
-	int positionX, positionY, positionZ;
-	char tempString[16];
-	char dataString[16];
+	char* vertices;
+	int vertexCount;
 	bool result;
 
 
-	// Convert the position from floating point to integer.
-	positionX = (int)posX;
-	positionY = (int)posY;
-	positionZ = (int)posZ;
-
-	// Truncate the position if it exceeds either 9999 or -9999.
-	if(positionX > 9999) { positionX = 9999; }
-	if(positionY > 9999) { positionY = 9999; }
-	if(positionZ > 9999) { positionZ = 9999; }
+	vertexCount = snapshot.vertexCount;
 
-	if(positionX < -9999) { positionX = -9999; }
-	if(positionY < -9999) { positionY = -9999; }
-	if(positionZ < -9999) { positionZ = -9999; }
+	m_indexCount = 0;
+	bytesUploaded = 0;
+	bytesSaved = 0;
 
-	// Setup the X position string.
-	_itoa_s(positionX, tempString, 10);
-	strcpy_s(dataString, "X: ");
-	strcat_s(dataString, tempString);
-
-	result = UpdateSentence(m_sentence5, dataString, 10, 130, 0.0f, 1.0f, 0.0f, deviceContext);
-	if(!result)
+	if(vertexCount == 0)
 	{
-		return false;
+		m_uploadVersion = snapshot.version;
+		return true;
 	}
-	
-	// Setup the Y position string.
-	_itoa_s(positionY, tempString, 10);
-	strcpy_s(dataString, "Y: ");
-	strcat_s(dataString, tempString);
 
-	result = UpdateSentence(m_sentence6, dataString, 10, 150, 0.0f, 1.0f, 0.0f, deviceContext);
-	if(!result)
+	// If no sentence has changed since the last upload then draw the same vertices again, as long as the ring buffer has
+	// not written over them or been renamed since.
+	if(snapshot.version == m_uploadVersion)
 	{
-		return false;
+		result = ringBuffer->Reuse(m_allocation);
+		if(result)
+		{
+			m_indexCount = (vertexCount / 4) * 6;
+			bytesSaved = sizeof(VertexType) * vertexCount;
+			return true;
+		}
 	}
 
-	// Setup the Z position string.
-	_itoa_s(positionZ, tempString, 10);
-	strcpy_s(dataString, "Z: ");
-	strcat_s(dataString, tempString);
+	// Take room for the batch from the ring buffer, if it is full the text is not drawn this frame and the ring buffer
+	// shows the failure.
+	m_uploadVersion = 0;
 
-	result = UpdateSentence(m_sentence7, dataString, 10, 170, 0.0f, 1.0f, 0.0f, deviceContext);
-	if(!result)
+	vertices = (char*)ringBuffer->Map(device, vertexCount, sizeof(VertexType), m_allocation);
+	if(!vertices)
 	{
-		return false;
+		return true;
 	}
 
-	return true;
-}
+	// The sentences are already packed one after the other in the snapshot.
+	StreamCopy(vertices, snapshot.vertices, sizeof(VertexType) * vertexCount);
+	StreamFence();
 
+	ringBuffer->Unmap(device);
 
-bool TextClass::SetCameraRotation(float rotX, float rotY, float rotZ, ID3D11DeviceContext* deviceContext)
-{
-	int rotationX, rotationY, rotationZ;
-	char tempString[16];
-	char dataString[16];
-	bool result;
+	m_baseVertex = m_allocation.offset / sizeof(VertexType);
+	m_uploadVersion = snapshot.version;
 
+	m_indexCount = (vertexCount / 4) * 6;
+	bytesUploaded = sizeof(VertexType) * vertexCount;
 
-	// Convert the rotation from floating point to integer.
-	rotationX = (int)rotX;
-	rotationY = (int)rotY;
-	rotationZ = (int)rotZ;
+	return true;
+}
 
-	// Setup the X rotation string.
-	_itoa_s(rotationX, tempString, 10);
-	strcpy_s(dataString, "rX: ");
-	strcat_s(dataString, tempString);
 
-	result = UpdateSentence(m_sentence8, dataString, 10, 210, 0.0f, 1.0f, 0.0f, deviceContext);
-	if(!result)
+void TextClass::ReleaseBatch()
+{
+	// Release the index buffer.
+	if(m_indexBuffer)
 	{
-		return false;
+		m_indexBuffer->Release();
+		m_indexBuffer = 0;
 	}
 
-	// Setup the Y rotation string.
-	_itoa_s(rotationY, tempString, 10);
-	strcpy_s(dataString, "rY: ");
-	strcat_s(dataString, tempString);
+	m_indexCount = 0;
 
-	result = UpdateSentence(m_sentence9, dataString, 10, 230, 0.0f, 1.0f, 0.0f, deviceContext);
-	if(!result)
-	{
-		return false;
-	}
+	return;
+}
 
-	// Setup the Z rotation string.
-	_itoa_s(rotationZ, tempString, 10);
-	strcpy_s(dataString, "rZ: ");
-	strcat_s(dataString, tempString);
 
-	result = UpdateSentence(m_sentence10, dataString, 10, 250, 0.0f, 1.0f, 0.0f, deviceContext);
-	if(!result)
-	{
-		return false;
-	}
+void TextClass::SetBytesUploaded(int bytesUploaded, int bytesSaved)
+{
+	m_frameStats.bytesUploaded = bytesUploaded;
+	m_frameStats.bytesSaved = bytesSaved;
+	StatsOverlayClass::SetCounter(m_metrics[3], m_frameStats.bytesUploaded / 1024);
+	StatsOverlayClass::SetCounter(m_metrics[4], m_frameStats.bytesSaved / 1024);
 
-	return true;
-}
\ No newline at end of file
+	return;
+}
+
+
+void TextClass::GetStats(StatsType& stats)
+{
+	stats = m_frameStats;
+	return;
+}
@@ -5,11 +5,34 @@
 #define _TEXTCLASS_H_
 
 
+/////////////
+// GLOBALS //
+/////////////
+const int TEXT_MAX_SENTENCES = 512;
+const int TEXT_SENTENCE_LENGTH = 48;
+
+
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
 #include "fontclass.h"
 #include "fontshaderclass.h"
+#include "ringbufferclass.h"
+#include "profilerclass.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// A copy of the glyph vertices of every sentence in use, taken on the main thread so the render thread can draw them
+// while the sentences change for the next frame.  The copy only ever grows so it does not allocate every frame.  The
+// version changes whenever a sentence does, an unchanged snapshot is neither copied nor uploaded again.
+struct TextSnapshotType
+{
+	char* vertices;
+	int vertexCount, capacity;
+	unsigned int version;
+};
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -18,17 +41,35 @@
 class TextClass
 {
 private:
+	struct VertexType
+	{
+		Vector3 position;
+	    Vector2 texture;
+		Vector4 color;
+	};
+
+	// The sentences are slots in a pool, each with room for TEXT_SENTENCE_LENGTH letters.  A sentence keeps the text,
+	// position and color it was last built with so an unchanged update costs nothing, and its glyph vertices stay in
+	// memory until it changes so they can be copied into the batch with every other sentence.
 	struct SentenceType
 	{
-		ID3D11Buffer *vertexBuffer, *indexBuffer;
-		int vertexCount, indexCount, maxLength;
+		bool inUse, textValid;
+		VertexType* vertices;
+		int vertexCount;
+		char text[TEXT_SENTENCE_LENGTH + 1];
+		int positionX, positionY;
 		float red, green, blue;
 	};
 
-	struct VertexType
+public:
+	// Counts for the last frame.  The sentences are counted when the snapshot is taken and the bytes are the glyph vertices
+	// the render thread wrote into the ring buffer and those it drew again from last frame's space because nothing had
+	// changed, handed back to the main thread with SetBytesUploaded.
+	struct StatsType
 	{
-		D3DXVECTOR3 position;
-	    D3DXVECTOR2 texture;
+		int sentences;
+		int sentencesUpdated, sentencesSkipped;
+		int bytesUploaded, bytesSaved;
 	};
 
 public:
@@ -36,28 +77,43 @@ public:
 	TextClass(const TextClass&);
 	~TextClass();
 
-	bool Initialize(ID3D11Device*, ID3D11DeviceContext*, HWND, int, int, D3DXMATRIX);
+	bool Initialize(RenderDeviceClass*, int, int, Matrix);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, FontShaderClass*, D3DXMATRIX, D3DXMATRIX);
 
-	bool SetVideoCardInfo(char*, int, ID3D11DeviceContext*);
-	bool SetFps(int, ID3D11DeviceContext*);
-	bool SetCpu(int, ID3D11DeviceContext*);
-	bool SetCameraPosition(float, float, float, ID3D11DeviceContext*);
-	bool SetCameraRotation(float, float, float, ID3D11DeviceContext*);
+	// The sentences are updated and copied into a snapshot on the main thread, the snapshot is rendered on the render
+	// thread and Render hands back how many bytes it uploaded and how many it did not have to.
+	bool TakeSnapshot(TextSnapshotType&);
+	static void ReleaseSnapshot(TextSnapshotType&);
+	bool Render(DrawListClass*, FontShaderClass*, Matrix, Matrix, RingBufferClass*, RenderDeviceClass*, const TextSnapshotType&, int&, int&);
+	void SetBytesUploaded(int, int);
+
+	// A sentence is a handle into the pool, -1 when the pool is empty.
+	int CreateSentence();
+	void ReleaseSentence(int);
+	bool UpdateSentence(int, const char*, int, int, float, float, float);
+
+	void GetStats(StatsType&);
 
 private:
-	bool InitializeSentence(SentenceType**, int, ID3D11Device*);
-	bool UpdateSentence(SentenceType*, char*, int, int, float, float, float, ID3D11DeviceContext*);
-	void ReleaseSentence(SentenceType**);
-	bool RenderSentence(SentenceType*, ID3D11DeviceContext*, FontShaderClass*, D3DXMATRIX, D3DXMATRIX);
+	bool InitializeBatch(RenderDeviceClass*);
+	bool UpdateBatch(RenderDeviceClass*, RingBufferClass*, const TextSnapshotType&, int&, int&);
+	void ReleaseBatch();
 
 private:
 	int m_screenWidth, m_screenHeight;
-	D3DXMATRIX m_baseViewMatrix;
+	Matrix m_baseViewMatrix;
 	FontClass* m_Font;
-	SentenceType *m_sentence1, *m_sentence2, *m_sentence3, *m_sentence4, *m_sentence5;
-	SentenceType *m_sentence6, *m_sentence7, *m_sentence8, *m_sentence9, *m_sentence10;
+	SentenceType* m_sentences;
+	VertexType* m_sentenceVertices;
+	int* m_freeSentences;
+	int m_freeCount;
+	unsigned int m_version;
+	RenderBuffer* m_indexBuffer;
+	int m_indexCount, m_baseVertex;
+	RingBufferClass::AllocationType m_allocation;
+	unsigned int m_uploadVersion;
+	StatsType m_stats, m_frameStats;
+	int m_metrics[5];
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -20,14 +20,11 @@ TextureClass::~TextureClass()
 }
 
 
-bool TextureClass::Initialize(ID3D11Device* device, WCHAR* filename)
+bool TextureClass::Initialize(RenderDeviceClass* device, char* filename)
 {
-	HRESULT result;
-
-
 	// Load the texture in.
-	result = D3DX11CreateShaderResourceViewFromFile(device, filename, NULL, NULL, &m_texture, NULL);
-	if(FAILED(result))
+	m_texture = device->CreateTextureFromFile(filename);
+	if(!m_texture)
 	{
 		return false;
 	}
@@ -49,7 +46,7 @@ void TextureClass::Shutdown()
 }
 
 
-ID3D11ShaderResourceView* TextureClass::GetTexture()
+RenderTexture* TextureClass::GetTexture()
 {
 	return m_texture;
 }
\ No newline at end of file
@@ -5,11 +5,10 @@
 #define _TEXTURECLASS_H_
 
 
-//////////////
-// INCLUDES //
-//////////////
-#include <d3d11.h>
-#include <d3dx11tex.h>
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -22,13 +21,13 @@ public:
 	TextureClass(const TextureClass&);
 	~TextureClass();
 
-	bool Initialize(ID3D11Device*, WCHAR*);
+	bool Initialize(RenderDeviceClass*, char*);
 	void Shutdown();
 
-	ID3D11ShaderResourceView* GetTexture();
+	RenderTexture* GetTexture();
 
 private:
-	ID3D11ShaderResourceView* m_texture;
+	RenderTexture* m_texture;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,706 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: enginebench.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Times the engine's hot paths against the code they replaced and checks both give the same results, a mismatch makes
+// it fail.  Everything runs headless so it works on any platform.
+//
+// Usage: enginebench [-quick] [section...]
+//
+// Without a section every one is run.  -quick runs a few repetitions, enough for ctest to check the results.
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mathreference.h"
+#include "clockclass.h"
+#include "nulldeviceclass.h"
+#include "terrainclass.h"
+#include "textclass.h"
+#include "fontshaderclass.h"
+#include "drawlistclass.h"
+#include "ringbufferclass.h"
+#include "jobsystemclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCH_VERTICES = 65536;
+const int BENCH_MATRICES = 4096;
+const int BENCH_SPHERES = 65536;
+const int BENCH_RUNS = 50;
+const int BENCH_QUICK_RUNS = 2;
+const int BENCH_TERRAIN_SIZES[3] = { 129, 257, 513 };
+const int BENCH_TEXT_SENTENCES = 32;
+const int BENCH_TEXT_FRAMES = 256;
+const int BENCH_JOB_THREADS[4] = { 1, 2, 4, 8 };
+const int BENCH_JOB_SPAWNS = 512;
+const int BENCH_JOB_RANGES = 256;
+const int BENCH_JOB_ITEMS = 1 << 20;
+const int BENCH_JOB_GRAIN = 4096;
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+typedef bool (*BenchFunction)();
+
+struct BenchSectionType
+{
+	const char* name;
+	BenchFunction function;
+};
+
+
+// The terrain and text vertex layouts, for replaying the way the meshes were uploaded before they were written into
+// mapped buffers.
+struct TerrainVertexType
+{
+	Vector3 position;
+	Vector2 texture;
+};
+
+struct TextVertexType
+{
+	Vector3 position;
+	Vector2 texture;
+	Vector4 color;
+};
+
+
+static int g_runs = BENCH_RUNS;
+
+
+static float RandomFloat(unsigned int& random, float minimum, float maximum)
+{
+	random = random * 1664525u + 1013904223u;
+
+	return minimum + (maximum - minimum) * (float)(random >> 8) / 16777216.0f;
+}
+
+
+// Prints the fastest run of each side in millions of items a second.
+static void PrintTimes(const char* name, int items, float engineTime, float referenceTime)
+{
+	printf("  %-24s %10.1f M/s %10.1f M/s %8.2fx\n", name, (float)items / (engineTime * 1000.0f), (float)items / (referenceTime * 1000.0f), 
+		   referenceTime / engineTime);
+
+	return;
+}
+
+
+static bool BenchMath()
+{
+	std::vector<Vector3> positions(BENCH_VERTICES);
+	std::vector<Vector4> output(BENCH_VERTICES), expected(BENCH_VERTICES);
+	std::vector<Matrix> matrices(BENCH_MATRICES), products(BENCH_MATRICES), expectedProducts(BENCH_MATRICES);
+	std::vector<Vector4> spheres(BENCH_SPHERES);
+	bool* visible;
+	bool* expectedVisible;
+	Matrix m, view, projection;
+	Frustum frustum;
+	Vector3 eye, at, up;
+	StopwatchClass stopwatch;
+	float engineTime, referenceTime, time;
+	unsigned int random;
+	int run, i, j, visibleCount, expectedCount;
+	bool result;
+
+
+	random = 1;
+
+	for(i=0; i<BENCH_VERTICES; i++)
+	{
+		positions[i] = Vector3(RandomFloat(random, -100.0f, 100.0f), RandomFloat(random, -100.0f, 100.0f), RandomFloat(random, -100.0f, 100.0f));
+	}
+
+	for(i=0; i<BENCH_MATRICES; i++)
+	{
+		for(j=0; j<16; j++)
+		{
+			matrices[i].m[j / 4][j % 4] = RandomFloat(random, -2.0f, 2.0f);
+		}
+	}
+
+	for(i=0; i<BENCH_SPHERES; i++)
+	{
+		spheres[i] = Vector4(RandomFloat(random, -80.0f, 80.0f), RandomFloat(random, -60.0f, 60.0f), RandomFloat(random, -40.0f, 120.0f), 
+							 RandomFloat(random, 0.0f, 4.0f));
+	}
+
+	m = matrices[0];
+
+	eye = Vector3(0.0f, 10.0f, -30.0f);
+	at = Vector3(0.0f, 0.0f, 0.0f);
+	up = Vector3(0.0f, 1.0f, 0.0f);
+	MatrixLookAtLH(&view, &eye, &at, &up);
+	MatrixPerspectiveFovLH(&projection, 0.785f, 1.333f, 0.1f, 100.0f);
+	MatrixMultiply(&view, &view, &projection);
+	FrustumFromMatrix(&frustum, &view);
+
+	visible = new bool[BENCH_SPHERES];
+	expectedVisible = new bool[BENCH_SPHERES];
+
+	printf("math: engine %s path against the scalar reference, fastest of %d runs\n", 
+#if defined(ENGINE_MATH_SSE)
+		   "sse",
+#elif defined(ENGINE_MATH_NEON)
+		   "neon",
+#else
+		   "scalar",
+#endif
+		   g_runs);
+	printf("  %-24s %14s %14s %9s\n", "", "engine", "reference", "speedup");
+
+	// Vec3TransformArray.
+	engineTime = referenceTime = 1.0e9f;
+	for(run=0; run<g_runs; run++)
+	{
+		stopwatch.Start();
+		Vec3TransformArray(&output[0], sizeof(Vector4), &positions[0], sizeof(Vector3), &m, BENCH_VERTICES);
+		time = stopwatch.Lap();
+		engineTime = (time < engineTime) ? time : engineTime;
+
+		ReferenceTransformArray(&expected[0], sizeof(Vector4), &positions[0], sizeof(Vector3), &m, BENCH_VERTICES);
+		time = stopwatch.Lap();
+		referenceTime = (time < referenceTime) ? time : referenceTime;
+	}
+
+	PrintTimes("Vec3TransformArray", BENCH_VERTICES, engineTime, referenceTime);
+	result = (memcmp(&output[0], &expected[0], sizeof(Vector4) * BENCH_VERTICES) == 0);
+
+	// MatrixMultiply, each product is chained onto the next so the calls can not overlap.
+	engineTime = referenceTime = 1.0e9f;
+	for(run=0; run<g_runs; run++)
+	{
+		stopwatch.Start();
+		products[0] = matrices[0];
+		for(i=1; i<BENCH_MATRICES; i++)
+		{
+			MatrixMultiply(&products[i], &products[i - 1], &matrices[i]);
+		}
+		time = stopwatch.Lap();
+		engineTime = (time < engineTime) ? time : engineTime;
+
+		expectedProducts[0] = matrices[0];
+		for(i=1; i<BENCH_MATRICES; i++)
+		{
+			ReferenceMatrixMultiply(&expectedProducts[i], &expectedProducts[i - 1], &matrices[i]);
+		}
+		time = stopwatch.Lap();
+		referenceTime = (time < referenceTime) ? time : referenceTime;
+	}
+
+	PrintTimes("MatrixMultiply", BENCH_MATRICES - 1, engineTime, referenceTime);
+	result = result && (memcmp(&products[0], &expectedProducts[0], sizeof(Matrix) * BENCH_MATRICES) == 0);
+
+	// FrustumCheckSpheres.
+	engineTime = referenceTime = 1.0e9f;
+	visibleCount = expectedCount = 0;
+	for(run=0; run<g_runs; run++)
+	{
+		stopwatch.Start();
+		visibleCount = FrustumCheckSpheres(&frustum, &spheres[0], BENCH_SPHERES, visible);
+		time = stopwatch.Lap();
+		engineTime = (time < engineTime) ? time : engineTime;
+
+		expectedCount = ReferenceCheckSpheres(&frustum, &spheres[0], BENCH_SPHERES, expectedVisible);
+		time = stopwatch.Lap();
+		referenceTime = (time < referenceTime) ? time : referenceTime;
+	}
+
+	PrintTimes("FrustumCheckSpheres", BENCH_SPHERES, engineTime, referenceTime);
+	result = result && (visibleCount == expectedCount) && (memcmp(visible, expectedVisible, BENCH_SPHERES) == 0);
+
+	delete [] visible;
+	delete [] expectedVisible;
+
+	printf("  results %s\n", result ? "match" : "DIFFER");
+
+	return result;
+}
+
+
+// The terrain mesh as it was built before: a heap array of vertices and one of indices, both copied into new static
+// buffers.  Returns the bytes written, to the arrays and by the copies.
+static int BuildTerrainBefore(RenderDeviceClass* device, const Vector3* heightMap, int width, int height, RenderBuffer*& vertexBuffer, 
+							  RenderBuffer*& indexBuffer)
+{
+	static const int corners[2][6] = { { 3, 4, 2, 2, 1, 3 }, { 3, 4, 1, 1, 4, 2 } };
+	TerrainVertexType* vertices;
+	unsigned int* indices;
+	const Vector3* point;
+	int vertexCount, index, cornerIndex[5], i, j, k;
+	float textureScaleU, textureScaleV, textureOffsetU, textureOffsetV;
+
+
+	vertexCount = (width - 1) * (height - 1) * 6;
+
+	vertices = new TerrainVertexType[vertexCount];
+	indices = new unsigned int[vertexCount];
+
+	textureScaleU = (float)NORMAL_MAP_SCALE / (float)(width * NORMAL_MAP_SCALE);
+	textureScaleV = (float)NORMAL_MAP_SCALE / (float)(height * NORMAL_MAP_SCALE);
+	textureOffsetU = 0.5f / (float)(width * NORMAL_MAP_SCALE);
+	textureOffsetV = 0.5f / (float)(height * NORMAL_MAP_SCALE);
+
+	index = 0;
+	for(j=0; j<(height-1); j++)
+	{
+		for(i=0; i<(width-1); i++)
+		{
+			cornerIndex[1] = (height * j) + i;
+			cornerIndex[2] = (height * j) + (i+1);
+			cornerIndex[3] = (height * (j+1)) + i;
+			cornerIndex[4] = (height * (j+1)) + (i+1);
+
+			for(k=0; k<6; k++)
+			{
+				point = &heightMap[cornerIndex[corners[((i + j) % 2 != 0) ? 0 : 1][k]]];
+				vertices[index].position = *point;
+				vertices[index].texture = Vector2((point->x * textureScaleU) + textureOffsetU, (point->z * textureScaleV) + textureOffsetV);
+				indices[index] = index;
+				index++;
+			}
+		}
+	}
+
+	if(vertexBuffer)
+	{
+		vertexBuffer->Release();
+		indexBuffer->Release();
+	}
+
+	vertexBuffer = device->CreateBuffer(RENDER_BUFFER_VERTEX, RENDER_USAGE_STATIC, sizeof(TerrainVertexType) * vertexCount, vertices);
+	indexBuffer = device->CreateBuffer(RENDER_BUFFER_INDEX, RENDER_USAGE_STATIC, sizeof(unsigned int) * vertexCount, indices);
+
+	delete [] vertices;
+	delete [] indices;
+
+	return 2 * (sizeof(TerrainVertexType) + sizeof(unsigned int)) * vertexCount;
+}
+
+
+static bool BenchTerrainRebuild(NullDeviceClass* device, int size)
+{
+	TerrainClass terrain;
+	RenderBuffer* vertexBuffer;
+	RenderBuffer* indexBuffer;
+	Vector3* heightMap;
+	StopwatchClass stopwatch;
+	char label[32];
+	float beforeTime, afterTime, time;
+	int beforeBytes, afterBytes, deviceBytes, run, i, j;
+	bool result;
+
+
+	result = terrain.InitializeTerrain(device, size, size);
+	if(!result)
+	{
+		printf("  terrain %dx%d failed to initialize\n", size, size);
+		return false;
+	}
+
+	heightMap = new Vector3[size * size];
+	for(j=0; j<size; j++)
+	{
+		for(i=0; i<size; i++)
+		{
+			heightMap[(size * j) + i] = Vector3((float)i, sinf((float)i * 0.1f) * 4.0f, (float)j);
+		}
+	}
+
+	vertexBuffer = 0;
+	indexBuffer = 0;
+	beforeTime = afterTime = 1.0e9f;
+	beforeBytes = afterBytes = 0;
+
+	for(run=0; result && (run<g_runs); run++)
+	{
+		// Before, every rebuild allocated, filled and copied both arrays.
+		stopwatch.Start();
+		beforeBytes = BuildTerrainBefore(device, heightMap, size, size, vertexBuffer, indexBuffer);
+		time = stopwatch.GetMilliseconds();
+		beforeTime = (time < beforeTime) ? time : beforeTime;
+
+		// Now new heights rebuild the mesh straight into the mapped vertex buffer.
+		result = terrain.GenerateHeightMap();
+		if(result)
+		{
+			deviceBytes = device->GetCounters().bytesMapped + device->GetCounters().bytesInitialized;
+			result = terrain.Upload(device);
+			deviceBytes = device->GetCounters().bytesMapped + device->GetCounters().bytesInitialized - deviceBytes;
+
+			afterBytes = terrain.GetMeshBytes();
+			afterTime = (terrain.GetMeshTime() < afterTime) ? terrain.GetMeshTime() : afterTime;
+
+			// The mesh is the only buffer data written and it is written once.
+			result = (deviceBytes == afterBytes) && (afterBytes == (int)sizeof(TerrainVertexType) * terrain.GetIndexCount());
+		}
+	}
+
+	if(vertexBuffer)
+	{
+		vertexBuffer->Release();
+		indexBuffer->Release();
+	}
+
+	delete [] heightMap;
+	terrain.Shutdown();
+
+	if(result)
+	{
+		sprintf(label, "terrain %dx%d", size, size);
+		printf("  %-22s %8d KB %8.3f ms %8d KB %8.3f ms\n", label, beforeBytes / 1024, beforeTime, afterBytes / 1024, afterTime);
+	}
+	else
+	{
+		printf("  terrain %dx%d rebuild wrote the wrong number of bytes\n", size, size);
+	}
+
+	return result;
+}
+
+
+static bool BenchTextRebuild(NullDeviceClass* device)
+{
+	TextClass text;
+	FontShaderClass fontShader;
+	DrawListClass drawList;
+	RingBufferClass ringBuffer;
+	TextSnapshotType snapshot;
+	RingBufferClass::StatsType ringStats;
+	RenderBuffer* batchBuffer;
+	char* gathered;
+	char* shadow;
+	Matrix identity;
+	StopwatchClass stopwatch;
+	char sentence[TEXT_SENTENCE_LENGTH + 1];
+	char label[32];
+	int sentences[BENCH_TEXT_SENTENCES];
+	int frames, frame, batchBytes, bytesUploaded, bytesSaved, pass, i;
+	unsigned int version;
+	long long beforeBytes, afterBytes;
+	float beforeTime, afterTime;
+	bool result;
+
+
+	MatrixIdentity(&identity);
+
+	result = text.Initialize(device, 1024, 768, identity);
+	result = result && fontShader.Initialize(device);
+	result = result && drawList.Initialize(64, 64 * 1024);
+	result = result && ringBuffer.Initialize(device, 1024 * 1024);
+	if(!result)
+	{
+		printf("  text failed to initialize\n");
+		return false;
+	}
+
+	// A HUD of full sentences where one value changes every frame.
+	for(i=0; i<BENCH_TEXT_SENTENCES; i++)
+	{
+		sentences[i] = text.CreateSentence();
+		sprintf(sentence, "Sentence %2d of the heads up display %5d", i, 0);
+		text.UpdateSentence(sentences[i], sentence, 8, 8 + (i * 16), 1.0f, 1.0f, 1.0f);
+	}
+
+	memset(&snapshot, 0, sizeof(TextSnapshotType));
+	frames = (g_runs < BENCH_RUNS) ? 8 : BENCH_TEXT_FRAMES;
+
+	batchBuffer = device->CreateBuffer(RENDER_BUFFER_VERTEX, RENDER_USAGE_DYNAMIC, sizeof(TextVertexType) * TEXT_MAX_SENTENCES * TEXT_SENTENCE_LENGTH * 4, 0);
+	gathered = new char[sizeof(TextVertexType) * TEXT_MAX_SENTENCES * TEXT_SENTENCE_LENGTH * 4];
+	shadow = new char[sizeof(TextVertexType) * TEXT_MAX_SENTENCES * TEXT_SENTENCE_LENGTH * 4];
+	memset(shadow, 0, sizeof(TextVertexType) * TEXT_MAX_SENTENCES * TEXT_SENTENCE_LENGTH * 4);
+
+	// The first pass changes one value every frame, the second changes nothing.
+	for(pass=0; result && (pass<2); pass++)
+	{
+		beforeBytes = afterBytes = 0;
+		beforeTime = afterTime = 0.0f;
+
+		for(frame=0; result && (frame<frames); frame++)
+		{
+			if(pass == 0)
+			{
+				sprintf(sentence, "Sentence %2d of the heads up display %5d", frame % BENCH_TEXT_SENTENCES, frame);
+				text.UpdateSentence(sentences[frame % BENCH_TEXT_SENTENCES], sentence, 8, 8 + ((frame % BENCH_TEXT_SENTENCES) * 16), 1.0f, 1.0f, 1.0f);
+			}
+
+			// Now the main thread copies the sentences into the snapshot if they changed and the render thread writes it
+			// into the ring or draws last frame's copy again.
+			version = snapshot.version;
+
+			stopwatch.Start();
+			result = text.TakeSnapshot(snapshot);
+			drawList.Reset();
+			result = result && text.Render(&drawList, &fontShader, identity, identity, &ringBuffer, device, snapshot, bytesUploaded, bytesSaved);
+			ringBuffer.EndFrame(device, ringStats);
+			afterTime += stopwatch.GetMilliseconds();
+
+			batchBytes = snapshot.vertexCount * sizeof(TextVertexType);
+			afterBytes += bytesUploaded;
+			if(snapshot.version != version)
+			{
+				afterBytes += batchBytes;
+			}
+
+			// Before, the sentences were gathered into frame memory, compared against the buffer's shadow copy and
+			// uploaded and copied into the shadow when they differed.
+			stopwatch.Start();
+			memcpy(gathered, snapshot.vertices, batchBytes);
+			beforeBytes += batchBytes;
+
+			if(memcmp(gathered, shadow, batchBytes) != 0)
+			{
+				memcpy(device->MapBuffer(batchBuffer, RENDER_MAP_DISCARD), gathered, batchBytes);
+				device->UnmapBuffer(batchBuffer);
+				memcpy(shadow, gathered, batchBytes);
+				beforeBytes += 2 * batchBytes;
+			}
+
+			beforeTime += stopwatch.GetMilliseconds();
+		}
+
+		sprintf(label, (pass == 0) ? "text %d lines, a frame" : "text %d lines, static", BENCH_TEXT_SENTENCES);
+		printf("  %-22s %8d KB %8.3f ms %8d KB %8.3f ms\n", label, (int)(beforeBytes / frames / 1024), beforeTime / frames, 
+			   (int)(afterBytes / frames / 1024), afterTime / frames);
+	}
+
+	// Nothing changed in the second pass, so nothing should have been written.
+	if(result && (afterBytes != 0))
+	{
+		printf("  text wrote vertices when no sentence had changed\n");
+		result = false;
+	}
+
+	batchBuffer->Release();
+	delete [] gathered;
+	delete [] shadow;
+
+	TextClass::ReleaseSnapshot(snapshot);
+	for(i=0; i<BENCH_TEXT_SENTENCES; i++)
+	{
+		text.ReleaseSentence(sentences[i]);
+	}
+
+	ringBuffer.Shutdown();
+	drawList.Shutdown();
+	fontShader.Shutdown();
+	text.Shutdown();
+
+	return result;
+}
+
+
+static bool BenchRebuild()
+{
+	NullDeviceClass device;
+	bool result;
+	int i;
+
+
+	result = device.Initialize(1024, 768, 1000.0f, 0.1f);
+	if(!result)
+	{
+		return false;
+	}
+
+	printf("rebuild: bytes written per mesh rebuild on the null device, before and after building into mapped buffers\n");
+	printf("  %-22s %23s %23s\n", "", "before", "after");
+
+	for(i=0; result && (i<3); i++)
+	{
+		result = BenchTerrainRebuild(&device, BENCH_TERRAIN_SIZES[i]);
+	}
+
+	result = result && BenchTextRebuild(&device);
+
+	device.Shutdown();
+
+	return result;
+}
+
+
+static void EmptyJob(void* data, int start, int end)
+{
+	return;
+}
+
+
+// A few rounds of arithmetic on every item, the same on every thread count so the results can be compared exactly.
+static void WorkJob(void* data, int start, int end)
+{
+	float* items;
+	float value;
+	int i, j;
+
+
+	items = (float*)data;
+
+	for(i=start; i<end; i++)
+	{
+		value = (float)i;
+		for(j=0; j<8; j++)
+		{
+			value = value * 0.5f + 1.0f / (value + 1.0f);
+		}
+
+		items[i] = value;
+	}
+
+	return;
+}
+
+
+// Times what it costs to add jobs and wait on them and how a real loop scales, on each thread count in turn.
+static bool BenchJobs()
+{
+	JobSystemClass* jobSystem;
+	JobCounterType counter;
+	std::vector<float> items(BENCH_JOB_ITEMS), expected(BENCH_JOB_ITEMS);
+	StopwatchClass stopwatch;
+	float spawnTime, forTime, workTime, singleTime, time;
+	int threadCount, count, run, i, j;
+	bool result;
+
+
+	WorkJob(&expected[0], 0, BENCH_JOB_ITEMS);
+
+	count = (g_runs < BENCH_RUNS) ? 2 : 4;
+
+	printf("jobs: cost of adding jobs and ParallelFor scaling on %d hardware threads, fastest of %d runs\n", 
+		   (int)std::thread::hardware_concurrency(), g_runs);
+	printf("  %-8s %14s %16s %12s %9s\n", "threads", "run+wait", "parallel for", "work", "speedup");
+
+	result = true;
+	singleTime = 0.0f;
+
+	for(i=0; result && (i<count); i++)
+	{
+		threadCount = BENCH_JOB_THREADS[i];
+
+		jobSystem = new JobSystemClass;
+		if(!jobSystem || !jobSystem->Initialize(threadCount))
+		{
+			printf("  the job system failed to initialize on %d threads\n", threadCount);
+			delete jobSystem;
+			return false;
+		}
+
+		spawnTime = forTime = workTime = 1.0e9f;
+		for(run=0; run<g_runs; run++)
+		{
+			// Empty jobs added one at a time and waited on together.
+			counter.pending = 0;
+			stopwatch.Start();
+			for(j=0; j<BENCH_JOB_SPAWNS; j++)
+			{
+				JobSystemClass::Run(&EmptyJob, 0, 0, 1, &counter);
+			}
+			JobSystemClass::Wait(&counter);
+			time = stopwatch.Lap();
+			spawnTime = (time < spawnTime) ? time : spawnTime;
+
+			// A ParallelFor with nothing to do, split as finely as it goes.
+			JobSystemClass::ParallelFor(&EmptyJob, 0, BENCH_JOB_RANGES, 1);
+			time = stopwatch.Lap();
+			forTime = (time < forTime) ? time : forTime;
+
+			// A loop with real work in it.
+			memset(&items[0], 0, sizeof(float) * BENCH_JOB_ITEMS);
+			stopwatch.Lap();
+			JobSystemClass::ParallelFor(&WorkJob, &items[0], BENCH_JOB_ITEMS, BENCH_JOB_GRAIN);
+			time = stopwatch.Lap();
+			workTime = (time < workTime) ? time : workTime;
+
+			result = result && (counter.pending.load() == 0);
+			result = result && (memcmp(&items[0], &expected[0], sizeof(float) * BENCH_JOB_ITEMS) == 0);
+		}
+
+		if(threadCount == 1)
+		{
+			singleTime = workTime;
+		}
+
+		printf("  %-8d %8.1f ns/job %10.2f us/call %9.3f ms %8.2fx\n", JobSystemClass::GetThreadCount(), 
+			   spawnTime * 1.0e6f / BENCH_JOB_SPAWNS, forTime * 1000.0f, workTime, singleTime / workTime);
+
+		jobSystem->Shutdown();
+		delete jobSystem;
+	}
+
+	printf("  results %s\n", result ? "match" : "DIFFER");
+
+	return result;
+}
+
+
+static const BenchSectionType g_sections[] =
+{
+	{ "math", &BenchMath },
+	{ "rebuild", &BenchRebuild },
+	{ "jobs", &BenchJobs }
+};
+
+
+int main(int argc, char** argv)
+{
+	bool selected[sizeof(g_sections) / sizeof(BenchSectionType)];
+	int sectionCount, i, j;
+	bool any, result;
+
+
+	sectionCount = sizeof(g_sections) / sizeof(BenchSectionType);
+	any = false;
+
+	for(j=0; j<sectionCount; j++)
+	{
+		selected[j] = false;
+	}
+
+	for(i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "-quick") == 0)
+		{
+			g_runs = BENCH_QUICK_RUNS;
+			continue;
+		}
+
+		for(j=0; j<sectionCount; j++)
+		{
+			if(strcmp(argv[i], g_sections[j].name) == 0)
+			{
+				selected[j] = true;
+				any = true;
+				break;
+			}
+		}
+
+		if(j == sectionCount)
+		{
+			printf("unknown section %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	result = true;
+	for(j=0; j<sectionCount; j++)
+	{
+		if(!any || selected[j])
+		{
+			result = g_sections[j].function() && result;
+		}
+	}
+
+	return result ? 0 : 1;
+}
@@ -0,0 +1,288 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: goldenimagetest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Renders the height map terrain and a line of text on the software device and compares the frame against a reference
+// image checked in next to the test.  It runs from the Engine directory so the data paths are the same as the game's.
+//
+// Usage: goldenimagetest <reference.bmp> [-update]
+//
+// With -update the reference is written from the frame instead, for when a change to the renderer is meant to change
+// the picture.  A failing run saves what it drew as goldenimage_actual.bmp in the working directory.
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "testhelpers.h"
+#include "softwaredeviceclass.h"
+#include "jobsystemclass.h"
+#include "cameraclass.h"
+#include "lightclass.h"
+#include "terrainclass.h"
+#include "terrainshaderclass.h"
+#include "fontshaderclass.h"
+#include "textclass.h"
+#include "drawlistclass.h"
+#include "ringbufferclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int GOLDEN_WIDTH = 256;
+const int GOLDEN_HEIGHT = 192;
+const int GOLDEN_THREADS = 4;
+
+// Channels may differ by a step or two where the compiler rounds differently, a pixel only counts as wrong past that
+// and a few of those are allowed along triangle edges.
+const int GOLDEN_CHANNEL_TOLERANCE = 2;
+const int GOLDEN_MAX_WRONG_PIXELS = 16;
+
+
+// Reads a 24 bit bottom up bitmap as written by SaveFrame into top down blue, green, red, alpha bytes.
+static unsigned char* LoadFrame(const char* filename, int& width, int& height)
+{
+	FILE* filePtr;
+	unsigned char header[54];
+	unsigned char* row;
+	unsigned char* frame;
+	int rowSize, x, y;
+	bool result;
+
+
+	filePtr = fopen(filename, "rb");
+	if(!filePtr)
+	{
+		return 0;
+	}
+
+	if((fread(header, 1, sizeof(header), filePtr) != sizeof(header)) || (header[0] != 'B') || (header[1] != 'M') || (header[28] != 24))
+	{
+		fclose(filePtr);
+		return 0;
+	}
+
+	width = header[18] | (header[19] << 8) | (header[20] << 16) | (header[21] << 24);
+	height = header[22] | (header[23] << 8) | (header[24] << 16) | (header[25] << 24);
+	if((width <= 0) || (height <= 0))
+	{
+		fclose(filePtr);
+		return 0;
+	}
+
+	rowSize = (width * 3 + 3) & ~3;
+	row = new unsigned char[rowSize];
+	frame = new unsigned char[width * height * 4];
+
+	result = true;
+	for(y=height-1; result && (y>=0); y--)
+	{
+		result = (fread(row, 1, rowSize, filePtr) == (size_t)rowSize);
+
+		for(x=0; result && (x<width); x++)
+		{
+			frame[(y * width + x) * 4 + 0] = row[x * 3 + 0];
+			frame[(y * width + x) * 4 + 1] = row[x * 3 + 1];
+			frame[(y * width + x) * 4 + 2] = row[x * 3 + 2];
+			frame[(y * width + x) * 4 + 3] = 255;
+		}
+	}
+
+	fclose(filePtr);
+	delete [] row;
+
+	if(!result)
+	{
+		delete [] frame;
+		return 0;
+	}
+
+	return frame;
+}
+
+
+// Draws the scene the same way the render thread does, terrain in the opaque pass and the text in the overlay pass.
+static bool RenderScene(SoftwareDeviceClass* device)
+{
+	CameraClass camera;
+	LightClass light;
+	TerrainClass terrain;
+	TerrainShaderClass terrainShader;
+	FontShaderClass fontShader;
+	TextClass text;
+	DrawListClass drawList;
+	RingBufferClass ringBuffer;
+	TextSnapshotType snapshot;
+	RingBufferClass::StatsType ringStats;
+	DrawPacketType packet;
+	Matrix baseViewMatrix, worldMatrix, viewMatrix, projectionMatrix, orthoMatrix;
+	int sentence, bytesUploaded, bytesSaved;
+	bool result;
+
+
+	camera.SetPosition(0.0f, 0.0f, -1.0f);
+	camera.Render();
+	camera.GetViewMatrix(baseViewMatrix);
+
+	// Look down across the height map from its near edge.
+	camera.SetPosition(128.0f, 45.0f, -30.0f);
+	camera.SetRotation(30.0f, 0.0f, 0.0f);
+	camera.Render();
+
+	light.SetAmbientColor(0.15f, 0.15f, 0.15f, 1.0f);
+	light.SetDiffuseColor(1.0f, 0.95f, 0.85f, 1.0f);
+	light.SetDirection(-0.6f, -0.5f, 0.4f);
+
+	result = terrain.Initialize(device, (char*)"../Engine/data/heightmap01.bmp");
+	if(!TEST_CHECK(result))
+	{
+		return false;
+	}
+
+	// Bake the occlusion and the shadows and write them to the light map texture.
+	result = terrain.UpdateLightMap(light.GetDirection());
+	if(result && terrain.IsUploadPending())
+	{
+		result = terrain.Upload(device);
+	}
+
+	result = result && terrainShader.Initialize(device);
+	result = result && fontShader.Initialize(device);
+	result = result && text.Initialize(device, GOLDEN_WIDTH, GOLDEN_HEIGHT, baseViewMatrix);
+	result = result && drawList.Initialize(1024, 1024 * 1024);
+	result = result && ringBuffer.Initialize(device, 256 * 1024);
+	if(!TEST_CHECK(result))
+	{
+		terrain.Shutdown();
+		return false;
+	}
+
+	sentence = text.CreateSentence();
+	result = text.UpdateSentence(sentence, "Golden 0123", 8, 8, 1.0f, 1.0f, 0.0f);
+
+	memset(&snapshot, 0, sizeof(TextSnapshotType));
+	result = result && text.TakeSnapshot(snapshot);
+	TEST_CHECK(result);
+
+	device->GetWorldMatrix(worldMatrix);
+	camera.GetViewMatrix(viewMatrix);
+	device->GetProjectionMatrix(projectionMatrix);
+	device->GetOrthoMatrix(orthoMatrix);
+
+	device->BeginScene(0.2f, 0.3f, 0.5f, 1.0f);
+	drawList.Reset();
+
+	memset(&packet, 0, sizeof(DrawPacketType));
+	packet.pass = DRAW_PASS_OPAQUE;
+	terrain.Render(packet);
+
+	result = result && terrainShader.Render(&drawList, packet, worldMatrix, viewMatrix, projectionMatrix, terrain.GetNormalMap(), terrain.GetLightMap(),
+											light.GetAmbientColor(), light.GetDiffuseColor(), light.GetDirection());
+	result = result && text.Render(&drawList, &fontShader, worldMatrix, orthoMatrix, &ringBuffer, device, snapshot, bytesUploaded, bytesSaved);
+	TEST_CHECK(result);
+
+	drawList.Sort();
+	result = result && drawList.Execute(device);
+	TEST_CHECK(result);
+
+	ringBuffer.EndFrame(device, ringStats);
+	device->EndScene();
+
+	TextClass::ReleaseSnapshot(snapshot);
+	text.ReleaseSentence(sentence);
+
+	ringBuffer.Shutdown();
+	drawList.Shutdown();
+	text.Shutdown();
+	fontShader.Shutdown();
+	terrainShader.Shutdown();
+	terrain.Shutdown();
+
+	return result;
+}
+
+
+int main(int argc, char** argv)
+{
+	JobSystemClass jobSystem;
+	SoftwareDeviceClass device;
+	const unsigned char* frame;
+	unsigned char* reference;
+	int width, height, wrongPixels, maxDifference, difference, pitch, i, j, k;
+	bool result, update;
+
+
+	if(argc < 2)
+	{
+		printf("usage: goldenimagetest <reference.bmp> [-update]\n");
+		return 1;
+	}
+
+	update = (argc > 2) && (strcmp(argv[2], "-update") == 0);
+
+	// Bin and shade on several threads, the picture must not depend on how the tiles were shared out.
+	result = jobSystem.Initialize(GOLDEN_THREADS);
+	result = result && device.Initialize(GOLDEN_WIDTH, GOLDEN_HEIGHT, 1000.0f, 0.1f);
+	if(!TEST_CHECK(result))
+	{
+		return TestResult("goldenimage");
+	}
+
+	result = RenderScene(&device);
+
+	frame = device.GetFrameData();
+	pitch = device.GetFramePitch();
+
+	if(result && update)
+	{
+		TEST_CHECK(device.SaveFrame(argv[1]));
+		printf("wrote %s\n", argv[1]);
+	}
+	else if(result)
+	{
+		reference = LoadFrame(argv[1], width, height);
+		if(TEST_CHECK(reference != 0) && TEST_CHECK((width == GOLDEN_WIDTH) && (height == GOLDEN_HEIGHT)))
+		{
+			wrongPixels = 0;
+			maxDifference = 0;
+
+			for(j=0; j<height; j++)
+			{
+				for(i=0; i<width; i++)
+				{
+					for(k=0; k<3; k++)
+					{
+						difference = abs((int)frame[j * pitch + i * 4 + k] - (int)reference[(j * width + i) * 4 + k]);
+						maxDifference = (difference > maxDifference) ? difference : maxDifference;
+						if(difference > GOLDEN_CHANNEL_TOLERANCE)
+						{
+							wrongPixels++;
+							break;
+						}
+					}
+				}
+			}
+
+			printf("%d pixels differ from the reference, largest channel difference %d\n", wrongPixels, maxDifference);
+			if(!TEST_CHECK(wrongPixels <= GOLDEN_MAX_WRONG_PIXELS))
+			{
+				device.SaveFrame("goldenimage_actual.bmp");
+			}
+		}
+
+		delete [] reference;
+	}
+
+	device.Shutdown();
+	jobSystem.Shutdown();
+
+	return TestResult("goldenimage");
+}
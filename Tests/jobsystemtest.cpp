@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemtest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Checks that threads other than the workers hand their queues back when they exit, that a job left behind in such a
+// queue still runs, and that a thread which outlives one job system gets a fresh queue from the next.
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "testhelpers.h"
+#include "jobsystemclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int TEST_THREAD_RUNS = JOB_MAX_THREADS * 3;
+const int TEST_JOBS = 8;
+
+
+static std::atomic<int> g_jobsRun;
+
+
+static void CountJob(void* data, int start, int end)
+{
+	g_jobsRun.fetch_add(end - start);
+	return;
+}
+
+
+// Adds a few jobs and waits on them, then exits.
+static void AddAndWait()
+{
+	JobCounterType counter;
+	int i;
+
+
+	counter.pending = 0;
+
+	for(i=0; i<TEST_JOBS; i++)
+	{
+		JobSystemClass::Run(&CountJob, 0, i, i + 1, &counter);
+	}
+
+	JobSystemClass::Wait(&counter);
+
+	return;
+}
+
+
+// Adds a few jobs and exits without waiting on them.
+static void AddAndExit(JobCounterType* counter)
+{
+	int i;
+
+
+	for(i=0; i<TEST_JOBS; i++)
+	{
+		JobSystemClass::Run(&CountJob, 0, i, i + 1, counter);
+	}
+
+	return;
+}
+
+
+// Adds jobs under the first job system, then waits for the test to start the second one and adds jobs under that.
+static void AddAcrossRestart(std::atomic<int>* step)
+{
+	AddAndWait();
+	step->store(1);
+
+	while(step->load() != 2)
+	{
+		std::this_thread::yield();
+	}
+
+	AddAndWait();
+
+	return;
+}
+
+
+static void TestQueueRelease()
+{
+	JobSystemClass jobSystem;
+	JobSystemClass::StatsType stats;
+	JobCounterType counter;
+	std::thread thread;
+	int i;
+
+
+	TEST_CHECK(jobSystem.Initialize(2));
+
+	// Far more threads come and go than there are queues, each would keep its queue for good if it were not handed back
+	// and the later ones would have to run their jobs inline.
+	g_jobsRun = 0;
+	for(i=0; i<TEST_THREAD_RUNS; i++)
+	{
+		thread = std::thread(&AddAndWait);
+		thread.join();
+	}
+
+	jobSystem.Frame();
+	jobSystem.GetStats(stats);
+	TEST_CHECK(g_jobsRun.load() == TEST_THREAD_RUNS * TEST_JOBS);
+	TEST_CHECK(stats.jobsInline == 0);
+	TEST_CHECK(stats.jobsRun == TEST_THREAD_RUNS * TEST_JOBS);
+
+	jobSystem.Shutdown();
+
+	// With no workers only the thread itself can run its jobs, so they are all done by the time it has exited.
+	TEST_CHECK(jobSystem.Initialize(1));
+
+	g_jobsRun = 0;
+	counter.pending = 0;
+	thread = std::thread(&AddAndExit, &counter);
+	thread.join();
+
+	TEST_CHECK(counter.pending.load() == 0);
+	TEST_CHECK(g_jobsRun.load() == TEST_JOBS);
+
+	jobSystem.Shutdown();
+
+	return;
+}
+
+
+static void TestRestart()
+{
+	JobSystemClass jobSystem;
+	JobSystemClass::StatsType stats;
+	std::atomic<int> step;
+	std::thread thread;
+
+
+	// A thread adds jobs under one job system and then again under the next, the queue it took the first time went
+	// with the first job system.
+	TEST_CHECK(jobSystem.Initialize(2));
+
+	g_jobsRun = 0;
+	step = 0;
+
+	thread = std::thread(&AddAcrossRestart, &step);
+
+	while(step.load() != 1)
+	{
+		std::this_thread::yield();
+	}
+
+	jobSystem.Shutdown();
+	TEST_CHECK(jobSystem.Initialize(2));
+	step = 2;
+
+	thread.join();
+
+	jobSystem.Frame();
+	jobSystem.GetStats(stats);
+	TEST_CHECK(g_jobsRun.load() == 2 * TEST_JOBS);
+	TEST_CHECK(stats.jobsRun == TEST_JOBS);
+	TEST_CHECK(stats.jobsInline == 0);
+
+	jobSystem.Shutdown();
+
+	return;
+}
+
+
+int main()
+{
+	TestQueueRelease();
+	TestRestart();
+
+	return TestResult("jobsystem");
+}
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mathreference.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MATHREFERENCE_H_
+#define _MATHREFERENCE_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mathclass.h"
+
+
+// Plain loops that add the terms in the same order as every path in mathclass.cpp, so the results have to match them
+// bit for bit.  They are also the scalar side of the math benchmark.
+static inline void ReferenceTransformArray(Vector4* out, int outStride, const Vector3* in, int inStride, const Matrix* m, int count)
+{
+	const float* v;
+	float* result;
+	int i, j;
+
+
+	for(i=0; i<count; i++)
+	{
+		v = (const float*)((const char*)in + i * inStride);
+		result = (float*)((char*)out + i * outStride);
+
+		for(j=0; j<4; j++)
+		{
+			result[j] = ((m->m[0][j] * v[0]) + (m->m[1][j] * v[1])) + ((m->m[2][j] * v[2]) + m->m[3][j]);
+		}
+	}
+
+	return;
+}
+
+
+static inline void ReferenceMatrixMultiply(Matrix* out, const Matrix* a, const Matrix* b)
+{
+	Matrix result;
+	int i, j;
+
+
+	for(i=0; i<4; i++)
+	{
+		for(j=0; j<4; j++)
+		{
+			result.m[i][j] = ((b->m[0][j] * a->m[i][0]) + (b->m[1][j] * a->m[i][1])) + ((b->m[2][j] * a->m[i][2]) + (b->m[3][j] * a->m[i][3]));
+		}
+	}
+
+	*out = result;
+
+	return;
+}
+
+
+static inline int ReferenceCheckSpheres(const Frustum* frustum, const Vector4* spheres, int count, bool* visible)
+{
+	const Plane* plane;
+	int i, j, visibleCount;
+
+
+	visibleCount = 0;
+
+	for(i=0; i<count; i++)
+	{
+		visible[i] = true;
+
+		for(j=0; j<6; j++)
+		{
+			plane = &frustum->planes[j];
+			if((plane->a * spheres[i].x) + (plane->b * spheres[i].y) + (plane->c * spheres[i].z) + plane->d < -spheres[i].w)
+			{
+				visible[i] = false;
+				break;
+			}
+		}
+
+		visibleCount += visible[i] ? 1 : 0;
+	}
+
+	return visibleCount;
+}
+
+#endif
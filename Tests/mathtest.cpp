@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mathtest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Checks the batch transforms, the matrix multiply and the sphere culling against the reference loops bit for bit.  It
+// is built once for the SIMD path of the machine and once with ENGINE_MATH_SCALAR, both passing means the paths agree.
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <string.h>
+#include <vector>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "testhelpers.h"
+#include "mathreference.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int MATH_TEST_VERTICES = 1001;
+const int MATH_TEST_MATRICES = 256;
+const int MATH_TEST_SPHERES = 4099;
+
+
+// A vertex with the position at the front and other data after it, like the terrain and text vertices.
+struct StridedVertexType
+{
+	Vector3 position;
+	float texture[2];
+};
+
+struct StridedOutputType
+{
+	Vector4 position;
+	float extra[6];
+};
+
+
+static unsigned int g_random = 12345;
+
+
+static float RandomFloat(float minimum, float maximum)
+{
+	g_random = g_random * 1664525u + 1013904223u;
+
+	return minimum + (maximum - minimum) * (float)(g_random >> 8) / 16777216.0f;
+}
+
+
+static void RandomMatrix(Matrix* m, float range)
+{
+	int i, j;
+
+
+	for(i=0; i<4; i++)
+	{
+		for(j=0; j<4; j++)
+		{
+			m->m[i][j] = RandomFloat(-range, range);
+		}
+	}
+
+	return;
+}
+
+
+static void TestTransformArray()
+{
+	std::vector<StridedVertexType> input(MATH_TEST_VERTICES);
+	std::vector<StridedOutputType> output(MATH_TEST_VERTICES), expected(MATH_TEST_VERTICES);
+	std::vector<Vector4> packed(MATH_TEST_VERTICES), packedExpected(MATH_TEST_VERTICES);
+	Matrix m;
+	int i, wrong;
+
+
+	for(i=0; i<MATH_TEST_VERTICES; i++)
+	{
+		input[i].position = Vector3(RandomFloat(-1000.0f, 1000.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0e-3f, 1.0e5f));
+	}
+
+	RandomMatrix(&m, 10.0f);
+
+	// Strided both ways, the way the software device transforms its vertices.
+	memset(&output[0], 0, sizeof(StridedOutputType) * MATH_TEST_VERTICES);
+	memset(&expected[0], 0, sizeof(StridedOutputType) * MATH_TEST_VERTICES);
+
+	Vec3TransformArray(&output[0].position, sizeof(StridedOutputType), &input[0].position, sizeof(StridedVertexType), &m, MATH_TEST_VERTICES);
+	ReferenceTransformArray(&expected[0].position, sizeof(StridedOutputType), &input[0].position, sizeof(StridedVertexType), &m, MATH_TEST_VERTICES);
+
+	wrong = 0;
+	for(i=0; i<MATH_TEST_VERTICES; i++)
+	{
+		wrong += (memcmp(&output[i].position, &expected[i].position, sizeof(Vector4)) != 0) ? 1 : 0;
+	}
+
+	TEST_CHECK(wrong == 0);
+
+	// Tightly packed with the output stride the same as the input, a count that leaves a remainder.
+	Vec3TransformArray(&packed[0], sizeof(Vector4), &input[0].position, sizeof(StridedVertexType), &m, MATH_TEST_VERTICES - 2);
+	ReferenceTransformArray(&packedExpected[0], sizeof(Vector4), &input[0].position, sizeof(StridedVertexType), &m, MATH_TEST_VERTICES - 2);
+
+	TEST_CHECK(memcmp(&packed[0], &packedExpected[0], sizeof(Vector4) * (MATH_TEST_VERTICES - 2)) == 0);
+
+	return;
+}
+
+
+static void TestMatrixMultiply()
+{
+	Matrix a, b, result, expected;
+	int i, wrong;
+
+
+	wrong = 0;
+	for(i=0; i<MATH_TEST_MATRICES; i++)
+	{
+		RandomMatrix(&a, 100.0f);
+		RandomMatrix(&b, 0.01f);
+
+		MatrixMultiply(&result, &a, &b);
+		ReferenceMatrixMultiply(&expected, &a, &b);
+		wrong += (memcmp(&result, &expected, sizeof(Matrix)) != 0) ? 1 : 0;
+
+		// The output may be either of the inputs.
+		result = a;
+		MatrixMultiply(&result, &result, &b);
+		wrong += (memcmp(&result, &expected, sizeof(Matrix)) != 0) ? 1 : 0;
+
+		result = b;
+		MatrixMultiply(&result, &a, &result);
+		wrong += (memcmp(&result, &expected, sizeof(Matrix)) != 0) ? 1 : 0;
+	}
+
+	TEST_CHECK(wrong == 0);
+
+	return;
+}
+
+
+static void TestCheckSpheres()
+{
+	std::vector<Vector4> spheres(MATH_TEST_SPHERES);
+	bool* visible;
+	bool* expected;
+	Matrix view, projection, viewProjection;
+	Frustum frustum;
+	Vector3 eye, at, up;
+	int i, count, expectedCount, wrong;
+
+
+	eye = Vector3(10.0f, 5.0f, -20.0f);
+	at = Vector3(0.0f, 0.0f, 0.0f);
+	up = Vector3(0.0f, 1.0f, 0.0f);
+
+	MatrixLookAtLH(&view, &eye, &at, &up);
+	MatrixPerspectiveFovLH(&projection, 0.785f, 1.333f, 0.1f, 100.0f);
+	MatrixMultiply(&viewProjection, &view, &projection);
+	FrustumFromMatrix(&frustum, &viewProjection);
+
+	// Scatter the spheres across the frustum and past every side of it, some with no radius.
+	for(i=0; i<MATH_TEST_SPHERES; i++)
+	{
+		spheres[i] = Vector4(RandomFloat(-80.0f, 80.0f), RandomFloat(-60.0f, 60.0f), RandomFloat(-40.0f, 120.0f), 
+							 (i % 5 == 0) ? 0.0f : RandomFloat(0.0f, 8.0f));
+	}
+
+	visible = new bool[MATH_TEST_SPHERES];
+	expected = new bool[MATH_TEST_SPHERES];
+
+	count = FrustumCheckSpheres(&frustum, &spheres[0], MATH_TEST_SPHERES, visible);
+	expectedCount = ReferenceCheckSpheres(&frustum, &spheres[0], MATH_TEST_SPHERES, expected);
+
+	wrong = 0;
+	for(i=0; i<MATH_TEST_SPHERES; i++)
+	{
+		wrong += (visible[i] != expected[i]) ? 1 : 0;
+	}
+
+	TEST_CHECK(count == expectedCount);
+	TEST_CHECK(wrong == 0);
+
+	// Some must be in and some out or the test proves nothing.
+	TEST_CHECK((expectedCount > 0) && (expectedCount < MATH_TEST_SPHERES));
+
+	// Spheres that only just touch a plane, where the order the distance is summed in decides the answer.
+	for(i=0; i<MATH_TEST_SPHERES; i++)
+	{
+		spheres[i].w = -((frustum.planes[i % 6].a * spheres[i].x) + (frustum.planes[i % 6].b * spheres[i].y) + 
+						 (frustum.planes[i % 6].c * spheres[i].z) + frustum.planes[i % 6].d);
+	}
+
+	count = FrustumCheckSpheres(&frustum, &spheres[0], MATH_TEST_SPHERES, visible);
+	expectedCount = ReferenceCheckSpheres(&frustum, &spheres[0], MATH_TEST_SPHERES, expected);
+
+	wrong = 0;
+	for(i=0; i<MATH_TEST_SPHERES; i++)
+	{
+		wrong += (visible[i] != expected[i]) ? 1 : 0;
+	}
+
+	TEST_CHECK(count == expectedCount);
+	TEST_CHECK(wrong == 0);
+
+	delete [] visible;
+	delete [] expected;
+
+	return;
+}
+
+
+int main()
+{
+	TestTransformArray();
+	TestMatrixMultiply();
+	TestCheckSpheres();
+
+#if defined(ENGINE_MATH_SSE)
+	return TestResult("math (sse)");
+#elif defined(ENGINE_MATH_NEON)
+	return TestResult("math (neon)");
+#else
+	return TestResult("math (scalar)");
+#endif
+}
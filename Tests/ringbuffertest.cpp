@@ -0,0 +1,377 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringbuffertest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Drives the ring buffer with fence values the test completes by hand, so the frames in flight are known exactly.
+// Checks alignment, wrapping, a full ring, the discard when a frame has nothing in the buffer yet and reusing an
+// allocation in later frames.
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stdio.h>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "testhelpers.h"
+#include "nulldeviceclass.h"
+#include "ringbufferclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FakeFenceDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+// A null device whose fences only complete when the test says the GPU has got that far.
+class FakeFenceDeviceClass : public NullDeviceClass
+{
+public:
+	FakeFenceDeviceClass()
+	{
+		m_inserted = 0;
+		m_completed = 0;
+	}
+
+	unsigned long long InsertFence()
+	{
+		m_inserted++;
+		return m_inserted;
+	}
+
+	bool IsFenceComplete(unsigned long long fence)
+	{
+		return fence <= m_completed;
+	}
+
+	void CompleteFences(unsigned long long fence)
+	{
+		m_completed = fence;
+	}
+
+	void CompleteAllFences()
+	{
+		m_completed = m_inserted;
+	}
+
+private:
+	unsigned long long m_inserted, m_completed;
+};
+
+
+static void TestAlignment()
+{
+	FakeFenceDeviceClass device;
+	RingBufferClass ring;
+	RingBufferClass::AllocationType allocation;
+	bool wrapped;
+
+
+	TEST_CHECK(device.Initialize(64, 64, 0.1f, 100.0f));
+	TEST_CHECK(ring.Initialize(&device, 1000));
+
+	// Every block starts on a multiple of its own alignment.
+	TEST_CHECK(ring.Reserve(5, 1, allocation, wrapped));
+	TEST_CHECK(allocation.offset == 0);
+	TEST_CHECK(ring.Reserve(24, 12, allocation, wrapped));
+	TEST_CHECK(allocation.offset == 12);
+	TEST_CHECK(ring.Reserve(36, 36, allocation, wrapped));
+	TEST_CHECK(allocation.offset == 36);
+	TEST_CHECK(ring.Reserve(7, 36, allocation, wrapped));
+	TEST_CHECK(allocation.offset == 72);
+	TEST_CHECK(!wrapped);
+
+	// The padding counts as in use.
+	TEST_CHECK(ring.GetBytesInFlight() == 79);
+
+	// A block bigger than the buffer or with no size never fits.
+	TEST_CHECK(!ring.Reserve(1001, 1, allocation, wrapped));
+	TEST_CHECK(!ring.Reserve(0, 1, allocation, wrapped));
+
+	ring.Shutdown();
+	device.Shutdown();
+
+	return;
+}
+
+
+static void TestWrap()
+{
+	FakeFenceDeviceClass device;
+	RingBufferClass ring;
+	RingBufferClass::AllocationType allocation;
+	long long start;
+	bool wrapped;
+
+
+	TEST_CHECK(device.Initialize(64, 64, 0.1f, 100.0f));
+	TEST_CHECK(ring.Initialize(&device, 100));
+
+	// Two frames of 40 bytes, then the first one is retired.
+	TEST_CHECK(ring.Reserve(40, 4, allocation, wrapped));
+	TEST_CHECK(allocation.offset == 0);
+	start = allocation.position;
+	TEST_CHECK(ring.CloseFrame(1));
+	TEST_CHECK(ring.Reserve(40, 4, allocation, wrapped));
+	TEST_CHECK(allocation.offset == 40);
+	TEST_CHECK(ring.CloseFrame(2));
+	TEST_CHECK(ring.GetFramesInFlight() == 2);
+	TEST_CHECK(ring.GetOldestFence() == 1);
+
+	ring.RetireFrame();
+	TEST_CHECK(ring.GetFramesInFlight() == 1);
+	TEST_CHECK(ring.GetBytesInFlight() == 40);
+
+	// 30 bytes do not fit after the second frame so they go at the start.
+	TEST_CHECK(ring.Reserve(30, 4, allocation, wrapped));
+	TEST_CHECK(wrapped);
+	TEST_CHECK(allocation.offset == 0);
+	TEST_CHECK(allocation.position == start + 100);
+	TEST_CHECK(ring.GetBytesInFlight() == 90);
+
+	// The next block would run into the second frame, which is still in flight.
+	TEST_CHECK(!ring.Reserve(20, 4, allocation, wrapped));
+	TEST_CHECK(!wrapped);
+
+	// Ten bytes still fit between the head and the second frame.
+	TEST_CHECK(ring.Reserve(10, 2, allocation, wrapped));
+	TEST_CHECK(allocation.offset == 30);
+	TEST_CHECK(ring.CloseFrame(3));
+
+	// Once every frame is retired the ring is empty and starts again from the beginning of a lap.
+	ring.RetireFrame();
+	ring.RetireFrame();
+	TEST_CHECK(ring.GetFramesInFlight() == 0);
+	TEST_CHECK(ring.GetBytesInFlight() == 0);
+
+	TEST_CHECK(ring.Reserve(100, 4, allocation, wrapped));
+	TEST_CHECK(allocation.offset == 0);
+	TEST_CHECK(!wrapped);
+
+	// A frame with nothing in it is not closed.
+	TEST_CHECK(ring.CloseFrame(4));
+	TEST_CHECK(!ring.CloseFrame(5));
+
+	ring.Shutdown();
+	device.Shutdown();
+
+	return;
+}
+
+
+static void TestFullRing()
+{
+	FakeFenceDeviceClass device;
+	RingBufferClass ring;
+	RingBufferClass::AllocationType allocation;
+	RingBufferClass::StatsType stats;
+	int frame;
+	void* data;
+
+
+	TEST_CHECK(device.Initialize(64, 64, 0.1f, 100.0f));
+	TEST_CHECK(ring.Initialize(&device, 1024));
+	device.ResetCounters();
+
+	// Four frames of 256 bytes fill the ring while the GPU has finished none of them.
+	for(frame=0; frame<4; frame++)
+	{
+		data = ring.Map(&device, 64, 4, allocation);
+		TEST_CHECK(data != 0);
+		TEST_CHECK(allocation.offset == frame * 256);
+		ring.Unmap(&device);
+		ring.EndFrame(&device, stats);
+	}
+
+	TEST_CHECK(ring.GetFramesInFlight() == 4);
+	TEST_CHECK(ring.GetBytesInFlight() == 1024);
+	TEST_CHECK(stats.bytesInFlight == 1024);
+	TEST_CHECK(device.GetCounters().bufferRenames == 0);
+
+	// Once the first two frames are done their space is used again with no overwrite.
+	device.CompleteFences(2);
+	data = ring.Map(&device, 128, 4, allocation);
+	TEST_CHECK(data != 0);
+	TEST_CHECK(allocation.offset == 0);
+	ring.Unmap(&device);
+
+	TEST_CHECK(ring.GetFramesInFlight() == 2);
+	TEST_CHECK(device.GetCounters().bufferRenames == 0);
+
+	// The ring is full again and this frame already has a block in it, so it can not be renamed and the map fails.
+	data = ring.Map(&device, 64, 4, allocation);
+	TEST_CHECK(data == 0);
+	ring.EndFrame(&device, stats);
+	TEST_CHECK(stats.allocations == 1);
+	TEST_CHECK(stats.failedAllocations == 1);
+	TEST_CHECK(stats.discards == 0);
+	TEST_CHECK(ring.GetFramesInFlight() == 3);
+
+	ring.Shutdown();
+	device.Shutdown();
+
+	return;
+}
+
+
+static void TestDiscard()
+{
+	FakeFenceDeviceClass device;
+	RingBufferClass ring;
+	RingBufferClass::AllocationType allocation;
+	RingBufferClass::StatsType stats;
+	int frame;
+	void* data;
+
+
+	TEST_CHECK(device.Initialize(64, 64, 0.1f, 100.0f));
+	TEST_CHECK(ring.Initialize(&device, 1024));
+	device.ResetCounters();
+
+	for(frame=0; frame<4; frame++)
+	{
+		ring.Map(&device, 64, 4, allocation);
+		ring.Unmap(&device);
+		ring.EndFrame(&device, stats);
+	}
+
+	// Nothing is free and nothing has been written this frame, so the whole buffer is renamed and the frames in flight
+	// keep the old copy.
+	data = ring.Map(&device, 64, 4, allocation);
+	TEST_CHECK(data != 0);
+	TEST_CHECK(allocation.offset == 0);
+	ring.Unmap(&device);
+	TEST_CHECK(device.GetCounters().bufferRenames == 1);
+	TEST_CHECK(ring.GetFramesInFlight() == 0);
+	TEST_CHECK(ring.GetBytesInFlight() == 256);
+
+	ring.EndFrame(&device, stats);
+	TEST_CHECK(stats.discards == 1);
+	TEST_CHECK(stats.failedAllocations == 0);
+
+	// A block bigger than the whole buffer fails without renaming it.
+	data = ring.Map(&device, 300, 4, allocation);
+	TEST_CHECK(data == 0);
+	TEST_CHECK(device.GetCounters().bufferRenames == 1);
+
+	ring.EndFrame(&device, stats);
+	TEST_CHECK(stats.failedAllocations == 1);
+
+	ring.Shutdown();
+	device.Shutdown();
+
+	return;
+}
+
+
+static void TestReuse()
+{
+	FakeFenceDeviceClass device;
+	RingBufferClass ring;
+	RingBufferClass::AllocationType kept, allocation;
+	RingBufferClass::StatsType stats;
+	int frame;
+	void* data;
+
+
+	TEST_CHECK(device.Initialize(64, 64, 0.1f, 100.0f));
+	TEST_CHECK(ring.Initialize(&device, 1024));
+
+	// Nothing was ever allocated.
+	kept.position = 0;
+	kept.offset = 0;
+	kept.size = 0;
+	TEST_CHECK(!ring.Reuse(kept));
+
+	// A block whose frame the GPU has finished can still be drawn again until its space is handed out.
+	data = ring.Map(&device, 64, 4, kept);
+	TEST_CHECK(data != 0);
+	TEST_CHECK(kept.offset == 0);
+	ring.Unmap(&device);
+	ring.EndFrame(&device, stats);
+
+	ring.Map(&device, 32, 4, allocation);
+	ring.Unmap(&device);
+	ring.EndFrame(&device, stats);
+
+	device.CompleteFences(1);
+	ring.Map(&device, 32, 4, allocation);
+	ring.Unmap(&device);
+	TEST_CHECK(ring.GetBytesInFlight() == 256);
+
+	TEST_CHECK(ring.Reuse(kept));
+	TEST_CHECK(ring.GetBytesInFlight() == 512);
+	ring.EndFrame(&device, stats);
+
+	// The block is drawn again every frame while other blocks stream past it.  The GPU keeps up, but the space is not
+	// handed out again while a frame that drew it is in flight, so the ring fills up after the rest of it is used.
+	for(frame=0; frame<4; frame++)
+	{
+		device.CompleteAllFences();
+		TEST_CHECK(ring.Reuse(kept));
+
+		data = ring.Map(&device, 32, 4, allocation);
+		TEST_CHECK(data != 0);
+		TEST_CHECK(allocation.offset == 512 + (frame * 128));
+		ring.Unmap(&device);
+
+		ring.EndFrame(&device, stats);
+	}
+
+	device.CompleteAllFences();
+	TEST_CHECK(ring.Reuse(kept));
+	TEST_CHECK(ring.Map(&device, 32, 4, allocation) == 0);
+	ring.EndFrame(&device, stats);
+	TEST_CHECK(stats.failedAllocations == 1);
+	TEST_CHECK(stats.discards == 0);
+	TEST_CHECK(ring.GetFramesInFlight() == 1);
+
+	// Once no frame draws it the space goes to the next block, and the old block can not be drawn again.
+	device.CompleteAllFences();
+	data = ring.Map(&device, 32, 4, allocation);
+	TEST_CHECK(data != 0);
+	TEST_CHECK(allocation.offset == 0);
+	ring.Unmap(&device);
+	TEST_CHECK(!ring.Reuse(kept));
+	ring.EndFrame(&device, stats);
+
+	// A renamed buffer has lost every earlier block, even one whose space was never written over.
+	data = ring.Map(&device, 64, 4, kept);
+	TEST_CHECK(kept.offset == 128);
+	ring.Unmap(&device);
+	ring.EndFrame(&device, stats);
+
+	for(frame=0; frame<2; frame++)
+	{
+		ring.Map(&device, 64, 4, allocation);
+		ring.Unmap(&device);
+		ring.EndFrame(&device, stats);
+		TEST_CHECK(ring.Reuse(kept));
+		ring.EndFrame(&device, stats);
+	}
+
+	data = ring.Map(&device, 64, 4, allocation);
+	TEST_CHECK(data != 0);
+	ring.Unmap(&device);
+	TEST_CHECK(!ring.Reuse(kept));
+
+	ring.EndFrame(&device, stats);
+	TEST_CHECK(stats.discards == 1);
+
+	ring.Shutdown();
+	device.Shutdown();
+
+	return;
+}
+
+
+int main()
+{
+	TestAlignment();
+	TestWrap();
+	TestFullRing();
+	TestDiscard();
+	TestReuse();
+
+	return TestResult("ringbuffer");
+}
@@ -0,0 +1,299 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shadercachetest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Stores byte code, saves it and maps it back in, checks the key changes with every compiler input and that damaged
+// files are treated as an empty cache.  The cache files are written to the working directory.
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "testhelpers.h"
+#include "shadercacheclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char* CACHE_FILENAME = "shadercachetest.bin";
+const int CACHE_HEADER_SIZE = 16;
+const int CACHE_ENTRY_SIZE = 16;
+
+
+static bool WriteFile(const char* filename, const std::vector<unsigned char>& bytes)
+{
+	FILE* file;
+	size_t count;
+
+
+	file = fopen(filename, "wb");
+	if(!file)
+	{
+		return false;
+	}
+
+	count = bytes.empty() ? 0 : fwrite(&bytes[0], 1, bytes.size(), file);
+	fclose(file);
+
+	return count == bytes.size();
+}
+
+
+static bool ReadFile(const char* filename, std::vector<unsigned char>& bytes)
+{
+	FILE* file;
+	unsigned char buffer[4096];
+	size_t count;
+
+
+	file = fopen(filename, "rb");
+	if(!file)
+	{
+		return false;
+	}
+
+	bytes.clear();
+	while((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		bytes.insert(bytes.end(), buffer, buffer + count);
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+
+static void WriteUint(std::vector<unsigned char>& bytes, int offset, unsigned int value)
+{
+	int i;
+
+
+	for(i=0; i<4; i++)
+	{
+		bytes[offset + i] = (unsigned char)(value >> (i * 8));
+	}
+
+	return;
+}
+
+
+// Maps the file and returns how many of the keys it finds, a rejected file finds none.
+static int CountEntries(const char* filename, const unsigned long long* keys, int keyCount)
+{
+	ShaderCacheClass cache;
+	const void* data;
+	int size, found, i;
+
+
+	found = 0;
+
+	if(cache.Initialize(filename))
+	{
+		for(i=0; i<keyCount; i++)
+		{
+			if(cache.Find(keys[i], data, size))
+			{
+				found++;
+			}
+		}
+	}
+
+	cache.Shutdown();
+
+	return found;
+}
+
+
+static void TestStoreSaveMapFind()
+{
+	ShaderCacheClass cache;
+	ShaderCacheClass::StatsType stats;
+	const char* byteCode[3] = { "vertex shader byte code", "pixel shader", "x" };
+	unsigned long long keys[3];
+	const void* data;
+	int size, i;
+
+
+	remove(CACHE_FILENAME);
+
+	for(i=0; i<3; i++)
+	{
+		keys[i] = ShaderCacheClass::HashShader(byteCode[i], (int)strlen(byteCode[i]), "main", "vs_5_0", (unsigned int)i);
+	}
+
+	// A missing file is an empty cache.
+	TEST_CHECK(cache.Initialize(CACHE_FILENAME));
+	TEST_CHECK(!cache.Find(keys[0], data, size));
+
+	TEST_CHECK(cache.Store(keys[0], byteCode[0], (int)strlen(byteCode[0]) + 1));
+	TEST_CHECK(cache.Store(keys[1], byteCode[1], (int)strlen(byteCode[1]) + 1));
+	TEST_CHECK(!cache.Store(keys[2], byteCode[2], 0));
+
+	// A stored entry is found straight away.
+	TEST_CHECK(cache.Find(keys[1], data, size) && (size == (int)strlen(byteCode[1]) + 1) && (memcmp(data, byteCode[1], size) == 0));
+
+	TEST_CHECK(cache.Save());
+	cache.Shutdown();
+
+	// Map the saved file into a new cache, every entry has to come back byte for byte.
+	TEST_CHECK(cache.Initialize(CACHE_FILENAME));
+
+	cache.GetStats(stats);
+	TEST_CHECK(stats.bytesMapped == CACHE_HEADER_SIZE + (2 * CACHE_ENTRY_SIZE) + (int)(strlen(byteCode[0]) + strlen(byteCode[1]) + 2));
+
+	for(i=0; i<2; i++)
+	{
+		TEST_CHECK(cache.Find(keys[i], data, size) && (size == (int)strlen(byteCode[i]) + 1) && (memcmp(data, byteCode[i], size) == 0));
+	}
+
+	TEST_CHECK(!cache.Find(keys[2], data, size));
+
+	// Store another entry and save over the mapped file, the mapped entries have to survive being rewritten.
+	TEST_CHECK(cache.Store(keys[2], byteCode[2], 1));
+	TEST_CHECK(cache.Save());
+
+	for(i=0; i<2; i++)
+	{
+		TEST_CHECK(cache.Find(keys[i], data, size) && (memcmp(data, byteCode[i], size) == 0));
+	}
+
+	cache.Shutdown();
+
+	TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 3) == 3);
+
+	return;
+}
+
+
+static void TestHashInputs()
+{
+	const char* source = "float4 main() : SV_TARGET { return 1; }";
+	const char* otherSource = "float4 main() : SV_TARGET { return 0; }";
+	unsigned long long hash;
+	int size;
+
+
+	size = (int)strlen(source);
+	hash = ShaderCacheClass::HashShader(source, size, "main", "ps_5_0", 1);
+
+	// The same inputs always give the same key.
+	TEST_CHECK(hash == ShaderCacheClass::HashShader(source, size, "main", "ps_5_0", 1));
+
+	// Changing any one of them gives a different key.
+	TEST_CHECK(hash != ShaderCacheClass::HashShader(otherSource, size, "main", "ps_5_0", 1));
+	TEST_CHECK(hash != ShaderCacheClass::HashShader(source, size - 1, "main", "ps_5_0", 1));
+	TEST_CHECK(hash != ShaderCacheClass::HashShader(source, size, "Main", "ps_5_0", 1));
+	TEST_CHECK(hash != ShaderCacheClass::HashShader(source, size, "main", "ps_4_0", 1));
+	TEST_CHECK(hash != ShaderCacheClass::HashShader(source, size, "main", "ps_5_0", 3));
+
+	// Moving a character between the entry point and the profile must not give the same key either.
+	TEST_CHECK(ShaderCacheClass::HashShader(source, size, "ab", "c", 0) != ShaderCacheClass::HashShader(source, size, "a", "bc", 0));
+
+	return;
+}
+
+
+static void TestDamagedFiles()
+{
+	ShaderCacheClass cache;
+	std::vector<unsigned char> valid, damaged;
+	unsigned long long keys[2];
+	unsigned int dataOffset;
+	int size;
+
+
+	// Write a good file with two entries to damage.
+	remove(CACHE_FILENAME);
+
+	keys[0] = ShaderCacheClass::HashShader("a", 1, "main", "vs_5_0", 0);
+	keys[1] = ShaderCacheClass::HashShader("b", 1, "main", "vs_5_0", 0);
+
+	cache.Initialize(CACHE_FILENAME);
+	cache.Store(keys[0], "first entry", 12);
+	cache.Store(keys[1], "second entry", 13);
+	cache.Shutdown();
+
+	TEST_CHECK(ReadFile(CACHE_FILENAME, valid));
+	TEST_CHECK(valid.size() == (size_t)(CACHE_HEADER_SIZE + (2 * CACHE_ENTRY_SIZE) + 25));
+	TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 2) == 2);
+
+	if(valid.size() != (size_t)(CACHE_HEADER_SIZE + (2 * CACHE_ENTRY_SIZE) + 25))
+	{
+		return;
+	}
+
+	// Files cut off inside the header, inside the entry table and inside the byte code are all rejected.
+	for(size=0; size<(int)valid.size(); size++)
+	{
+		damaged.assign(valid.begin(), valid.begin() + size);
+		WriteFile(CACHE_FILENAME, damaged);
+
+		if(!TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 2) == 0))
+		{
+			printf("  truncated to %d bytes\n", size);
+		}
+	}
+
+	// A bad magic or version.
+	damaged = valid;
+	damaged[0] = 'X';
+	WriteFile(CACHE_FILENAME, damaged);
+	TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 2) == 0);
+
+	damaged = valid;
+	WriteUint(damaged, 4, SHADER_CACHE_VERSION + 1);
+	WriteFile(CACHE_FILENAME, damaged);
+	TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 2) == 0);
+
+	// More entries than the file has room for.
+	damaged = valid;
+	WriteUint(damaged, 8, 0x10000000);
+	WriteFile(CACHE_FILENAME, damaged);
+	TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 2) == 0);
+
+	// An offset past the end of the file, and one where the offset plus the size wraps around.
+	dataOffset = CACHE_HEADER_SIZE + CACHE_ENTRY_SIZE + 8;
+
+	damaged = valid;
+	WriteUint(damaged, dataOffset, (unsigned int)valid.size() + 1);
+	WriteFile(CACHE_FILENAME, damaged);
+	TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 2) == 0);
+
+	damaged = valid;
+	WriteUint(damaged, dataOffset + 4, 0xfffffff0);
+	WriteFile(CACHE_FILENAME, damaged);
+	TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 2) == 0);
+
+	damaged = valid;
+	WriteUint(damaged, dataOffset, 0xfffffff0);
+	WriteUint(damaged, dataOffset + 4, 0x20);
+	WriteFile(CACHE_FILENAME, damaged);
+	TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 2) == 0);
+
+	// The untouched file still loads.
+	WriteFile(CACHE_FILENAME, valid);
+	TEST_CHECK(CountEntries(CACHE_FILENAME, keys, 2) == 2);
+
+	remove(CACHE_FILENAME);
+
+	return;
+}
+
+
+int main()
+{
+	TestStoreSaveMapFind();
+	TestHashInputs();
+	TestDamagedFiles();
+
+	return TestResult("shadercache");
+}
@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: testhelpers.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TESTHELPERS_H_
+#define _TESTHELPERS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stdio.h>
+
+
+///////////////////////////////
+// PRE-PROCESSING DIRECTIVES //
+///////////////////////////////
+// Checks go on after a failure so one run shows everything that is wrong, the test fails if any of them did.
+#define TEST_CHECK(condition) TestCheck((condition), #condition, __FILE__, __LINE__)
+
+
+/////////////
+// GLOBALS //
+/////////////
+static int g_testChecks = 0;
+static int g_testFailures = 0;
+
+
+static inline bool TestCheck(bool passed, const char* condition, const char* file, int line)
+{
+	g_testChecks++;
+
+	if(!passed)
+	{
+		printf("%s(%d): check failed: %s\n", file, line, condition);
+		g_testFailures++;
+	}
+
+	return passed;
+}
+
+
+// Prints the totals and returns the exit code for the test.
+static inline int TestResult(const char* name)
+{
+	printf("%s: %d checks, %d failed\n", name, g_testChecks, g_testFailures);
+
+	return (g_testFailures == 0) ? 0 : 1;
+}
+
+#endif
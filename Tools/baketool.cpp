@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: baketool.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Bakes the terrain normal map and light map without a window or a device so the bakers can be timed on any platform.
+//
+// Usage: baketool [width] [height] [max threads] [runs]
+//
+// The bakes are repeated with the job system started on 1, 2, 4... threads up to the maximum, every hardware thread by
+// default.  Every job writes its own rows so the checksums must not change with the thread count.
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <thread>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "terrainclass.h"
+#include "normalmapclass.h"
+#include "lightmapclass.h"
+#include "jobsystemclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BAKE_DEFAULT_SIZE = 257;
+const int BAKE_DEFAULT_RUNS = 5;
+
+
+static void GenerateHeights(float* heights, int width, int height)
+{
+	int i, j;
+
+
+	// Rolling hills with a ridge across them, the same every run so the checksums can be compared.
+	for(j=0; j<height; j++)
+	{
+		for(i=0; i<width; i++)
+		{
+			heights[(j * width) + i] = 20.0f * sinf((float)i * 0.05f) * cosf((float)j * 0.07f) + 
+									   6.0f * sinf((float)(i + j) * 0.21f) + 10.0f;
+		}
+	}
+
+	return;
+}
+
+
+static unsigned int Checksum(const unsigned char* data, int rowBytes, int rows, int pitch)
+{
+	unsigned int hash;
+	int i, j;
+
+
+	// FNV-1a over the rows without their padding.
+	hash = 2166136261u;
+
+	for(j=0; j<rows; j++)
+	{
+		for(i=0; i<rowBytes; i++)
+		{
+			hash = (hash ^ data[(j * pitch) + i]) * 16777619u;
+		}
+	}
+
+	return hash;
+}
+
+
+static bool RunBakes(const float* heights, int width, int height, int threadCount, int runs)
+{
+	JobSystemClass* jobSystem;
+	NormalMapClass* normalMap;
+	LightMapClass* lightMap;
+	float normalTime, occlusionTime, shadowTime;
+	unsigned int normalHash, lightHash;
+	bool result;
+	int i;
+
+
+	jobSystem = new JobSystemClass;
+	normalMap = new NormalMapClass;
+	lightMap = new LightMapClass;
+
+	result = jobSystem->Initialize(threadCount);
+	if(result)
+	{
+		result = normalMap->Initialize(width, height, NORMAL_MAP_SCALE);
+	}
+
+	if(result)
+	{
+		result = lightMap->Initialize(normalMap->GetWidth(), normalMap->GetHeight(), 1.0f / (float)NORMAL_MAP_SCALE);
+	}
+
+	// Keep the fastest of the runs, the first one also pays for faulting in the pages.
+	normalTime = occlusionTime = shadowTime = 1.0e9f;
+
+	for(i=0; result && (i<runs); i++)
+	{
+		result = normalMap->Bake(heights, 1);
+		if(!result)
+		{
+			break;
+		}
+
+		result = lightMap->BakeOcclusion(normalMap->GetHeightData(), normalMap->GetHeightPitch());
+		if(!result)
+		{
+			break;
+		}
+
+		// Alternate the light direction so every run does a full shadow sweep.
+		result = lightMap->BakeShadows(normalMap->GetHeightData(), normalMap->GetHeightPitch(), -0.5f, -0.6f - (float)(i % 2) * 0.1f, 0.3f);
+		if(!result)
+		{
+			break;
+		}
+
+		normalTime = (normalMap->GetBakeTime() < normalTime) ? normalMap->GetBakeTime() : normalTime;
+		occlusionTime = (lightMap->GetOcclusionBakeTime() < occlusionTime) ? lightMap->GetOcclusionBakeTime() : occlusionTime;
+		shadowTime = (lightMap->GetShadowBakeTime() < shadowTime) ? lightMap->GetShadowBakeTime() : shadowTime;
+	}
+
+	if(result)
+	{
+		normalHash = Checksum((const unsigned char*)normalMap->GetNormalData(), normalMap->GetWidth() * 2, normalMap->GetHeight(), 
+							  normalMap->GetNormalPitch());
+		lightHash = Checksum(lightMap->GetLightData(), normalMap->GetWidth() * 2, normalMap->GetHeight(), lightMap->GetLightPitch());
+
+		printf("%8d %12.3f %12.3f %12.3f   %08x   %08x\n", JobSystemClass::GetThreadCount(), normalTime, occlusionTime, shadowTime, 
+			   normalHash, lightHash);
+	}
+	else
+	{
+		printf("%8d bake failed\n", threadCount);
+	}
+
+	lightMap->Shutdown();
+	delete lightMap;
+	normalMap->Shutdown();
+	delete normalMap;
+	jobSystem->Shutdown();
+	delete jobSystem;
+
+	return result;
+}
+
+
+int main(int argc, char** argv)
+{
+	int width, height, maxThreads, runs, threadCount;
+	float* heights;
+	bool result;
+
+
+	width = (argc > 1) ? atoi(argv[1]) : BAKE_DEFAULT_SIZE;
+	height = (argc > 2) ? atoi(argv[2]) : width;
+	maxThreads = (argc > 3) ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+	runs = (argc > 4) ? atoi(argv[4]) : BAKE_DEFAULT_RUNS;
+
+	if((width < 2) || (height < 2) || (runs < 1))
+	{
+		printf("usage: baketool [width] [height] [max threads] [runs]\n");
+		return 1;
+	}
+
+	maxThreads = (maxThreads < 1) ? 1 : maxThreads;
+
+	heights = new float[width * height];
+	GenerateHeights(heights, width, height);
+
+	printf("%dx%d height map, normal map scale %d, fastest of %d runs\n", width, height, NORMAL_MAP_SCALE, runs);
+	printf("%8s %12s %12s %12s %10s %10s\n", "threads", "normals ms", "occlusion ms", "shadows ms", "normals", "light");
+
+	result = true;
+	threadCount = 1;
+
+	while(result)
+	{
+		result = RunBakes(heights, width, height, threadCount, runs);
+		if(threadCount >= maxThreads)
+		{
+			break;
+		}
+
+		threadCount = (threadCount * 2 > maxThreads) ? maxThreads : threadCount * 2;
+	}
+
+	delete [] heights;
+
+	return result ? 0 : 1;
+}